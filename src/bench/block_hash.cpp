@@ -0,0 +1,109 @@
+// Copyright (c) 2020 The ShroudX Project developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "primitives/block.h"
+#include "uint256.h"
+
+#include <vector>
+
+namespace {
+
+// Roughly the number of CBlockHeader::GetHash() calls a block goes through on -reindex:
+// LoadExternalBlockFile, ProcessNewBlock, AcceptBlockHeader, CheckBlockHeader, checkpoint
+// checks, ActivateBestChain and ConnectBlock.
+const int HASHES_PER_HEADER = 8;
+
+const int BATCH_SIZE = 8;
+const int CHAIN_SIZE = 64;
+
+CBlockHeader MakeHeader()
+{
+    CBlockHeader header;
+    header.hashPrevBlock = uint256S("0x1e5ca84ad93f5b5ca96f2f5bc50e6bff0a13be3a0bc6a2b0d5f4b5fd1ae1c93b");
+    header.hashMerkleRoot = uint256S("0x5d8e1cb1a5b83e57d6a7f4b1efdd90f1b3e4f2b6c0d5e6a4a3c8f2d1e0b9a7c6");
+    header.nTime = 1585000000;
+    header.nBits = 0x1e0ffff0;
+    header.nNonce = 1;
+    return header;
+}
+
+} // namespace
+
+// Every header is new, as on -reindex: one X16Rv2 evaluation and the rest served from the cache
+static void BlockHeaderHashReindex(benchmark::State& state)
+{
+    CBlockHeader header = MakeHeader();
+    uint256 hash;
+    while (state.KeepRunning()) {
+        header.nNonce++;
+        for (int i = 0; i < HASHES_PER_HEADER; i++)
+            hash = header.GetHash();
+    }
+}
+
+// Same as above with every call evaluating X16Rv2
+static void BlockHeaderHashReindexUncached(benchmark::State& state)
+{
+    CBlockHeader header = MakeHeader();
+    uint256 hash;
+    while (state.KeepRunning()) {
+        header.nNonce++;
+        for (int i = 0; i < HASHES_PER_HEADER; i++)
+            hash = header.GetPoWHash();
+    }
+}
+
+// Nonce search as in the miner: headers that only differ by nNonce, one at a time
+static void BlockHeaderPoWHashNonces(benchmark::State& state)
+{
+    CBlockHeader header = MakeHeader();
+    uint256 hash;
+    while (state.KeepRunning()) {
+        for (int i = 0; i < BATCH_SIZE; i++) {
+            header.nNonce++;
+            hash = header.GetPoWHash();
+        }
+    }
+}
+
+// Same nonces hashed together, all the headers select the same algorithms
+static void BlockHeaderPoWHashNoncesBatch(benchmark::State& state)
+{
+    CBlockHeader headers[BATCH_SIZE];
+    const CBlockHeader* pheaders[BATCH_SIZE];
+    uint256 hashes[BATCH_SIZE];
+    for (int i = 0; i < BATCH_SIZE; i++) {
+        headers[i] = MakeHeader();
+        pheaders[i] = &headers[i];
+    }
+    while (state.KeepRunning()) {
+        for (int i = 0; i < BATCH_SIZE; i++)
+            headers[i].nNonce += BATCH_SIZE;
+        GetPoWHashes(pheaders, BATCH_SIZE, hashes);
+    }
+}
+
+// Headers of a chain as loaded from the block index, every one has a different hashPrevBlock
+static void BlockHeaderPoWHashChainBatch(benchmark::State& state)
+{
+    std::vector<CBlockHeader> headers(CHAIN_SIZE, MakeHeader());
+    std::vector<const CBlockHeader*> pheaders(CHAIN_SIZE);
+    std::vector<uint256> hashes(CHAIN_SIZE);
+    for (int i = 0; i < CHAIN_SIZE; i++) {
+        if (i > 0)
+            headers[i].hashPrevBlock = headers[i - 1].GetPoWHash();
+        pheaders[i] = &headers[i];
+    }
+    while (state.KeepRunning()) {
+        GetPoWHashes(pheaders.data(), CHAIN_SIZE, hashes.data());
+    }
+}
+
+BENCHMARK(BlockHeaderHashReindex);
+BENCHMARK(BlockHeaderHashReindexUncached);
+BENCHMARK(BlockHeaderPoWHashNonces);
+BENCHMARK(BlockHeaderPoWHashNoncesBatch);
+BENCHMARK(BlockHeaderPoWHashChainBatch);
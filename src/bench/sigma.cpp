@@ -0,0 +1,119 @@
+// Copyright (c) 2020 The ShroudX Project developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "sigma/sigmaplus_prover.h"
+#include "sigma/sigmaplus_verifier.h"
+
+#include <vector>
+
+using namespace secp_primitives;
+
+namespace {
+
+// Same shape as sigma::Params but smaller anonymity set to keep proving fast, N = 4^5.
+const int n = 4;
+const int m = 5;
+const int N = 1024;
+
+struct SigmaBenchSetup {
+    GroupElement g;
+    std::vector<GroupElement> h;
+    sigma::GeneratorTables tables;
+    std::vector<GroupElement> commits;
+    Scalar r;
+    std::size_t index;
+
+    SigmaBenchSetup() : g(random_element()), h(random_elements(n * m)), tables(g, h), index(N / 2) {
+        r.randomize();
+        commits = random_elements(N);
+        commits[index] = h[0] * r;
+    }
+
+    static GroupElement random_element() {
+        GroupElement e;
+        e.randomize();
+        return e;
+    }
+
+    static std::vector<GroupElement> random_elements(std::size_t size) {
+        std::vector<GroupElement> result(size);
+        for (auto &e : result)
+            e.randomize();
+        return result;
+    }
+};
+
+SigmaBenchSetup& GetSetup() {
+    static SigmaBenchSetup setup;
+    return setup;
+}
+
+void Multiply(benchmark::State& state, bool fTables)
+{
+    SigmaBenchSetup& setup = GetSetup();
+    Scalar s;
+    s.randomize();
+    GroupElement result;
+    while (state.KeepRunning()) {
+        result = fTables ? setup.tables.g.multiply(s) : setup.g * s;
+    }
+}
+
+void Commit(benchmark::State& state, bool fTables)
+{
+    SigmaBenchSetup& setup = GetSetup();
+    std::vector<Scalar> exps(n * m);
+    for (auto &e : exps)
+        e.randomize();
+    while (state.KeepRunning()) {
+        GroupElement result;
+        sigma::SigmaPrimitives<Scalar, GroupElement>::commit(
+            setup.g, setup.h, exps, setup.r, fTables ? &setup.tables : nullptr, result);
+    }
+}
+
+void Prove(benchmark::State& state, bool fTables)
+{
+    SigmaBenchSetup& setup = GetSetup();
+    sigma::SigmaPlusProver<Scalar, GroupElement> prover(setup.g, setup.h, n, m, fTables ? &setup.tables : nullptr);
+    while (state.KeepRunning()) {
+        sigma::SigmaPlusProof<Scalar, GroupElement> proof(n, m);
+        prover.proof(setup.commits, setup.index, setup.r, false, proof);
+    }
+}
+
+void Verify(benchmark::State& state, bool fTables)
+{
+    SigmaBenchSetup& setup = GetSetup();
+    sigma::SigmaPlusProver<Scalar, GroupElement> prover(setup.g, setup.h, n, m);
+    sigma::SigmaPlusProof<Scalar, GroupElement> proof(n, m);
+    prover.proof(setup.commits, setup.index, setup.r, false, proof);
+
+    sigma::SigmaPlusVerifier<Scalar, GroupElement> verifier(setup.g, setup.h, n, m, fTables ? &setup.tables : nullptr);
+    while (state.KeepRunning()) {
+        verifier.verify(setup.commits, proof, false);
+    }
+}
+
+} // namespace
+
+static void SigmaMultiply(benchmark::State& state) { Multiply(state, false); }
+static void SigmaMultiplyFixedBase(benchmark::State& state) { Multiply(state, true); }
+static void SigmaCommit(benchmark::State& state) { Commit(state, false); }
+static void SigmaCommitFixedBase(benchmark::State& state) { Commit(state, true); }
+static void SigmaProve(benchmark::State& state) { Prove(state, false); }
+static void SigmaProveFixedBase(benchmark::State& state) { Prove(state, true); }
+static void SigmaVerify(benchmark::State& state) { Verify(state, false); }
+static void SigmaVerifyFixedBase(benchmark::State& state) { Verify(state, true); }
+
+BENCHMARK(SigmaMultiply);
+BENCHMARK(SigmaMultiplyFixedBase);
+BENCHMARK(SigmaCommit);
+BENCHMARK(SigmaCommitFixedBase);
+BENCHMARK(SigmaProve);
+BENCHMARK(SigmaProveFixedBase);
+BENCHMARK(SigmaVerify);
+BENCHMARK(SigmaVerifyFixedBase);
@@ -0,0 +1,79 @@
+// Copyright (c) 2020 The ShroudX Project developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "arith_uint256.h"
+#include "chain.h"
+#include "chainparams.h"
+#include "pos.h"
+
+#include <vector>
+
+namespace {
+
+// A wallet with many staking outputs, searched over the whole window CreateCoinStake allows
+const int COINS = 64;
+const unsigned int WINDOW = 60;
+// and the same wallet tried at the one timestamp a staker checks per block
+const int COINS_SINGLE = 1024;
+
+// no kernel ever meets this target, so every timestamp is hashed
+const unsigned int BITS = 0x03000001;
+
+struct StakeKernelSetup {
+    uint256 hashBlock;
+    CBlockIndex index;
+    std::vector<COutPoint> coins;
+
+    StakeKernelSetup() : hashBlock(ArithToUint256(42)) {
+        SelectParams(CBaseChainParams::MAIN);
+        index.phashBlock = &hashBlock;
+        index.nHeight = Params().GetConsensus().nFirstPOSBlock + 1000;
+        index.nTime = 1585000000;
+        index.nStakeModifier = ArithToUint256(0x5eed);
+        for (int i = 0; i < COINS_SINGLE; i++)
+            coins.push_back(COutPoint(ArithToUint256(i + 1), i % 3));
+    }
+};
+
+StakeKernelSetup& GetSetup()
+{
+    static StakeKernelSetup setup;
+    return setup;
+}
+
+void Check(benchmark::State& state, int nCoins, unsigned int nWindow)
+{
+    StakeKernelSetup& setup = GetSetup();
+    unsigned int nTime = setup.index.GetBlockTime() + 120;
+    while (state.KeepRunning()) {
+        for (int i = 0; i < nCoins; i++)
+            for (unsigned int n = 0; n < nWindow; n++)
+                CheckStakeKernelHash(&setup.index, BITS, setup.index.GetBlockTime(), 1000 * COIN, setup.coins[i], nTime - n);
+    }
+}
+
+void Search(benchmark::State& state, int nCoins, unsigned int nWindow)
+{
+    StakeKernelSetup& setup = GetSetup();
+    while (state.KeepRunning()) {
+        for (int i = 0; i < nCoins; i++) {
+            uint32_t nTimeTx = setup.index.GetBlockTime() + 120;
+            SearchStakeKernelHash(&setup.index, BITS, setup.index.GetBlockTime(), 1000 * COIN, setup.coins[i], nTimeTx, nWindow);
+        }
+    }
+}
+
+} // namespace
+
+static void StakeKernelWindowCheck(benchmark::State& state) { Check(state, COINS, WINDOW); }
+static void StakeKernelWindowSearch(benchmark::State& state) { Search(state, COINS, WINDOW); }
+static void StakeKernelSingleCheck(benchmark::State& state) { Check(state, COINS_SINGLE, 1); }
+static void StakeKernelSingleSearch(benchmark::State& state) { Search(state, COINS_SINGLE, 1); }
+
+BENCHMARK(StakeKernelWindowCheck);
+BENCHMARK(StakeKernelWindowSearch);
+BENCHMARK(StakeKernelSingleCheck);
+BENCHMARK(StakeKernelSingleSearch);
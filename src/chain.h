@@ -531,7 +531,8 @@ public:
         nDiskBlockVersion = nVersion;
     }
 
-    uint256 GetBlockHash() const
+    /** Header of the stored block, unlike GetBlockHeader() it doesn't need pprev */
+    CBlockHeader GetDiskBlockHeader() const
     {
         CBlockHeader    block;
         block.nVersion       = nVersion;
@@ -540,8 +541,12 @@ public:
         block.nTime          = nTime;
         block.nBits          = nBits;
         block.nNonce         = nNonce;
+        return block;
+    }
 
-        return block.GetHash();
+    uint256 GetBlockHash() const
+    {
+        return GetDiskBlockHeader().GetHash();
     }
 
     std::string ToString() const
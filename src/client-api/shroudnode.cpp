@@ -218,8 +218,8 @@ UniValue shroudnodelist(Type type, const UniValue& data, const UniValue& auth, b
                 return data;
             }
 
-            std::vector <CShroudnode> vShroudnodes = mnodeman.GetFullShroudnodeVector();
-            BOOST_FOREACH(CShroudnode & mn, vShroudnodes) {
+            CShroudnodeMan::shroudnode_snapshot_t vShroudnodes = mnodeman.GetShroudnodeSnapshot();
+            BOOST_FOREACH(const CShroudnode & mn, *vShroudnodes) {
                 std::string txHash = mn.vin.prevout.hash.ToString().substr(0,64);
                 std::string outputIndex = to_string(mn.vin.prevout.n);
                 std::string key = txHash + outputIndex;
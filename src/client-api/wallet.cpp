@@ -20,20 +20,9 @@ using namespace boost::chrono;
 using namespace std;
 
 void GetSigmaBalance(CAmount& sigmaAll, CAmount& sigmaConfirmed) {
-    auto coins = zwalletMain->GetTracker().ListMints(true, false, false);
-    for (const auto& coin : coins) {
-        // ignore spent coin
-        if (coin.isUsed)
-            continue;
-
-        int64_t coinValue;
-        DenominationToInteger(coin.denom, coinValue);
-
-        sigmaAll += coinValue;
-        if (coin.nHeight > 0
-            && coin.nHeight + (ZC_MINT_CONFIRMATIONS-1) <= chainActive.Height())
-            sigmaConfirmed += coinValue;
-    }
+    std::pair<CAmount, CAmount> sigmaBalance = pwalletMain->GetSigmaBalance();
+    sigmaAll += sigmaBalance.first;
+    sigmaConfirmed += sigmaBalance.second;
 }
 
 UniValue getTxMetadataEntry(string txid, string address, CAmount amount){
@@ -633,10 +622,11 @@ UniValue balance(Type type, const UniValue& data, const UniValue& auth, bool fHe
     UniValue sigmaObj(UniValue::VOBJ);
 
     // various balances
-    CAmount xzcConfirmed = pwalletMain->GetBalance();
-    CAmount xzcUnconfirmed = pwalletMain->GetUnconfirmedBalance();
+    CWalletBalances balances = pwalletMain->GetBalances();
+    CAmount xzcConfirmed = balances.nTrusted;
+    CAmount xzcUnconfirmed = balances.nUnconfirmed;
     CAmount xzcLocked = getLockUnspentAmount();
-    CAmount xzcImmature = pwalletMain->GetImmatureBalance();
+    CAmount xzcImmature = balances.nImmature;
 
     //get private confirmed
     CAmount sigmaAll = 0;
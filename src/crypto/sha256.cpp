@@ -8,6 +8,12 @@
 
 #include <string.h>
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SHA256_USE_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
 // Internal implementation code.
 namespace
 {
@@ -128,6 +134,245 @@ void Transform(uint32_t* s, const unsigned char* chunk)
 }
 
 } // namespace sha256
+
+#ifdef SHA256_USE_X86
+/**
+ * Transformations for the x86 SHA extensions and for AVX2. Built with function target attributes,
+ * so the rest of the file doesn't need any special compiler flags; callers check the CPU first.
+ */
+namespace sha256_x86
+{
+#define SHA256_SHANI_TARGET __attribute__((target("sha,sse4.1")))
+#define SHA256_AVX2_TARGET __attribute__((target("avx2")))
+
+bool HasSHANI()
+{
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_SSE4_1))
+        return false;
+    if (__get_cpuid_max(0, NULL) < 7)
+        return false;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return (ebx & bit_SHA) != 0;
+}
+
+bool HasAVX2()
+{
+    return __builtin_cpu_supports("avx2");
+}
+
+/** Four rounds, message words plus round constants in msg. */
+SHA256_SHANI_TARGET inline void Quad(__m128i& state0, __m128i& state1, __m128i m, __m128i k)
+{
+    __m128i msg = _mm_add_epi32(m, k);
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0E));
+}
+
+/** One SHA-256 transformation with the SHA extensions, same as sha256::Transform. */
+SHA256_SHANI_TARGET void TransformSHANI(uint32_t* s, const unsigned char* chunk)
+{
+    const __m128i MASK = _mm_set_epi64x(0x0c0d0e0f08090a0bull, 0x0405060700010203ull);
+    __m128i m0, m1, m2, m3;
+
+    // the instructions want the state as ABEF and CDGH
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&s[0]), 0xB1);
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&s[4]), 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+    const __m128i abef = state0, cdgh = state1;
+
+    // Rounds 0-3
+    m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(chunk + 0)), MASK);
+    Quad(state0, state1, m0, _mm_set_epi64x(0xe9b5dba5b5c0fbcfull, 0x71374491428a2f98ull));
+
+    // Rounds 4-7
+    m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(chunk + 16)), MASK);
+    Quad(state0, state1, m1, _mm_set_epi64x(0xab1c5ed5923f82a4ull, 0x59f111f13956c25bull));
+    m0 = _mm_sha256msg1_epu32(m0, m1);
+
+    // Rounds 8-11
+    m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(chunk + 32)), MASK);
+    Quad(state0, state1, m2, _mm_set_epi64x(0x550c7dc3243185beull, 0x12835b01d807aa98ull));
+    m1 = _mm_sha256msg1_epu32(m1, m2);
+
+    // Rounds 12-15
+    m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(chunk + 48)), MASK);
+    Quad(state0, state1, m3, _mm_set_epi64x(0xc19bf1749bdc06a7ull, 0x80deb1fe72be5d74ull));
+    m0 = _mm_sha256msg2_epu32(_mm_add_epi32(m0, _mm_alignr_epi8(m3, m2, 4)), m3);
+    m2 = _mm_sha256msg1_epu32(m2, m3);
+
+    // Rounds 16-19
+    Quad(state0, state1, m0, _mm_set_epi64x(0x240ca1cc0fc19dc6ull, 0xefbe4786e49b69c1ull));
+    m1 = _mm_sha256msg2_epu32(_mm_add_epi32(m1, _mm_alignr_epi8(m0, m3, 4)), m0);
+    m3 = _mm_sha256msg1_epu32(m3, m0);
+
+    // Rounds 20-23
+    Quad(state0, state1, m1, _mm_set_epi64x(0x76f988da5cb0a9dcull, 0x4a7484aa2de92c6full));
+    m2 = _mm_sha256msg2_epu32(_mm_add_epi32(m2, _mm_alignr_epi8(m1, m0, 4)), m1);
+    m0 = _mm_sha256msg1_epu32(m0, m1);
+
+    // Rounds 24-27
+    Quad(state0, state1, m2, _mm_set_epi64x(0xbf597fc7b00327c8ull, 0xa831c66d983e5152ull));
+    m3 = _mm_sha256msg2_epu32(_mm_add_epi32(m3, _mm_alignr_epi8(m2, m1, 4)), m2);
+    m1 = _mm_sha256msg1_epu32(m1, m2);
+
+    // Rounds 28-31
+    Quad(state0, state1, m3, _mm_set_epi64x(0x1429296706ca6351ull, 0xd5a79147c6e00bf3ull));
+    m0 = _mm_sha256msg2_epu32(_mm_add_epi32(m0, _mm_alignr_epi8(m3, m2, 4)), m3);
+    m2 = _mm_sha256msg1_epu32(m2, m3);
+
+    // Rounds 32-35
+    Quad(state0, state1, m0, _mm_set_epi64x(0x53380d134d2c6dfcull, 0x2e1b213827b70a85ull));
+    m1 = _mm_sha256msg2_epu32(_mm_add_epi32(m1, _mm_alignr_epi8(m0, m3, 4)), m0);
+    m3 = _mm_sha256msg1_epu32(m3, m0);
+
+    // Rounds 36-39
+    Quad(state0, state1, m1, _mm_set_epi64x(0x92722c8581c2c92eull, 0x766a0abb650a7354ull));
+    m2 = _mm_sha256msg2_epu32(_mm_add_epi32(m2, _mm_alignr_epi8(m1, m0, 4)), m1);
+    m0 = _mm_sha256msg1_epu32(m0, m1);
+
+    // Rounds 40-43
+    Quad(state0, state1, m2, _mm_set_epi64x(0xc76c51a3c24b8b70ull, 0xa81a664ba2bfe8a1ull));
+    m3 = _mm_sha256msg2_epu32(_mm_add_epi32(m3, _mm_alignr_epi8(m2, m1, 4)), m2);
+    m1 = _mm_sha256msg1_epu32(m1, m2);
+
+    // Rounds 44-47
+    Quad(state0, state1, m3, _mm_set_epi64x(0x106aa070f40e3585ull, 0xd6990624d192e819ull));
+    m0 = _mm_sha256msg2_epu32(_mm_add_epi32(m0, _mm_alignr_epi8(m3, m2, 4)), m3);
+    m2 = _mm_sha256msg1_epu32(m2, m3);
+
+    // Rounds 48-51
+    Quad(state0, state1, m0, _mm_set_epi64x(0x34b0bcb52748774cull, 0x1e376c0819a4c116ull));
+    m1 = _mm_sha256msg2_epu32(_mm_add_epi32(m1, _mm_alignr_epi8(m0, m3, 4)), m0);
+    m3 = _mm_sha256msg1_epu32(m3, m0);
+
+    // Rounds 52-55
+    Quad(state0, state1, m1, _mm_set_epi64x(0x682e6ff35b9cca4full, 0x4ed8aa4a391c0cb3ull));
+    m2 = _mm_sha256msg2_epu32(_mm_add_epi32(m2, _mm_alignr_epi8(m1, m0, 4)), m1);
+
+    // Rounds 56-59
+    Quad(state0, state1, m2, _mm_set_epi64x(0x8cc7020884c87814ull, 0x78a5636f748f82eeull));
+    m3 = _mm_sha256msg2_epu32(_mm_add_epi32(m3, _mm_alignr_epi8(m2, m1, 4)), m2);
+
+    // Rounds 60-63
+    Quad(state0, state1, m3, _mm_set_epi64x(0xc67178f2bef9a3f7ull, 0xa4506ceb90befffaull));
+    state0 = _mm_add_epi32(state0, abef);
+    state1 = _mm_add_epi32(state1, cdgh);
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    _mm_storeu_si128((__m128i*)&s[0], _mm_blend_epi16(tmp, state1, 0xF0));
+    _mm_storeu_si128((__m128i*)&s[4], _mm_alignr_epi8(state1, tmp, 8));
+}
+
+SHA256_AVX2_TARGET inline __m256i K(uint32_t x) { return _mm256_set1_epi32(x); }
+SHA256_AVX2_TARGET inline __m256i Add(__m256i x, __m256i y) { return _mm256_add_epi32(x, y); }
+SHA256_AVX2_TARGET inline __m256i Add(__m256i x, __m256i y, __m256i z, __m256i w) { return Add(Add(x, y), Add(z, w)); }
+SHA256_AVX2_TARGET inline __m256i Xor(__m256i x, __m256i y, __m256i z) { return _mm256_xor_si256(_mm256_xor_si256(x, y), z); }
+SHA256_AVX2_TARGET inline __m256i Ror(__m256i x, int n) { return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n)); }
+
+SHA256_AVX2_TARGET inline __m256i Ch(__m256i x, __m256i y, __m256i z) { return _mm256_xor_si256(z, _mm256_and_si256(x, _mm256_xor_si256(y, z))); }
+SHA256_AVX2_TARGET inline __m256i Maj(__m256i x, __m256i y, __m256i z) { return _mm256_or_si256(_mm256_and_si256(x, y), _mm256_and_si256(z, _mm256_or_si256(x, y))); }
+SHA256_AVX2_TARGET inline __m256i Sigma0(__m256i x) { return Xor(Ror(x, 2), Ror(x, 13), Ror(x, 22)); }
+SHA256_AVX2_TARGET inline __m256i Sigma1(__m256i x) { return Xor(Ror(x, 6), Ror(x, 11), Ror(x, 25)); }
+SHA256_AVX2_TARGET inline __m256i sigma0(__m256i x) { return Xor(Ror(x, 7), Ror(x, 18), _mm256_srli_epi32(x, 3)); }
+SHA256_AVX2_TARGET inline __m256i sigma1(__m256i x) { return Xor(Ror(x, 17), Ror(x, 19), _mm256_srli_epi32(x, 10)); }
+
+SHA256_AVX2_TARGET inline void Round(__m256i a, __m256i b, __m256i c, __m256i& d, __m256i e, __m256i f, __m256i g, __m256i& h, __m256i k, __m256i w)
+{
+    __m256i t1 = Add(Add(h, Sigma1(e)), Add(Ch(e, f, g), Add(k, w)));
+    __m256i t2 = Add(Sigma0(a), Maj(a, b, c));
+    d = Add(d, t1);
+    h = Add(t1, t2);
+}
+
+/** Eight SHA-256 transformations at once, lane i of every word belongs to the i-th chunk. */
+SHA256_AVX2_TARGET void Transform8(__m256i* s, const __m256i* chunk)
+{
+    __m256i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+    __m256i w0, w1, w2, w3, w4, w5, w6, w7, w8, w9, w10, w11, w12, w13, w14, w15;
+
+    Round(a, b, c, d, e, f, g, h, K(0x428a2f98), w0 = chunk[0]);
+    Round(h, a, b, c, d, e, f, g, K(0x71374491), w1 = chunk[1]);
+    Round(g, h, a, b, c, d, e, f, K(0xb5c0fbcf), w2 = chunk[2]);
+    Round(f, g, h, a, b, c, d, e, K(0xe9b5dba5), w3 = chunk[3]);
+    Round(e, f, g, h, a, b, c, d, K(0x3956c25b), w4 = chunk[4]);
+    Round(d, e, f, g, h, a, b, c, K(0x59f111f1), w5 = chunk[5]);
+    Round(c, d, e, f, g, h, a, b, K(0x923f82a4), w6 = chunk[6]);
+    Round(b, c, d, e, f, g, h, a, K(0xab1c5ed5), w7 = chunk[7]);
+    Round(a, b, c, d, e, f, g, h, K(0xd807aa98), w8 = chunk[8]);
+    Round(h, a, b, c, d, e, f, g, K(0x12835b01), w9 = chunk[9]);
+    Round(g, h, a, b, c, d, e, f, K(0x243185be), w10 = chunk[10]);
+    Round(f, g, h, a, b, c, d, e, K(0x550c7dc3), w11 = chunk[11]);
+    Round(e, f, g, h, a, b, c, d, K(0x72be5d74), w12 = chunk[12]);
+    Round(d, e, f, g, h, a, b, c, K(0x80deb1fe), w13 = chunk[13]);
+    Round(c, d, e, f, g, h, a, b, K(0x9bdc06a7), w14 = chunk[14]);
+    Round(b, c, d, e, f, g, h, a, K(0xc19bf174), w15 = chunk[15]);
+
+    Round(a, b, c, d, e, f, g, h, K(0xe49b69c1), w0 = Add(w0, sigma1(w14), w9, sigma0(w1)));
+    Round(h, a, b, c, d, e, f, g, K(0xefbe4786), w1 = Add(w1, sigma1(w15), w10, sigma0(w2)));
+    Round(g, h, a, b, c, d, e, f, K(0x0fc19dc6), w2 = Add(w2, sigma1(w0), w11, sigma0(w3)));
+    Round(f, g, h, a, b, c, d, e, K(0x240ca1cc), w3 = Add(w3, sigma1(w1), w12, sigma0(w4)));
+    Round(e, f, g, h, a, b, c, d, K(0x2de92c6f), w4 = Add(w4, sigma1(w2), w13, sigma0(w5)));
+    Round(d, e, f, g, h, a, b, c, K(0x4a7484aa), w5 = Add(w5, sigma1(w3), w14, sigma0(w6)));
+    Round(c, d, e, f, g, h, a, b, K(0x5cb0a9dc), w6 = Add(w6, sigma1(w4), w15, sigma0(w7)));
+    Round(b, c, d, e, f, g, h, a, K(0x76f988da), w7 = Add(w7, sigma1(w5), w0, sigma0(w8)));
+    Round(a, b, c, d, e, f, g, h, K(0x983e5152), w8 = Add(w8, sigma1(w6), w1, sigma0(w9)));
+    Round(h, a, b, c, d, e, f, g, K(0xa831c66d), w9 = Add(w9, sigma1(w7), w2, sigma0(w10)));
+    Round(g, h, a, b, c, d, e, f, K(0xb00327c8), w10 = Add(w10, sigma1(w8), w3, sigma0(w11)));
+    Round(f, g, h, a, b, c, d, e, K(0xbf597fc7), w11 = Add(w11, sigma1(w9), w4, sigma0(w12)));
+    Round(e, f, g, h, a, b, c, d, K(0xc6e00bf3), w12 = Add(w12, sigma1(w10), w5, sigma0(w13)));
+    Round(d, e, f, g, h, a, b, c, K(0xd5a79147), w13 = Add(w13, sigma1(w11), w6, sigma0(w14)));
+    Round(c, d, e, f, g, h, a, b, K(0x06ca6351), w14 = Add(w14, sigma1(w12), w7, sigma0(w15)));
+    Round(b, c, d, e, f, g, h, a, K(0x14292967), w15 = Add(w15, sigma1(w13), w8, sigma0(w0)));
+
+    Round(a, b, c, d, e, f, g, h, K(0x27b70a85), w0 = Add(w0, sigma1(w14), w9, sigma0(w1)));
+    Round(h, a, b, c, d, e, f, g, K(0x2e1b2138), w1 = Add(w1, sigma1(w15), w10, sigma0(w2)));
+    Round(g, h, a, b, c, d, e, f, K(0x4d2c6dfc), w2 = Add(w2, sigma1(w0), w11, sigma0(w3)));
+    Round(f, g, h, a, b, c, d, e, K(0x53380d13), w3 = Add(w3, sigma1(w1), w12, sigma0(w4)));
+    Round(e, f, g, h, a, b, c, d, K(0x650a7354), w4 = Add(w4, sigma1(w2), w13, sigma0(w5)));
+    Round(d, e, f, g, h, a, b, c, K(0x766a0abb), w5 = Add(w5, sigma1(w3), w14, sigma0(w6)));
+    Round(c, d, e, f, g, h, a, b, K(0x81c2c92e), w6 = Add(w6, sigma1(w4), w15, sigma0(w7)));
+    Round(b, c, d, e, f, g, h, a, K(0x92722c85), w7 = Add(w7, sigma1(w5), w0, sigma0(w8)));
+    Round(a, b, c, d, e, f, g, h, K(0xa2bfe8a1), w8 = Add(w8, sigma1(w6), w1, sigma0(w9)));
+    Round(h, a, b, c, d, e, f, g, K(0xa81a664b), w9 = Add(w9, sigma1(w7), w2, sigma0(w10)));
+    Round(g, h, a, b, c, d, e, f, K(0xc24b8b70), w10 = Add(w10, sigma1(w8), w3, sigma0(w11)));
+    Round(f, g, h, a, b, c, d, e, K(0xc76c51a3), w11 = Add(w11, sigma1(w9), w4, sigma0(w12)));
+    Round(e, f, g, h, a, b, c, d, K(0xd192e819), w12 = Add(w12, sigma1(w10), w5, sigma0(w13)));
+    Round(d, e, f, g, h, a, b, c, K(0xd6990624), w13 = Add(w13, sigma1(w11), w6, sigma0(w14)));
+    Round(c, d, e, f, g, h, a, b, K(0xf40e3585), w14 = Add(w14, sigma1(w12), w7, sigma0(w15)));
+    Round(b, c, d, e, f, g, h, a, K(0x106aa070), w15 = Add(w15, sigma1(w13), w8, sigma0(w0)));
+
+    Round(a, b, c, d, e, f, g, h, K(0x19a4c116), w0 = Add(w0, sigma1(w14), w9, sigma0(w1)));
+    Round(h, a, b, c, d, e, f, g, K(0x1e376c08), w1 = Add(w1, sigma1(w15), w10, sigma0(w2)));
+    Round(g, h, a, b, c, d, e, f, K(0x2748774c), w2 = Add(w2, sigma1(w0), w11, sigma0(w3)));
+    Round(f, g, h, a, b, c, d, e, K(0x34b0bcb5), w3 = Add(w3, sigma1(w1), w12, sigma0(w4)));
+    Round(e, f, g, h, a, b, c, d, K(0x391c0cb3), w4 = Add(w4, sigma1(w2), w13, sigma0(w5)));
+    Round(d, e, f, g, h, a, b, c, K(0x4ed8aa4a), w5 = Add(w5, sigma1(w3), w14, sigma0(w6)));
+    Round(c, d, e, f, g, h, a, b, K(0x5b9cca4f), w6 = Add(w6, sigma1(w4), w15, sigma0(w7)));
+    Round(b, c, d, e, f, g, h, a, K(0x682e6ff3), w7 = Add(w7, sigma1(w5), w0, sigma0(w8)));
+    Round(a, b, c, d, e, f, g, h, K(0x748f82ee), w8 = Add(w8, sigma1(w6), w1, sigma0(w9)));
+    Round(h, a, b, c, d, e, f, g, K(0x78a5636f), w9 = Add(w9, sigma1(w7), w2, sigma0(w10)));
+    Round(g, h, a, b, c, d, e, f, K(0x84c87814), w10 = Add(w10, sigma1(w8), w3, sigma0(w11)));
+    Round(f, g, h, a, b, c, d, e, K(0x8cc70208), w11 = Add(w11, sigma1(w9), w4, sigma0(w12)));
+    Round(e, f, g, h, a, b, c, d, K(0x90befffa), w12 = Add(w12, sigma1(w10), w5, sigma0(w13)));
+    Round(d, e, f, g, h, a, b, c, K(0xa4506ceb), w13 = Add(w13, sigma1(w11), w6, sigma0(w14)));
+    Round(c, d, e, f, g, h, a, b, K(0xbef9a3f7), Add(w14, sigma1(w12), w7, sigma0(w15)));
+    Round(b, c, d, e, f, g, h, a, K(0xc67178f2), Add(w15, sigma1(w13), w8, sigma0(w0)));
+
+    s[0] = Add(s[0], a);
+    s[1] = Add(s[1], b);
+    s[2] = Add(s[2], c);
+    s[3] = Add(s[3], d);
+    s[4] = Add(s[4], e);
+    s[5] = Add(s[5], f);
+    s[6] = Add(s[6], g);
+    s[7] = Add(s[7], h);
+}
+
+} // namespace sha256_x86
+#endif // SHA256_USE_X86
 } // namespace
 
 
@@ -187,3 +432,147 @@ CSHA256& CSHA256::Reset()
     sha256::Initialize(s);
     return *this;
 }
+
+
+////// Double SHA-256 sweep
+
+namespace
+{
+typedef void (*TransformType)(uint32_t*, const unsigned char*);
+
+/** Fastest single block transformation on this CPU. */
+TransformType SelectTransform()
+{
+#ifdef SHA256_USE_X86
+    if (sha256_x86::HasSHANI())
+        return sha256_x86::TransformSHANI;
+#endif
+    return sha256::Transform;
+}
+
+/** Second SHA-256 of a 32 byte hash held in s, result in out. */
+void FinalizeDouble(const uint32_t* s, unsigned char* out, TransformType transform)
+{
+    unsigned char chunk[64] = {0};
+    for (int i = 0; i < 8; i++)
+        WriteBE32(chunk + 4 * i, s[i]);
+    chunk[32] = 0x80;
+    chunk[62] = 0x01; // 256 bits
+    uint32_t s2[8];
+    sha256::Initialize(s2);
+    transform(s2, chunk);
+    for (int i = 0; i < 8; i++)
+        WriteBE32(out + 4 * i, s2[i]);
+}
+
+#ifdef SHA256_USE_X86
+namespace sha256_x86
+{
+/**
+ * CSHA256DSweep::Finalize for the values in groups of eight with AVX2, returns how many values
+ * were hashed.
+ */
+SHA256_AVX2_TARGET size_t Finalize8(const uint32_t* s, const unsigned char* buf, size_t pos, const uint32_t* values, size_t count, unsigned char* out)
+{
+    // message words of the last block, the value only touches the words at pos / 4 and after
+    uint32_t words[16], iv[8];
+    for (int j = 0; j < 16; j++)
+        words[j] = ReadBE32(buf + 4 * j);
+    sha256::Initialize(iv);
+    const size_t first = pos / 4, last = (pos + 3) / 4;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8, out += 8 * CSHA256::OUTPUT_SIZE) {
+        uint32_t lo[8], hi[8];
+        for (int l = 0; l < 8; l++) {
+            unsigned char word[8];
+            memcpy(word, buf + 4 * first, 8);
+            WriteLE32(word + pos % 4, values[i + l]);
+            lo[l] = ReadBE32(word);
+            hi[l] = ReadBE32(word + 4);
+        }
+        __m256i state[8], chunk[16];
+        for (int j = 0; j < 16; j++)
+            chunk[j] = K(words[j]);
+        chunk[first] = _mm256_loadu_si256((const __m256i*)lo);
+        if (last != first)
+            chunk[last] = _mm256_loadu_si256((const __m256i*)hi);
+        for (int j = 0; j < 8; j++)
+            state[j] = K(s[j]);
+        Transform8(state, chunk);
+
+        // the inner hash already is the first half of the message words of the outer one
+        for (int j = 0; j < 8; j++)
+            chunk[j] = state[j];
+        chunk[8] = K(0x80000000ul);
+        for (int j = 9; j < 15; j++)
+            chunk[j] = K(0);
+        chunk[15] = K(256);
+        for (int j = 0; j < 8; j++)
+            state[j] = K(iv[j]);
+        Transform8(state, chunk);
+
+        for (int j = 0; j < 8; j++) {
+            uint32_t lanes[8];
+            _mm256_storeu_si256((__m256i*)lanes, state[j]);
+            for (int l = 0; l < 8; l++)
+                WriteBE32(out + l * CSHA256::OUTPUT_SIZE + 4 * j, lanes[l]);
+        }
+    }
+    return i;
+}
+} // namespace sha256_x86
+#endif
+} // namespace
+
+CSHA256DSweep::CSHA256DSweep(const unsigned char* prefix, size_t len) : pos(len % 64), fSingleBlock(len % 64 + 4 + 9 <= 64)
+{
+    static const TransformType transform = SelectTransform();
+    if (!fSingleBlock)
+        hasher.Write(prefix, len);
+    sha256::Initialize(s);
+    for (size_t i = 0; i + 64 <= len; i += 64)
+        transform(s, prefix + i);
+    memset(buf, 0, sizeof(buf));
+    if (fSingleBlock) {
+        memcpy(buf, prefix + len - pos, pos);
+        buf[pos + 4] = 0x80;
+        // written as the 32 bit words Transform reads them
+        WriteBE32(buf + 56, (uint32_t)(((uint64_t)(len + 4) << 3) >> 32));
+        WriteBE32(buf + 60, (uint32_t)((len + 4) << 3));
+    }
+}
+
+void CSHA256DSweep::Finalize(const uint32_t* values, size_t count, unsigned char* out) const
+{
+    if (!fSingleBlock) {
+        for (size_t i = 0; i < count; i++, out += OUTPUT_SIZE) {
+            unsigned char value[4];
+            WriteLE32(value, values[i]);
+            CSHA256 inner(hasher);
+            inner.Write(value, 4).Finalize(out);
+            CSHA256().Write(out, OUTPUT_SIZE).Finalize(out);
+        }
+        return;
+    }
+
+    // with the SHA extensions one value at a time is faster than eight with AVX2
+    static const TransformType transform = SelectTransform();
+    size_t i = 0;
+#ifdef SHA256_USE_X86
+    static const bool fAVX2 = transform == sha256::Transform && sha256_x86::HasAVX2();
+    if (fAVX2) {
+        i = sha256_x86::Finalize8(s, buf, pos, values, count, out);
+        out += i * OUTPUT_SIZE;
+    }
+#endif
+
+    unsigned char chunk[64];
+    memcpy(chunk, buf, sizeof(chunk));
+    for (; i < count; i++, out += OUTPUT_SIZE) {
+        uint32_t inner[8];
+        memcpy(inner, s, sizeof(inner));
+        WriteLE32(chunk + pos, values[i]);
+        transform(inner, chunk);
+        FinalizeDouble(inner, out, transform);
+    }
+}
@@ -25,4 +25,27 @@ public:
     CSHA256& Reset();
 };
 
+/**
+ * Double SHA-256 of a fixed prefix followed by a 4 byte little endian value, for many values at
+ * once, like a serialized kernel tried with a range of timestamps. The full blocks of the prefix
+ * are hashed once, after that every value takes two transformations: with the SHA extensions one
+ * value at a time, with AVX2 eight at a time.
+ */
+class CSHA256DSweep
+{
+private:
+    uint32_t s[8];          //!< state after the full blocks of the prefix
+    unsigned char buf[64];  //!< last block, with the rest of the prefix and the padding
+    size_t pos;             //!< offset of the value in buf
+    CSHA256 hasher;         //!< for prefixes that leave no room for the value and padding in buf
+    bool fSingleBlock;
+
+public:
+    static const size_t OUTPUT_SIZE = CSHA256::OUTPUT_SIZE;
+
+    CSHA256DSweep(const unsigned char* prefix, size_t len);
+    /** out + i * OUTPUT_SIZE receives the double SHA-256 of prefix followed by values[i] */
+    void Finalize(const uint32_t* values, size_t count, unsigned char* out) const;
+};
+
 #endif // BITCOIN_CRYPTO_SHA256_H
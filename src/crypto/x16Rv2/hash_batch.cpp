@@ -0,0 +1,658 @@
+// Copyright (c) 2020 The ShroudX Project developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "hash_batch.h"
+#include "hash_algos.h"
+
+#include "crypto/common.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define X16RV2_USE_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+/** Headers kept in flight, enough for every algorithm of a round to get a few lanes */
+const size_t MAX_CHUNK = 64;
+
+enum {
+    ALGO_BLAKE = 0,
+    ALGO_KECCAK = 4,
+    ALGO_SKEIN = 5,
+    ALGO_CUBEHASH = 7,
+    ALGO_COUNT = 16
+};
+
+/** One X16Rv2 round of a single header, the body of the switch in HashX16RV2 */
+void HashStep(int algo, const void* in, size_t len, uint512& out)
+{
+    // tiger only writes the first 24 bytes and the following hash reads all 64
+    uint512 tiger;
+
+    switch (algo) {
+        case 0: {
+            sph_blake512_context ctx;
+            sph_blake512_init(&ctx);
+            sph_blake512(&ctx, in, len);
+            sph_blake512_close(&ctx, out.begin());
+            break;
+        }
+        case 1: {
+            sph_bmw512_context ctx;
+            sph_bmw512_init(&ctx);
+            sph_bmw512(&ctx, in, len);
+            sph_bmw512_close(&ctx, out.begin());
+            break;
+        }
+        case 2: {
+            sph_groestl512_context ctx;
+            sph_groestl512_init(&ctx);
+            sph_groestl512(&ctx, in, len);
+            sph_groestl512_close(&ctx, out.begin());
+            break;
+        }
+        case 3: {
+            sph_jh512_context ctx;
+            sph_jh512_init(&ctx);
+            sph_jh512(&ctx, in, len);
+            sph_jh512_close(&ctx, out.begin());
+            break;
+        }
+        case 4: {
+            sph_tiger_context ctx_tiger;
+            sph_tiger_init(&ctx_tiger);
+            sph_tiger(&ctx_tiger, in, len);
+            sph_tiger_close(&ctx_tiger, tiger.begin());
+
+            sph_keccak512_context ctx;
+            sph_keccak512_init(&ctx);
+            sph_keccak512(&ctx, tiger.begin(), 64);
+            sph_keccak512_close(&ctx, out.begin());
+            break;
+        }
+        case 5: {
+            sph_skein512_context ctx;
+            sph_skein512_init(&ctx);
+            sph_skein512(&ctx, in, len);
+            sph_skein512_close(&ctx, out.begin());
+            break;
+        }
+        case 6: {
+            sph_tiger_context ctx_tiger;
+            sph_tiger_init(&ctx_tiger);
+            sph_tiger(&ctx_tiger, in, len);
+            sph_tiger_close(&ctx_tiger, tiger.begin());
+
+            sph_luffa512_context ctx;
+            sph_luffa512_init(&ctx);
+            sph_luffa512(&ctx, tiger.begin(), 64);
+            sph_luffa512_close(&ctx, out.begin());
+            break;
+        }
+        case 7: {
+            sph_cubehash512_context ctx;
+            sph_cubehash512_init(&ctx);
+            sph_cubehash512(&ctx, in, len);
+            sph_cubehash512_close(&ctx, out.begin());
+            break;
+        }
+        case 8: {
+            sph_shavite512_context ctx;
+            sph_shavite512_init(&ctx);
+            sph_shavite512(&ctx, in, len);
+            sph_shavite512_close(&ctx, out.begin());
+            break;
+        }
+        case 9: {
+            sph_simd512_context ctx;
+            sph_simd512_init(&ctx);
+            sph_simd512(&ctx, in, len);
+            sph_simd512_close(&ctx, out.begin());
+            break;
+        }
+        case 10: {
+            sph_echo512_context ctx;
+            sph_echo512_init(&ctx);
+            sph_echo512(&ctx, in, len);
+            sph_echo512_close(&ctx, out.begin());
+            break;
+        }
+        case 11: {
+            sph_hamsi512_context ctx;
+            sph_hamsi512_init(&ctx);
+            sph_hamsi512(&ctx, in, len);
+            sph_hamsi512_close(&ctx, out.begin());
+            break;
+        }
+        case 12: {
+            sph_fugue512_context ctx;
+            sph_fugue512_init(&ctx);
+            sph_fugue512(&ctx, in, len);
+            sph_fugue512_close(&ctx, out.begin());
+            break;
+        }
+        case 13: {
+            sph_shabal512_context ctx;
+            sph_shabal512_init(&ctx);
+            sph_shabal512(&ctx, in, len);
+            sph_shabal512_close(&ctx, out.begin());
+            break;
+        }
+        case 14: {
+            sph_whirlpool_context ctx;
+            sph_whirlpool_init(&ctx);
+            sph_whirlpool(&ctx, in, len);
+            sph_whirlpool_close(&ctx, out.begin());
+            break;
+        }
+        case 15: {
+            sph_tiger_context ctx_tiger;
+            sph_tiger_init(&ctx_tiger);
+            sph_tiger(&ctx_tiger, in, len);
+            sph_tiger_close(&ctx_tiger, tiger.begin());
+
+            sph_sha512_context ctx;
+            sph_sha512_init(&ctx);
+            sph_sha512(&ctx, tiger.begin(), 64);
+            sph_sha512_close(&ctx, out.begin());
+            break;
+        }
+    }
+}
+
+#ifdef X16RV2_USE_AVX2
+
+/**
+ * AVX2 versions of the functions where it pays off. The 64 bit ARX ones hash four inputs at once,
+ * lane i of every vector belongs to the i-th input. They only handle the X16Rv2 input sizes: a
+ * 64 byte hash or an 80 byte header. Built with function target attributes, so the rest of the
+ * tree doesn't need -mavx2, and only called after checking the CPU at runtime.
+ */
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+bool HaveAVX2()
+{
+    static const bool fAVX2 = __builtin_cpu_supports("avx2");
+    return fAVX2;
+}
+
+AVX2_TARGET inline __m256i Rotl64x4(__m256i x, int n)
+{
+    return _mm256_or_si256(_mm256_slli_epi64(x, n), _mm256_srli_epi64(x, 64 - n));
+}
+
+AVX2_TARGET inline __m256i Rotr64x4(__m256i x, int n)
+{
+    return _mm256_or_si256(_mm256_srli_epi64(x, n), _mm256_slli_epi64(x, 64 - n));
+}
+
+AVX2_TARGET inline __m256i Set64x4(const uint64_t words[4][16], int i)
+{
+    return _mm256_set_epi64x(words[3][i], words[2][i], words[1][i], words[0][i]);
+}
+
+AVX2_TARGET inline void Get64x4(__m256i x, uint64_t lanes[4])
+{
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), x);
+}
+
+const uint64_t BLAKE512_IV[8] = {
+    0x6A09E667F3BCC908ULL, 0xBB67AE8584CAA73BULL, 0x3C6EF372FE94F82BULL, 0xA54FF53A5F1D36F1ULL,
+    0x510E527FADE682D1ULL, 0x9B05688C2B3E6C1FULL, 0x1F83D9ABFB41BD6BULL, 0x5BE0CD19137E2179ULL
+};
+
+const uint64_t BLAKE512_CB[16] = {
+    0x243F6A8885A308D3ULL, 0x13198A2E03707344ULL, 0xA4093822299F31D0ULL, 0x082EFA98EC4E6C89ULL,
+    0x452821E638D01377ULL, 0xBE5466CF34E90C6CULL, 0xC0AC29B7C97C50DDULL, 0x3F84D5B5B5470917ULL,
+    0x9216D5D98979FB1BULL, 0xD1310BA698DFB5ACULL, 0x2FFD72DBD01ADFB7ULL, 0xB8E1AFED6A267E96ULL,
+    0xBA7C9045F12C7F99ULL, 0x24A19947B3916CF7ULL, 0x0801F2E2858EFC16ULL, 0x636920D871574E69ULL
+};
+
+const unsigned char BLAKE_SIGMA[10][16] = {
+    {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+    { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+    { 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+    {  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+    {  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+    {  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+    { 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+    { 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+    {  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+    { 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 }
+};
+
+AVX2_TARGET inline void BlakeG(const __m256i* m, const unsigned char* s, int i,
+        __m256i& a, __m256i& b, __m256i& c, __m256i& d)
+{
+    const __m256i m0c1 = _mm256_xor_si256(m[s[2 * i]], _mm256_set1_epi64x(BLAKE512_CB[s[2 * i + 1]]));
+    const __m256i m1c0 = _mm256_xor_si256(m[s[2 * i + 1]], _mm256_set1_epi64x(BLAKE512_CB[s[2 * i]]));
+    a = _mm256_add_epi64(_mm256_add_epi64(a, b), m0c1);
+    d = Rotr64x4(_mm256_xor_si256(d, a), 32);
+    c = _mm256_add_epi64(c, d);
+    b = Rotr64x4(_mm256_xor_si256(b, c), 25);
+    a = _mm256_add_epi64(_mm256_add_epi64(a, b), m1c0);
+    d = Rotr64x4(_mm256_xor_si256(d, a), 16);
+    c = _mm256_add_epi64(c, d);
+    b = Rotr64x4(_mm256_xor_si256(b, c), 11);
+}
+
+/** BLAKE-512 with 16 rounds, the message and its padding fit a single block */
+AVX2_TARGET void Blake512x4(const unsigned char* const in[4], size_t len, unsigned char* const out[4])
+{
+    uint64_t words[4][16];
+    for (int lane = 0; lane < 4; lane++) {
+        unsigned char block[128] = {0};
+        memcpy(block, in[lane], len);
+        block[len] = 0x80;
+        block[111] |= 1;
+        WriteBE64(block + 120, len << 3);
+        for (int i = 0; i < 16; i++)
+            words[lane][i] = ReadBE64(block + 8 * i);
+    }
+
+    __m256i m[16];
+    for (int i = 0; i < 16; i++)
+        m[i] = Set64x4(words, i);
+
+    __m256i v[16];
+    for (int i = 0; i < 8; i++)
+        v[i] = _mm256_set1_epi64x(BLAKE512_IV[i]);
+    for (int i = 0; i < 4; i++)
+        v[8 + i] = _mm256_set1_epi64x(BLAKE512_CB[i]);
+    v[12] = _mm256_set1_epi64x((len << 3) ^ BLAKE512_CB[4]);
+    v[13] = _mm256_set1_epi64x((len << 3) ^ BLAKE512_CB[5]);
+    v[14] = _mm256_set1_epi64x(BLAKE512_CB[6]);
+    v[15] = _mm256_set1_epi64x(BLAKE512_CB[7]);
+
+    for (int r = 0; r < 16; r++) {
+        const unsigned char* s = BLAKE_SIGMA[r % 10];
+        BlakeG(m, s, 0, v[0], v[4], v[8], v[12]);
+        BlakeG(m, s, 1, v[1], v[5], v[9], v[13]);
+        BlakeG(m, s, 2, v[2], v[6], v[10], v[14]);
+        BlakeG(m, s, 3, v[3], v[7], v[11], v[15]);
+        BlakeG(m, s, 4, v[0], v[5], v[10], v[15]);
+        BlakeG(m, s, 5, v[1], v[6], v[11], v[12]);
+        BlakeG(m, s, 6, v[2], v[7], v[8], v[13]);
+        BlakeG(m, s, 7, v[3], v[4], v[9], v[14]);
+    }
+
+    for (int i = 0; i < 8; i++) {
+        uint64_t h[4];
+        Get64x4(_mm256_xor_si256(_mm256_set1_epi64x(BLAKE512_IV[i]), _mm256_xor_si256(v[i], v[i + 8])), h);
+        for (int lane = 0; lane < 4; lane++)
+            WriteBE64(out[lane] + 8 * i, h[lane]);
+    }
+}
+
+const uint64_t KECCAK_RC[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808AULL, 0x8000000080008000ULL,
+    0x000000000000808BULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x000000000000008AULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000AULL,
+    0x000000008000808BULL, 0x800000000000008BULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800AULL, 0x800000008000000AULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+/** One Keccak-f[1600] round, lane (x, y) of the state is a[x + 5 * y] */
+AVX2_TARGET inline void KeccakRound(__m256i a[25], uint64_t rc)
+{
+    const __m256i c0 = _mm256_xor_si256(_mm256_xor_si256(_mm256_xor_si256(a[0], a[5]), _mm256_xor_si256(a[10], a[15])), a[20]);
+    const __m256i c1 = _mm256_xor_si256(_mm256_xor_si256(_mm256_xor_si256(a[1], a[6]), _mm256_xor_si256(a[11], a[16])), a[21]);
+    const __m256i c2 = _mm256_xor_si256(_mm256_xor_si256(_mm256_xor_si256(a[2], a[7]), _mm256_xor_si256(a[12], a[17])), a[22]);
+    const __m256i c3 = _mm256_xor_si256(_mm256_xor_si256(_mm256_xor_si256(a[3], a[8]), _mm256_xor_si256(a[13], a[18])), a[23]);
+    const __m256i c4 = _mm256_xor_si256(_mm256_xor_si256(_mm256_xor_si256(a[4], a[9]), _mm256_xor_si256(a[14], a[19])), a[24]);
+    const __m256i d0 = _mm256_xor_si256(c4, Rotl64x4(c1, 1));
+    const __m256i d1 = _mm256_xor_si256(c0, Rotl64x4(c2, 1));
+    const __m256i d2 = _mm256_xor_si256(c1, Rotl64x4(c3, 1));
+    const __m256i d3 = _mm256_xor_si256(c2, Rotl64x4(c4, 1));
+    const __m256i d4 = _mm256_xor_si256(c3, Rotl64x4(c0, 1));
+
+    // theta, rho and pi
+    __m256i b[25];
+    b[0] = _mm256_xor_si256(a[0], d0);
+    b[10] = Rotl64x4(_mm256_xor_si256(a[1], d1), 1);
+    b[20] = Rotl64x4(_mm256_xor_si256(a[2], d2), 62);
+    b[5] = Rotl64x4(_mm256_xor_si256(a[3], d3), 28);
+    b[15] = Rotl64x4(_mm256_xor_si256(a[4], d4), 27);
+    b[16] = Rotl64x4(_mm256_xor_si256(a[5], d0), 36);
+    b[1] = Rotl64x4(_mm256_xor_si256(a[6], d1), 44);
+    b[11] = Rotl64x4(_mm256_xor_si256(a[7], d2), 6);
+    b[21] = Rotl64x4(_mm256_xor_si256(a[8], d3), 55);
+    b[6] = Rotl64x4(_mm256_xor_si256(a[9], d4), 20);
+    b[7] = Rotl64x4(_mm256_xor_si256(a[10], d0), 3);
+    b[17] = Rotl64x4(_mm256_xor_si256(a[11], d1), 10);
+    b[2] = Rotl64x4(_mm256_xor_si256(a[12], d2), 43);
+    b[12] = Rotl64x4(_mm256_xor_si256(a[13], d3), 25);
+    b[22] = Rotl64x4(_mm256_xor_si256(a[14], d4), 39);
+    b[23] = Rotl64x4(_mm256_xor_si256(a[15], d0), 41);
+    b[8] = Rotl64x4(_mm256_xor_si256(a[16], d1), 45);
+    b[18] = Rotl64x4(_mm256_xor_si256(a[17], d2), 15);
+    b[3] = Rotl64x4(_mm256_xor_si256(a[18], d3), 21);
+    b[13] = Rotl64x4(_mm256_xor_si256(a[19], d4), 8);
+    b[14] = Rotl64x4(_mm256_xor_si256(a[20], d0), 18);
+    b[24] = Rotl64x4(_mm256_xor_si256(a[21], d1), 2);
+    b[9] = Rotl64x4(_mm256_xor_si256(a[22], d2), 61);
+    b[19] = Rotl64x4(_mm256_xor_si256(a[23], d3), 56);
+    b[4] = Rotl64x4(_mm256_xor_si256(a[24], d4), 14);
+
+    // chi and iota
+    a[0] = _mm256_xor_si256(b[0], _mm256_andnot_si256(b[1], b[2]));
+    a[1] = _mm256_xor_si256(b[1], _mm256_andnot_si256(b[2], b[3]));
+    a[2] = _mm256_xor_si256(b[2], _mm256_andnot_si256(b[3], b[4]));
+    a[3] = _mm256_xor_si256(b[3], _mm256_andnot_si256(b[4], b[0]));
+    a[4] = _mm256_xor_si256(b[4], _mm256_andnot_si256(b[0], b[1]));
+    a[5] = _mm256_xor_si256(b[5], _mm256_andnot_si256(b[6], b[7]));
+    a[6] = _mm256_xor_si256(b[6], _mm256_andnot_si256(b[7], b[8]));
+    a[7] = _mm256_xor_si256(b[7], _mm256_andnot_si256(b[8], b[9]));
+    a[8] = _mm256_xor_si256(b[8], _mm256_andnot_si256(b[9], b[5]));
+    a[9] = _mm256_xor_si256(b[9], _mm256_andnot_si256(b[5], b[6]));
+    a[10] = _mm256_xor_si256(b[10], _mm256_andnot_si256(b[11], b[12]));
+    a[11] = _mm256_xor_si256(b[11], _mm256_andnot_si256(b[12], b[13]));
+    a[12] = _mm256_xor_si256(b[12], _mm256_andnot_si256(b[13], b[14]));
+    a[13] = _mm256_xor_si256(b[13], _mm256_andnot_si256(b[14], b[10]));
+    a[14] = _mm256_xor_si256(b[14], _mm256_andnot_si256(b[10], b[11]));
+    a[15] = _mm256_xor_si256(b[15], _mm256_andnot_si256(b[16], b[17]));
+    a[16] = _mm256_xor_si256(b[16], _mm256_andnot_si256(b[17], b[18]));
+    a[17] = _mm256_xor_si256(b[17], _mm256_andnot_si256(b[18], b[19]));
+    a[18] = _mm256_xor_si256(b[18], _mm256_andnot_si256(b[19], b[15]));
+    a[19] = _mm256_xor_si256(b[19], _mm256_andnot_si256(b[15], b[16]));
+    a[20] = _mm256_xor_si256(b[20], _mm256_andnot_si256(b[21], b[22]));
+    a[21] = _mm256_xor_si256(b[21], _mm256_andnot_si256(b[22], b[23]));
+    a[22] = _mm256_xor_si256(b[22], _mm256_andnot_si256(b[23], b[24]));
+    a[23] = _mm256_xor_si256(b[23], _mm256_andnot_si256(b[24], b[20]));
+    a[24] = _mm256_xor_si256(b[24], _mm256_andnot_si256(b[20], b[21]));
+    a[0] = _mm256_xor_si256(a[0], _mm256_set1_epi64x(rc));
+}
+
+/** Keccak-512 (the original padding, not SHA-3) of a 64 byte message, which fits the 72 byte rate */
+AVX2_TARGET void Keccak512x4(const unsigned char* const in[4], unsigned char* const out[4])
+{
+    uint64_t words[4][16];
+    for (int lane = 0; lane < 4; lane++)
+        for (int i = 0; i < 8; i++)
+            words[lane][i] = ReadLE64(in[lane] + 8 * i);
+
+    __m256i a[25];
+    for (int i = 0; i < 8; i++)
+        a[i] = Set64x4(words, i);
+    a[8] = _mm256_set1_epi64x(0x8000000000000001ULL);
+    for (int i = 9; i < 25; i++)
+        a[i] = _mm256_setzero_si256();
+
+    for (int r = 0; r < 24; r++)
+        KeccakRound(a, KECCAK_RC[r]);
+
+    for (int i = 0; i < 8; i++) {
+        uint64_t h[4];
+        Get64x4(a[i], h);
+        for (int lane = 0; lane < 4; lane++)
+            WriteLE64(out[lane] + 8 * i, h[lane]);
+    }
+}
+
+const uint64_t SKEIN512_IV[8] = {
+    0x4903ADFF749C51CEULL, 0x0D95DE399746DF03ULL, 0x8FD1934127C79BCEULL, 0x9A255629FF352CB1ULL,
+    0x5DB62599DF6CA7B0ULL, 0xEABE394CA9D5C3F4ULL, 0x991112C71A75B523ULL, 0xAE18A40B660FCC33ULL
+};
+
+// Tweak words of the UBI blocks: first, final and type bits, the position is in the other word
+const uint64_t SKEIN_MSG_FIRST = 0x7000000000000000ULL;
+const uint64_t SKEIN_MSG_FINAL = 0xB000000000000000ULL;
+const uint64_t SKEIN_MSG_ONLY = 0xF000000000000000ULL;
+const uint64_t SKEIN_OUT = 0xFF00000000000000ULL;
+
+#define SKEIN_MIX(x0, x1, rc)   do { \
+        x0 = _mm256_add_epi64(x0, x1); \
+        x1 = _mm256_xor_si256(Rotl64x4(x1, rc), x0); \
+    } while (0)
+
+#define SKEIN_MIX8(w0, w1, w2, w3, w4, w5, w6, w7, rc0, rc1, rc2, rc3)   do { \
+        SKEIN_MIX(p[w0], p[w1], rc0); \
+        SKEIN_MIX(p[w2], p[w3], rc1); \
+        SKEIN_MIX(p[w4], p[w5], rc2); \
+        SKEIN_MIX(p[w6], p[w7], rc3); \
+    } while (0)
+
+/** Adds the subkey s to p */
+AVX2_TARGET inline void SkeinInject(__m256i p[8], const __m256i k[9], const uint64_t t[3], int s)
+{
+    for (int i = 0; i < 8; i++)
+        p[i] = _mm256_add_epi64(p[i], k[(s + i) % 9]);
+    p[5] = _mm256_add_epi64(p[5], _mm256_set1_epi64x(t[s % 3]));
+    p[6] = _mm256_add_epi64(p[6], _mm256_set1_epi64x(t[(s + 1) % 3]));
+    p[7] = _mm256_add_epi64(p[7], _mm256_set1_epi64x(s));
+}
+
+/** One UBI block: h = Threefish-512 of m keyed by h with tweak (t0, t1), xored with m */
+AVX2_TARGET void SkeinUBI(__m256i h[8], const __m256i m[8], uint64_t t0, uint64_t t1)
+{
+    __m256i k[9];
+    k[8] = _mm256_set1_epi64x(0x1BD11BDAA9FC1A22ULL);
+    for (int i = 0; i < 8; i++) {
+        k[i] = h[i];
+        k[8] = _mm256_xor_si256(k[8], h[i]);
+    }
+    const uint64_t t[3] = { t0, t1, t0 ^ t1 };
+
+    __m256i p[8];
+    for (int i = 0; i < 8; i++)
+        p[i] = m[i];
+
+    for (int s = 0; s < 18; s += 2) {
+        SkeinInject(p, k, t, s);
+        SKEIN_MIX8(0, 1, 2, 3, 4, 5, 6, 7, 46, 36, 19, 37);
+        SKEIN_MIX8(2, 1, 4, 7, 6, 5, 0, 3, 33, 27, 14, 42);
+        SKEIN_MIX8(4, 1, 6, 3, 0, 5, 2, 7, 17, 49, 36, 39);
+        SKEIN_MIX8(6, 1, 0, 7, 2, 5, 4, 3, 44,  9, 54, 56);
+        SkeinInject(p, k, t, s + 1);
+        SKEIN_MIX8(0, 1, 2, 3, 4, 5, 6, 7, 39, 30, 34, 24);
+        SKEIN_MIX8(2, 1, 4, 7, 6, 5, 0, 3, 13, 50, 10, 17);
+        SKEIN_MIX8(4, 1, 6, 3, 0, 5, 2, 7, 25, 29, 39, 43);
+        SKEIN_MIX8(6, 1, 0, 7, 2, 5, 4, 3,  8, 35, 56, 22);
+    }
+    SkeinInject(p, k, t, 18);
+
+    for (int i = 0; i < 8; i++)
+        h[i] = _mm256_xor_si256(m[i], p[i]);
+}
+
+/** Skein-512-512 of a 64 or 80 byte message */
+AVX2_TARGET void Skein512x4(const unsigned char* const in[4], size_t len, unsigned char* const out[4])
+{
+    uint64_t words[4][16];
+    for (int lane = 0; lane < 4; lane++) {
+        unsigned char block[128] = {0};
+        memcpy(block, in[lane], len);
+        for (int i = 0; i < 16; i++)
+            words[lane][i] = ReadLE64(block + 8 * i);
+    }
+
+    __m256i h[8], m[8];
+    for (int i = 0; i < 8; i++) {
+        h[i] = _mm256_set1_epi64x(SKEIN512_IV[i]);
+        m[i] = Set64x4(words, i);
+    }
+    if (len <= 64) {
+        SkeinUBI(h, m, len, SKEIN_MSG_ONLY);
+    } else {
+        SkeinUBI(h, m, 64, SKEIN_MSG_FIRST);
+        for (int i = 0; i < 8; i++)
+            m[i] = Set64x4(words, 8 + i);
+        SkeinUBI(h, m, len, SKEIN_MSG_FINAL);
+    }
+
+    for (int i = 0; i < 8; i++)
+        m[i] = _mm256_setzero_si256();
+    SkeinUBI(h, m, 8, SKEIN_OUT);
+
+    for (int i = 0; i < 8; i++) {
+        uint64_t lanes[4];
+        Get64x4(h[i], lanes);
+        for (int lane = 0; lane < 4; lane++)
+            WriteLE64(out[lane] + 8 * i, lanes[lane]);
+    }
+}
+
+const uint32_t CUBEHASH512_IV[32] = {
+    0x2AEA2A61, 0x50F494D4, 0x2D538B8B, 0x4167D83E, 0x3FEE2313, 0xC701CF8C, 0xCC39968E, 0x50AC5695,
+    0x4D42C787, 0xA647A8B3, 0x97CF0BEF, 0x825B4537, 0xEEF864D2, 0xF22090C4, 0xD0E5CD33, 0xA23911AE,
+    0xFCD398D9, 0x148FE485, 0x1B017BEF, 0xB6444532, 0x6A536159, 0x2FF5781C, 0x91FA7934, 0x0DBADEA9,
+    0xD65C8A2B, 0xA5A70E75, 0xB1C62456, 0xBC796576, 0x1921C8F7, 0xE7989AF1, 0x7795D246, 0xD43E3B44
+};
+
+AVX2_TARGET inline __m256i Rotl32x8(__m256i x, int n)
+{
+    return _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - n));
+}
+
+/** One CubeHash round, the state words 0-7, 8-15, 16-23 and 24-31 are in a, b, c and d */
+AVX2_TARGET inline void CubehashRound(__m256i& a, __m256i& b, __m256i& c, __m256i& d)
+{
+    c = _mm256_add_epi32(c, a);
+    d = _mm256_add_epi32(d, b);
+    // rotate and swap x[0..7] with x[8..15]
+    __m256i t = Rotl32x8(a, 7);
+    a = Rotl32x8(b, 7);
+    b = t;
+    a = _mm256_xor_si256(a, c);
+    b = _mm256_xor_si256(b, d);
+    c = _mm256_shuffle_epi32(c, 0x4E);
+    d = _mm256_shuffle_epi32(d, 0x4E);
+
+    c = _mm256_add_epi32(c, a);
+    d = _mm256_add_epi32(d, b);
+    a = _mm256_permute4x64_epi64(Rotl32x8(a, 11), 0x4E);
+    b = _mm256_permute4x64_epi64(Rotl32x8(b, 11), 0x4E);
+    a = _mm256_xor_si256(a, c);
+    b = _mm256_xor_si256(b, d);
+    c = _mm256_shuffle_epi32(c, 0xB1);
+    d = _mm256_shuffle_epi32(d, 0xB1);
+}
+
+/**
+ * CubeHash16/32-512 of a 64 or 80 byte message. CubeHash is 32 bit ARX on a 1024 bit state, so
+ * a single message fills four vectors and needs no lanes.
+ */
+AVX2_TARGET void Cubehash512(const unsigned char* in, size_t len, unsigned char* out)
+{
+    unsigned char blocks[96] = {0};
+    memcpy(blocks, in, len);
+    blocks[len] = 0x80;
+
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(CUBEHASH512_IV));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(CUBEHASH512_IV + 8));
+    __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(CUBEHASH512_IV + 16));
+    __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(CUBEHASH512_IV + 24));
+
+    // inputs of 64 and 80 bytes both pad to three 32 byte blocks
+    for (size_t pos = 0; pos < sizeof(blocks); pos += 32) {
+        a = _mm256_xor_si256(a, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(blocks + pos)));
+        for (int r = 0; r < 16; r++)
+            CubehashRound(a, b, c, d);
+    }
+
+    d = _mm256_xor_si256(d, _mm256_set_epi32(1, 0, 0, 0, 0, 0, 0, 0));
+    for (int r = 0; r < 160; r++)
+        CubehashRound(a, b, c, d);
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), a);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 32), b);
+}
+
+/** Hashes up to four inputs with a vectorized function, unused lanes repeat the first input */
+void HashStepx4(int algo, const void* const in[], size_t len, uint512* const out[], size_t count)
+{
+    const unsigned char* lanesIn[4];
+    unsigned char* lanesOut[4];
+    uint512 tiger[4], unused[4];
+    for (size_t lane = 0; lane < 4; lane++) {
+        const size_t i = lane < count ? lane : 0;
+        lanesIn[lane] = static_cast<const unsigned char*>(in[i]);
+        lanesOut[lane] = lane < count ? out[lane]->begin() : unused[lane].begin();
+    }
+
+    switch (algo) {
+        case ALGO_BLAKE:
+            Blake512x4(lanesIn, len, lanesOut);
+            break;
+        case ALGO_KECCAK:
+            for (size_t lane = 0; lane < 4; lane++) {
+                sph_tiger_context ctx_tiger;
+                sph_tiger_init(&ctx_tiger);
+                sph_tiger(&ctx_tiger, lanesIn[lane], len);
+                sph_tiger_close(&ctx_tiger, tiger[lane].begin());
+                lanesIn[lane] = tiger[lane].begin();
+            }
+            Keccak512x4(lanesIn, lanesOut);
+            break;
+        case ALGO_SKEIN:
+            Skein512x4(lanesIn, len, lanesOut);
+            break;
+    }
+}
+
+#endif // X16RV2_USE_AVX2
+
+/** Runs one round for the lanes that selected algo */
+void HashLanes(int algo, const void* const in[], size_t len, uint512* const out[], size_t count)
+{
+#ifdef X16RV2_USE_AVX2
+    if (count > 1 && (algo == ALGO_BLAKE || algo == ALGO_KECCAK || algo == ALGO_SKEIN) && HaveAVX2()) {
+        for (size_t i = 0; i < count; i += 4)
+            HashStepx4(algo, in + i, len, out + i, std::min<size_t>(count - i, 4));
+        return;
+    }
+    if (algo == ALGO_CUBEHASH && HaveAVX2()) {
+        for (size_t i = 0; i < count; i++)
+            Cubehash512(static_cast<const unsigned char*>(in[i]), len, out[i]->begin());
+        return;
+    }
+#endif
+    for (size_t i = 0; i < count; i++)
+        HashStep(algo, in[i], len, *out[i]);
+}
+
+void HashChunk(const unsigned char* const headers[], size_t count, uint256 out[])
+{
+    uint256 prevBlockHashes[MAX_CHUNK];
+    uint512 hashes[2][MAX_CHUNK];
+    for (size_t i = 0; i < count; i++)
+        memcpy(prevBlockHashes[i].begin(), headers[i] + 4, 32);
+
+    for (int round = 0; round < 16; round++) {
+        uint512* roundOut = hashes[round & 1];
+        const uint512* roundIn = hashes[(round + 1) & 1];
+        const size_t len = round == 0 ? X16RV2_HEADER_SIZE : 64;
+
+        const void* lanesIn[ALGO_COUNT][MAX_CHUNK];
+        uint512* lanesOut[ALGO_COUNT][MAX_CHUNK];
+        size_t lanes[ALGO_COUNT] = {0};
+        for (size_t i = 0; i < count; i++) {
+            const int algo = GetHashSelection(prevBlockHashes[i], round);
+            lanesIn[algo][lanes[algo]] = round == 0 ? static_cast<const void*>(headers[i]) : roundIn[i].begin();
+            lanesOut[algo][lanes[algo]] = &roundOut[i];
+            lanes[algo]++;
+        }
+
+        for (int algo = 0; algo < ALGO_COUNT; algo++) {
+            if (lanes[algo] > 0)
+                HashLanes(algo, lanesIn[algo], len, lanesOut[algo], lanes[algo]);
+        }
+    }
+
+    for (size_t i = 0; i < count; i++)
+        out[i] = hashes[1][i].trim256();
+}
+
+} // namespace
+
+void HashX16RV2Batch(const unsigned char* const headers[], size_t count, uint256 out[])
+{
+    for (size_t i = 0; i < count; i += MAX_CHUNK)
+        HashChunk(headers + i, std::min(count - i, MAX_CHUNK), out + i);
+}
@@ -0,0 +1,24 @@
+// Copyright (c) 2020 The ShroudX Project developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef HASH_BATCH_H
+#define HASH_BATCH_H
+
+#include "uint256.h"
+
+#include <cstddef>
+
+/** Size of the hashed part of a block header, nVersion to nNonce */
+static const size_t X16RV2_HEADER_SIZE = 80;
+
+/**
+ * X16Rv2 of many block headers at once, out[i] is the same as HashX16RV2 of headers[i] with its
+ * own hashPrevBlock. Every round the headers that select the same algorithm are hashed together,
+ * four at a time with AVX2 for blake, keccak and skein when the CPU has it; cubehash uses AVX2
+ * for one header at a time. Headers sharing hashPrevBlock, like the nonces tried by a miner,
+ * always select the same algorithms.
+ */
+void HashX16RV2Batch(const unsigned char* const headers[], size_t count, uint256 out[]);
+
+#endif // HASH_BATCH_H
@@ -2337,19 +2337,15 @@ bool CDarkSendSigner::SignMessage(std::string strMessage, std::vector<unsigned c
 }
 
 bool CDarkSendSigner::VerifyMessage(CPubKey pubkey, const std::vector<unsigned char> &vchSig, std::string strMessage, std::string &strErrorRet) {
-    CHashWriter ss(SER_GETHASH, 0);
-    ss << strMessageMagic;
-    ss << strMessage;
-
-    CPubKey pubkeyFromSig;
-    if (!pubkeyFromSig.RecoverCompact(ss.GetHash(), vchSig)) {
+    CKeyID keyIDFromSig;
+    if (!RecoverMessageKey(vchSig, strMessage, keyIDFromSig)) {
         strErrorRet = "Error recovering public key.";
         return false;
     }
 
-    if (pubkeyFromSig.GetID() != pubkey.GetID()) {
+    if (keyIDFromSig != pubkey.GetID()) {
         strErrorRet = strprintf("Keys don't match: pubkey=%s, pubkeyFromSig=%s, strMessage=%s, vchSig=%s",
-                                pubkey.GetID().ToString(), pubkeyFromSig.GetID().ToString(), strMessage,
+                                pubkey.GetID().ToString(), keyIDFromSig.ToString(), strMessage,
                                 EncodeBase64(&vchSig[0], vchSig.size()));
         return false;
     }
@@ -2357,6 +2353,46 @@ bool CDarkSendSigner::VerifyMessage(CPubKey pubkey, const std::vector<unsigned c
     return true;
 }
 
+bool CDarkSendSigner::RecoverMessageKey(const std::vector<unsigned char> &vchSig, const std::string &strMessage, CKeyID &keyIDRet) {
+    CHashWriter ss(SER_GETHASH, 0);
+    ss << strMessageMagic;
+    ss << strMessage;
+    uint256 hashMessage = ss.GetHash();
+
+    CHashWriter ssSig(SER_GETHASH, 0);
+    ssSig << hashMessage;
+    ssSig << vchSig;
+    uint256 hashSig = ssSig.GetHash();
+
+    {
+        LOCK(cs_mapRecoveredKeys);
+        std::map<uint256, CKeyID>::const_iterator it = mapRecoveredKeys.find(hashSig);
+        if (it != mapRecoveredKeys.end()) {
+            keyIDRet = it->second;
+            return true;
+        }
+    }
+
+    // recovering is the expensive part, so it is done without holding the lock
+    CPubKey pubkeyFromSig;
+    if (!pubkeyFromSig.RecoverCompact(hashMessage, vchSig))
+        return false;
+    keyIDRet = pubkeyFromSig.GetID();
+
+    LOCK(cs_mapRecoveredKeys);
+    if (mapRecoveredKeys.size() >= MAX_RECOVERED_MESSAGE_KEYS) {
+        // keys are hashes, so the first entry is as good as a random one to evict
+        mapRecoveredKeys.erase(mapRecoveredKeys.begin());
+    }
+    mapRecoveredKeys.insert(std::make_pair(hashSig, keyIDRet));
+    return true;
+}
+
+size_t CDarkSendSigner::GetRecoveredKeysCount() {
+    LOCK(cs_mapRecoveredKeys);
+    return mapRecoveredKeys.size();
+}
+
 bool CDarkSendEntry::AddScriptSig(const CTxIn &txin) {
     BOOST_FOREACH(CTxDSIn & txdsin, vecTxDSIn)
     {
@@ -24,6 +24,8 @@ static const int MIN_PRIVATESEND_PEER_PROTO_VERSION = 70206;
 static const CAmount PRIVATESEND_COLLATERAL         = 0.001 * COIN;
 static const CAmount PRIVATESEND_POOL_MAX           = 999.999 * COIN;
 static const int DENOMS_COUNT_MAX                   = 100;
+//! keys recovered from message signatures remembered by CDarkSendSigner
+static const size_t MAX_RECOVERED_MESSAGE_KEYS      = 50000;
 
 static const int DEFAULT_PRIVATESEND_ROUNDS         = 2;
 static const int DEFAULT_PRIVATESEND_AMOUNT         = 1000;
@@ -247,6 +249,15 @@ public:
     bool SignMessage(std::string strMessage, std::vector<unsigned char>& vchSigRet, CKey key);
     /// Verify the message, returns true if succcessful
     bool VerifyMessage(CPubKey pubkey, const std::vector<unsigned char>& vchSig, std::string strMessage, std::string& strErrorRet);
+    /// Recover the key which signed the message, remembering it so the same signature is recovered only once
+    bool RecoverMessageKey(const std::vector<unsigned char>& vchSig, const std::string& strMessage, CKeyID& keyIDRet);
+    /// Number of recovered keys remembered
+    size_t GetRecoveredKeysCount();
+
+private:
+    CCriticalSection cs_mapRecoveredKeys;
+    // signature hash - key, checks done ahead of message processing land here
+    std::map<uint256, CKeyID> mapRecoveredKeys;
 };
 
 
@@ -160,10 +160,12 @@ uint256 GetConsensusHash()
     // Balances - loop through the tally map, updating the sha context with the data from each balance and tally type
     // Placeholders:  "address|propertyid|balance|selloffer_reserve|accept_reserve|metadex_reserve"
     // Sort alphabetically first
+    // The supply of every property is summed on the way to verify the running totals kept by update_tally_map
     std::map<std::string, CMPTally> tallyMapSorted;
     for (std::unordered_map<string, CMPTally>::iterator uoit = mp_tally_map.begin(); uoit != mp_tally_map.end(); ++uoit) {
         tallyMapSorted.insert(std::make_pair(uoit->first,uoit->second));
     }
+    std::unordered_map<uint32_t, CMPSupply> supplies;
     for (std::map<string, CMPTally>::iterator my_it = tallyMapSorted.begin(); my_it != tallyMapSorted.end(); ++my_it) {
         const std::string& address = my_it->first;
         CMPTally& tally = my_it->second;
@@ -174,8 +176,14 @@ uint256 GetConsensusHash()
             if (dataStr.empty()) continue; // skip empty balances
             if (elysium_debug_consensus_hash) PrintToLog("Adding balance data to consensus hash: %s\n", dataStr);
             SHA256_Update(&shaCtx, dataStr.c_str(), dataStr.length());
+
+            CMPSupply& supply = supplies[propertyId];
+            supply.tokens += tally.getMoney(propertyId, BALANCE) + tally.getMoney(propertyId, SELLOFFER_RESERVE) +
+                             tally.getMoney(propertyId, ACCEPT_RESERVE) + tally.getMoney(propertyId, METADEX_RESERVE);
+            supply.owners++;
         }
     }
+    VerifyTotalTokens(supplies);
 
     // DEx sell offers - loop through the DEx and add each sell offer to the consensus hash (ordered by txid)
     // Placeholders: "txid|address|propertyid|offeramount|btcdesired|minfee|timelimit"
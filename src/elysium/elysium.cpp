@@ -6,6 +6,7 @@
 #include "dex.h"
 #include "errors.h"
 #include "fees.h"
+#include "inputcache.h"
 #include "log.h"
 #include "mdex.h"
 #include "notifications.h"
@@ -15,6 +16,7 @@
 #include "rules.h"
 #include "script.h"
 #include "sigmadb.h"
+#include "snapshot.h"
 #include "sp.h"
 #include "tally.h"
 #include "tx.h"
@@ -33,6 +35,7 @@
 #include "../coincontrol.h"
 #include "../coins.h"
 #include "../core_io.h"
+#include "../crypto/common.h"
 #include "../init.h"
 #include "../main.h"
 #include "../primitives/block.h"
@@ -59,17 +62,21 @@
 #include <boost/filesystem.hpp>
 #include <boost/foreach.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/thread.hpp>
 
 #include <openssl/sha.h>
 
 #include "leveldb/db.h"
+#include "leveldb/write_batch.h"
 
 #include <assert.h>
 #include <stdint.h>
 #include <stdio.h>
 
+#include <algorithm>
 #include <fstream>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -94,6 +101,9 @@ using namespace elysium;
 
 static int nWaterlineBlock = 0;
 
+//! Maximum number of threads reading blocks ahead of the initial scan
+static const int MAX_SCAN_THREADS = 8;
+
 //! Available balances of wallet properties
 std::map<uint32_t, int64_t> global_balance_money;
 //! Reserved balances of wallet propertiess
@@ -117,6 +127,7 @@ bool autoCommit = true;
 static int64_t elysium_prev = 0;
 
 static boost::filesystem::path MPPersistencePath;
+static std::unique_ptr<SnapshotWriter> snapshotWriter;
 
 static int elysiumInitialized = 0;
 
@@ -244,6 +255,9 @@ CrowdMap elysium::my_crowds;
 // this is the master list of all amounts for all addresses for all properties, map is unsorted
 std::unordered_map<std::string, CMPTally> elysium::mp_tally_map;
 
+// running supply and number of holders of every property, kept in step with mp_tally_map by update_tally_map
+static std::unordered_map<uint32_t, CMPSupply> mp_supply_map;
+
 CMPTally* elysium::getTally(const std::string& address)
 {
     std::unordered_map<std::string, CMPTally>::iterator it = mp_tally_map.find(address);
@@ -413,11 +427,17 @@ std::string elysium::getTokenLabel(uint32_t propertyId)
     return tokenStr;
 }
 
+// the part of a tally counted in the supply of a property, pending amounts are not
+static int64_t getHeldTokens(const CMPTally& tally, uint32_t propertyId)
+{
+    return tally.getMoney(propertyId, BALANCE) + tally.getMoney(propertyId, SELLOFFER_RESERVE) +
+           tally.getMoney(propertyId, ACCEPT_RESERVE) + tally.getMoney(propertyId, METADEX_RESERVE);
+}
+
 // get total tokens for a property
 // optionally counts the number of addresses who own that property: n_owners_total
 int64_t elysium::getTotalTokens(uint32_t propertyId, int64_t* n_owners_total)
 {
-    int64_t prev = 0;
     int64_t owners = 0;
     int64_t totalTokens = 0;
 
@@ -429,18 +449,10 @@ int64_t elysium::getTotalTokens(uint32_t propertyId, int64_t* n_owners_total)
     }
 
     if (!property.fixed || n_owners_total) {
-        for (std::unordered_map<std::string, CMPTally>::const_iterator it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
-            const CMPTally& tally = it->second;
-
-            totalTokens += tally.getMoney(propertyId, BALANCE);
-            totalTokens += tally.getMoney(propertyId, SELLOFFER_RESERVE);
-            totalTokens += tally.getMoney(propertyId, ACCEPT_RESERVE);
-            totalTokens += tally.getMoney(propertyId, METADEX_RESERVE);
-
-            if (prev != totalTokens) {
-                prev = totalTokens;
-                owners++;
-            }
+        std::unordered_map<uint32_t, CMPSupply>::const_iterator it = mp_supply_map.find(propertyId);
+        if (it != mp_supply_map.end()) {
+            totalTokens = it->second.tokens;
+            owners = it->second.owners;
         }
         int64_t cachedFee = p_feecache->GetCachedAmount(propertyId);
         totalTokens += cachedFee;
@@ -455,6 +467,46 @@ int64_t elysium::getTotalTokens(uint32_t propertyId, int64_t* n_owners_total)
     return totalTokens;
 }
 
+bool elysium::VerifyTotalTokens(const std::unordered_map<uint32_t, CMPSupply>& computed)
+{
+    LOCK(cs_main);
+
+    bool fMatch = true;
+    for (std::unordered_map<uint32_t, CMPSupply>::const_iterator it = mp_supply_map.begin(); it != mp_supply_map.end(); ++it) {
+        const CMPSupply& supply = it->second;
+        if (supply.tokens == 0 && supply.owners == 0) continue; // nothing held any more
+        std::unordered_map<uint32_t, CMPSupply>::const_iterator found = computed.find(it->first);
+        if (found == computed.end() || found->second.tokens != supply.tokens || found->second.owners != supply.owners) {
+            PrintToLog("%s(): ERROR: running supply of property %d is %d tokens held by %d addresses, tally has %d held by %d\n",
+                    __func__, it->first, supply.tokens, supply.owners,
+                    found == computed.end() ? 0 : found->second.tokens, found == computed.end() ? 0 : found->second.owners);
+            fMatch = false;
+        }
+    }
+    for (std::unordered_map<uint32_t, CMPSupply>::const_iterator it = computed.begin(); it != computed.end(); ++it) {
+        if (it->second.tokens == 0 && it->second.owners == 0) continue;
+        if (mp_supply_map.find(it->first) == mp_supply_map.end()) {
+            PrintToLog("%s(): ERROR: property %d is missing from the running supply, tally has %d held by %d addresses\n",
+                    __func__, it->first, it->second.tokens, it->second.owners);
+            fMatch = false;
+        }
+    }
+
+    if (!fMatch) {
+        mp_supply_map = computed;
+    }
+
+    return fMatch;
+}
+
+void elysium::clear_tally_map()
+{
+    LOCK(cs_main);
+
+    mp_tally_map.clear();
+    mp_supply_map.clear();
+}
+
 // return true if everything is ok
 bool elysium::update_tally_map(const std::string& who, uint32_t propertyId, int64_t amount, TallyType ttype)
 {
@@ -486,8 +538,17 @@ bool elysium::update_tally_map(const std::string& who, uint32_t propertyId, int6
     }
 
     CMPTally& tally = my_it->second;
+    int64_t heldBefore = getHeldTokens(tally, propertyId);
     bRet = tally.updateMoney(propertyId, amount, ttype);
 
+    if (bRet && ttype != PENDING) {
+        int64_t heldAfter = getHeldTokens(tally, propertyId);
+        CMPSupply& supply = mp_supply_map[propertyId];
+        supply.tokens += heldAfter - heldBefore;
+        if (heldBefore == 0 && heldAfter != 0) ++supply.owners;
+        if (heldBefore != 0 && heldAfter == 0) --supply.owners;
+    }
+
     after = getMPbalance(who, propertyId, ttype);
     if (!bRet) {
         assert(before == after);
@@ -628,55 +689,64 @@ CCoinsViewCache elysium::view(&viewDummy);
 //! Guards coins view cache
 CCriticalSection elysium::cs_tx_cache;
 
-static unsigned int nCacheHits = 0;
-static unsigned int nCacheMiss = 0;
+//! Number of transactions in the coins view cache, before it's cleared
+static const unsigned int MAX_VIEW_CACHE_SIZE = 10000;
 
 /**
  * Fetches transaction inputs and adds them to the coins view cache.
  *
+ * The view only mirrors the inputs of the transactions being parsed, the outputs themselves are
+ * resolved and cached by an InputCache sized by -elysiumtxcache.
+ *
  * Note: cs_tx_cache should be locked, when adding and accessing inputs!
  *
- * @param tx[in]  The transaction to fetch inputs for
+ * @param tx[in]           The transaction to fetch inputs for
+ * @param pBlockIndex[in]  The block connecting the transaction, if any
+ * @param idx[in]          The position of the transaction in the block
  * @return True, if all inputs were successfully added to the cache
  */
-static bool FillTxInputCache(const CTransaction& tx)
+static bool FillTxInputCache(const CTransaction& tx, const CBlockIndex* pBlockIndex, unsigned int idx)
 {
-    static unsigned int nCacheSize = GetArg("-elysiumtxcache", 500000);
+    static InputCache inputCache(GetArg("-elysiumtxcache", 500000));
 
-    if (view.GetCacheSize() > nCacheSize) {
-        PrintToLog("%s(): clearing cache before insertion [size=%d, hit=%d, miss=%d]\n",
-                __func__, view.GetCacheSize(), nCacheHits, nCacheMiss);
+    if (view.GetCacheSize() > MAX_VIEW_CACHE_SIZE) {
         view.Flush();
     }
 
-    for (std::vector<CTxIn>::const_iterator it = tx.vin.begin(); it != tx.vin.end(); ++it) {
-        const CTxIn& txIn = *it;
-
+    // inputs already in the view, like the ones given for raw transactions, are kept
+    bool fMissing = false;
+    for (std::vector<CTxIn>::const_iterator it = tx.vin.begin(); it != tx.vin.end() && !fMissing; ++it) {
         if (it->scriptSig.IsSigmaSpend()) {
             continue;
         }
+        const CCoins* coins = view.AccessCoins(it->prevout.hash);
+        fMissing = !coins || !coins->IsAvailable(it->prevout.n);
+    }
+    if (!fMissing) {
+        return true;
+    }
 
-        unsigned int nOut = txIn.prevout.n;
-        CCoinsModifier coins = view.ModifyCoins(txIn.prevout.hash);
+    std::vector<CTxOut> outputs;
+    if (!inputCache.GetInputs(tx, pBlockIndex, idx, outputs)) {
+        return false;
+    }
 
-        if (coins->IsAvailable(nOut)) {
-            ++nCacheHits;
+    for (size_t i = 0; i < tx.vin.size(); ++i) {
+        const CTxIn& txIn = tx.vin[i];
+
+        if (txIn.scriptSig.IsSigmaSpend()) {
             continue;
-        } else {
-            ++nCacheMiss;
         }
 
-        CTransaction txPrev;
-        uint256 hashBlock;
-        if (!GetTransaction(txIn.prevout.hash, txPrev, Params().GetConsensus(), hashBlock, true)) {
-            return false;
+        unsigned int nOut = txIn.prevout.n;
+        CCoinsModifier coins = view.ModifyCoins(txIn.prevout.hash);
+        if (coins->IsAvailable(nOut)) {
+            continue;
         }
-
         if (nOut >= coins->vout.size()) {
             coins->vout.resize(nOut+1);
         }
-        coins->vout[nOut].scriptPubKey = txPrev.vout[nOut].scriptPubKey;
-        coins->vout[nOut].nValue = txPrev.vout[nOut].nValue;
+        coins->vout[nOut] = outputs[i];
     }
 
     return true;
@@ -688,7 +758,7 @@ static bool FillTxInputCache(const CTransaction& tx)
 // RETURNS: 0 if parsed a MP TX
 // RETURNS: < 0 if a non-MP-TX or invalid
 // RETURNS: >0 if 1 or more payments have been made
-static int parseTransaction(bool bRPConly, const CTransaction& wtx, int nBlock, unsigned int idx, CMPTransaction& mp_tx, unsigned int nTime)
+static int parseTransaction(bool bRPConly, const CTransaction& wtx, int nBlock, unsigned int idx, CMPTransaction& mp_tx, unsigned int nTime, const CBlockIndex* pBlockIndex = NULL)
 {
     InputMode inputMode = InputMode::NORMAL;
     if (wtx.IsSigmaSpend()) {
@@ -718,7 +788,7 @@ static int parseTransaction(bool bRPConly, const CTransaction& wtx, int nBlock,
     LOCK(cs_tx_cache);
 
     // Add previous transaction inputs to the cache
-    if (!FillTxInputCache(wtx)) {
+    if (!FillTxInputCache(wtx, pBlockIndex, idx)) {
         PrintToLog("%s() ERROR: failed to get inputs for %s\n", __func__, wtx.GetHash().GetHex());
         return -101;
     }
@@ -1130,6 +1200,138 @@ public:
     }
 };
 
+/**
+ * Reads blocks ahead of the initial scan on worker threads.
+ *
+ * Each worker claims the next block, reads and deserializes it, and picks out
+ * the transactions carrying an Elysium marker. The scan takes the blocks in
+ * order with Next(), while the workers stay at most a fixed number of blocks
+ * ahead of it. The workers never touch cs_main, which is held by the scan.
+ *
+ * @see elysium_initial_scan()
+ */
+class BlockPrefetcher
+{
+public:
+    struct Result
+    {
+        bool fRead;
+        CBlock block;
+        std::vector<unsigned> vCandidates;
+    };
+
+private:
+    struct Entry
+    {
+        int nHeight;
+        uint256 hash;
+        CDiskBlockPos pos;
+    };
+
+    std::vector<Entry> m_entries;
+    const size_t m_nMaxAhead;
+
+    boost::mutex m_mutex;
+    boost::condition_variable m_condWorker;
+    boost::condition_variable m_condScan;
+    std::map<size_t, std::unique_ptr<Result>> m_results;
+    size_t m_nNextRead;
+    size_t m_nNextTaken;
+    bool m_fStop;
+
+    boost::thread_group m_threads;
+
+    void read(const Entry& entry, Result& result) const
+    {
+        result.fRead = ReadBlockFromDisk(result.block, entry.pos, entry.nHeight, Params().GetConsensus());
+        if (result.fRead && result.block.GetHash() != entry.hash) {
+            result.fRead = error("%s: block at %s doesn't match index for %s", __func__, entry.pos.ToString(), entry.hash.GetHex());
+        }
+        if (!result.fRead) {
+            return;
+        }
+
+        for (unsigned i = 0; i < result.block.vtx.size(); i++) {
+            if (DeterminePacketClass(result.block.vtx[i], entry.nHeight)) {
+                result.vCandidates.push_back(i);
+            }
+        }
+    }
+
+    void threadRead()
+    {
+        while (true) {
+            size_t n;
+            {
+                boost::unique_lock<boost::mutex> lock(m_mutex);
+                while (!m_fStop && m_nNextRead < m_entries.size() && m_nNextRead >= m_nNextTaken + m_nMaxAhead) {
+                    m_condWorker.wait(lock);
+                }
+                if (m_fStop || m_nNextRead >= m_entries.size()) {
+                    return;
+                }
+                n = m_nNextRead++;
+            }
+
+            std::unique_ptr<Result> result(new Result());
+            read(m_entries[n], *result);
+
+            boost::unique_lock<boost::mutex> lock(m_mutex);
+            m_results[n] = std::move(result);
+            m_condScan.notify_one();
+        }
+    }
+
+public:
+    /** Captures the positions of the blocks, requires cs_main. */
+    BlockPrefetcher(int nFirstBlock, int nLastBlock, int nThreads)
+    : m_nMaxAhead(16 * nThreads), m_nNextRead(0), m_nNextTaken(0), m_fStop(false)
+    {
+        AssertLockHeld(cs_main);
+
+        for (int nBlock = nFirstBlock; nBlock <= nLastBlock; ++nBlock) {
+            const CBlockIndex* pblockindex = chainActive[nBlock];
+            if (NULL == pblockindex) break;
+            m_entries.push_back(Entry{nBlock, pblockindex->GetBlockHash(), pblockindex->GetBlockPos()});
+        }
+
+        for (int i = 0; i < nThreads; i++) {
+            m_threads.create_thread(boost::bind(&BlockPrefetcher::threadRead, this));
+        }
+    }
+
+    ~BlockPrefetcher()
+    {
+        {
+            boost::unique_lock<boost::mutex> lock(m_mutex);
+            m_fStop = true;
+        }
+        m_condWorker.notify_all();
+        m_threads.join_all();
+    }
+
+    /** Returns the next block in order, or nothing once all blocks were taken. */
+    std::unique_ptr<Result> Next()
+    {
+        boost::unique_lock<boost::mutex> lock(m_mutex);
+        if (m_nNextTaken >= m_entries.size()) {
+            return nullptr;
+        }
+
+        std::map<size_t, std::unique_ptr<Result>>::iterator it;
+        while ((it = m_results.find(m_nNextTaken)) == m_results.end()) {
+            m_condScan.wait(lock);
+        }
+
+        std::unique_ptr<Result> result = std::move(it->second);
+        m_results.erase(it);
+        m_nNextTaken++;
+        m_condWorker.notify_all();
+
+        return result;
+    }
+};
+
 /**
  * Scans the blockchain for meta transactions.
  *
@@ -1164,6 +1366,10 @@ static int elysium_initial_scan(int nFirstBlock)
     // used to print the progress to the console and notifies the UI
     ProgressReporter progressReporter(chainActive[nFirstBlock], chainActive[nLastBlock]);
 
+    // blocks are read and classified ahead on other threads
+    int nThreads = GetArg("-elysiumscanthreads", std::min(GetNumCores(), MAX_SCAN_THREADS));
+    BlockPrefetcher prefetcher(nFirstBlock, nLastBlock, std::max(1, std::min(nThreads, MAX_SCAN_THREADS)));
+
     for (nBlock = nFirstBlock; nBlock <= nLastBlock; ++nBlock)
     {
         if (ShutdownRequested()) {
@@ -1184,20 +1390,28 @@ static int elysium_initial_scan(int nFirstBlock)
         }
 
         // Get block to parse.
-        CBlock block;
+        std::unique_ptr<BlockPrefetcher::Result> result = prefetcher.Next();
 
-        if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus())) {
+        if (!result || !result->fRead) {
             break;
         }
 
-        // Parse block.
+        const CBlock& block = result->block;
+
+        // Parse block, only transactions with a marker can be Elysium transactions.
         unsigned parsed = 0;
 
         elysium_handler_block_begin(nBlock, pblockindex);
 
+        std::vector<unsigned>::const_iterator itCandidate = result->vCandidates.begin();
         for (unsigned i = 0; i < block.vtx.size(); i++) {
-            if (elysium_handler_tx(block.vtx[i], nBlock, i, pblockindex)) {
-                parsed++;
+            if (itCandidate != result->vCandidates.end() && *itCandidate == i) {
+                ++itCandidate;
+                if (elysium_handler_tx(block.vtx[i], nBlock, i, pblockindex)) {
+                    parsed++;
+                }
+            } else {
+                PendingDelete(block.vtx[i].GetHash());
             }
         }
 
@@ -1436,7 +1650,7 @@ static int elysium_file_load(const string &filename, int what, bool verifyHash =
   switch (what)
   {
     case FILETYPE_BALANCES:
-      mp_tally_map.clear();
+      clear_tally_map();
       inputLineFunc = input_elysium_balances_string;
       break;
 
@@ -1464,7 +1678,7 @@ static int elysium_file_load(const string &filename, int what, bool verifyHash =
       // memory leak ... gotta unallocate inner layers first....
       // TODO
       // ...
-      metadex.clear();
+      MetaDEx_CLEAR();
       inputLineFunc = input_mp_mdexorder_string;
       break;
 
@@ -1549,10 +1763,98 @@ static char const * const statePrefix[NUM_FILETYPES] = {
     "mdexorders",
 };
 
+static char const * const snapshotPrefix = "snapshot";
+
+static boost::filesystem::path snapshot_path(const uint256& blockHash)
+{
+    return MPPersistencePath / strprintf("%s-%s.dat", snapshotPrefix, blockHash.ToString());
+}
+
+static int load_state_snapshot(const uint256& blockHash)
+{
+    const boost::filesystem::path path = snapshot_path(blockHash);
+
+    // checksums of all sections are verified when mapping, nothing is cleared for a damaged snapshot
+    MappedSnapshot snapshot;
+    if (!snapshot.Open(path, blockHash, NUM_FILETYPES)) {
+        return -1;
+    }
+
+    clear_tally_map();
+    my_offers.clear();
+    my_accepts.clear();
+    my_crowds.clear();
+    MetaDEx_CLEAR();
+
+    try {
+        MemoryReader balances = snapshot.Section(FILETYPE_BALANCES);
+        while (!balances.empty()) {
+            std::string address;
+            uint32_t propertyId;
+            int64_t balance, sellReserved, acceptReserved, metadexReserved;
+            balances >> address >> propertyId >> balance >> sellReserved >> acceptReserved >> metadexReserved;
+
+            if (balance) update_tally_map(address, propertyId, balance, BALANCE);
+            if (sellReserved) update_tally_map(address, propertyId, sellReserved, SELLOFFER_RESERVE);
+            if (acceptReserved) update_tally_map(address, propertyId, acceptReserved, ACCEPT_RESERVE);
+            if (metadexReserved) update_tally_map(address, propertyId, metadexReserved, METADEX_RESERVE);
+        }
+
+        MemoryReader offers = snapshot.Section(FILETYPE_OFFERS);
+        while (!offers.empty()) {
+            std::string combo;
+            CMPOffer offer;
+            offers >> combo >> offer;
+            if (!my_offers.insert(std::make_pair(combo, offer)).second) return -1;
+        }
+
+        MemoryReader accepts = snapshot.Section(FILETYPE_ACCEPTS);
+        while (!accepts.empty()) {
+            std::string combo;
+            CMPAccept accept;
+            accepts >> combo >> accept;
+            if (!my_accepts.insert(std::make_pair(combo, accept)).second) return -1;
+        }
+
+        MemoryReader globals = snapshot.Section(FILETYPE_GLOBALS);
+        int64_t elysiumPrev;
+        uint32_t nextSPID, nextTestSPID;
+        globals >> elysiumPrev >> nextSPID >> nextTestSPID;
+        elysium_prev = elysiumPrev;
+        _my_sps->init(nextSPID, nextTestSPID);
+
+        MemoryReader crowds = snapshot.Section(FILETYPE_CROWDSALES);
+        while (!crowds.empty()) {
+            std::string address;
+            CMPCrowd crowd;
+            crowds >> address >> crowd;
+            if (!my_crowds.insert(std::make_pair(address, crowd)).second) return -1;
+        }
+
+        MemoryReader orders = snapshot.Section(FILETYPE_MDEXORDERS);
+        while (!orders.empty()) {
+            CMPMetaDEx order;
+            orders >> order;
+            if (!MetaDEx_INSERT(order)) return -1;
+        }
+    } catch (const std::exception& e) {
+        PrintToLog("%s(%s): failed to read snapshot: %s\n", __func__, path.string(), e.what());
+        return -1;
+    }
+
+    PrintToLog("%s(%s) loaded\n", __func__, path.string());
+    LogPrintf("%s(): file: %s loaded\n", __func__, path.string());
+
+    return 0;
+}
+
 // returns the height of the state loaded
 static int load_most_relevant_state()
 {
   int res = -1;
+  // snapshots still being written belong to the blocks we're about to look at
+  if (snapshotWriter) snapshotWriter->Flush();
+
   // check the SP database and roll it back to its latest valid state
   // according to the active chain
   uint256 spWatermark;
@@ -1618,8 +1920,9 @@ static int load_most_relevant_state()
   if (curTip != NULL) abortRollBackBlock = curTip->nHeight - (MAX_STATE_HISTORY+1);
   while (NULL != curTip && persistedBlocks.size() > 0 && curTip->nHeight > abortRollBackBlock) {
     if (persistedBlocks.find(spBlockIndex->GetBlockHash()) != persistedBlocks.end()) {
-      int success = -1;
-      for (int i = 0; i < NUM_FILETYPES; ++i) {
+      // prefer the binary snapshot, the text state files are a fallback
+      int success = load_state_snapshot(curTip->GetBlockHash());
+      for (int i = 0; success < 0 && i < NUM_FILETYPES; ++i) {
         boost::filesystem::path path = MPPersistencePath / strprintf("%s-%s.dat", statePrefix[i], curTip->GetBlockHash().ToString());
         const std::string strFile = path.string();
         success = elysium_file_load(strFile, i, true);
@@ -1779,6 +2082,64 @@ static int write_mp_crowdsales(std::ofstream& file, SHA256_CTX* shaCtx)
     return 0;
 }
 
+// serializing is cheap enough to stay under cs_main, hashing and writing the file is left to snapshotWriter
+static std::unique_ptr<StateSnapshot> capture_state(CBlockIndex const *pBlockIndex)
+{
+    std::unique_ptr<StateSnapshot> snapshot(new StateSnapshot(pBlockIndex->GetBlockHash(), NUM_FILETYPES));
+
+    CDataStream& balances = snapshot->Section(FILETYPE_BALANCES);
+    for (std::unordered_map<std::string, CMPTally>::iterator it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
+        CMPTally& tally = it->second;
+        tally.init();
+        uint32_t propertyId = 0;
+        while (0 != (propertyId = tally.next())) {
+            int64_t balance = tally.getMoney(propertyId, BALANCE);
+            int64_t sellReserved = tally.getMoney(propertyId, SELLOFFER_RESERVE);
+            int64_t acceptReserved = tally.getMoney(propertyId, ACCEPT_RESERVE);
+            int64_t metadexReserved = tally.getMoney(propertyId, METADEX_RESERVE);
+
+            // empty balances are skipped like in the text files
+            if (0 == balance && 0 == sellReserved && 0 == acceptReserved && 0 == metadexReserved) {
+                continue;
+            }
+            balances << it->first << propertyId << balance << sellReserved << acceptReserved << metadexReserved;
+        }
+    }
+
+    CDataStream& offers = snapshot->Section(FILETYPE_OFFERS);
+    for (OfferMap::const_iterator it = my_offers.begin(); it != my_offers.end(); ++it) {
+        offers << it->first << it->second;
+    }
+
+    CDataStream& accepts = snapshot->Section(FILETYPE_ACCEPTS);
+    for (AcceptMap::const_iterator it = my_accepts.begin(); it != my_accepts.end(); ++it) {
+        accepts << it->first << it->second;
+    }
+
+    CDataStream& globals = snapshot->Section(FILETYPE_GLOBALS);
+    globals << elysium_prev;
+    globals << _my_sps->peekNextSPID(ELYSIUM_PROPERTY_ELYSIUM);
+    globals << _my_sps->peekNextSPID(ELYSIUM_PROPERTY_TELYSIUM);
+
+    CDataStream& crowds = snapshot->Section(FILETYPE_CROWDSALES);
+    for (CrowdMap::const_iterator it = my_crowds.begin(); it != my_crowds.end(); ++it) {
+        crowds << it->first << it->second;
+    }
+
+    CDataStream& orders = snapshot->Section(FILETYPE_MDEXORDERS);
+    for (md_PropertiesMap::const_iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
+        const md_PricesMap& prices = my_it->second;
+        for (md_PricesMap::const_iterator it = prices.begin(); it != prices.end(); ++it) {
+            const md_Set& indexes = it->second;
+            for (md_Set::const_iterator it = indexes.begin(); it != indexes.end(); ++it) {
+                orders << *it;
+            }
+        }
+    }
+
+    return snapshot;
+}
+
 static int write_state_file( CBlockIndex const *pBlockIndex, int what )
 {
   boost::filesystem::path path = MPPersistencePath / strprintf("%s-%s.dat", statePrefix[what], pBlockIndex->GetBlockHash().ToString());
@@ -1832,6 +2193,10 @@ static int write_state_file( CBlockIndex const *pBlockIndex, int what )
 
 static bool is_state_prefix( std::string const &str )
 {
+  if (boost::equals(str, snapshotPrefix)) {
+    return true;
+  }
+
   for (int i = 0; i < NUM_FILETYPES; ++i) {
     if (boost::equals(str,  statePrefix[i])) {
       return true;
@@ -1892,19 +2257,24 @@ static void prune_state_files( CBlockIndex const *topIndex )
         boost::filesystem::path path = MPPersistencePath / strprintf("%s-%s.dat", statePrefix[i], strBlockHash);
         boost::filesystem::remove(path);
       }
+      boost::filesystem::remove(snapshot_path(*iter));
     }
   }
 }
 
 int elysium_save_state( CBlockIndex const *pBlockIndex )
 {
-    // write the new state as of the given block
-    write_state_file(pBlockIndex, FILETYPE_BALANCES);
-    write_state_file(pBlockIndex, FILETYPE_OFFERS);
-    write_state_file(pBlockIndex, FILETYPE_ACCEPTS);
-    write_state_file(pBlockIndex, FILETYPE_GLOBALS);
-    write_state_file(pBlockIndex, FILETYPE_CROWDSALES);
-    write_state_file(pBlockIndex, FILETYPE_MDEXORDERS);
+    // write the new state as of the given block, the text files are kept for debugging only
+    snapshotWriter->Queue(snapshot_path(pBlockIndex->GetBlockHash()), capture_state(pBlockIndex));
+
+    if (elysium_debug_persistence) {
+        write_state_file(pBlockIndex, FILETYPE_BALANCES);
+        write_state_file(pBlockIndex, FILETYPE_OFFERS);
+        write_state_file(pBlockIndex, FILETYPE_ACCEPTS);
+        write_state_file(pBlockIndex, FILETYPE_GLOBALS);
+        write_state_file(pBlockIndex, FILETYPE_CROWDSALES);
+        write_state_file(pBlockIndex, FILETYPE_MDEXORDERS);
+    }
 
     // clean-up the directory
     prune_state_files(pBlockIndex);
@@ -1922,11 +2292,11 @@ void clear_all_state()
     LOCK(cs_main);
 
     // Memory based storage
-    mp_tally_map.clear();
+    clear_tally_map();
     my_offers.clear();
     my_accepts.clear();
     my_crowds.clear();
-    metadex.clear();
+    MetaDEx_CLEAR();
     my_pending.clear();
     ResetConsensusParams();
     ClearActivations();
@@ -2019,6 +2389,7 @@ int elysium_init()
 
     MPPersistencePath = GetDataDir() / "MP_persist";
     TryCreateDirectory(MPPersistencePath);
+    snapshotWriter.reset(new SnapshotWriter());
 
     txProcessor = new TxProcessor();
 
@@ -2122,6 +2493,7 @@ int elysium_shutdown()
 #ifdef ENABLE_WALLET
     delete wallet; wallet = nullptr;
 #endif
+    snapshotWriter.reset(); // writes the snapshots still queued
     delete txProcessor; txProcessor = nullptr;
     delete sigmaDb; sigmaDb = nullptr;
     delete p_txlistdb; p_txlistdb = nullptr;
@@ -2167,7 +2539,7 @@ bool elysium_handler_tx(const CTransaction& tx, int nBlock, unsigned int idx, co
     mp_obj.unlockLogic();
 
     bool fFoundTx = false;
-    int pop_ret = parseTransaction(false, tx, nBlock, idx, mp_obj, nBlockTime);
+    int pop_ret = parseTransaction(false, tx, nBlock, idx, mp_obj, nBlockTime, pBlockIndex);
 
     if (0 == pop_ret) {
         int interp_ret = txProcessor->ProcessTx(mp_obj);
@@ -3102,34 +3474,219 @@ unsigned int n_found = 0;
 }
 
 // MPSTOList here
+/**
+ * Secondary index keys of the trade and STO databases.
+ *
+ * The keys start with a type byte, which sorts before any character of the hex
+ * txids and addresses used as keys of the records, followed by big-endian
+ * numbers, so the entries of a range are adjacent and in order.
+ */
+enum class IndexKeyType : uint8_t
+{
+    Version = 0,
+    TradesByPair = 1,
+    TradesByAddress = 2,
+    STOByBlock = 3
+};
+
+//! Version of the secondary indexes, the indexes are rebuilt when opening a database with another version
+static const std::string INDEX_VERSION = "1";
+//! Number of records indexed per batch, when rebuilding the indexes
+static const unsigned int INDEX_BATCH_SIZE = 10000;
+
+// <1 byte of type><4 bytes of property A><4 bytes of property B><4 bytes of block><32 bytes of txid1><32 bytes of txid2>
+#define TRADE_PAIR_KEY_SIZE (1 + 3 * sizeof(uint32_t) + 2 * 32)
+// <32 bytes of txid><4 bytes of property for sale><4 bytes of property desired>
+#define TRADE_ADDRESS_VALUE_SIZE (32 + 2 * sizeof(uint32_t))
+
+static bool IsIndexKey(const Slice& key)
+{
+    return !key.empty() && static_cast<uint8_t>(key[0]) <= static_cast<uint8_t>(IndexKeyType::STOByBlock);
+}
+
+static std::string CreateIndexKey(IndexKeyType type)
+{
+    return std::string(1, static_cast<char>(type));
+}
+
+static void AppendBE32(std::string& key, uint32_t value)
+{
+    unsigned char buf[sizeof(value)];
+    WriteBE32(buf, value);
+    key.append(reinterpret_cast<const char*>(buf), sizeof(buf));
+}
+
+static void AppendHash(std::string& key, const uint256& hash)
+{
+    key.append(reinterpret_cast<const char*>(hash.begin()), hash.size());
+}
+
+static uint256 ReadHash(const char* data)
+{
+    uint256 hash;
+    std::copy(data, data + hash.size(), hash.begin());
+    return hash;
+}
+
+// <1 byte of type><4 bytes of property A><4 bytes of property B>
+static std::string CreateTradePairPrefix(uint32_t propertyIdA, uint32_t propertyIdB)
+{
+    std::string key = CreateIndexKey(IndexKeyType::TradesByPair);
+    AppendBE32(key, propertyIdA);
+    AppendBE32(key, propertyIdB);
+    return key;
+}
+
+static std::string CreateTradePairKey(uint32_t prop1, uint32_t prop2, int block, const uint256& txid1, const uint256& txid2)
+{
+    std::string key = CreateTradePairPrefix(prop1, prop2);
+    AppendBE32(key, block);
+    AppendHash(key, txid1);
+    AppendHash(key, txid2);
+    return key;
+}
+
+// <1 byte of type><1 byte of address size><address>
+static std::string CreateTradeAddressPrefix(const std::string& address)
+{
+    std::string key = CreateIndexKey(IndexKeyType::TradesByAddress);
+    key.push_back(static_cast<char>(address.size()));
+    key.append(address);
+    return key;
+}
+
+// <address prefix><4 bytes of block><4 bytes of index within block>
+static std::string CreateTradeAddressKey(const std::string& address, int block, int blockIndex)
+{
+    std::string key = CreateTradeAddressPrefix(address);
+    AppendBE32(key, block);
+    AppendBE32(key, blockIndex);
+    return key;
+}
+
+static std::string CreateTradeAddressValue(const uint256& txid, uint32_t propertyIdForSale, uint32_t propertyIdDesired)
+{
+    std::string value;
+    AppendHash(value, txid);
+    AppendBE32(value, propertyIdForSale);
+    AppendBE32(value, propertyIdDesired);
+    return value;
+}
+
+// <1 byte of type><4 bytes of block><address>
+static std::string CreateSTOBlockKey(int block, const std::string& address)
+{
+    std::string key = CreateIndexKey(IndexKeyType::STOByBlock);
+    AppendBE32(key, block);
+    key.append(address);
+    return key;
+}
+
+/** Returns the block of a secondary index entry, or -1 if the entry isn't tied to a block. */
+static int GetIndexKeyBlock(const Slice& key)
+{
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(key.data());
+
+    switch (static_cast<IndexKeyType>(data[0])) {
+        case IndexKeyType::TradesByPair:
+            if (key.size() != TRADE_PAIR_KEY_SIZE) return -1;
+            return ReadBE32(data + 1 + 2 * sizeof(uint32_t));
+        case IndexKeyType::TradesByAddress:
+            if (key.size() < 2 || key.size() != 2 + data[1] + 2 * sizeof(uint32_t)) return -1;
+            return ReadBE32(data + 2 + data[1]);
+        case IndexKeyType::STOByBlock:
+            if (key.size() < 1 + sizeof(uint32_t)) return -1;
+            return ReadBE32(data + 1);
+        default:
+            return -1;
+    }
+}
+
+/** Appends the receipts of an address to the list, skipping transactions already listed. */
+static void AppendSTOReceipts(std::string& mySTOReceipts, const std::string& recipientAddress, const std::string& strValue)
+{
+    // break into individual receipts
+    std::vector<std::string> vstr;
+    boost::split(vstr, strValue, boost::is_any_of(","), token_compress_on);
+    for(uint32_t i = 0; i<vstr.size(); i++) {
+        // add to array
+        std::vector<std::string> svstr;
+        boost::split(svstr, vstr[i], boost::is_any_of(":"), token_compress_on);
+        if(4 == svstr.size()) {
+            size_t txidMatch = mySTOReceipts.find(svstr[0]);
+            if(txidMatch==std::string::npos) mySTOReceipts += svstr[0]+":"+svstr[1]+":"+recipientAddress+":"+svstr[2]+",";
+        }
+    }
+}
+
+/**
+ * Builds the index of STO receipts by block, if it is missing or outdated.
+ *
+ * Databases created by earlier versions only contain the receipts by address.
+ */
+void CMPSTOList::buildIndexes()
+{
+  if (!pdb) return;
+
+  std::string strVersion;
+  if (pdb->Get(readoptions, CreateIndexKey(IndexKeyType::Version), &strVersion).ok() && strVersion == INDEX_VERSION) return;
+
+  PrintToLog("Building send-to-owners database indexes..\n");
+
+  leveldb::WriteBatch batch;
+  unsigned int n_indexed = 0, n_batched = 0;
+  leveldb::Iterator* it = NewIterator();
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+      if (IsIndexKey(it->key())) {
+          batch.Delete(it->key());
+          continue;
+      }
+      std::string recipientAddress = it->key().ToString();
+      std::string strValue = it->value().ToString();
+      std::vector<std::string> vecSTORecords;
+      boost::split(vecSTORecords, strValue, boost::is_any_of(","), boost::token_compress_on);
+      for (uint32_t i = 0; i < vecSTORecords.size(); i++) {
+          std::vector<std::string> vecSTORecordFields;
+          boost::split(vecSTORecordFields, vecSTORecords[i], boost::is_any_of(":"), boost::token_compress_on);
+          if (4 != vecSTORecordFields.size()) continue;
+          batch.Put(CreateSTOBlockKey(atoi(vecSTORecordFields[1]), recipientAddress), "");
+          ++n_indexed;
+      }
+      if (++n_batched >= INDEX_BATCH_SIZE) {
+          pdb->Write(writeoptions, &batch);
+          batch.Clear();
+          n_batched = 0;
+      }
+  }
+  delete it;
+
+  batch.Put(CreateIndexKey(IndexKeyType::Version), INDEX_VERSION);
+  Status status = pdb->Write(syncoptions, &batch);
+
+  PrintToLog("%s(): indexed %d receipts, %s\n", __FUNCTION__, n_indexed, status.ToString());
+}
+
 std::string CMPSTOList::getMySTOReceipts(string filterAddress)
 {
   if (!pdb) return "";
   string mySTOReceipts = "";
-  Slice skey, svalue;
-  Iterator* it = NewIterator();
-  for(it->SeekToFirst(); it->Valid(); it->Next()) {
-      skey = it->key();
-      string recipientAddress = skey.ToString();
-      if(!IsMyAddress(recipientAddress)) continue; // not ours, not interested
-      if((!filterAddress.empty()) && (filterAddress != recipientAddress)) continue; // not the filtered address
-      // ours, get info
-      svalue = it->value();
-      string strValue = svalue.ToString();
-      // break into individual receipts
-      std::vector<std::string> vstr;
-      boost::split(vstr, strValue, boost::is_any_of(","), token_compress_on);
-      for(uint32_t i = 0; i<vstr.size(); i++) {
-          // add to array
-          std::vector<std::string> svstr;
-          boost::split(svstr, vstr[i], boost::is_any_of(":"), token_compress_on);
-          if(4 == svstr.size()) {
-              size_t txidMatch = mySTOReceipts.find(svstr[0]);
-              if(txidMatch==std::string::npos) mySTOReceipts += svstr[0]+":"+svstr[1]+":"+recipientAddress+":"+svstr[2]+",";
-          }
+  if (!filterAddress.empty()) {
+      // receipts are stored by address
+      string strValue;
+      if (IsMyAddress(filterAddress) && pdb->Get(readoptions, filterAddress, &strValue).ok()) {
+          AppendSTOReceipts(mySTOReceipts, filterAddress, strValue);
       }
+  } else {
+      Iterator* it = NewIterator();
+      for(it->SeekToFirst(); it->Valid(); it->Next()) {
+          if (IsIndexKey(it->key())) continue;
+          string recipientAddress = it->key().ToString();
+          if(!IsMyAddress(recipientAddress)) continue; // not ours, not interested
+          // ours, get info
+          AppendSTOReceipts(mySTOReceipts, recipientAddress, it->value().ToString());
+      }
+      delete it;
   }
-  delete it;
   // above code will leave a trailing comma - strip it
   if (mySTOReceipts.size() > 0) mySTOReceipts.resize(mySTOReceipts.size()-1);
   return mySTOReceipts;
@@ -3157,6 +3714,7 @@ void CMPSTOList::getRecipients(const uint256 txid, string filterAddress, UniValu
   for(it->SeekToFirst(); it->Valid(); it->Next())
   {
       skey = it->key();
+      if (IsIndexKey(skey)) continue;
       string recipientAddress = skey.ToString();
       svalue = it->value();
       string strValue = svalue.ToString();
@@ -3236,43 +3794,30 @@ void CMPSTOList::recordSTOReceive(string address, const uint256 &txid, int nBloc
 {
   if (!pdb) return;
 
+  const string key = address;
+  const string newValue = strprintf("%s:%d:%u:%lu,", txid.ToString(), nBlock, propertyId, amount);
+  string strValue;
+
   bool addressExists = s_stolistdb->exists(address);
   if (addressExists)
   {
       //retrieve existing record
-      std::vector<std::string> vstr;
-      string strValue;
       Status status = pdb->Get(readoptions, address, &strValue);
-      if (status.ok())
-      {
-          // add details to record
-          // see if we are overwriting (check)
-          size_t txidMatch = strValue.find(txid.ToString());
-          if(txidMatch!=std::string::npos) PrintToLog("STODEBUG : Duplicating entry for %s : %s\n",address,txid.ToString());
-
-          const string key = address;
-          const string newValue = strprintf("%s:%d:%u:%lu,", txid.ToString(), nBlock, propertyId, amount);
-          strValue += newValue;
-          // write updated record
-          Status status;
-          if (pdb)
-          {
-              status = pdb->Put(writeoptions, key, strValue);
-              PrintToLog("STODBDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
-          }
-      }
-  }
-  else
-  {
-      const string key = address;
-      const string value = strprintf("%s:%d:%u:%lu,", txid.ToString(), nBlock, propertyId, amount);
-      Status status;
-      if (pdb)
-      {
-          status = pdb->Put(writeoptions, key, value);
-          PrintToLog("STODBDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
-      }
+      if (!status.ok()) return;
+
+      // add details to record
+      // see if we are overwriting (check)
+      size_t txidMatch = strValue.find(txid.ToString());
+      if(txidMatch!=std::string::npos) PrintToLog("STODEBUG : Duplicating entry for %s : %s\n",address,txid.ToString());
   }
+  strValue += newValue;
+
+  // write updated record, and index it by block
+  leveldb::WriteBatch batch;
+  batch.Put(key, strValue);
+  batch.Put(CreateSTOBlockKey(nBlock, address), "");
+  Status status = pdb->Write(writeoptions, &batch);
+  PrintToLog("STODBDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
 }
 
 void CMPSTOList::printAll()
@@ -3284,6 +3829,7 @@ void CMPSTOList::printAll()
   for(it->SeekToFirst(); it->Valid(); it->Next())
   {
     skey = it->key();
+    if (IsIndexKey(skey)) continue;
     svalue = it->value();
     ++count;
     PrintToLog("entry #%8d= %s:%s\n", count, skey.ToString(), svalue.ToString());
@@ -3305,11 +3851,23 @@ void CMPSTOList::printStats()
 int CMPSTOList::deleteAboveBlock(int blockNum)
 {
   unsigned int n_found = 0;
-  std::vector<std::string> vecSTORecords;
+  std::set<std::string> setAddresses;
+  leveldb::WriteBatch batch;
+
+  // find the recipients of the blocks via the block index
+  const std::string prefix = CreateIndexKey(IndexKeyType::STOByBlock);
   leveldb::Iterator* it = NewIterator();
-  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+  for (it->Seek(CreateSTOBlockKey(blockNum, "")); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+      setAddresses.insert(it->key().ToString().substr(prefix.size() + sizeof(uint32_t)));
+      batch.Delete(it->key());
+  }
+  delete it;
+
+  std::vector<std::string> vecSTORecords;
+  for (std::set<std::string>::const_iterator address = setAddresses.begin(); address != setAddresses.end(); ++address) {
       std::string newValue;
-      std::string oldValue = it->value().ToString();
+      std::string oldValue;
+      if (!pdb->Get(readoptions, *address, &oldValue).ok()) continue;
       bool needsUpdate = false;
       boost::split(vecSTORecords, oldValue, boost::is_any_of(","), boost::token_compress_on);
       for (uint32_t i = 0; i<vecSTORecords.size(); i++) {
@@ -3324,20 +3882,72 @@ int CMPSTOList::deleteAboveBlock(int blockNum)
       }
       if (needsUpdate) { // rewrite record with existing key and new value
           ++n_found;
-          leveldb::Status status = pdb->Put(writeoptions, it->key().ToString(), newValue);
+          batch.Put(*address, newValue);
           PrintToLog("DEBUG STO - rewriting STO data after reorg\n");
-          PrintToLog("STODBDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
       }
   }
 
+  leveldb::Status status = pdb->Write(writeoptions, &batch);
+  PrintToLog("STODBDEBUG : %s(): %s, line %d, file: %s\n", __FUNCTION__, status.ToString(), __LINE__, __FILE__);
   PrintToLog("%s(%d); stodb updated records= %d\n", __FUNCTION__, blockNum, n_found);
 
-  delete it;
-
   return (n_found);
 }
 
 // MPTradeList here
+/**
+ * Builds the indexes of trades by property pair and by address, if they are missing or outdated.
+ *
+ * Databases created by earlier versions only contain the trades by txid.
+ */
+void CMPTradeList::buildIndexes()
+{
+  if (!pdb) return;
+
+  std::string strVersion;
+  if (pdb->Get(readoptions, CreateIndexKey(IndexKeyType::Version), &strVersion).ok() && strVersion == INDEX_VERSION) return;
+
+  PrintToLog("Building trade database indexes..\n");
+
+  leveldb::WriteBatch batch;
+  unsigned int n_indexed = 0, n_batched = 0;
+  std::vector<std::string> vstr;
+  leveldb::Iterator* it = NewIterator();
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+      if (IsIndexKey(it->key())) {
+          batch.Delete(it->key());
+          continue;
+      }
+      std::string strKey = it->key().ToString();
+      std::string strValue = it->value().ToString();
+      boost::split(vstr, strValue, boost::is_any_of(":"), token_compress_on);
+      if (strKey.size() == 64 && vstr.size() == 5) { // trades have 5 tokens, key is txid
+          uint32_t propertyIdForSale = atoi64(vstr[1]);
+          uint32_t propertyIdDesired = atoi64(vstr[2]);
+          batch.Put(CreateTradeAddressKey(vstr[0], atoi(vstr[3]), atoi(vstr[4])),
+                  CreateTradeAddressValue(uint256S(strKey), propertyIdForSale, propertyIdDesired));
+      } else if (strKey.size() == 129 && vstr.size() >= 7) { // trade matches have 8 tokens (7 without fee), key is txid+txid
+          uint32_t prop1 = atoi64(vstr[2]);
+          uint32_t prop2 = atoi64(vstr[3]);
+          batch.Put(CreateTradePairKey(prop1, prop2, atoi(vstr[6]), uint256S(strKey.substr(0, 64)), uint256S(strKey.substr(65, 64))), strValue);
+      } else {
+          continue;
+      }
+      ++n_indexed;
+      if (++n_batched >= INDEX_BATCH_SIZE) {
+          pdb->Write(writeoptions, &batch);
+          batch.Clear();
+          n_batched = 0;
+      }
+  }
+  delete it;
+
+  batch.Put(CreateIndexKey(IndexKeyType::Version), INDEX_VERSION);
+  Status status = pdb->Write(syncoptions, &batch);
+
+  PrintToLog("%s(): indexed %d trades, %s\n", __FUNCTION__, n_indexed, status.ToString());
+}
+
 bool CMPTradeList::getMatchingTrades(const uint256& txid, uint32_t propertyId, UniValue& tradeArray, int64_t& totalSold, int64_t& totalReceived)
 {
   if (!pdb) return false;
@@ -3351,6 +3961,7 @@ bool CMPTradeList::getMatchingTrades(const uint256& txid, uint32_t propertyId, U
   leveldb::Iterator* it = NewIterator();
   for(it->SeekToFirst(); it->Valid(); it->Next()) {
       // search key to see if this is a matching trade
+      if (IsIndexKey(it->key())) continue;
       std::string strKey = it->key().ToString();
       std::string strValue = it->value().ToString();
       std::string matchTxid;
@@ -3426,73 +4037,83 @@ void CMPTradeList::getTradesForPair(uint32_t propertyIdSideA, uint32_t propertyI
   std::vector<std::pair<int64_t, UniValue> > vecResponse;
   bool propertyIdSideAIsDivisible = isPropertyDivisible(propertyIdSideA);
   bool propertyIdSideBIsDivisible = isPropertyDivisible(propertyIdSideB);
-  for(it->SeekToFirst(); it->Valid(); it->Next()) {
-      std::string strKey = it->key().ToString();
-      std::string strValue = it->value().ToString();
-      std::vector<std::string> vecKeys;
-      std::vector<std::string> vecValues;
-      uint256 sellerTxid, matchingTxid;
-      std::string sellerAddress, matchingAddress;
-      int64_t amountReceived = 0, amountSold = 0;
-      if (strKey.size() != 129) continue; // only interested in matches
-      boost::split(vecKeys, strKey, boost::is_any_of("+"), boost::token_compress_on);
-      boost::split(vecValues, strValue, boost::is_any_of(":"), boost::token_compress_on);
-      if (vecKeys.size() != 2 || vecValues.size() != 8) {
-          PrintToLog("TRADEDB error - unexpected number of tokens (%s:%s)\n", strKey, strValue);
-          continue;
-      }
-      uint32_t tradePropertyIdSideA = boost::lexical_cast<uint32_t>(vecValues[2]);
-      uint32_t tradePropertyIdSideB = boost::lexical_cast<uint32_t>(vecValues[3]);
-      if (tradePropertyIdSideA == propertyIdSideA && tradePropertyIdSideB == propertyIdSideB) {
-          sellerTxid.SetHex(vecKeys[1]);
-          sellerAddress = vecValues[1];
-          amountSold = boost::lexical_cast<int64_t>(vecValues[4]);
-          matchingTxid.SetHex(vecKeys[0]);
-          matchingAddress = vecValues[0];
-          amountReceived = boost::lexical_cast<int64_t>(vecValues[5]);
-      } else if (tradePropertyIdSideB == propertyIdSideA && tradePropertyIdSideA == propertyIdSideB) {
-          sellerTxid.SetHex(vecKeys[0]);
-          sellerAddress = vecValues[0];
-          amountSold = boost::lexical_cast<int64_t>(vecValues[5]);
-          matchingTxid.SetHex(vecKeys[1]);
-          matchingAddress = vecValues[1];
-          amountReceived = boost::lexical_cast<int64_t>(vecValues[4]);
-      } else {
-          continue;
-      }
 
-      rational_t unitPrice(amountReceived, amountSold);
-      rational_t inversePrice(amountSold, amountReceived);
-      if (!propertyIdSideAIsDivisible) unitPrice = unitPrice / COIN;
-      if (!propertyIdSideBIsDivisible) inversePrice = inversePrice / COIN;
-      std::string unitPriceStr = xToString(unitPrice); // TODO: not here!
-      std::string inversePriceStr = xToString(inversePrice);
-
-      int64_t blockNum = boost::lexical_cast<int64_t>(vecValues[6]);
+  // trades are indexed by the properties of the matched trades in the recorded order, so
+  // walk back from the most recent trades of both orientations, at least one trade is returned
+  uint64_t maxTrades = std::max<uint64_t>(count, 1);
+  for (int orientation = 0; orientation < 2; ++orientation) {
+      const bool fSideAFirst = (orientation == 0);
+      const std::string prefix = fSideAFirst ? CreateTradePairPrefix(propertyIdSideA, propertyIdSideB)
+                                             : CreateTradePairPrefix(propertyIdSideB, propertyIdSideA);
+      uint64_t found = 0;
+
+      it->Seek(prefix + std::string(TRADE_PAIR_KEY_SIZE - prefix.size(), '\xff'));
+      if (it->Valid()) it->Prev(); else it->SeekToLast();
+
+      for (; it->Valid() && it->key().starts_with(prefix) && found < maxTrades; it->Prev()) {
+          std::string strValue = it->value().ToString();
+          std::vector<std::string> vecValues;
+          uint256 sellerTxid, matchingTxid;
+          std::string sellerAddress, matchingAddress;
+          int64_t amountReceived = 0, amountSold = 0;
+          boost::split(vecValues, strValue, boost::is_any_of(":"), boost::token_compress_on);
+          if (it->key().size() != TRADE_PAIR_KEY_SIZE || vecValues.size() != 8) {
+              PrintToLog("TRADEDB error - unexpected number of tokens (%s)\n", strValue);
+              continue;
+          }
+          const char* txids = it->key().data() + TRADE_PAIR_KEY_SIZE - 64;
+          if (fSideAFirst) {
+              sellerTxid = ReadHash(txids + 32);
+              sellerAddress = vecValues[1];
+              amountSold = boost::lexical_cast<int64_t>(vecValues[4]);
+              matchingTxid = ReadHash(txids);
+              matchingAddress = vecValues[0];
+              amountReceived = boost::lexical_cast<int64_t>(vecValues[5]);
+          } else {
+              sellerTxid = ReadHash(txids);
+              sellerAddress = vecValues[0];
+              amountSold = boost::lexical_cast<int64_t>(vecValues[5]);
+              matchingTxid = ReadHash(txids + 32);
+              matchingAddress = vecValues[1];
+              amountReceived = boost::lexical_cast<int64_t>(vecValues[4]);
+          }
 
-      UniValue trade(UniValue::VOBJ);
-      trade.push_back(Pair("block", blockNum));
-      trade.push_back(Pair("unitprice", unitPriceStr));
-      trade.push_back(Pair("inverseprice", inversePriceStr));
-      trade.push_back(Pair("sellertxid", sellerTxid.GetHex()));
-      trade.push_back(Pair("selleraddress", sellerAddress));
-      if (propertyIdSideAIsDivisible) {
-          trade.push_back(Pair("amountsold", FormatDivisibleMP(amountSold)));
-      } else {
-          trade.push_back(Pair("amountsold", FormatIndivisibleMP(amountSold)));
-      }
-      if (propertyIdSideBIsDivisible) {
-          trade.push_back(Pair("amountreceived", FormatDivisibleMP(amountReceived)));
-      } else {
-          trade.push_back(Pair("amountreceived", FormatIndivisibleMP(amountReceived)));
+          rational_t unitPrice(amountReceived, amountSold);
+          rational_t inversePrice(amountSold, amountReceived);
+          if (!propertyIdSideAIsDivisible) unitPrice = unitPrice / COIN;
+          if (!propertyIdSideBIsDivisible) inversePrice = inversePrice / COIN;
+          std::string unitPriceStr = xToString(unitPrice); // TODO: not here!
+          std::string inversePriceStr = xToString(inversePrice);
+
+          int64_t blockNum = boost::lexical_cast<int64_t>(vecValues[6]);
+
+          UniValue trade(UniValue::VOBJ);
+          trade.push_back(Pair("block", blockNum));
+          trade.push_back(Pair("unitprice", unitPriceStr));
+          trade.push_back(Pair("inverseprice", inversePriceStr));
+          trade.push_back(Pair("sellertxid", sellerTxid.GetHex()));
+          trade.push_back(Pair("selleraddress", sellerAddress));
+          if (propertyIdSideAIsDivisible) {
+              trade.push_back(Pair("amountsold", FormatDivisibleMP(amountSold)));
+          } else {
+              trade.push_back(Pair("amountsold", FormatIndivisibleMP(amountSold)));
+          }
+          if (propertyIdSideBIsDivisible) {
+              trade.push_back(Pair("amountreceived", FormatDivisibleMP(amountReceived)));
+          } else {
+              trade.push_back(Pair("amountreceived", FormatIndivisibleMP(amountReceived)));
+          }
+          trade.push_back(Pair("matchingtxid", matchingTxid.GetHex()));
+          trade.push_back(Pair("matchingaddress", matchingAddress));
+          vecResponse.push_back(make_pair(blockNum, trade));
+          ++found;
       }
-      trade.push_back(Pair("matchingtxid", matchingTxid.GetHex()));
-      trade.push_back(Pair("matchingaddress", matchingAddress));
-      vecResponse.push_back(make_pair(blockNum, trade));
   }
 
+  delete it;
+
   // sort the response most recent first before adding to the array
-  std::sort(vecResponse.begin(), vecResponse.end(), CompareTradePair);
+  std::stable_sort(vecResponse.begin(), vecResponse.end(), CompareTradePair);
   uint64_t processed = 0;
   for (std::vector<std::pair<int64_t, UniValue> >::iterator it = vecResponse.begin(); it != vecResponse.end(); ++it) {
       responseArray.push_back(it->second);
@@ -3506,8 +4127,6 @@ void CMPTradeList::getTradesForPair(uint32_t propertyIdSideA, uint32_t propertyI
   for (std::vector<UniValue>::iterator it = responseArrayValues.begin(); it != responseArrayValues.end(); ++it) {
       responseArray.push_back(*it);
   }
-
-  delete it;
 }
 
 // obtains a vector of txids where the supplied address participated in a trade (needed for gettradehistory_MP)
@@ -3516,40 +4135,31 @@ void CMPTradeList::getTradesForPair(uint32_t propertyIdSideA, uint32_t propertyI
 void CMPTradeList::getTradesForAddress(std::string address, std::vector<uint256>& vecTransactions, uint32_t propertyIdFilter)
 {
   if (!pdb) return;
-  std::map<std::string,uint256> mapTrades;
+  const std::string prefix = CreateTradeAddressPrefix(address);
   leveldb::Iterator* it = NewIterator();
-  for(it->SeekToFirst(); it->Valid(); it->Next()) {
-      std::string strKey = it->key().ToString();
-      std::string strValue = it->value().ToString();
-      std::vector<std::string> vecValues;
-      if (strKey.size() != 64) continue; // only interested in trades
-      uint256 txid = uint256S(strKey);
-      size_t addressMatch = strValue.find(address);
-      if (addressMatch == std::string::npos) continue;
-      boost::split(vecValues, strValue, boost::is_any_of(":"), token_compress_on);
-      if (vecValues.size() != 5) {
-          PrintToLog("TRADEDB error - unexpected number of tokens in value (%s)\n", strValue);
+  for(it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+      Slice svalue = it->value();
+      if (svalue.size() != TRADE_ADDRESS_VALUE_SIZE) {
+          PrintToLog("TRADEDB error - unexpected size of index value for %s\n", address);
           continue;
       }
-      uint32_t propertyIdForSale = boost::lexical_cast<uint32_t>(vecValues[1]);
-      uint32_t propertyIdDesired = boost::lexical_cast<uint32_t>(vecValues[2]);
-      int64_t blockNum = boost::lexical_cast<uint32_t>(vecValues[3]);
-      int64_t txIndex = boost::lexical_cast<uint32_t>(vecValues[4]);
+      const unsigned char* data = reinterpret_cast<const unsigned char*>(svalue.data());
+      uint32_t propertyIdForSale = ReadBE32(data + 32);
+      uint32_t propertyIdDesired = ReadBE32(data + 32 + sizeof(uint32_t));
       if (propertyIdFilter != 0 && propertyIdFilter != propertyIdForSale && propertyIdFilter != propertyIdDesired) continue;
-      std::string sortKey = strprintf("%06d%010d", blockNum, txIndex);
-      mapTrades.insert(std::make_pair(sortKey, txid));
+      vecTransactions.push_back(ReadHash(svalue.data()));
   }
   delete it;
-  for (std::map<std::string,uint256>::iterator it = mapTrades.begin(); it != mapTrades.end(); it++) {
-      vecTransactions.push_back(it->second);
-  }
 }
 
 void CMPTradeList::recordNewTrade(const uint256& txid, const std::string& address, uint32_t propertyIdForSale, uint32_t propertyIdDesired, int blockNum, int blockIndex)
 {
   if (!pdb) return;
   std::string strValue = strprintf("%s:%d:%d:%d:%d", address, propertyIdForSale, propertyIdDesired, blockNum, blockIndex);
-  Status status = pdb->Put(writeoptions, txid.ToString(), strValue);
+  leveldb::WriteBatch batch;
+  batch.Put(txid.ToString(), strValue);
+  batch.Put(CreateTradeAddressKey(address, blockNum, blockIndex), CreateTradeAddressValue(txid, propertyIdForSale, propertyIdDesired));
+  Status status = pdb->Write(writeoptions, &batch);
   ++nWritten;
   if (elysium_debug_tradedb) PrintToLog("%s(): %s\n", __FUNCTION__, status.ToString());
 }
@@ -3559,13 +4169,12 @@ void CMPTradeList::recordMatchedTrade(const uint256 txid1, const uint256 txid2,
   if (!pdb) return;
   const string key = txid1.ToString() + "+" + txid2.ToString();
   const string value = strprintf("%s:%s:%u:%u:%lu:%lu:%d:%d", address1, address2, prop1, prop2, amount1, amount2, blockNum, fee);
-  Status status;
-  if (pdb)
-  {
-    status = pdb->Put(writeoptions, key, value);
-    ++nWritten;
-    if (elysium_debug_tradedb) PrintToLog("%s(): %s\n", __FUNCTION__, status.ToString());
-  }
+  leveldb::WriteBatch batch;
+  batch.Put(key, value);
+  batch.Put(CreateTradePairKey(prop1, prop2, blockNum, txid1, txid2), value);
+  Status status = pdb->Write(writeoptions, &batch);
+  ++nWritten;
+  if (elysium_debug_tradedb) PrintToLog("%s(): %s\n", __FUNCTION__, status.ToString());
 }
 
 /**
@@ -3585,10 +4194,16 @@ int CMPTradeList::deleteAboveBlock(int blockNum)
   {
     skey = it->key();
     svalue = it->value();
+    if (IsIndexKey(skey)) {
+        // index entries are removed together with their records
+        if (GetIndexKeyBlock(skey) >= blockNum) pdb->Delete(writeoptions, skey);
+        continue;
+    }
     ++count;
+    block = 0;
     string strvalue = it->value().ToString();
     boost::split(vstr, strvalue, boost::is_any_of(":"), token_compress_on);
-    if (7 == vstr.size()) block = atoi(vstr[6]); // trade matches have 7 tokens, key is txid+txid, only care about block
+    if (7 == vstr.size() || 8 == vstr.size()) block = atoi(vstr[6]); // trade matches have 8 tokens (7 without fee), key is txid+txid, only care about block
     if (5 == vstr.size()) block = atoi(vstr[3]); // trades have 5 tokens, key is txid, only care about block
     if (block >= blockNum) {
         ++n_found;
@@ -3616,6 +4231,7 @@ int CMPTradeList::getMPTradeCountTotal()
     Iterator* it = NewIterator();
     for(it->SeekToFirst(); it->Valid(); it->Next())
     {
+        if (IsIndexKey(it->key())) continue;
         ++count;
     }
     delete it;
@@ -3631,6 +4247,7 @@ void CMPTradeList::printAll()
   for(it->SeekToFirst(); it->Valid(); it->Next())
   {
     skey = it->key();
+    if (IsIndexKey(skey)) continue;
     svalue = it->value();
     ++count;
     PrintToLog("entry #%8d= %s:%s\n", count, skey.ToString(), svalue.ToString());
@@ -139,6 +139,7 @@ public:
     {
         leveldb::Status status = Open(path, fWipe);
         PrintToLog("Loading send-to-owners database: %s\n", status.ToString());
+        buildIndexes();
     }
 
     virtual ~CMPSTOList()
@@ -153,9 +154,14 @@ public:
     void printAll();
     bool exists(string address);
     void recordSTOReceive(std::string, const uint256&, int, unsigned int, uint64_t);
+
+private:
+    /** Builds the index of receipts by block, if it is missing or outdated. */
+    void buildIndexes();
 };
 
 /** LevelDB based storage for the trade history. Trades are listed with key "txid1+txid2".
+ * Secondary index entries by property pair and by address use binary keys.
  */
 class CMPTradeList : public CDBBase
 {
@@ -164,6 +170,7 @@ public:
     {
         leveldb::Status status = Open(path, fWipe);
         PrintToLog("Loading trades database: %s\n", status.ToString());
+        buildIndexes();
     }
 
     virtual ~CMPTradeList()
@@ -181,6 +188,10 @@ public:
     void getTradesForAddress(std::string address, std::vector<uint256>& vecTransactions, uint32_t propertyIdFilter = 0);
     void getTradesForPair(uint32_t propertyIdSideA, uint32_t propertyIdSideB, UniValue& response, uint64_t count);
     int getMPTradeCountTotal();
+
+private:
+    /** Builds the indexes of trades by property pair and by address, if they are missing or outdated. */
+    void buildIndexes();
 };
 
 /** LevelDB based storage for transactions, with txid as key and validity bit, and other data as value.
@@ -301,8 +312,20 @@ uint32_t GetNextPropertyId(bool maineco); // maybe move into sp
 
 CMPTally* getTally(const std::string& address);
 
+/** Tokens of a property held by all addresses, and the number of addresses holding any. */
+struct CMPSupply
+{
+    int64_t tokens;
+    int64_t owners;
+
+    CMPSupply() : tokens(0), owners(0) {}
+};
+
 int64_t getTotalTokens(uint32_t propertyId, int64_t* n_owners_total = NULL);
 
+/** Compares the running supply of each property with one recomputed from the tally map and resyncs it on mismatch. */
+bool VerifyTotalTokens(const std::unordered_map<uint32_t, CMPSupply>& computed);
+
 std::string strTransactionType(uint16_t txType);
 
 /** Determines, whether it is valid to use a Class C transaction for a given payload size. */
@@ -312,6 +335,9 @@ bool getValidMPTX(const uint256 &txid, int *block = NULL, unsigned int *type = N
 
 bool update_tally_map(const std::string& who, uint32_t propertyId, int64_t amount, TallyType ttype);
 
+/** Clears all balances, together with the running supply of every property. */
+void clear_tally_map();
+
 std::string getTokenLabel(uint32_t propertyId);
 
 /**
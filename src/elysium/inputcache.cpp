@@ -0,0 +1,151 @@
+#include "inputcache.h"
+
+#include "log.h"
+
+#include "../chain.h"
+#include "../chainparams.h"
+#include "../main.h"
+#include "../sync.h"
+
+namespace elysium {
+
+InputCache::InputCache(size_t maxSize)
+    : maxSize(maxSize), pUndoBlock(NULL), fUndoRead(false), nHits(0), nMisses(0)
+{
+}
+
+InputCache::~InputCache()
+{
+}
+
+bool InputCache::GetInputs(const CTransaction& tx, const CBlockIndex* pBlockIndex, unsigned int idx, std::vector<CTxOut>& outputs)
+{
+    outputs.assign(tx.vin.size(), CTxOut());
+
+    std::vector<size_t> missing;
+    for (size_t i = 0; i < tx.vin.size(); ++i) {
+        const CTxIn& txIn = tx.vin[i];
+        if (txIn.scriptSig.IsSigmaSpend()) {
+            continue;
+        }
+        if (Find(txIn.prevout, outputs[i])) {
+            ++nHits;
+        } else {
+            ++nMisses;
+            missing.push_back(i);
+        }
+    }
+
+    if (missing.empty()) {
+        return true;
+    }
+
+    // the undo data holds the spent outputs in the order of the inputs
+    const CTxUndo* txUndo = pBlockIndex ? GetTxUndo(pBlockIndex, idx) : NULL;
+    if (txUndo && txUndo->vprevout.size() == tx.vin.size()) {
+        for (size_t i : missing) {
+            outputs[i] = txUndo->vprevout[i].txout;
+            Add(tx.vin[i].prevout, outputs[i]);
+        }
+        return true;
+    }
+
+    for (size_t i : missing) {
+        if (!LookupOutput(tx.vin[i].prevout, outputs[i])) {
+            return false;
+        }
+        Add(tx.vin[i].prevout, outputs[i]);
+    }
+
+    return true;
+}
+
+void InputCache::Clear()
+{
+    entries.clear();
+    index.clear();
+    pUndoBlock = NULL;
+    fUndoRead = false;
+    blockUndo.vtxundo.clear();
+}
+
+bool InputCache::ReadBlockUndo(const CBlockIndex* pBlockIndex, CBlockUndo& blockUndo)
+{
+    LOCK(cs_main);
+
+    CDiskBlockPos pos = pBlockIndex->GetUndoPos();
+    if (pos.IsNull() || !pBlockIndex->pprev) {
+        return false;
+    }
+
+    return UndoReadFromDisk(blockUndo, pos, pBlockIndex->pprev->GetBlockHash());
+}
+
+bool InputCache::LookupOutput(const COutPoint& outpoint, CTxOut& output)
+{
+    {
+        LOCK(cs_main);
+        CCoins coins;
+        if (pcoinsTip->GetCoins(outpoint.hash, coins) && coins.IsAvailable(outpoint.n)) {
+            output = coins.vout[outpoint.n];
+            return true;
+        }
+    }
+
+    CTransaction txPrev;
+    uint256 hashBlock;
+    if (!GetTransaction(outpoint.hash, txPrev, Params().GetConsensus(), hashBlock, true) || outpoint.n >= txPrev.vout.size()) {
+        return false;
+    }
+
+    output = txPrev.vout[outpoint.n];
+    return true;
+}
+
+bool InputCache::Find(const COutPoint& outpoint, CTxOut& output)
+{
+    auto it = index.find(outpoint);
+    if (it == index.end()) {
+        return false;
+    }
+
+    entries.splice(entries.begin(), entries, it->second);
+    output = it->second->second;
+    return true;
+}
+
+void InputCache::Add(const COutPoint& outpoint, const CTxOut& output)
+{
+    if (maxSize == 0 || index.count(outpoint)) {
+        return;
+    }
+
+    entries.push_front(std::make_pair(outpoint, output));
+    index.emplace(outpoint, entries.begin());
+
+    while (entries.size() > maxSize) {
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+}
+
+const CTxUndo* InputCache::GetTxUndo(const CBlockIndex* pBlockIndex, unsigned int idx)
+{
+    if (pBlockIndex != pUndoBlock) {
+        pUndoBlock = pBlockIndex;
+        blockUndo.vtxundo.clear();
+        fUndoRead = ReadBlockUndo(pBlockIndex, blockUndo);
+        if (!fUndoRead) {
+            PrintToLog("%s(): no undo data for block %d, falling back to single lookups\n", __func__, pBlockIndex->nHeight);
+        }
+    }
+
+    // the coinbase has no undo entry
+    if (!fUndoRead || idx == 0 || idx > blockUndo.vtxundo.size()) {
+        return NULL;
+    }
+
+    return &blockUndo.vtxundo[idx - 1];
+}
+
+} // namespace elysium
@@ -0,0 +1,82 @@
+#ifndef ZCOIN_ELYSIUM_INPUTCACHE_H
+#define ZCOIN_ELYSIUM_INPUTCACHE_H
+
+#include "../coins.h"
+#include "../primitives/transaction.h"
+#include "../uint256.h"
+#include "../undo.h"
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <stddef.h>
+
+class CBlockIndex;
+
+namespace elysium {
+
+/** Outputs spent by transactions, as needed to identify their senders.
+ *
+ * The inputs of a transaction in a connected block are taken from the undo data of that block,
+ * which is read once for all its transactions. Other inputs come from the chainstate, and only
+ * if the output is spent already from the transaction index. Resolved outputs are kept in a
+ * bounded cache, evicting the least recently used ones.
+ *
+ * Note: not thread-safe, cs_tx_cache guards the instance used for parsing.
+ */
+class InputCache
+{
+public:
+    explicit InputCache(size_t maxSize);
+    virtual ~InputCache();
+
+    /**
+     * Looks up the outputs spent by a transaction, in the order of its inputs. Sigma spends
+     * don't spend outputs and are left null.
+     *
+     * @param tx[in]           The transaction
+     * @param pBlockIndex[in]  The block connecting the transaction or NULL, if unknown
+     * @param idx[in]          The position of the transaction in that block
+     * @param outputs[out]     The spent outputs
+     * @return True, if all spent outputs were found
+     */
+    bool GetInputs(const CTransaction& tx, const CBlockIndex* pBlockIndex, unsigned int idx, std::vector<CTxOut>& outputs);
+
+    void Clear();
+
+    size_t Size() const { return entries.size(); }
+    size_t Hits() const { return nHits; }
+    size_t Misses() const { return nMisses; }
+
+protected:
+    //! Reads the undo data of a block.
+    virtual bool ReadBlockUndo(const CBlockIndex* pBlockIndex, CBlockUndo& blockUndo);
+
+    //! Looks up a single output, for transactions without undo data.
+    virtual bool LookupOutput(const COutPoint& outpoint, CTxOut& output);
+
+private:
+    typedef std::list<std::pair<COutPoint, CTxOut>> EntryList;
+
+    size_t maxSize;
+    EntryList entries; //!< most recently used first
+    std::unordered_map<COutPoint, EntryList::iterator, SaltedOutpointHasher> index;
+
+    //! Undo data of the last block read, transactions of a block are parsed in a row
+    const CBlockIndex* pUndoBlock;
+    bool fUndoRead;
+    CBlockUndo blockUndo;
+
+    size_t nHits;
+    size_t nMisses;
+
+    bool Find(const COutPoint& outpoint, CTxOut& output);
+    void Add(const COutPoint& outpoint, const CTxOut& output);
+    const CTxUndo* GetTxUndo(const CBlockIndex* pBlockIndex, unsigned int idx);
+};
+
+} // namespace elysium
+
+#endif // ZCOIN_ELYSIUM_INPUTCACHE_H
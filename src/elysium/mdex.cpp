@@ -11,6 +11,7 @@
 
 #include "arith_uint256.h"
 #include "chain.h"
+#include "coins.h"
 #include "main.h"
 #include "tinyformat.h"
 #include "uint256.h"
@@ -30,6 +31,9 @@
 #include <map>
 #include <set>
 #include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 
 typedef boost::multiprecision::cpp_dec_float_100 dec_float;
 typedef boost::multiprecision::checked_int128_t int128_t;
@@ -42,6 +46,66 @@ using namespace elysium;
 //! Global map for price and order data
 md_PropertiesMap elysium::metadex;
 
+//! Position of an order, sorted like a walk over the order book
+typedef std::tuple<uint32_t, rational_t, int, unsigned int> md_Position;
+//! Orders of one address in order book order
+typedef std::map<md_Position, md_Set::iterator> md_AddressOrders;
+
+//! Orders in the order book by transaction hash
+static std::unordered_map<uint256, md_Set::iterator, SaltedTxidHasher> metadexByTxid;
+//! Orders in the order book by address
+static std::unordered_map<std::string, md_AddressOrders> metadexByAddr;
+
+static md_Position GetPosition(const CMPMetaDEx& obj)
+{
+    return std::make_tuple(obj.getProperty(), obj.unitPrice(), obj.getBlock(), obj.getIdx());
+}
+
+/** Adds an order, which was just inserted into the order book, to the indexes. */
+static void IndexOrder(md_Set::iterator it)
+{
+    metadexByTxid[it->getHash()] = it;
+    metadexByAddr[it->getAddr()][GetPosition(*it)] = it;
+}
+
+/** Removes an order from the order book and the indexes, and returns the next order of the set. */
+static md_Set::iterator EraseOrder(md_Set& indexes, md_Set::iterator it)
+{
+    metadexByTxid.erase(it->getHash());
+
+    std::unordered_map<std::string, md_AddressOrders>::iterator itAddr = metadexByAddr.find(it->getAddr());
+    if (itAddr != metadexByAddr.end()) {
+        itAddr->second.erase(GetPosition(*it));
+        if (itAddr->second.empty()) metadexByAddr.erase(itAddr);
+    }
+
+    return indexes.erase(it);
+}
+
+/** Removes an order of the address index from the order book and the indexes. */
+static void EraseOrder(md_Set::iterator it)
+{
+    md_Set* indexes = get_Indexes(get_Prices(it->getProperty()), it->unitPrice());
+    assert(indexes);
+    EraseOrder(*indexes, it);
+}
+
+/** Returns the orders of an address, which match the predicate, in order book order. */
+template<typename Predicate>
+static std::vector<md_Set::iterator> GetAddressOrders(const std::string& addr, Predicate predicate)
+{
+    std::vector<md_Set::iterator> orders;
+
+    std::unordered_map<std::string, md_AddressOrders>::const_iterator itAddr = metadexByAddr.find(addr);
+    if (itAddr == metadexByAddr.end()) return orders;
+
+    for (md_AddressOrders::const_iterator it = itAddr->second.begin(); it != itAddr->second.end(); ++it) {
+        if (predicate(*it->second)) orders.push_back(it->second);
+    }
+
+    return orders;
+}
+
 md_PricesMap* elysium::get_Prices(uint32_t prop)
 {
     md_PropertiesMap::iterator it = metadex.find(prop);
@@ -315,12 +379,12 @@ static MatchReturnType x_Trade(CMPMetaDEx* const pnew)
 
             if (elysium_debug_metadex1) PrintToLog("++ erased old: %s\n", offerIt->ToString());
             // erase the old seller element
-            pofferSet->erase(offerIt++);
+            offerIt = EraseOrder(*pofferSet, offerIt);
 
             // insert the updated one in place of the old
             if (0 < seller_replacement.getAmountRemaining()) {
                 PrintToLog("++ inserting seller_replacement: %s\n", seller_replacement.ToString());
-                pofferSet->insert(seller_replacement);
+                IndexOrder(pofferSet->insert(seller_replacement).first);
             }
 
             if (bBuyerSatisfied) {
@@ -456,39 +520,32 @@ bool MetaDEx_compare::operator()(const CMPMetaDEx &lhs, const CMPMetaDEx &rhs) c
 
 bool elysium::MetaDEx_INSERT(const CMPMetaDEx& objMetaDEx)
 {
-    // Create an empty price map (to use in case price map for this property does not already exist)
-    md_PricesMap temp_prices;
-    // Attempt to obtain the price map for the property
-    md_PricesMap *p_prices = get_Prices(objMetaDEx.getProperty());
-
-    // Create an empty set of metadex objects (to use in case no set currently exists at this price)
-    md_Set temp_indexes;
-    md_Set *p_indexes = NULL;
-
-    // Prepare for return code
-    std::pair <md_Set::iterator, bool> ret;
-
-    // Attempt to obtain a set of metadex objects for this price from the price map
-    if (p_prices) p_indexes = get_Indexes(p_prices, objMetaDEx.unitPrice());
-    // See if the set was populated, if not no set exists at this price level, use the empty set that we created earlier
-    if (!p_indexes) p_indexes = &temp_indexes;
+    // Obtain the set of metadex objects for this property and price
+    md_PricesMap* prices = get_Prices(objMetaDEx.getProperty());
+    md_Set* indexes = prices ? get_Indexes(prices, objMetaDEx.unitPrice()) : NULL;
 
     // Attempt to insert the metadex object into the set
-    ret = p_indexes->insert(objMetaDEx);
-    if (false == ret.second) return false;
-
-    // If a prices map did not exist for this property, set p_prices to the temp empty price map
-    if (!p_prices) p_prices = &temp_prices;
-
-    // Update the prices map with the new set at this price
-    (*p_prices)[objMetaDEx.unitPrice()] = *p_indexes;
+    std::pair<md_Set::iterator, bool> ret;
+    if (indexes) {
+        ret = indexes->insert(objMetaDEx);
+        if (false == ret.second) return false;
+    } else {
+        // first order at this price, an empty set always takes it
+        ret = metadex[objMetaDEx.getProperty()][objMetaDEx.unitPrice()].insert(objMetaDEx);
+    }
 
-    // Set the metadex map for the property to the updated (or new if it didn't exist) price map
-    metadex[objMetaDEx.getProperty()] = *p_prices;
+    IndexOrder(ret.first);
 
     return true;
 }
 
+void elysium::MetaDEx_CLEAR()
+{
+    metadex.clear();
+    metadexByTxid.clear();
+    metadexByAddr.clear();
+}
+
 // pretty much directly linked to the ADD TX21 command off the wire
 int elysium::MetaDEx_ADD(const std::string& sender_addr, uint32_t prop, int64_t amount, int block, uint32_t property_desired, int64_t amount_desired, const uint256& txid, unsigned int idx)
 {
@@ -529,49 +586,36 @@ int elysium::MetaDEx_CANCEL_AT_PRICE(const uint256& txid, unsigned int block, co
 {
     int rc = METADEX_ERROR -20;
     CMPMetaDEx mdex(sender_addr, 0, prop, amount, property_desired, amount_desired, uint256(), 0, CMPTransaction::CANCEL_AT_PRICE);
-    md_PricesMap* prices = get_Prices(prop);
-    const CMPMetaDEx* p_mdex = NULL;
 
     if (elysium_debug_metadex1) PrintToLog("%s():%s\n", __FUNCTION__, mdex.ToString());
 
     if (elysium_debug_metadex2) MetaDEx_debug_print();
 
-    if (!prices) {
+    if (!get_Prices(prop)) {
         PrintToLog("%s() NOTHING FOUND for %s\n", __FUNCTION__, mdex.ToString());
         return rc -1;
     }
 
-    // within the desired property map (given one property) iterate over the items
-    for (md_PricesMap::iterator my_it = prices->begin(); my_it != prices->end(); ++my_it) {
-        rational_t sellers_price = my_it->first;
-
-        if (mdex.unitPrice() != sellers_price) continue;
-
-        md_Set* indexes = &(my_it->second);
-
-        for (md_Set::iterator iitt = indexes->begin(); iitt != indexes->end();) {
-            p_mdex = &(*iitt);
+    const rational_t price = mdex.unitPrice();
+    std::vector<md_Set::iterator> orders = GetAddressOrders(sender_addr, [&](const CMPMetaDEx& obj) {
+        return obj.getProperty() == prop && obj.getDesProperty() == property_desired && obj.unitPrice() == price;
+    });
 
-            if (elysium_debug_metadex3) PrintToLog("%s(): %s\n", __FUNCTION__, p_mdex->ToString());
+    for (std::vector<md_Set::iterator>::const_iterator it = orders.begin(); it != orders.end(); ++it) {
+        const CMPMetaDEx* p_mdex = &(**it);
 
-            if ((p_mdex->getDesProperty() != property_desired) || (p_mdex->getAddr() != sender_addr)) {
-                ++iitt;
-                continue;
-            }
-
-            rc = 0;
-            PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, p_mdex->ToString());
+        rc = 0;
+        PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, p_mdex->ToString());
 
-            // move from reserve to main
-            assert(update_tally_map(p_mdex->getAddr(), p_mdex->getProperty(), -p_mdex->getAmountRemaining(), METADEX_RESERVE));
-            assert(update_tally_map(p_mdex->getAddr(), p_mdex->getProperty(), p_mdex->getAmountRemaining(), BALANCE));
+        // move from reserve to main
+        assert(update_tally_map(p_mdex->getAddr(), p_mdex->getProperty(), -p_mdex->getAmountRemaining(), METADEX_RESERVE));
+        assert(update_tally_map(p_mdex->getAddr(), p_mdex->getProperty(), p_mdex->getAmountRemaining(), BALANCE));
 
-            // record the cancellation
-            bool bValid = true;
-            p_txlistdb->recordMetaDExCancelTX(txid, p_mdex->getHash(), bValid, block, p_mdex->getProperty(), p_mdex->getAmountRemaining());
+        // record the cancellation
+        bool bValid = true;
+        p_txlistdb->recordMetaDExCancelTX(txid, p_mdex->getHash(), bValid, block, p_mdex->getProperty(), p_mdex->getAmountRemaining());
 
-            indexes->erase(iitt++);
-        }
+        EraseOrder(*it);
     }
 
     if (elysium_debug_metadex2) MetaDEx_debug_print();
@@ -582,45 +626,35 @@ int elysium::MetaDEx_CANCEL_AT_PRICE(const uint256& txid, unsigned int block, co
 int elysium::MetaDEx_CANCEL_ALL_FOR_PAIR(const uint256& txid, unsigned int block, const std::string& sender_addr, uint32_t prop, uint32_t property_desired)
 {
     int rc = METADEX_ERROR -30;
-    md_PricesMap* prices = get_Prices(prop);
-    const CMPMetaDEx* p_mdex = NULL;
 
     PrintToLog("%s(%d,%d)\n", __FUNCTION__, prop, property_desired);
 
     if (elysium_debug_metadex3) MetaDEx_debug_print();
 
-    if (!prices) {
+    if (!get_Prices(prop)) {
         PrintToLog("%s() NOTHING FOUND\n", __FUNCTION__);
         return rc -1;
     }
 
-    // within the desired property map (given one property) iterate over the items
-    for (md_PricesMap::iterator my_it = prices->begin(); my_it != prices->end(); ++my_it) {
-        md_Set* indexes = &(my_it->second);
-
-        for (md_Set::iterator iitt = indexes->begin(); iitt != indexes->end();) {
-            p_mdex = &(*iitt);
+    std::vector<md_Set::iterator> orders = GetAddressOrders(sender_addr, [&](const CMPMetaDEx& obj) {
+        return obj.getProperty() == prop && obj.getDesProperty() == property_desired;
+    });
 
-            if (elysium_debug_metadex3) PrintToLog("%s(): %s\n", __FUNCTION__, p_mdex->ToString());
+    for (std::vector<md_Set::iterator>::const_iterator it = orders.begin(); it != orders.end(); ++it) {
+        const CMPMetaDEx* p_mdex = &(**it);
 
-            if ((p_mdex->getDesProperty() != property_desired) || (p_mdex->getAddr() != sender_addr)) {
-                ++iitt;
-                continue;
-            }
-
-            rc = 0;
-            PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, p_mdex->ToString());
+        rc = 0;
+        PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, p_mdex->ToString());
 
-            // move from reserve to main
-            assert(update_tally_map(p_mdex->getAddr(), p_mdex->getProperty(), -p_mdex->getAmountRemaining(), METADEX_RESERVE));
-            assert(update_tally_map(p_mdex->getAddr(), p_mdex->getProperty(), p_mdex->getAmountRemaining(), BALANCE));
+        // move from reserve to main
+        assert(update_tally_map(p_mdex->getAddr(), p_mdex->getProperty(), -p_mdex->getAmountRemaining(), METADEX_RESERVE));
+        assert(update_tally_map(p_mdex->getAddr(), p_mdex->getProperty(), p_mdex->getAmountRemaining(), BALANCE));
 
-            // record the cancellation
-            bool bValid = true;
-            p_txlistdb->recordMetaDExCancelTX(txid, p_mdex->getHash(), bValid, block, p_mdex->getProperty(), p_mdex->getAmountRemaining());
+        // record the cancellation
+        bool bValid = true;
+        p_txlistdb->recordMetaDExCancelTX(txid, p_mdex->getHash(), bValid, block, p_mdex->getProperty(), p_mdex->getAmountRemaining());
 
-            indexes->erase(iitt++);
-        }
+        EraseOrder(*it);
     }
 
     if (elysium_debug_metadex3) MetaDEx_debug_print();
@@ -641,44 +675,28 @@ int elysium::MetaDEx_CANCEL_EVERYTHING(const uint256& txid, unsigned int block,
 
     PrintToLog("<<<<<<\n");
 
-    for (md_PropertiesMap::iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
-        unsigned int prop = my_it->first;
+    // skip properties, which are not in the expected ecosystem
+    std::vector<md_Set::iterator> orders = GetAddressOrders(sender_addr, [&](const CMPMetaDEx& obj) {
+        if (isMainEcosystemProperty(ecosystem) && !isMainEcosystemProperty(obj.getProperty())) return false;
+        if (isTestEcosystemProperty(ecosystem) && !isTestEcosystemProperty(obj.getProperty())) return false;
+        return true;
+    });
 
-        // skip property, if it is not in the expected ecosystem
-        if (isMainEcosystemProperty(ecosystem) && !isMainEcosystemProperty(prop)) continue;
-        if (isTestEcosystemProperty(ecosystem) && !isTestEcosystemProperty(prop)) continue;
+    for (std::vector<md_Set::iterator>::const_iterator iter = orders.begin(); iter != orders.end(); ++iter) {
+        md_Set::iterator it = *iter;
 
-        PrintToLog(" ## property: %u\n", prop);
-        md_PricesMap& prices = my_it->second;
+        rc = 0;
+        PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, it->ToString());
 
-        for (md_PricesMap::iterator it = prices.begin(); it != prices.end(); ++it) {
-            rational_t price = it->first;
-            md_Set& indexes = it->second;
+        // move from reserve to balance
+        assert(update_tally_map(it->getAddr(), it->getProperty(), -it->getAmountRemaining(), METADEX_RESERVE));
+        assert(update_tally_map(it->getAddr(), it->getProperty(), it->getAmountRemaining(), BALANCE));
 
-            PrintToLog("  # Price Level: %s\n", xToString(price));
-
-            for (md_Set::iterator it = indexes.begin(); it != indexes.end();) {
-                PrintToLog("%s= %s\n", xToString(price), it->ToString());
-
-                if (it->getAddr() != sender_addr) {
-                    ++it;
-                    continue;
-                }
+        // record the cancellation
+        bool bValid = true;
+        p_txlistdb->recordMetaDExCancelTX(txid, it->getHash(), bValid, block, it->getProperty(), it->getAmountRemaining());
 
-                rc = 0;
-                PrintToLog("%s(): REMOVING %s\n", __FUNCTION__, it->ToString());
-
-                // move from reserve to balance
-                assert(update_tally_map(it->getAddr(), it->getProperty(), -it->getAmountRemaining(), METADEX_RESERVE));
-                assert(update_tally_map(it->getAddr(), it->getProperty(), it->getAmountRemaining(), BALANCE));
-
-                // record the cancellation
-                bool bValid = true;
-                p_txlistdb->recordMetaDExCancelTX(txid, it->getHash(), bValid, block, it->getProperty(), it->getAmountRemaining());
-
-                indexes.erase(it++);
-            }
-        }
+        EraseOrder(it);
     }
     PrintToLog(">>>>>>\n");
 
@@ -704,7 +722,7 @@ int elysium::MetaDEx_SHUTDOWN_ALLPAIR()
                     // move from reserve to balance
                     assert(update_tally_map(it->getAddr(), it->getProperty(), -it->getAmountRemaining(), METADEX_RESERVE));
                     assert(update_tally_map(it->getAddr(), it->getProperty(), it->getAmountRemaining(), BALANCE));
-                    indexes.erase(it++);
+                    it = EraseOrder(indexes, it);
                 }
             }
         }
@@ -728,29 +746,20 @@ int elysium::MetaDEx_SHUTDOWN()
                 // move from reserve to balance
                 assert(update_tally_map(it->getAddr(), it->getProperty(), -it->getAmountRemaining(), METADEX_RESERVE));
                 assert(update_tally_map(it->getAddr(), it->getProperty(), it->getAmountRemaining(), BALANCE));
-                indexes.erase(it++);
+                it = EraseOrder(indexes, it);
             }
         }
     }
     return rc;
 }
 
-// searches the metadex maps to see if a trade is still open
-// allows search to be optimized if propertyIdForSale is specified
+// looks up the order in the txid index to see if a trade is still open
+// the trade is only reported as open if it sells propertyIdForSale, if specified
 bool elysium::MetaDEx_isOpen(const uint256& txid, uint32_t propertyIdForSale)
 {
-    for (md_PropertiesMap::iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
-        if (propertyIdForSale != 0 && propertyIdForSale != my_it->first) continue;
-        md_PricesMap & prices = my_it->second;
-        for (md_PricesMap::iterator it = prices.begin(); it != prices.end(); ++it) {
-            md_Set & indexes = (it->second);
-            for (md_Set::iterator it = indexes.begin(); it != indexes.end(); ++it) {
-                CMPMetaDEx obj = *it;
-                if( obj.getHash().GetHex() == txid.GetHex() ) return true;
-            }
-        }
-    }
-    return false;
+    const CMPMetaDEx* obj = MetaDEx_RetrieveTrade(txid);
+    if (!obj) return false;
+    return propertyIdForSale == 0 || propertyIdForSale == obj->getProperty();
 }
 
 /**
@@ -837,14 +846,7 @@ void elysium::MetaDEx_debug_print(bool bShowPriceLevel, bool bDisplay)
  */
 const CMPMetaDEx* elysium::MetaDEx_RetrieveTrade(const uint256& txid)
 {
-    for (md_PropertiesMap::iterator propIter = metadex.begin(); propIter != metadex.end(); ++propIter) {
-        md_PricesMap & prices = propIter->second;
-        for (md_PricesMap::iterator pricesIter = prices.begin(); pricesIter != prices.end(); ++pricesIter) {
-            md_Set & indexes = pricesIter->second;
-            for (md_Set::iterator tradesIter = indexes.begin(); tradesIter != indexes.end(); ++tradesIter) {
-                if (txid == (*tradesIter).getHash()) return &(*tradesIter);
-            }
-        }
-    }
-    return (CMPMetaDEx*) NULL;
+    std::unordered_map<uint256, md_Set::iterator, SaltedTxidHasher>::const_iterator it = metadexByTxid.find(txid);
+    if (it == metadexByTxid.end()) return (CMPMetaDEx*) NULL;
+    return &(*it->second);
 }
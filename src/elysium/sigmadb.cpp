@@ -244,6 +244,7 @@ void SafeSeekToPreviousKey(leveldb::Iterator *it, const leveldb::Slice& key)
 SigmaDatabase *sigmaDb;
 
 constexpr uint16_t SigmaDatabase::MAX_GROUP_SIZE;
+constexpr size_t SigmaDatabase::MAX_CACHED_GROUPS;
 
 // Database structure
 // Index height and commitment
@@ -251,6 +252,7 @@ constexpr uint16_t SigmaDatabase::MAX_GROUP_SIZE;
 // Sequence of mint sorted following blockchain
 // 1<seq uint64>=key
 SigmaDatabase::SigmaDatabase(const boost::filesystem::path& path, bool wipe, uint16_t groupSize)
+    : groupCacheTick(0), groupCacheGeneration(0)
 {
     auto status = Open(path, wipe);
     if (!status.ok()) {
@@ -292,6 +294,19 @@ std::pair<SigmaMintGroup, SigmaMintIndex> SigmaDatabase::RecordMint(
 
     AddEntry(key, GetSlice(buffer), height);
 
+    // Write through to the cached group, or drop it if the mint doesn't extend it.
+    {
+        LOCK(cs_groupCache);
+        auto it = groupCache.find(std::make_tuple(propertyId, denomination, lastGroup));
+        if (it != groupCache.end()) {
+            if (it->second.members.size() == nextIdx && pubKey.IsMember()) {
+                it->second.members.push_back(pubKey);
+            } else {
+                groupCache.erase(it);
+            }
+        }
+    }
+
     // Raise event.
     MintAdded(propertyId, denomination, lastGroup, nextIdx, pubKey, height);
 
@@ -445,6 +460,12 @@ void SigmaDatabase::DeleteAll(int startBlock)
         throw std::runtime_error("Fail to update database");
     }
 
+    {
+        LOCK(cs_groupCache);
+        groupCache.clear();
+        groupCacheGeneration++;
+    }
+
     for (auto &defer : defers) {
         defer();
     }
@@ -553,6 +574,67 @@ size_t SigmaDatabase::GetAnonimityGroup(
     return i;
 }
 
+std::shared_ptr<const std::vector<SigmaPublicKey>> SigmaDatabase::GetAnonimityGroupSnapshot(
+    uint32_t propertyId, uint8_t denomination, uint32_t groupId, size_t count)
+{
+    auto key = std::make_tuple(propertyId, denomination, groupId);
+
+    while (true) {
+        uint64_t generation;
+
+        {
+            LOCK(cs_groupCache);
+
+            auto it = groupCache.find(key);
+            if (it != groupCache.end() && it->second.members.size() >= count) {
+                auto& group = it->second;
+                group.lastUsed = ++groupCacheTick;
+                if (!group.snapshot || group.snapshot->size() < count) {
+                    group.snapshot = std::make_shared<const std::vector<SigmaPublicKey>>(group.members);
+                }
+                return group.snapshot;
+            }
+
+            generation = groupCacheGeneration;
+        }
+
+        // Load the whole group without holding the lock, it decodes and checks every mint.
+        std::vector<SigmaPublicKey> members;
+        GetAnonimityGroup(propertyId, denomination, groupId, groupSize, std::back_inserter(members));
+
+        LOCK(cs_groupCache);
+
+        if (generation != groupCacheGeneration) {
+            continue;
+        }
+
+        auto it = groupCache.find(key);
+        if (it == groupCache.end()) {
+            if (groupCache.size() >= MAX_CACHED_GROUPS) {
+                auto oldest = groupCache.begin();
+                for (auto i = groupCache.begin(); i != groupCache.end(); i++) {
+                    if (i->second.lastUsed < oldest->second.lastUsed) {
+                        oldest = i;
+                    }
+                }
+                groupCache.erase(oldest);
+            }
+            it = groupCache.insert(std::make_pair(key, CachedGroup())).first;
+        }
+
+        // A mint recorded while loading may already be in the cached group.
+        auto& group = it->second;
+        if (group.members.size() < members.size()) {
+            group.members = std::move(members);
+        }
+        group.lastUsed = ++groupCacheTick;
+        if (!group.snapshot || group.snapshot->size() < std::min(count, group.members.size())) {
+            group.snapshot = std::make_shared<const std::vector<SigmaPublicKey>>(group.members);
+        }
+        return group.snapshot;
+    }
+}
+
 uint32_t SigmaDatabase::GetLastGroupId(
     uint32_t propertyId,
     uint8_t denomination)
@@ -6,6 +6,7 @@
 #include "property.h"
 #include "sigmaprimitives.h"
 
+#include "../sync.h"
 #include "../uint256.h"
 
 #include <univalue.h>
@@ -15,7 +16,10 @@
 
 #include <leveldb/slice.h>
 
+#include <map>
+#include <memory>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include <inttypes.h>
@@ -84,6 +88,14 @@ public:
         return firstIt;
     }
 
+    /**
+     * Members of a group from an in-memory cache, already checked to be valid. RecordMint and DeleteAll keep the
+     * cache in step with the database. The set holds at least the first count members, unless the group has fewer
+     * mints. It may hold more. It never changes and can be used without holding any lock.
+     */
+    std::shared_ptr<const std::vector<SigmaPublicKey>> GetAnonimityGroupSnapshot(
+        uint32_t propertyId, uint8_t denomination, uint32_t groupId, size_t count);
+
     void DeleteAll(int startBlock);
 
     uint32_t GetLastGroupId(uint32_t propertyId, uint8_t denomination);
@@ -104,6 +116,25 @@ public:
 protected:
     void AddEntry(const leveldb::Slice& key, const leveldb::Slice& value, int block);
 
+private:
+    /**
+     * Number of groups kept by the anonimity group cache.
+     */
+    static constexpr size_t MAX_CACHED_GROUPS = 16;
+
+    struct CachedGroup
+    {
+        std::vector<SigmaPublicKey> members;
+        std::shared_ptr<const std::vector<SigmaPublicKey>> snapshot;
+        uint64_t lastUsed;
+    };
+
+    CCriticalSection cs_groupCache;
+    std::map<std::tuple<uint32_t, uint8_t, uint32_t>, CachedGroup> groupCache;
+    uint64_t groupCacheTick;
+    // Bumped by DeleteAll, groups loaded while it ran may contain deleted mints.
+    uint64_t groupCacheGeneration;
+
 private:
     void RecordGroupSize(uint16_t groupSize);
 
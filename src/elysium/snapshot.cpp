@@ -0,0 +1,254 @@
+#include "snapshot.h"
+
+#include "log.h"
+
+#include "../clientversion.h"
+#include "../fs.h"
+#include "../hash.h"
+#include "../util.h"
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace elysium {
+
+namespace {
+
+const char SNAPSHOT_MAGIC[4] = {'E', 'L', 'S', 'S'};
+
+} // anonymous namespace
+
+const uint32_t StateSnapshot::CURRENT_VERSION;
+
+StateSnapshot::StateSnapshot(const uint256& blockHash, unsigned sectionCount)
+    : blockHash(blockHash), sections(sectionCount, CDataStream(SER_DISK, CLIENT_VERSION))
+{
+}
+
+bool StateSnapshot::Write(const boost::filesystem::path& path) const
+{
+    boost::filesystem::path pathTmp = path;
+    pathTmp.replace_extension(".tmp");
+
+    CAutoFile file(fsbridge::fopen(pathTmp, "wb"), SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        PrintToLog("%s(): failed to open %s\n", __func__, pathTmp.string());
+        return false;
+    }
+
+    // header, then every section followed by the checksum of its records
+    try {
+        file << FLATDATA(SNAPSHOT_MAGIC);
+        file << CURRENT_VERSION;
+        file << blockHash;
+        WriteCompactSize(file, sections.size());
+        for (const CDataStream& section : sections) {
+            WriteCompactSize(file, section.size());
+            if (!section.empty()) {
+                file.write(&section[0], section.size());
+            }
+            file << Hash(section.begin(), section.end());
+        }
+    } catch (const std::exception& e) {
+        PrintToLog("%s(): failed to write %s: %s\n", __func__, pathTmp.string(), e.what());
+        file.fclose();
+        boost::filesystem::remove(pathTmp);
+        return false;
+    }
+    FileCommit(file.Get());
+    file.fclose();
+
+    if (!RenameOver(pathTmp, path)) {
+        PrintToLog("%s(): failed to rename %s\n", __func__, pathTmp.string());
+        return false;
+    }
+
+    return true;
+}
+
+MappedSnapshot::MappedSnapshot() : data(NULL), size(0)
+{
+}
+
+MappedSnapshot::~MappedSnapshot()
+{
+    Close();
+}
+
+void MappedSnapshot::Close()
+{
+#ifdef WIN32
+    buffer.clear();
+    buffer.shrink_to_fit();
+#else
+    if (data) {
+        munmap(const_cast<char*>(data), size);
+    }
+#endif
+    data = NULL;
+    size = 0;
+    sections.clear();
+}
+
+bool MappedSnapshot::Open(const boost::filesystem::path& path, const uint256& blockHash, unsigned sectionCount)
+{
+    Close();
+
+#ifdef WIN32
+    // no mapping here, read the whole file instead
+    FILE* file = fsbridge::fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+    char chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        buffer.insert(buffer.end(), chunk, chunk + n);
+    }
+    fclose(file);
+    if (buffer.empty()) {
+        return false;
+    }
+    data = buffer.data();
+    size = buffer.size();
+#else
+    int fd = open(path.string().c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    void* mapped = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        PrintToLog("%s(): failed to map %s\n", __func__, path.string());
+        return false;
+    }
+    posix_madvise(mapped, st.st_size, POSIX_MADV_SEQUENTIAL);
+    data = static_cast<const char*>(mapped);
+    size = st.st_size;
+#endif
+
+    try {
+        MemoryReader reader(data, data + size, SER_DISK, CLIENT_VERSION);
+
+        char magic[sizeof(SNAPSHOT_MAGIC)];
+        uint32_t version;
+        uint256 hash;
+        reader >> FLATDATA(magic) >> version >> hash;
+        if (memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0 || version != StateSnapshot::CURRENT_VERSION) {
+            PrintToLog("%s(): %s is no snapshot of version %d\n", __func__, path.string(), StateSnapshot::CURRENT_VERSION);
+            Close();
+            return false;
+        }
+        if (hash != blockHash || ReadCompactSize(reader) != sectionCount) {
+            PrintToLog("%s(): %s does not match block %s\n", __func__, path.string(), blockHash.GetHex());
+            Close();
+            return false;
+        }
+
+        for (unsigned i = 0; i < sectionCount; ++i) {
+            uint64_t sectionSize = ReadCompactSize(reader);
+            if (sectionSize > reader.size()) {
+                throw std::ios_base::failure("section exceeds the file");
+            }
+            const char* begin = data + size - reader.size();
+            const char* end = begin + sectionSize;
+            reader = MemoryReader(end, data + size, SER_DISK, CLIENT_VERSION);
+
+            uint256 checksum;
+            reader >> checksum;
+            if (checksum != Hash(begin, end)) {
+                PrintToLog("%s(): section %d of %s failed checksum validation\n", __func__, i, path.string());
+                Close();
+                return false;
+            }
+            sections.push_back(std::make_pair(begin, end));
+        }
+    } catch (const std::exception& e) {
+        PrintToLog("%s(): %s is truncated: %s\n", __func__, path.string(), e.what());
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+MemoryReader MappedSnapshot::Section(unsigned type) const
+{
+    const std::pair<const char*, const char*>& section = sections.at(type);
+    return MemoryReader(section.first, section.second, SER_DISK, CLIENT_VERSION);
+}
+
+SnapshotWriter::SnapshotWriter() : fWriting(false), fStop(false)
+{
+    thread = boost::thread(&SnapshotWriter::ThreadWrite, this);
+}
+
+SnapshotWriter::~SnapshotWriter()
+{
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        fStop = true;
+    }
+    cond.notify_all();
+    thread.join();
+}
+
+void SnapshotWriter::Queue(const boost::filesystem::path& path, std::unique_ptr<StateSnapshot> snapshot)
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    while (queue.size() >= MAX_QUEUED) {
+        cond.wait(lock);
+    }
+    queue.push_back(std::make_pair(path, std::move(snapshot)));
+    cond.notify_all();
+}
+
+void SnapshotWriter::Flush()
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    while (!queue.empty() || fWriting) {
+        cond.wait(lock);
+    }
+}
+
+void SnapshotWriter::ThreadWrite()
+{
+    RenameThread("elysium-snapshot");
+
+    boost::unique_lock<boost::mutex> lock(mutex);
+    while (true) {
+        while (queue.empty() && !fStop) {
+            cond.wait(lock);
+        }
+        // snapshots still queued at shutdown are written before stopping
+        if (queue.empty()) {
+            break;
+        }
+
+        std::pair<boost::filesystem::path, std::unique_ptr<StateSnapshot>> next = std::move(queue.front());
+        queue.pop_front();
+        fWriting = true;
+        cond.notify_all();
+
+        lock.unlock();
+        if (!next.second->Write(next.first)) {
+            PrintToLog("Failed to write state snapshot for block %s\n", next.second->GetBlockHash().GetHex());
+        }
+        next.second.reset();
+        lock.lock();
+
+        fWriting = false;
+        cond.notify_all();
+    }
+}
+
+} // namespace elysium
@@ -0,0 +1,147 @@
+#ifndef ZCOIN_ELYSIUM_SNAPSHOT_H
+#define ZCOIN_ELYSIUM_SNAPSHOT_H
+
+#include "../streams.h"
+#include "../uint256.h"
+
+#include <boost/filesystem/path.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <deque>
+#include <ios>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <inttypes.h>
+#include <string.h>
+
+namespace elysium {
+
+/** Deserializes from memory owned by someone else, such as a section of a mapped snapshot.
+ */
+class MemoryReader
+{
+private:
+    const char* pbegin;
+    const char* pend;
+    int nType;
+    int nVersion;
+
+public:
+    MemoryReader(const char* begin, const char* end, int nTypeIn, int nVersionIn)
+        : pbegin(begin), pend(end), nType(nTypeIn), nVersion(nVersionIn)
+    {
+    }
+
+    bool empty() const { return pbegin == pend; }
+    size_t size() const { return pend - pbegin; }
+
+    int GetType() const { return nType; }
+    int GetVersion() const { return nVersion; }
+
+    MemoryReader& read(char* pch, size_t nSize)
+    {
+        if (nSize > size()) {
+            throw std::ios_base::failure("MemoryReader::read(): end of data");
+        }
+        memcpy(pch, pbegin, nSize);
+        pbegin += nSize;
+        return *this;
+    }
+
+    template<typename T>
+    MemoryReader& operator>>(T& obj)
+    {
+        ::Unserialize(*this, obj, nType, nVersion);
+        return *this;
+    }
+};
+
+/** Binary snapshot of the state after a block, the counterpart of the text state files.
+ *
+ * Every section holds the records of one state file type and carries its own checksum. A
+ * snapshot is written to a temporary file and renamed in place, and all checksums are
+ * verified before any section is handed out, so a damaged file is never half applied.
+ */
+class StateSnapshot
+{
+public:
+    static const uint32_t CURRENT_VERSION = 1;
+
+    explicit StateSnapshot(const uint256& blockHash, unsigned sectionCount);
+
+    const uint256& GetBlockHash() const { return blockHash; }
+
+    //! Stream to serialize the records of the given section into.
+    CDataStream& Section(unsigned type) { return sections.at(type); }
+
+    bool Write(const boost::filesystem::path& path) const;
+
+private:
+    uint256 blockHash;
+    std::vector<CDataStream> sections;
+};
+
+/** Snapshot file mapped into memory for loading.
+ */
+class MappedSnapshot
+{
+public:
+    MappedSnapshot();
+    ~MappedSnapshot();
+
+    /**
+     * Maps the snapshot and verifies it was taken at the given block, has the expected
+     * number of sections and that all of them match their checksum.
+     */
+    bool Open(const boost::filesystem::path& path, const uint256& blockHash, unsigned sectionCount);
+
+    MemoryReader Section(unsigned type) const;
+
+private:
+    const char* data;
+    size_t size;
+#ifdef WIN32
+    std::vector<char> buffer;
+#endif
+    std::vector<std::pair<const char*, const char*>> sections;
+
+    void Close();
+
+    MappedSnapshot(const MappedSnapshot&) = delete;
+    MappedSnapshot& operator=(const MappedSnapshot&) = delete;
+};
+
+/** Writes snapshots on a background thread, in the order they were queued.
+ */
+class SnapshotWriter
+{
+public:
+    //! Snapshots waiting to be written before Queue() blocks the caller.
+    static const size_t MAX_QUEUED = 4;
+
+    SnapshotWriter();
+    ~SnapshotWriter();
+
+    void Queue(const boost::filesystem::path& path, std::unique_ptr<StateSnapshot> snapshot);
+
+    //! Waits until every snapshot queued so far is on disk.
+    void Flush();
+
+private:
+    boost::mutex mutex;
+    boost::condition_variable cond;
+    std::deque<std::pair<boost::filesystem::path, std::unique_ptr<StateSnapshot>>> queue;
+    bool fWriting;
+    bool fStop;
+    boost::thread thread;
+
+    void ThreadWrite();
+};
+
+} // namespace elysium
+
+#endif // ZCOIN_ELYSIUM_SNAPSHOT_H
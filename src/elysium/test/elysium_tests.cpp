@@ -1,4 +1,5 @@
 #include "../elysium.h"
+#include "../fees.h"
 #include "../rules.h"
 #include "../sp.h"
 
@@ -32,4 +33,66 @@ BOOST_AUTO_TEST_CASE(elysium_mints_overflow)
     );
 }
 
+BOOST_AUTO_TEST_CASE(elysium_total_tokens_running)
+{
+    _my_sps = new CMPSPInfo(pathTemp / "MP_spinfo_supply_test", false);
+    p_feecache = new CElysiumFeeCache(pathTemp / "MP_feecache_supply_test", false);
+
+    CMPSPInfo::Entry sp;
+    auto property = _my_sps->putSP(1, sp);
+    auto other = _my_sps->putSP(1, sp);
+
+    const std::string addrA = "1KYiKJEfdJtap9QX2v9BXJMpz2SfU4pgZw";
+    const std::string addrB = "1JztLWos5K7LsqW5E78EASgiVBaCe6f7cD";
+
+    clear_tally_map();
+    int64_t owners = -1;
+    BOOST_CHECK_EQUAL(getTotalTokens(property, &owners), 0);
+    BOOST_CHECK_EQUAL(owners, 0);
+
+    BOOST_CHECK(update_tally_map(addrA, property, 100, BALANCE));
+    BOOST_CHECK(update_tally_map(addrB, property, 50, BALANCE));
+    BOOST_CHECK(update_tally_map(addrB, other, 7, BALANCE));
+    BOOST_CHECK_EQUAL(getTotalTokens(property, &owners), 150);
+    BOOST_CHECK_EQUAL(owners, 2);
+
+    // reserves are part of the supply, pending amounts and failed updates are not
+    BOOST_CHECK(update_tally_map(addrA, property, -40, BALANCE));
+    BOOST_CHECK(update_tally_map(addrA, property, 40, METADEX_RESERVE));
+    BOOST_CHECK(update_tally_map(addrA, property, 30, PENDING));
+    BOOST_CHECK(!update_tally_map(addrB, property, -51, BALANCE));
+    BOOST_CHECK_EQUAL(getTotalTokens(property, &owners), 150);
+    BOOST_CHECK_EQUAL(owners, 2);
+
+    // an address emptied of the property is no owner any more
+    BOOST_CHECK(update_tally_map(addrB, property, -50, BALANCE));
+    BOOST_CHECK_EQUAL(getTotalTokens(property, &owners), 100);
+    BOOST_CHECK_EQUAL(owners, 1);
+    BOOST_CHECK_EQUAL(getTotalTokens(other, &owners), 7);
+    BOOST_CHECK_EQUAL(owners, 1);
+
+    // totals matching the tally verify, others replace the running ones
+    std::unordered_map<uint32_t, CMPSupply> computed;
+    computed[property].tokens = 100;
+    computed[property].owners = 1;
+    computed[other].tokens = 7;
+    computed[other].owners = 1;
+    BOOST_CHECK(VerifyTotalTokens(computed));
+    computed[other].tokens = 8;
+    BOOST_CHECK(!VerifyTotalTokens(computed));
+    BOOST_CHECK_EQUAL(getTotalTokens(other), 8);
+    computed.erase(other);
+    BOOST_CHECK(!VerifyTotalTokens(computed));
+    BOOST_CHECK_EQUAL(getTotalTokens(other), 0);
+
+    clear_tally_map();
+    BOOST_CHECK_EQUAL(getTotalTokens(property, &owners), 0);
+    BOOST_CHECK_EQUAL(owners, 0);
+
+    delete p_feecache;
+    p_feecache = NULL;
+    delete _my_sps;
+    _my_sps = NULL;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,158 @@
+#include "../inputcache.h"
+
+#include "arith_uint256.h"
+#include "chain.h"
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+#include <vector>
+
+using namespace elysium;
+
+namespace {
+
+class TestInputCache : public InputCache
+{
+public:
+    std::map<const CBlockIndex*, CBlockUndo> undos;
+    std::map<COutPoint, CTxOut> outputs;
+    int nUndoReads;
+    int nLookups;
+
+    explicit TestInputCache(size_t maxSize) : InputCache(maxSize), nUndoReads(0), nLookups(0)
+    {
+    }
+
+protected:
+    bool ReadBlockUndo(const CBlockIndex* pBlockIndex, CBlockUndo& blockUndo) override
+    {
+        nUndoReads++;
+        auto it = undos.find(pBlockIndex);
+        if (it == undos.end()) {
+            return false;
+        }
+        blockUndo = it->second;
+        return true;
+    }
+
+    bool LookupOutput(const COutPoint& outpoint, CTxOut& output) override
+    {
+        nLookups++;
+        auto it = outputs.find(outpoint);
+        if (it == outputs.end()) {
+            return false;
+        }
+        output = it->second;
+        return true;
+    }
+};
+
+CTxOut CreateOutput(CAmount value)
+{
+    return CTxOut(value, CScript() << OP_TRUE);
+}
+
+CTransaction CreateSpend(const std::vector<COutPoint>& prevouts)
+{
+    CMutableTransaction tx;
+    for (const COutPoint& prevout : prevouts) {
+        tx.vin.push_back(CTxIn(prevout));
+    }
+    tx.vout.push_back(CreateOutput(1));
+    return tx;
+}
+
+} // anonymous namespace
+
+BOOST_FIXTURE_TEST_SUITE(elysium_inputcache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(inputs_from_block_undo)
+{
+    TestInputCache cache(100);
+    CBlockIndex block;
+
+    COutPoint a(ArithToUint256(1), 0), b(ArithToUint256(2), 3), c(ArithToUint256(3), 1);
+    CBlockUndo& undo = cache.undos[&block];
+    undo.vtxundo.resize(2);
+    undo.vtxundo[0].vprevout.push_back(CTxInUndo(CreateOutput(10)));
+    undo.vtxundo[0].vprevout.push_back(CTxInUndo(CreateOutput(20)));
+    undo.vtxundo[1].vprevout.push_back(CTxInUndo(CreateOutput(30)));
+
+    // the undo data of the block is read once for all of its transactions
+    std::vector<CTxOut> outputs;
+    BOOST_CHECK(cache.GetInputs(CreateSpend({a, b}), &block, 1, outputs));
+    BOOST_CHECK_EQUAL(outputs.size(), 2);
+    BOOST_CHECK_EQUAL(outputs[0].nValue, 10);
+    BOOST_CHECK_EQUAL(outputs[1].nValue, 20);
+    BOOST_CHECK(cache.GetInputs(CreateSpend({c}), &block, 2, outputs));
+    BOOST_CHECK_EQUAL(outputs[0].nValue, 30);
+    BOOST_CHECK_EQUAL(cache.nUndoReads, 1);
+    BOOST_CHECK_EQUAL(cache.nLookups, 0);
+    BOOST_CHECK_EQUAL(cache.Size(), 3);
+
+    // later queries of the same transactions are served from the cache
+    BOOST_CHECK(cache.GetInputs(CreateSpend({a, b}), NULL, 0, outputs));
+    BOOST_CHECK_EQUAL(outputs[1].nValue, 20);
+    BOOST_CHECK_EQUAL(cache.Hits(), 2);
+    BOOST_CHECK_EQUAL(cache.Misses(), 3);
+    BOOST_CHECK_EQUAL(cache.nLookups, 0);
+}
+
+BOOST_AUTO_TEST_CASE(inputs_without_undo)
+{
+    TestInputCache cache(100);
+    CBlockIndex block, other;
+
+    COutPoint a(ArithToUint256(1), 0), b(ArithToUint256(2), 0);
+    cache.outputs[a] = CreateOutput(10);
+    cache.outputs[b] = CreateOutput(20);
+
+    // undo data not matching the transaction is ignored
+    cache.undos[&block].vtxundo.resize(1);
+    cache.undos[&block].vtxundo[0].vprevout.push_back(CTxInUndo(CreateOutput(99)));
+
+    std::vector<CTxOut> outputs;
+    BOOST_CHECK(cache.GetInputs(CreateSpend({a, b}), &block, 1, outputs));
+    BOOST_CHECK_EQUAL(outputs[0].nValue, 10);
+    BOOST_CHECK_EQUAL(outputs[1].nValue, 20);
+    BOOST_CHECK_EQUAL(cache.nLookups, 2);
+
+    // so are coinbase positions and blocks without undo data
+    BOOST_CHECK(!cache.GetInputs(CreateSpend({COutPoint(ArithToUint256(5), 0)}), &block, 0, outputs));
+    BOOST_CHECK(!cache.GetInputs(CreateSpend({COutPoint(ArithToUint256(5), 0)}), &other, 1, outputs));
+    BOOST_CHECK_EQUAL(cache.nUndoReads, 2);
+    BOOST_CHECK_EQUAL(cache.nLookups, 4);
+    BOOST_CHECK_EQUAL(cache.Size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(least_recently_used_evicted)
+{
+    TestInputCache cache(2);
+
+    COutPoint a(ArithToUint256(1), 0), b(ArithToUint256(2), 0), c(ArithToUint256(3), 0);
+    cache.outputs[a] = CreateOutput(10);
+    cache.outputs[b] = CreateOutput(20);
+    cache.outputs[c] = CreateOutput(30);
+
+    std::vector<CTxOut> outputs;
+    BOOST_CHECK(cache.GetInputs(CreateSpend({a}), NULL, 0, outputs));
+    BOOST_CHECK(cache.GetInputs(CreateSpend({b}), NULL, 0, outputs));
+    BOOST_CHECK(cache.GetInputs(CreateSpend({a}), NULL, 0, outputs));
+    BOOST_CHECK_EQUAL(cache.nLookups, 2);
+
+    // b is the least recently used
+    BOOST_CHECK(cache.GetInputs(CreateSpend({c}), NULL, 0, outputs));
+    BOOST_CHECK_EQUAL(cache.Size(), 2);
+    BOOST_CHECK(cache.GetInputs(CreateSpend({a}), NULL, 0, outputs));
+    BOOST_CHECK_EQUAL(cache.nLookups, 3);
+    BOOST_CHECK(cache.GetInputs(CreateSpend({b}), NULL, 0, outputs));
+    BOOST_CHECK_EQUAL(outputs[0].nValue, 20);
+    BOOST_CHECK_EQUAL(cache.nLookups, 4);
+
+    cache.Clear();
+    BOOST_CHECK_EQUAL(cache.Size(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
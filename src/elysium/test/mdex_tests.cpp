@@ -0,0 +1,233 @@
+#include "elysium/mdex.h"
+#include "elysium/tally.h"
+#include "elysium/elysium.h"
+#include "elysium/property.h"
+#include "elysium/tx.h"
+
+#include "arith_uint256.h"
+#include "test/test_bitcoin.h"
+
+#include <stdint.h>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace elysium;
+
+namespace {
+
+/** Cancellations are recorded in the transaction list, which the plain testing setup does not open. */
+struct MetaDExTestingSetup : public TestingSetup
+{
+    MetaDExTestingSetup()
+    {
+        p_txlistdb = new CMPTxList(pathTemp / "MP_txlist_mdex", true);
+    }
+
+    ~MetaDExTestingSetup()
+    {
+        MetaDEx_CLEAR();
+        clear_tally_map();
+        delete p_txlistdb;
+        p_txlistdb = nullptr;
+    }
+};
+
+/** Puts an order into the order book and reserves its amount, as MetaDEx_ADD does. */
+void InsertOrder(const CMPMetaDEx& order)
+{
+    BOOST_REQUIRE(MetaDEx_INSERT(order));
+    BOOST_REQUIRE(update_tally_map(order.getAddr(), order.getProperty(), order.getAmountRemaining(), METADEX_RESERVE));
+}
+
+size_t CountOrders()
+{
+    size_t count = 0;
+    for (md_PropertiesMap::const_iterator itProp = metadex.begin(); itProp != metadex.end(); ++itProp) {
+        for (md_PricesMap::const_iterator itPrice = itProp->second.begin(); itPrice != itProp->second.end(); ++itPrice) {
+            count += itPrice->second.size();
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(elysium_mdex_tests, MetaDExTestingSetup)
+
+BOOST_AUTO_TEST_CASE(metadex_txid_index)
+{
+    const std::string addrA = "1KYiKJEfdJtap9QX2v9BXJMpz2SfU4pgZw";
+    const std::string addrB = "1JztLWos5K7LsqW5E78EASgiVBaCe6f7cD";
+    const uint256 txidA = ArithToUint256(1);
+    const uint256 txidB = ArithToUint256(2);
+    const uint256 txidC = ArithToUint256(3);
+
+    MetaDEx_CLEAR();
+
+    CMPMetaDEx orderA(addrA, 100, 3, 1000, 4, 2000, txidA, 1, CMPTransaction::ADD);
+    CMPMetaDEx orderB(addrB, 100, 3, 1000, 4, 2000, txidB, 2, CMPTransaction::ADD);
+    CMPMetaDEx orderC(addrA, 101, 4, 500, 3, 100, txidC, 1, CMPTransaction::ADD);
+    BOOST_CHECK(MetaDEx_INSERT(orderA));
+    BOOST_CHECK(MetaDEx_INSERT(orderB));
+    BOOST_CHECK(MetaDEx_INSERT(orderC));
+
+    // same block and position
+    CMPMetaDEx duplicate(addrB, 100, 3, 1000, 4, 2000, ArithToUint256(4), 1, CMPTransaction::ADD);
+    BOOST_CHECK(!MetaDEx_INSERT(duplicate));
+    BOOST_CHECK(!MetaDEx_isOpen(ArithToUint256(4)));
+
+    BOOST_CHECK(MetaDEx_isOpen(txidA));
+    BOOST_CHECK(MetaDEx_isOpen(txidA, 3));
+    BOOST_CHECK(!MetaDEx_isOpen(txidA, 4));
+    BOOST_CHECK(MetaDEx_isOpen(txidC, 4));
+
+    const CMPMetaDEx* trade = MetaDEx_RetrieveTrade(txidB);
+    BOOST_REQUIRE(trade != NULL);
+    BOOST_CHECK_EQUAL(trade->getAddr(), addrB);
+    BOOST_CHECK_EQUAL(trade->getIdx(), 2U);
+
+    // orders are returned to the balances of their owners when removed
+    BOOST_CHECK(update_tally_map(addrA, 3, 1000, METADEX_RESERVE));
+    BOOST_CHECK(update_tally_map(addrB, 3, 1000, METADEX_RESERVE));
+    BOOST_CHECK(update_tally_map(addrA, 4, 500, METADEX_RESERVE));
+    BOOST_CHECK_EQUAL(MetaDEx_SHUTDOWN(), 0);
+
+    BOOST_CHECK(!MetaDEx_isOpen(txidA));
+    BOOST_CHECK(!MetaDEx_isOpen(txidB));
+    BOOST_CHECK(MetaDEx_RetrieveTrade(txidC) == NULL);
+    BOOST_CHECK_EQUAL(getMPbalance(addrA, 3, BALANCE), 1000);
+    BOOST_CHECK_EQUAL(getMPbalance(addrA, 4, METADEX_RESERVE), 0);
+
+    // the indexes are cleared with the order book
+    BOOST_CHECK(MetaDEx_INSERT(orderA));
+    BOOST_CHECK(MetaDEx_isOpen(txidA));
+    MetaDEx_CLEAR();
+    BOOST_CHECK(!MetaDEx_isOpen(txidA));
+    BOOST_CHECK(metadex.empty());
+
+    clear_tally_map();
+}
+
+BOOST_AUTO_TEST_CASE(metadex_cancel_at_price)
+{
+    const std::string addrA = "1KYiKJEfdJtap9QX2v9BXJMpz2SfU4pgZw";
+    const std::string addrB = "1JztLWos5K7LsqW5E78EASgiVBaCe6f7cD";
+
+    CMPMetaDEx orderA1(addrA, 100, 3, 1000, 4, 2000, ArithToUint256(1), 1, CMPTransaction::ADD);
+    CMPMetaDEx orderA2(addrA, 101, 3, 500, 4, 1000, ArithToUint256(2), 1, CMPTransaction::ADD);
+    CMPMetaDEx orderA3(addrA, 101, 3, 1000, 4, 3000, ArithToUint256(3), 2, CMPTransaction::ADD);
+    CMPMetaDEx orderA4(addrA, 102, 3, 1000, 5, 2000, ArithToUint256(4), 1, CMPTransaction::ADD);
+    CMPMetaDEx orderB1(addrB, 100, 3, 1000, 4, 2000, ArithToUint256(5), 2, CMPTransaction::ADD);
+    InsertOrder(orderA1);
+    InsertOrder(orderA2);
+    InsertOrder(orderA3);
+    InsertOrder(orderA4);
+    InsertOrder(orderB1);
+
+    // only the orders of the sender for the pair and the price
+    BOOST_CHECK_EQUAL(MetaDEx_CANCEL_AT_PRICE(ArithToUint256(10), 110, addrA, 3, 100, 4, 200), 0);
+    BOOST_CHECK(!MetaDEx_isOpen(orderA1.getHash()));
+    BOOST_CHECK(!MetaDEx_isOpen(orderA2.getHash()));
+    BOOST_CHECK(MetaDEx_RetrieveTrade(orderA1.getHash()) == NULL);
+    BOOST_CHECK(MetaDEx_isOpen(orderA3.getHash()));
+    BOOST_CHECK(MetaDEx_isOpen(orderA4.getHash()));
+    BOOST_CHECK(MetaDEx_isOpen(orderB1.getHash()));
+    BOOST_CHECK_EQUAL(CountOrders(), 3U);
+    BOOST_CHECK_EQUAL(getMPbalance(addrA, 3, BALANCE), 1500);
+    BOOST_CHECK_EQUAL(getMPbalance(addrA, 3, METADEX_RESERVE), 2000);
+    BOOST_CHECK_EQUAL(getMPbalance(addrB, 3, METADEX_RESERVE), 1000);
+
+    // nothing left at that price
+    BOOST_CHECK(MetaDEx_CANCEL_AT_PRICE(ArithToUint256(11), 111, addrA, 3, 100, 4, 200) != 0);
+    BOOST_CHECK_EQUAL(CountOrders(), 3U);
+
+    // the indexes still match the order book
+    BOOST_CHECK_EQUAL(MetaDEx_SHUTDOWN(), 0);
+    BOOST_CHECK(!MetaDEx_isOpen(orderA3.getHash()));
+    BOOST_CHECK_EQUAL(CountOrders(), 0U);
+    BOOST_CHECK_EQUAL(getMPbalance(addrA, 3, BALANCE), 3500);
+    BOOST_CHECK_EQUAL(getMPbalance(addrB, 3, BALANCE), 1000);
+}
+
+BOOST_AUTO_TEST_CASE(metadex_cancel_all_for_pair)
+{
+    const std::string addrA = "1KYiKJEfdJtap9QX2v9BXJMpz2SfU4pgZw";
+    const std::string addrB = "1JztLWos5K7LsqW5E78EASgiVBaCe6f7cD";
+
+    CMPMetaDEx orderA1(addrA, 100, 3, 1000, 4, 2000, ArithToUint256(1), 1, CMPTransaction::ADD);
+    CMPMetaDEx orderA2(addrA, 101, 3, 1000, 4, 3000, ArithToUint256(2), 1, CMPTransaction::ADD);
+    CMPMetaDEx orderA3(addrA, 102, 3, 1000, 5, 2000, ArithToUint256(3), 1, CMPTransaction::ADD);
+    CMPMetaDEx orderA4(addrA, 102, 4, 1000, 3, 2000, ArithToUint256(4), 2, CMPTransaction::ADD);
+    CMPMetaDEx orderB1(addrB, 100, 3, 1000, 4, 2000, ArithToUint256(5), 2, CMPTransaction::ADD);
+    InsertOrder(orderA1);
+    InsertOrder(orderA2);
+    InsertOrder(orderA3);
+    InsertOrder(orderA4);
+    InsertOrder(orderB1);
+
+    // every price of the pair, but not the other direction
+    BOOST_CHECK_EQUAL(MetaDEx_CANCEL_ALL_FOR_PAIR(ArithToUint256(10), 110, addrA, 3, 4), 0);
+    BOOST_CHECK(!MetaDEx_isOpen(orderA1.getHash()));
+    BOOST_CHECK(!MetaDEx_isOpen(orderA2.getHash()));
+    BOOST_CHECK(MetaDEx_isOpen(orderA3.getHash()));
+    BOOST_CHECK(MetaDEx_isOpen(orderA4.getHash()));
+    BOOST_CHECK(MetaDEx_isOpen(orderB1.getHash()));
+    BOOST_CHECK_EQUAL(CountOrders(), 3U);
+    BOOST_CHECK_EQUAL(getMPbalance(addrA, 3, BALANCE), 2000);
+    BOOST_CHECK_EQUAL(getMPbalance(addrA, 3, METADEX_RESERVE), 1000);
+    BOOST_CHECK_EQUAL(getMPbalance(addrA, 4, METADEX_RESERVE), 1000);
+
+    BOOST_CHECK(MetaDEx_CANCEL_ALL_FOR_PAIR(ArithToUint256(11), 111, addrA, 3, 4) != 0);
+    BOOST_CHECK_EQUAL(MetaDEx_CANCEL_ALL_FOR_PAIR(ArithToUint256(12), 112, addrB, 3, 4), 0);
+    BOOST_CHECK(!MetaDEx_isOpen(orderB1.getHash()));
+    BOOST_CHECK_EQUAL(CountOrders(), 2U);
+
+    BOOST_CHECK_EQUAL(MetaDEx_SHUTDOWN(), 0);
+    BOOST_CHECK_EQUAL(CountOrders(), 0U);
+    BOOST_CHECK_EQUAL(getMPbalance(addrA, 3, BALANCE), 3000);
+    BOOST_CHECK_EQUAL(getMPbalance(addrA, 4, BALANCE), 1000);
+    BOOST_CHECK_EQUAL(getMPbalance(addrB, 3, BALANCE), 1000);
+}
+
+BOOST_AUTO_TEST_CASE(metadex_cancel_everything)
+{
+    const std::string addrA = "1KYiKJEfdJtap9QX2v9BXJMpz2SfU4pgZw";
+    const std::string addrB = "1JztLWos5K7LsqW5E78EASgiVBaCe6f7cD";
+    const uint32_t testProperty = TEST_ECO_PROPERTY_1;
+
+    CMPMetaDEx orderA1(addrA, 100, 3, 1000, 4, 2000, ArithToUint256(1), 1, CMPTransaction::ADD);
+    CMPMetaDEx orderA2(addrA, 101, 4, 1000, 5, 3000, ArithToUint256(2), 1, CMPTransaction::ADD);
+    CMPMetaDEx orderA3(addrA, 102, testProperty, 1000, ELYSIUM_PROPERTY_TELYSIUM, 2000, ArithToUint256(3), 1, CMPTransaction::ADD);
+    CMPMetaDEx orderB1(addrB, 100, 3, 1000, 4, 2000, ArithToUint256(4), 2, CMPTransaction::ADD);
+    InsertOrder(orderA1);
+    InsertOrder(orderA2);
+    InsertOrder(orderA3);
+    InsertOrder(orderB1);
+
+    // all pairs of the main ecosystem
+    BOOST_CHECK_EQUAL(MetaDEx_CANCEL_EVERYTHING(ArithToUint256(10), 110, addrA, ELYSIUM_PROPERTY_ELYSIUM), 0);
+    BOOST_CHECK(!MetaDEx_isOpen(orderA1.getHash()));
+    BOOST_CHECK(!MetaDEx_isOpen(orderA2.getHash()));
+    BOOST_CHECK(MetaDEx_isOpen(orderA3.getHash()));
+    BOOST_CHECK(MetaDEx_isOpen(orderB1.getHash()));
+    BOOST_CHECK_EQUAL(CountOrders(), 2U);
+    BOOST_CHECK_EQUAL(getMPbalance(addrA, 3, BALANCE), 1000);
+    BOOST_CHECK_EQUAL(getMPbalance(addrA, 4, BALANCE), 1000);
+    BOOST_CHECK_EQUAL(getMPbalance(addrA, testProperty, METADEX_RESERVE), 1000);
+
+    // then the test ecosystem
+    BOOST_CHECK_EQUAL(MetaDEx_CANCEL_EVERYTHING(ArithToUint256(11), 111, addrA, ELYSIUM_PROPERTY_TELYSIUM), 0);
+    BOOST_CHECK(!MetaDEx_isOpen(orderA3.getHash()));
+    BOOST_CHECK_EQUAL(getMPbalance(addrA, testProperty, BALANCE), 1000);
+    BOOST_CHECK(MetaDEx_CANCEL_EVERYTHING(ArithToUint256(12), 112, addrA, ELYSIUM_PROPERTY_ELYSIUM) != 0);
+
+    // the order of the other address is untouched
+    BOOST_CHECK(MetaDEx_isOpen(orderB1.getHash()));
+    BOOST_CHECK_EQUAL(CountOrders(), 1U);
+    BOOST_CHECK_EQUAL(MetaDEx_SHUTDOWN(), 0);
+    BOOST_CHECK_EQUAL(CountOrders(), 0U);
+    BOOST_CHECK_EQUAL(getMPbalance(addrB, 3, BALANCE), 1000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -504,6 +504,37 @@ BOOST_AUTO_TEST_CASE(get_anonimity_group_by_iterator)
     BOOST_CHECK_EQUAL(mints, result);
 }
 
+BOOST_AUTO_TEST_CASE(get_anonimity_group_snapshot)
+{
+    auto db = CreateDb();
+    auto mints = CreateMints(6);
+
+    BOOST_CHECK(db->GetAnonimityGroupSnapshot(1, 1, 0, 1)->empty());
+
+    for (size_t i = 0; i < 5; i++) {
+        db->RecordMint(1, 1, mints[i], 10);
+    }
+
+    auto snapshot = db->GetAnonimityGroupSnapshot(1, 1, 0, 5);
+    BOOST_CHECK_EQUAL(GetFirstN(mints, 5), *snapshot);
+
+    // new mints are written through to the cache without touching snapshots already handed out
+    db->RecordMint(1, 1, mints[5], 11);
+    BOOST_CHECK_EQUAL(mints, *db->GetAnonimityGroupSnapshot(1, 1, 0, 6));
+    BOOST_CHECK_EQUAL(GetFirstN(mints, 5), *snapshot);
+    BOOST_CHECK(db->GetAnonimityGroupSnapshot(1, 1, 0, 3)->size() >= 3);
+
+    // and removed with their blocks
+    db->DeleteAll(11);
+    BOOST_CHECK_EQUAL(GetFirstN(mints, 5), *db->GetAnonimityGroupSnapshot(1, 1, 0, 6));
+    BOOST_CHECK_EQUAL(db->GetAnonimityGroupAsVector(1, 1, 0, 6), *db->GetAnonimityGroupSnapshot(1, 1, 0, 6));
+
+    db->RecordMint(1, 1, mints[0], 12);
+    auto expected = GetFirstN(mints, 5);
+    expected.push_back(mints[0]);
+    BOOST_CHECK_EQUAL(expected, *db->GetAnonimityGroupSnapshot(1, 1, 0, 6));
+}
+
 BOOST_AUTO_TEST_CASE(group_size_default)
 {
     auto db = CreateDb(0);
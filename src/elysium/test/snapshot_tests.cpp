@@ -0,0 +1,148 @@
+#include "../dex.h"
+#include "../mdex.h"
+#include "../snapshot.h"
+
+#include "arith_uint256.h"
+#include "clientversion.h"
+#include "test/test_bitcoin.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace elysium;
+
+namespace {
+
+std::unique_ptr<StateSnapshot> CreateSnapshot(const uint256& blockHash)
+{
+    std::unique_ptr<StateSnapshot> snapshot(new StateSnapshot(blockHash, 3));
+    snapshot->Section(0) << std::string("1KYiKJEfdJtap9QX2v9BXJMpz2SfU4pgZw") << uint32_t(3) << int64_t(1000);
+    snapshot->Section(0) << std::string("1JztLWos5K7LsqW5E78EASgiVBaCe6f7cD") << uint32_t(4) << int64_t(-1);
+    // section 1 stays empty
+    snapshot->Section(2) << CMPMetaDEx("1KYiKJEfdJtap9QX2v9BXJMpz2SfU4pgZw", 100, 3, 1000, 4, 2000, ArithToUint256(1), 1, 1, 600);
+    return snapshot;
+}
+
+std::vector<char> ReadFile(const boost::filesystem::path& path)
+{
+    boost::filesystem::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const boost::filesystem::path& path, const std::vector<char>& data)
+{
+    boost::filesystem::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), data.size());
+}
+
+} // anonymous namespace
+
+BOOST_FIXTURE_TEST_SUITE(elysium_snapshot_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(snapshot_roundtrip)
+{
+    const uint256 blockHash = ArithToUint256(42);
+    const boost::filesystem::path path = pathTemp / "snapshot-roundtrip.dat";
+
+    BOOST_CHECK(CreateSnapshot(blockHash)->Write(path));
+    BOOST_CHECK(!boost::filesystem::exists(pathTemp / "snapshot-roundtrip.tmp"));
+
+    MappedSnapshot snapshot;
+    BOOST_REQUIRE(snapshot.Open(path, blockHash, 3));
+
+    MemoryReader balances = snapshot.Section(0);
+    std::string address;
+    uint32_t propertyId;
+    int64_t amount;
+    balances >> address >> propertyId >> amount;
+    BOOST_CHECK_EQUAL(address, "1KYiKJEfdJtap9QX2v9BXJMpz2SfU4pgZw");
+    BOOST_CHECK_EQUAL(propertyId, 3);
+    BOOST_CHECK_EQUAL(amount, 1000);
+    balances >> address >> propertyId >> amount;
+    BOOST_CHECK_EQUAL(address, "1JztLWos5K7LsqW5E78EASgiVBaCe6f7cD");
+    BOOST_CHECK_EQUAL(propertyId, 4);
+    BOOST_CHECK_EQUAL(amount, -1);
+    BOOST_CHECK(balances.empty());
+    BOOST_CHECK_THROW(balances >> amount, std::ios_base::failure);
+
+    BOOST_CHECK(snapshot.Section(1).empty());
+
+    MemoryReader orders = snapshot.Section(2);
+    CMPMetaDEx order;
+    orders >> order;
+    BOOST_CHECK(orders.empty());
+    BOOST_CHECK_EQUAL(order.getAddr(), "1KYiKJEfdJtap9QX2v9BXJMpz2SfU4pgZw");
+    BOOST_CHECK_EQUAL(order.getBlock(), 100);
+    BOOST_CHECK_EQUAL(order.getIdx(), 1);
+    BOOST_CHECK_EQUAL(order.getProperty(), 3);
+    BOOST_CHECK_EQUAL(order.getAmountForSale(), 1000);
+    BOOST_CHECK_EQUAL(order.getDesProperty(), 4);
+    BOOST_CHECK_EQUAL(order.getAmountDesired(), 2000);
+    BOOST_CHECK_EQUAL(order.getAmountRemaining(), 600);
+    BOOST_CHECK(order.getHash() == ArithToUint256(1));
+
+    // snapshots of other blocks or layouts are refused
+    MappedSnapshot other;
+    BOOST_CHECK(!other.Open(path, ArithToUint256(43), 3));
+    BOOST_CHECK(!other.Open(path, blockHash, 4));
+    BOOST_CHECK(!other.Open(pathTemp / "snapshot-missing.dat", blockHash, 3));
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_damaged)
+{
+    const uint256 blockHash = ArithToUint256(42);
+    const boost::filesystem::path path = pathTemp / "snapshot-damaged.dat";
+
+    BOOST_CHECK(CreateSnapshot(blockHash)->Write(path));
+    const std::vector<char> data = ReadFile(path);
+    BOOST_REQUIRE(data.size() > 100);
+
+    MappedSnapshot snapshot;
+
+    // any changed byte is caught by the header or a checksum
+    for (size_t i = 0; i < data.size(); i++) {
+        std::vector<char> damaged = data;
+        damaged[i] ^= 0x01;
+        WriteFile(path, damaged);
+        BOOST_CHECK(!snapshot.Open(path, blockHash, 3));
+    }
+
+    for (size_t size : {size_t(0), size_t(10), data.size() / 2, data.size() - 1}) {
+        WriteFile(path, std::vector<char>(data.begin(), data.begin() + size));
+        BOOST_CHECK(!snapshot.Open(path, blockHash, 3));
+    }
+
+    WriteFile(path, data);
+    BOOST_CHECK(snapshot.Open(path, blockHash, 3));
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_writer)
+{
+    std::vector<boost::filesystem::path> paths;
+    {
+        SnapshotWriter writer;
+        for (int i = 0; i < 10; i++) {
+            paths.push_back(pathTemp / strprintf("snapshot-writer%d.dat", i));
+            writer.Queue(paths.back(), CreateSnapshot(ArithToUint256(i)));
+        }
+        writer.Flush();
+        for (int i = 0; i < 10; i++) {
+            MappedSnapshot snapshot;
+            BOOST_CHECK(snapshot.Open(paths[i], ArithToUint256(i), 3));
+        }
+
+        // queued snapshots are still written when the writer goes away
+        paths.push_back(pathTemp / "snapshot-writer10.dat");
+        writer.Queue(paths.back(), CreateSnapshot(ArithToUint256(10)));
+    }
+
+    MappedSnapshot snapshot;
+    BOOST_CHECK(snapshot.Open(paths.back(), ArithToUint256(10), 3));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
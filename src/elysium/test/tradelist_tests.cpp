@@ -0,0 +1,166 @@
+#include "../elysium.h"
+#include "../sp.h"
+
+#include "arith_uint256.h"
+#include "test/test_bitcoin.h"
+
+#include <leveldb/db.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace elysium;
+
+namespace {
+
+class TestTradeList : public CMPTradeList
+{
+public:
+    TestTradeList(const boost::filesystem::path& path, bool fWipe) : CMPTradeList(path, fWipe)
+    {
+    }
+
+    /** Writes a record bypassing the indexes, as done by earlier versions. */
+    void WriteLegacy(const std::string& key, const std::string& value)
+    {
+        pdb->Put(writeoptions, key, value);
+        pdb->Delete(writeoptions, std::string(1, '\0'));
+    }
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(elysium_tradelist_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(trades_for_address)
+{
+    const std::string addrA = "1KYiKJEfdJtap9QX2v9BXJMpz2SfU4pgZw";
+    const std::string addrB = "1JztLWos5K7LsqW5E78EASgiVBaCe6f7cD";
+
+    std::unique_ptr<CMPTradeList> db(new CMPTradeList(pathTemp / "MP_tradelist_address", false));
+    db->recordNewTrade(ArithToUint256(3), addrA, 3, 4, 120, 1);
+    db->recordNewTrade(ArithToUint256(1), addrA, 3, 5, 100, 7);
+    db->recordNewTrade(ArithToUint256(2), addrB, 4, 3, 110, 2);
+    db->recordNewTrade(ArithToUint256(4), addrA, 5, 3, 100, 2);
+
+    // sorted by block, then by position in block
+    std::vector<uint256> trades;
+    db->getTradesForAddress(addrA, trades);
+    BOOST_CHECK(trades == std::vector<uint256>({ArithToUint256(4), ArithToUint256(1), ArithToUint256(3)}));
+
+    trades.clear();
+    db->getTradesForAddress(addrA, trades, 4);
+    BOOST_CHECK(trades == std::vector<uint256>({ArithToUint256(3)}));
+
+    trades.clear();
+    db->getTradesForAddress(addrB, trades, 5);
+    BOOST_CHECK(trades.empty());
+
+    BOOST_CHECK_EQUAL(db->getMPTradeCountTotal(), 4);
+
+    // the index follows the records on reorganizations
+    BOOST_CHECK_EQUAL(db->deleteAboveBlock(110), 2);
+    trades.clear();
+    db->getTradesForAddress(addrA, trades);
+    BOOST_CHECK(trades == std::vector<uint256>({ArithToUint256(4), ArithToUint256(1)}));
+    trades.clear();
+    db->getTradesForAddress(addrB, trades);
+    BOOST_CHECK(trades.empty());
+    BOOST_CHECK_EQUAL(db->getMPTradeCountTotal(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(trades_for_pair)
+{
+    _my_sps = new CMPSPInfo(pathTemp / "MP_spinfo_test", false);
+
+    const std::string addrA = "1KYiKJEfdJtap9QX2v9BXJMpz2SfU4pgZw";
+    const std::string addrB = "1JztLWos5K7LsqW5E78EASgiVBaCe6f7cD";
+
+    std::unique_ptr<CMPTradeList> db(new CMPTradeList(pathTemp / "MP_tradelist_pair", false));
+    db->recordMatchedTrade(ArithToUint256(1), ArithToUint256(2), addrA, addrB, 3, 4, 100, 200, 100, 0);
+    db->recordMatchedTrade(ArithToUint256(3), ArithToUint256(4), addrB, addrA, 4, 3, 300, 400, 101, 0);
+    db->recordMatchedTrade(ArithToUint256(5), ArithToUint256(6), addrA, addrB, 3, 4, 500, 600, 102, 0);
+    db->recordMatchedTrade(ArithToUint256(7), ArithToUint256(8), addrA, addrB, 3, 5, 700, 800, 103, 0);
+
+    // most recent trades of both orientations, oldest first
+    UniValue response(UniValue::VARR);
+    db->getTradesForPair(3, 4, response, 2);
+    BOOST_REQUIRE_EQUAL(response.size(), 2U);
+    BOOST_CHECK_EQUAL(response[0]["block"].get_int64(), 101);
+    BOOST_CHECK_EQUAL(response[0]["sellertxid"].get_str(), ArithToUint256(3).GetHex());
+    BOOST_CHECK_EQUAL(response[0]["amountsold"].get_str(), FormatDivisibleMP(400));
+    BOOST_CHECK_EQUAL(response[1]["block"].get_int64(), 102);
+    BOOST_CHECK_EQUAL(response[1]["sellertxid"].get_str(), ArithToUint256(6).GetHex());
+    BOOST_CHECK_EQUAL(response[1]["matchingaddress"].get_str(), addrA);
+
+    UniValue all(UniValue::VARR);
+    db->getTradesForPair(4, 3, all, 10);
+    BOOST_CHECK_EQUAL(all.size(), 3U);
+
+    BOOST_CHECK_EQUAL(db->deleteAboveBlock(102), 2);
+    UniValue remaining(UniValue::VARR);
+    db->getTradesForPair(3, 4, remaining, 10);
+    BOOST_CHECK_EQUAL(remaining.size(), 2U);
+}
+
+BOOST_AUTO_TEST_CASE(trade_indexes_migration)
+{
+    const std::string addr = "1KYiKJEfdJtap9QX2v9BXJMpz2SfU4pgZw";
+    const boost::filesystem::path path = pathTemp / "MP_tradelist_legacy";
+
+    {
+        TestTradeList db(path, false);
+        db.WriteLegacy(ArithToUint256(1).ToString(), strprintf("%s:%d:%d:%d:%d", addr, 3, 4, 100, 1));
+        db.WriteLegacy(ArithToUint256(2).ToString(), strprintf("%s:%d:%d:%d:%d", addr, 4, 3, 90, 1));
+
+        std::vector<uint256> trades;
+        db.getTradesForAddress(addr, trades);
+        BOOST_CHECK(trades.empty());
+    }
+
+    // indexes are built when opening a database without them
+    TestTradeList db(path, false);
+    std::vector<uint256> trades;
+    db.getTradesForAddress(addr, trades);
+    BOOST_CHECK(trades == std::vector<uint256>({ArithToUint256(2), ArithToUint256(1)}));
+    BOOST_CHECK_EQUAL(db.getMPTradeCountTotal(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(sto_receipts_reorg)
+{
+    _my_sps = new CMPSPInfo(pathTemp / "MP_spinfo_test", false);
+
+    const std::string addrA = "1KYiKJEfdJtap9QX2v9BXJMpz2SfU4pgZw";
+    const std::string addrB = "1JztLWos5K7LsqW5E78EASgiVBaCe6f7cD";
+
+    std::unique_ptr<CMPSTOList> db(new CMPSTOList(pathTemp / "MP_stolist_test", false));
+    db->recordSTOReceive(addrA, ArithToUint256(1), 100, 3, 10);
+    db->recordSTOReceive(addrB, ArithToUint256(1), 100, 3, 20);
+    db->recordSTOReceive(addrA, ArithToUint256(2), 110, 3, 30);
+
+    UniValue recipients(UniValue::VARR);
+    uint64_t total = 0, numRecipients = 0;
+    db->getRecipients(ArithToUint256(2), "*", &recipients, &total, &numRecipients);
+    BOOST_CHECK_EQUAL(numRecipients, 1U);
+    BOOST_CHECK_EQUAL(total, 30U);
+
+    // only the records of the addresses with receipts in the removed blocks are rewritten
+    BOOST_CHECK_EQUAL(db->deleteAboveBlock(105), 1);
+    BOOST_CHECK_EQUAL(db->deleteAboveBlock(105), 0);
+
+    recipients.clear();
+    total = numRecipients = 0;
+    db->getRecipients(ArithToUint256(2), "*", &recipients, &total, &numRecipients);
+    BOOST_CHECK_EQUAL(numRecipients, 0U);
+
+    recipients.clear();
+    total = numRecipients = 0;
+    db->getRecipients(ArithToUint256(1), "*", &recipients, &total, &numRecipients);
+    BOOST_CHECK_EQUAL(numRecipients, 2U);
+    BOOST_CHECK_EQUAL(total, 30U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -31,8 +31,11 @@ CHDMintTracker::CHDMintTracker(std::string strWalletFile)
 {
     this->strWalletFile = strWalletFile;
     mapSerialHashes.clear();
+    mapPubcoinHashes.clear();
+    mapUnspent.clear();
     mapPendingSpends.clear();
     fInitialized = false;
+    nUpdates = 0;
 }
 
 /**
@@ -45,6 +48,8 @@ CHDMintTracker::CHDMintTracker(std::string strWalletFile)
 CHDMintTracker::~CHDMintTracker()
 {
     mapSerialHashes.clear();
+    mapPubcoinHashes.clear();
+    mapUnspent.clear();
     mapPendingSpends.clear();
 }
 
@@ -75,8 +80,11 @@ bool CHDMintTracker::Archive(CMintMeta& meta)
 {
     uint256 hashPubcoin = meta.GetPubCoinValueHash();
 
-    if (HasSerialHash(meta.hashSerial))
-        mapSerialHashes.at(meta.hashSerial).isArchived = true;
+    if (HasSerialHash(meta.hashSerial)) {
+        CMintMeta archived = mapSerialHashes.at(meta.hashSerial);
+        archived.isArchived = true;
+        SetMeta(archived);
+    }
 
    CWalletDB walletdb(strWalletFile);
     CHDMint dMint;
@@ -140,14 +148,12 @@ bool CHDMintTracker::GetMetaFromSerial(const uint256 &hashSerial, CMintMeta& mMe
  */
 bool CHDMintTracker::GetMetaFromPubcoin(const uint256& hashPubcoin, CMintMeta& mMeta)
 {
-    for (auto it : mapSerialHashes) {
-        if (it.second.GetPubCoinValueHash() == hashPubcoin){
-            mMeta = it.second;
-            return true;
-        }
-    }
+    auto it = mapPubcoinHashes.find(hashPubcoin);
+    if (it == mapPubcoinHashes.end())
+        return false;
 
-    return false;
+    mMeta = mapSerialHashes.at(it->second);
+    return true;
 }
 
 /**
@@ -177,12 +183,7 @@ std::vector<uint256> CHDMintTracker::GetSerialHashes()
  */
 bool CHDMintTracker::HasPubcoinHash(const uint256& hashPubcoin) const
 {
-    for (auto const & it : mapSerialHashes) {
-        CMintMeta meta = it.second;
-        if (meta.GetPubCoinValueHash() == hashPubcoin)
-            return true;
-    }
-    return false;
+    return mapPubcoinHashes.count(hashPubcoin) > 0;
 }
 
 /**
@@ -197,6 +198,52 @@ bool CHDMintTracker::HasSerialHash(const uint256& hashSerial) const
     return it != mapSerialHashes.end();
 }
 
+/**
+ * Store a mint in memory, keeping the lookup indexes in line with it.
+ *
+ * @param meta the CMintMeta object to store, replaces any mint with the same serial hash
+ * @return void
+ */
+void CHDMintTracker::SetMeta(const CMintMeta& meta)
+{
+    auto it = mapSerialHashes.find(meta.hashSerial);
+    if (it != mapSerialHashes.end()) {
+        UnindexMeta(it->second);
+        it->second = meta;
+    } else {
+        mapSerialHashes.insert(std::make_pair(meta.hashSerial, meta));
+    }
+    IndexMeta(meta);
+    nUpdates++;
+}
+
+/**
+ * Add a mint to the pubcoin index and, if it can still be spent, to the bucket of its denomination.
+ *
+ * @param meta the CMintMeta object to index
+ * @return void
+ */
+void CHDMintTracker::IndexMeta(const CMintMeta& meta)
+{
+    mapPubcoinHashes[meta.GetPubCoinValueHash()] = meta.hashSerial;
+    if (!meta.isUsed && !meta.isArchived)
+        mapUnspent[meta.denom].insert(std::make_pair(meta.nHeight, meta.hashSerial));
+}
+
+/**
+ * Remove a mint from the indexes.
+ *
+ * @param meta the CMintMeta object as it was indexed
+ * @return void
+ */
+void CHDMintTracker::UnindexMeta(const CMintMeta& meta)
+{
+    mapPubcoinHashes.erase(meta.GetPubCoinValueHash());
+    auto bucket = mapUnspent.find(meta.denom);
+    if (bucket != mapUnspent.end())
+        bucket->second.erase(std::make_pair(meta.nHeight, meta.hashSerial));
+}
+
 /**
  * Update the tracker state
  * 
@@ -266,7 +313,7 @@ bool CHDMintTracker::UpdateState(const CMintMeta& meta)
             CT_UPDATED);
     }
 
-    mapSerialHashes[meta.hashSerial] = meta;
+    SetMeta(meta);
 
     return true;
 }
@@ -296,7 +343,7 @@ void CHDMintTracker::Add(const CHDMint& dMint, bool isNew, bool isArchived)
     meta.isArchived = isArchived;
     meta.isDeterministic = true;
     meta.isSeedCorrect = true;
-    mapSerialHashes[meta.hashSerial] = meta;
+    SetMeta(meta);
 
     pwalletMain->NotifyZerocoinChanged(
         pwalletMain,
@@ -321,7 +368,7 @@ void CHDMintTracker::Add(const CSigmaEntry& sigma, bool isNew, bool isArchived)
     meta.isArchived = isArchived;
     meta.isDeterministic = false;
     meta.isSeedCorrect = true;
-    mapSerialHashes[meta.hashSerial] = meta;
+    SetMeta(meta);
 
     if (isNew)
         CWalletDB(strWalletFile).WriteSigmaEntry(sigma);
@@ -366,20 +413,23 @@ void CHDMintTracker::SetPubcoinNotUsed(const uint256& hashPubcoin)
 
 
 /**
- * Check mempool for the spend associated with the mint serial hash passed
+ * Get the serial hashes of all sigma spends in the mempool
  * 
  * @param setMempool the set of txid hashes in the mempool
- * @param hashSerial the mint serial hash to check for
- * @return success
+ * @return set of spent serial hashes
  */
-bool CHDMintTracker::IsMempoolSpendOurs(const std::set<uint256>& setMempool, const uint256& hashSerial){
+std::set<uint256> CHDMintTracker::GetMempoolSerialHashes(const std::set<uint256>& setMempool){
+    std::set<uint256> setMempoolSerials;
+
+    // serials spent in the mempool are held by the sigma state, saving the parsing of each spend
+    for (auto const & mempoolSerial : sigma::CSigmaState::GetState()->GetMempoolCoinSerials())
+        setMempoolSerials.insert(primitives::GetSerialHash(mempoolSerial.first));
+
+    // only spends in the stem pool are left to parse
     for(auto& mempoolTxid : setMempool){
-        auto it = mempool.mapTx.find(mempoolTxid);
-        if (it == mempool.mapTx.end()){
-            it = stempool.mapTx.find(mempoolTxid);
-            if (it == stempool.mapTx.end())
-                continue;
-        }
+        auto it = stempool.mapTx.find(mempoolTxid);
+        if (it == stempool.mapTx.end())
+            continue;
 
         const CTransaction &tx = it->GetTx();
         for (const CTxIn& txin : tx.vin) {
@@ -389,31 +439,29 @@ bool CHDMintTracker::IsMempoolSpendOurs(const std::set<uint256>& setMempool, con
                 try {
                     std::tie(spend, pubcoinId) = sigma::ParseSigmaSpend(txin);
                 } catch (CBadTxIn &) {
-                    return false;
+                    continue;
                 } catch (std::ios_base::failure &) {
-                    return false;
+                    continue;
                 }
 
-                uint256 mempoolHashSerial = primitives::GetSerialHash(spend->getCoinSerialNumber());
-                if(mempoolHashSerial==hashSerial){
-                    return true;
-                }
+                setMempoolSerials.insert(primitives::GetSerialHash(spend->getCoinSerialNumber()));
             }
         }
     }
 
-    return false;
+    return setMempoolSerials;
 }
 
 /**
  * Update the in-memory CMintMeta object for the current mempool
  * 
  * @param setMempool the set of txid hashes in the mempool
+ * @param setMempoolSerials the serial hashes spent in the mempool
  * @param mint the CMintMeta object to check for
  * @param fSpend if this mint object is being updated as a result of a spend transaction
  * @return success
  */
-bool CHDMintTracker::UpdateMetaStatus(const std::set<uint256>& setMempool, CMintMeta& mint, bool fSpend)
+bool CHDMintTracker::UpdateMetaStatus(const std::set<uint256>& setMempool, const std::set<uint256>& setMempoolSerials, CMintMeta& mint, bool fSpend)
 {
     uint256 hashPubcoin = mint.GetPubCoinValueHash();
     //! Check whether this mint has been spent and is considered 'pending' or 'confirmed'
@@ -429,7 +477,7 @@ bool CHDMintTracker::UpdateMetaStatus(const std::set<uint256>& setMempool, CMint
 
     // Mempool might hold pending spend
     if(!isPendingSpend && fSpend)
-        isPendingSpend = IsMempoolSpendOurs(setMempool, mint.hashSerial);
+        isPendingSpend = static_cast<bool>(setMempoolSerials.count(mint.hashSerial));
 
     LogPrintf("UpdateMetaStatus : isPendingSpend: %d\n", isPendingSpend);
 
@@ -542,20 +590,19 @@ void CHDMintTracker::UpdateMintStateFromBlock(const std::vector<sigma::PublicCoi
     CKeyID seedId;
     int32_t nCount;
     std::set<uint256> setMempool = GetMempoolTxids();
+    std::set<uint256> setMempoolSerials = GetMempoolSerialHashes(setMempool);
     for (auto& mint : mints) {
         uint256 hashPubcoin = primitives::GetPubCoinValueHash(mint.getValue());
         CMintMeta meta;
-        // Check hashPubcoin in db
-        if(walletdb.ReadMintPoolPair(hashPubcoin, hashSeedMasterEntry, seedId, nCount)){
-            // If found in db but not in memory - this is likely a resync
-            if(!GetMetaFromPubcoin(hashPubcoin, meta)){
-                MintPoolEntry mintPoolEntry(hashSeedMasterEntry, seedId, nCount);
-                mintPoolEntries.push_back(std::make_pair(hashPubcoin, mintPoolEntry));
-                continue;
-            }
-            if(UpdateMetaStatus(setMempool, meta)){
+        // Check hashPubcoin in memory first, most mints of a block are someone else's
+        if(GetMetaFromPubcoin(hashPubcoin, meta)){
+            if(UpdateMetaStatus(setMempool, setMempoolSerials, meta)){
                 updatedMeta.emplace_back(meta);
             }
+        // If found in db but not in memory - this is likely a resync
+        } else if(walletdb.ReadMintPoolPair(hashPubcoin, hashSeedMasterEntry, seedId, nCount)){
+            MintPoolEntry mintPoolEntry(hashSeedMasterEntry, seedId, nCount);
+            mintPoolEntries.push_back(std::make_pair(hashPubcoin, mintPoolEntry));
         }
     }
 
@@ -578,25 +625,24 @@ void CHDMintTracker::UpdateSpendStateFromBlock(const sigma::spend_info_container
     CKeyID seedId;
     int32_t nCount;
     std::set<uint256> setMempool = GetMempoolTxids();
+    std::set<uint256> setMempoolSerials = GetMempoolSerialHashes(setMempool);
     for(auto& spentSerial : spentSerials){
         uint256 spentSerialHash = primitives::GetSerialHash(spentSerial.first);
         CMintMeta meta;
         GroupElement pubcoin;
-        // Check serialHash in db
-        if(walletdb.ReadPubcoin(spentSerialHash, pubcoin)){
-            // If found in db but not in memory - this is likely a resync
-            if(!GetMetaFromSerial(spentSerialHash, meta)){
-                uint256 hashPubcoin = primitives::GetPubCoinValueHash(pubcoin);
-                if(!walletdb.ReadMintPoolPair(hashPubcoin, hashSeedMasterEntry, seedId, nCount)){
-                    continue;
-                }
-                MintPoolEntry mintPoolEntry(hashSeedMasterEntry, seedId, nCount);
-                mintPoolEntries.push_back(std::make_pair(hashPubcoin, mintPoolEntry));
-                continue;
-            }
-            if(UpdateMetaStatus(setMempool, meta, true)){
+        // Check serialHash in memory first
+        if(GetMetaFromSerial(spentSerialHash, meta)){
+            if(UpdateMetaStatus(setMempool, setMempoolSerials, meta, true)){
                 updatedMeta.emplace_back(meta);
             }
+        // If found in db but not in memory - this is likely a resync
+        } else if(walletdb.ReadPubcoin(spentSerialHash, pubcoin)){
+            uint256 hashPubcoin = primitives::GetPubCoinValueHash(pubcoin);
+            if(!walletdb.ReadMintPoolPair(hashPubcoin, hashSeedMasterEntry, seedId, nCount)){
+                continue;
+            }
+            MintPoolEntry mintPoolEntry(hashSeedMasterEntry, seedId, nCount);
+            mintPoolEntries.push_back(std::make_pair(hashPubcoin, mintPoolEntry));
         }
     }
 
@@ -619,6 +665,7 @@ void CHDMintTracker::UpdateMintStateFromMempool(const std::vector<GroupElement>&
     CKeyID seedId;
     int32_t nCount;
     std::set<uint256> setMempool = GetMempoolTxids();
+    std::set<uint256> setMempoolSerials = GetMempoolSerialHashes(setMempool);
     for (auto& pubcoin : pubCoins) {
         uint256 hashPubcoin = primitives::GetPubCoinValueHash(pubcoin);
 
@@ -633,7 +680,7 @@ void CHDMintTracker::UpdateMintStateFromMempool(const std::vector<GroupElement>&
             }
             CMintMeta meta;
             GetMetaFromPubcoin(hashPubcoin, meta);
-            if(UpdateMetaStatus(setMempool, meta)){
+            if(UpdateMetaStatus(setMempool, setMempoolSerials, meta)){
                 updatedMeta.emplace_back(meta);
             }
         }
@@ -658,25 +705,24 @@ void CHDMintTracker::UpdateSpendStateFromMempool(const vector<Scalar>& spentSeri
     CKeyID seedId;
     int32_t nCount;
     std::set<uint256> setMempool = GetMempoolTxids();
+    std::set<uint256> setMempoolSerials = GetMempoolSerialHashes(setMempool);
     for(auto& spentSerial : spentSerials){
         uint256 spentSerialHash = primitives::GetSerialHash(spentSerial);
         CMintMeta meta;
         GroupElement pubcoin;
-        // Check serialHash in db
-        if(walletdb.ReadPubcoin(spentSerialHash, pubcoin)){
-            // If found in db but not in memory - this is likely a resync
-            if(!GetMetaFromSerial(spentSerialHash, meta)){
-                uint256 hashPubcoin = primitives::GetPubCoinValueHash(pubcoin);
-                if(!walletdb.ReadMintPoolPair(hashPubcoin, hashSeedMasterEntry, seedId, nCount)){
-                    continue;
-                }
-                MintPoolEntry mintPoolEntry(hashSeedMasterEntry, seedId, nCount);
-                mintPoolEntries.push_back(std::make_pair(hashPubcoin, mintPoolEntry));
-                continue;
-            }
-            if(UpdateMetaStatus(setMempool, meta, true)){
+        // Check serialHash in memory first
+        if(GetMetaFromSerial(spentSerialHash, meta)){
+            if(UpdateMetaStatus(setMempool, setMempoolSerials, meta, true)){
                 updatedMeta.emplace_back(meta);
             }
+        // If found in db but not in memory - this is likely a resync
+        } else if(walletdb.ReadPubcoin(spentSerialHash, pubcoin)){
+            uint256 hashPubcoin = primitives::GetPubCoinValueHash(pubcoin);
+            if(!walletdb.ReadMintPoolPair(hashPubcoin, hashSeedMasterEntry, seedId, nCount)){
+                continue;
+            }
+            MintPoolEntry mintPoolEntry(hashSeedMasterEntry, seedId, nCount);
+            mintPoolEntries.push_back(std::make_pair(hashPubcoin, mintPoolEntry));
         }
     }
 
@@ -733,8 +779,30 @@ std::vector<CMintMeta> CHDMintTracker::ListMints(bool fUnusedOnly, bool fMatureO
         LogPrint("zero", "%s: added %d hdmint from DB\n", __func__, listDeterministicDB.size());
     }
 
+    // Without a status update unused mints come straight from the denomination buckets
+    if (fUnusedOnly && !fUpdateStatus) {
+        int nMatureHeight = chainActive.Height() - (ZC_MINT_CONFIRMATIONS-1);
+        for (auto const & bucket : mapUnspent) {
+            auto end = fMatureOnly ? bucket.second.lower_bound(std::make_pair(nMatureHeight + 1, uint256())) : bucket.second.end();
+            for (auto it = bucket.second.begin(); it != end; ++it) {
+                const CMintMeta& mint = mapSerialHashes.at(it->second);
+
+                // Not confirmed
+                if (fMatureOnly && !mint.nHeight)
+                    continue;
+
+                if (!fWrongSeed && !mint.isSeedCorrect)
+                    continue;
+
+                setMints.push_back(mint);
+            }
+        }
+        return setMints;
+    }
+
     std::vector<CMintMeta> vOverWrite;
     std::set<uint256> setMempool = GetMempoolTxids();
+    std::set<uint256> setMempoolSerials = GetMempoolSerialHashes(setMempool);
     for (auto& it : mapSerialHashes) {
         CMintMeta mint = it.second;
 
@@ -744,7 +812,7 @@ std::vector<CMintMeta> CHDMintTracker::ListMints(bool fUnusedOnly, bool fMatureO
 
         // Update the metadata of the mints if requested
         if (fUpdateStatus){
-            if(UpdateMetaStatus(setMempool, mint)) {
+            if(UpdateMetaStatus(setMempool, setMempoolSerials, mint)) {
                 if (mint.isArchived)
                     continue;
 
@@ -799,4 +867,7 @@ std::set<uint256> CHDMintTracker::GetMempoolTxids(){
 void CHDMintTracker::Clear()
 {
     mapSerialHashes.clear();
+    mapPubcoinHashes.clear();
+    mapUnspent.clear();
+    nUpdates++;
 }
@@ -8,6 +8,7 @@
 #include "primitives/zerocoin.h"
 #include "hdmint/mintpool.h"
 #include <list>
+#include <set>
 
 class CHDMint;
 class CHDMintWallet;
@@ -18,10 +19,16 @@ private:
     bool fInitialized;
     std::string strWalletFile;
     std::map<uint256, CMintMeta> mapSerialHashes;
+    std::map<uint256, uint256> mapPubcoinHashes; //pubcoinhash, serialhash
+    std::map<sigma::CoinDenomination, std::set<std::pair<int, uint256>>> mapUnspent; //denomination, (height, serialhash) of unused, unarchived mints
     std::map<uint256, uint256> mapPendingSpends; //serialhash, txid of spend
-    bool IsMempoolSpendOurs(const std::set<uint256>& setMempool, const uint256& hashSerial);
-    bool UpdateMetaStatus(const std::set<uint256>& setMempool, CMintMeta& mint, bool fSpend=false);
+    uint64_t nUpdates; //changes to the tracked mints, lets callers tell whether anything they derived is stale
+    void SetMeta(const CMintMeta& meta);
+    void IndexMeta(const CMintMeta& meta);
+    void UnindexMeta(const CMintMeta& meta);
+    bool UpdateMetaStatus(const std::set<uint256>& setMempool, const std::set<uint256>& setMempoolSerials, CMintMeta& mint, bool fSpend=false);
     std::set<uint256> GetMempoolTxids();
+    std::set<uint256> GetMempoolSerialHashes(const std::set<uint256>& setMempool);
 public:
     CHDMintTracker(std::string strWalletFile);
     ~CHDMintTracker();
@@ -31,6 +38,7 @@ public:
     bool HasPubcoinHash(const uint256& hashPubcoin) const;
     bool HasSerialHash(const uint256& hashSerial) const;
     bool IsEmpty() const { return mapSerialHashes.empty(); }
+    uint64_t GetUpdateCount() const { return nUpdates; }
     void Init();
     bool GetMetaFromSerial(const uint256& hashSerial, CMintMeta& mMeta);
     bool GetMetaFromPubcoin(const uint256& hashPubcoin, CMintMeta& mMeta);
@@ -15,8 +15,28 @@
 #include "crypto/hmac_sha512.h"
 #include "keystore.h"
 #include <boost/optional.hpp>
+#include <boost/thread.hpp>
 #include "shroudnode-sync.h"
 
+#include <atomic>
+#include <exception>
+
+namespace {
+
+// Number of mint pool entries a thread derives at a time
+const size_t MINT_POOL_CHUNK_SIZE = 8;
+
+struct MintPoolSeed {
+    int32_t nCount;
+    CKeyID seedId;
+    uint512 mintSeed;
+    GroupElement commitmentValue;
+    uint256 hashSerial;
+    bool fValid;
+};
+
+} // namespace
+
 /**
  * Constructor for CHDMintWallet object.
  *
@@ -156,27 +176,73 @@ void CHDMintWallet::GenerateMintPool(int32_t nIndex)
     if(nIndex > 0 && nIndex >= nLastCount)
         nStop = nIndex + 20;
     LogPrintf("%s : nLastCount=%d nStop=%d\n", __func__, nLastCount, nStop - 1);
+
+    // The seeds follow the HD chain so they are created in order
+    std::vector<MintPoolSeed> seeds;
     for (; nLastCount <= nStop; ++nLastCount) {
         if (ShutdownRequested())
             return;
 
-        CKeyID seedId;
-        uint512 mintSeed;
-        if(!CreateMintSeed(mintSeed, nLastCount, seedId))
+        MintPoolSeed seed;
+        seed.nCount = nLastCount;
+        seed.fValid = false;
+        if(!CreateMintSeed(seed.mintSeed, nLastCount, seed.seedId))
             continue;
 
-        GroupElement commitmentValue;
-        sigma::PrivateCoin coin(sigma::Params::get_default(), sigma::CoinDenomination::SIGMA_DENOM_1);
-        if(!SeedToMint(mintSeed, commitmentValue, coin))
+        seeds.push_back(seed);
+    }
+
+    // Deriving the mints is independent for each seed, chunks of them are spread across cores
+    std::atomic<size_t> next(0);
+    std::vector<std::exception_ptr> errors;
+    boost::mutex errorsMutex;
+    const sigma::Params* params = sigma::Params::get_default();
+
+    auto derive = [&]() {
+        // only the secrets of the coin are set from the seed, so one coin serves the whole thread
+        sigma::PrivateCoin coin(params, sigma::CoinDenomination::SIGMA_DENOM_1);
+        size_t begin;
+        while ((begin = next.fetch_add(MINT_POOL_CHUNK_SIZE)) < seeds.size()) {
+            size_t end = std::min(begin + MINT_POOL_CHUNK_SIZE, seeds.size());
+            for (size_t i = begin; i < end; i++) {
+                try {
+                    seeds[i].fValid = SeedToMint(seeds[i].mintSeed, seeds[i].commitmentValue, coin);
+                    seeds[i].hashSerial = primitives::GetSerialHash(coin.getSerialNumber());
+                } catch (...) {
+                    boost::unique_lock<boost::mutex> lock(errorsMutex);
+                    errors.push_back(std::current_exception());
+                }
+            }
+        }
+    };
+
+    size_t threads = std::min(static_cast<size_t>(std::max(GetNumCores(), 1)),
+        (seeds.size() + MINT_POOL_CHUNK_SIZE - 1) / MINT_POOL_CHUNK_SIZE);
+    if (threads > 1) {
+        boost::thread_group workers;
+        for (size_t i = 0; i < threads; i++) {
+            workers.create_thread(derive);
+        }
+        workers.join_all();
+    } else {
+        derive();
+    }
+
+    if (!errors.empty()) {
+        std::rethrow_exception(errors.front());
+    }
+
+    for (const MintPoolSeed& seed : seeds) {
+        if (!seed.fValid)
             continue;
 
-        uint256 hashPubcoin = primitives::GetPubCoinValueHash(commitmentValue);
+        uint256 hashPubcoin = primitives::GetPubCoinValueHash(seed.commitmentValue);
 
-        MintPoolEntry mintPoolEntry(hashSeedMaster, seedId, nLastCount);
+        MintPoolEntry mintPoolEntry(hashSeedMaster, seed.seedId, seed.nCount);
         mintPool.Add(make_pair(hashPubcoin, mintPoolEntry));
-        CWalletDB(strWalletFile).WritePubcoin(primitives::GetSerialHash(coin.getSerialNumber()), commitmentValue);
-        CWalletDB(strWalletFile).WriteMintPoolPair(hashPubcoin, mintPoolEntry);
-        LogPrintf("%s : hashSeedMaster=%s hashPubcoin=%s seedId=%d count=%d\n", __func__, hashSeedMaster.GetHex(), hashPubcoin.GetHex(), seedId.GetHex(), nLastCount);
+        walletdb.WritePubcoin(seed.hashSerial, seed.commitmentValue);
+        walletdb.WriteMintPoolPair(hashPubcoin, mintPoolEntry);
+        LogPrintf("%s : hashSeedMaster=%s hashPubcoin=%s seedId=%d count=%d\n", __func__, hashSeedMaster.GetHex(), hashPubcoin.GetHex(), seed.seedId.GetHex(), seed.nCount);
     }
 
     // Update local + DB entries for count last generated
@@ -232,6 +298,7 @@ bool CHDMintWallet::GetSerialForPubcoin(const std::vector<std::pair<uint256, Gro
  * Mints are created deterministically so we can completely regenerate all mints and transaction data for them from chain data.
  * Rather than a single pass of listMints, we wrap each pass in an outer while loop, that continues until no updates are found.
  * The reason for this is to allow the mint counter in the wallet to update and regenerate more of the mint pool should it need to.
+ * Each pass goes over the minted coins once, matching them against the pubcoin hashes of the pool.
  * 
  * @param fGenerateMintPool whether or not to call GenerateMintPool. defaults to true
  * @param listMints An optional value. If passed, only sync the mints in this list. Else get all mints in the mintpool
@@ -253,75 +320,79 @@ void CHDMintWallet::SyncWithChain(bool fGenerateMintPool, boost::optional<std::l
             listMints = list<pair<uint256, MintPoolEntry>>();
             mintPool.List(listMints.get());
         }
-        for (pair<uint256, MintPoolEntry>& pMint : listMints.get()) {
+
+        // pool entries not seen before, by pubcoin hash
+        std::map<uint256, pair<uint256, MintPoolEntry>> mapPending;
+        for (const pair<uint256, MintPoolEntry>& pMint : listMints.get()) {
             if (setChecked.count(pMint.first))
                 continue;
             setChecked.insert(pMint.first);
 
+            // halt processing if mint already in tracker
+            if (tracker.HasPubcoinHash(pMint.first))
+                continue;
+
+            mapPending.insert(make_pair(pMint.first, pMint));
+        }
+
+        std::vector<std::pair<pair<uint256, MintPoolEntry>, std::pair<sigma::PublicCoin, sigma::CMintedCoinInfo>>> vFound;
+        if (!mapPending.empty()) {
+            LOCK(cs_main);
+            for (auto const & mint : sigma::CSigmaState::GetState()->GetMints()) {
+                auto it = mapPending.find(mint.first.getValueHash());
+                if (it != mapPending.end())
+                    vFound.push_back(make_pair(it->second, mint));
+            }
+        }
+
+        // handle the mints in the order of the counter, which is the order they were minted in
+        std::sort(vFound.begin(), vFound.end(), [](
+                const std::pair<pair<uint256, MintPoolEntry>, std::pair<sigma::PublicCoin, sigma::CMintedCoinInfo>>& a,
+                const std::pair<pair<uint256, MintPoolEntry>, std::pair<sigma::PublicCoin, sigma::CMintedCoinInfo>>& b) {
+            return get<2>(a.first.second) < get<2>(b.first.second);
+        });
+
+        CBlock block;
+        CBlockIndex* pindexBlock = nullptr;
+        for (auto& foundMint : vFound) {
             if (ShutdownRequested())
                 return;
 
+            pair<uint256, MintPoolEntry>& pMint = foundMint.first;
             uint160& mintHashSeedMaster = get<0>(pMint.second);
             int32_t& mintCount = get<2>(pMint.second);
+            const sigma::PublicCoin& pubcoin = foundMint.second.first;
+            const sigma::CMintedCoinInfo& mintInfo = foundMint.second.second;
 
-            // halt processing if mint already in tracker
-            if (tracker.HasPubcoinHash(pMint.first))
-                continue;
+            CBlockIndex* pindex = nullptr;
+            {
+                LOCK(cs_main);
+                pindex = chainActive[mintInfo.nHeight];
+            }
+            if (pindex && pindex != pindexBlock) {
+                pindexBlock = nullptr;
+                if (ReadBlockFromDisk(block, pindex, Params().GetConsensus()))
+                    pindexBlock = pindex;
+            }
 
             COutPoint outPoint;
-            if (sigma::GetOutPoint(outPoint, pMint.first)) {
-                const uint256& txHash = outPoint.hash;
-                //this mint has already occurred on the chain, increment counter's state to reflect this
-                LogPrintf("%s : Found wallet coin mint=%s count=%d tx=%s\n", __func__, pMint.first.GetHex(), mintCount, txHash.GetHex());
-                found = true;
-
-                uint256 hashBlock;
-                CTransaction tx;
-                if (!GetTransaction(txHash, tx, Params().GetConsensus(), hashBlock, true)) {
-                    LogPrintf("%s : failed to get transaction for mint %s!\n", __func__, pMint.first.GetHex());
-                    found = false;
-                    continue;
-                }
+            if (!pindex || pindex != pindexBlock || !sigma::GetOutPointFromBlock(outPoint, pubcoin.getValue(), block)) {
+                LogPrintf("%s : failed to get transaction for mint %s!\n", __func__, pMint.first.GetHex());
+                continue;
+            }
 
-                //Find the denomination
-                boost::optional<sigma::CoinDenomination> denomination = boost::none;
-                bool fFoundMint = false;
-                GroupElement bnValue;
-                for (const CTxOut& out : tx.vout) {
-                    if (!out.scriptPubKey.IsSigmaMint())
-                        continue;
+            const uint256& txHash = outPoint.hash;
+            //this mint has already occurred on the chain, increment counter's state to reflect this
+            LogPrintf("%s : Found wallet coin mint=%s count=%d tx=%s\n", __func__, pMint.first.GetHex(), mintCount, txHash.GetHex());
+            found = true;
 
-                    sigma::PublicCoin pubcoin;
-                    CValidationState state;
-                    if (!TxOutToPublicCoin(out, pubcoin, state)) {
-                        LogPrintf("%s : failed to get mint from txout for %s!\n", __func__, pMint.first.GetHex());
+            if (!setAddedTx.count(txHash)) {
+                for (const CTransaction& tx : block.vtx) {
+                    if (tx.GetHash() != txHash)
                         continue;
-                    }
 
-                    // See if this is the mint that we are looking for
-                    uint256 hashPubcoin = primitives::GetPubCoinValueHash(pubcoin.getValue());
-                    if (pMint.first == hashPubcoin) {
-                        denomination = pubcoin.getDenomination();
-                        bnValue = pubcoin.getValue();
-                        fFoundMint = true;
-                        break;
-                    }
-                }
-
-                if (!fFoundMint || denomination == boost::none) {
-                    LogPrintf("%s : failed to get mint %s from tx %s!\n", __func__, pMint.first.GetHex(), tx.GetHash().GetHex());
-                    found = false;
-                    break;
-                }
-
-                CBlockIndex* pindex = nullptr;
-                if (mapBlockIndex.count(hashBlock))
-                    pindex = mapBlockIndex.at(hashBlock);
-
-                if (!setAddedTx.count(txHash)) {
-                    CBlock block;
                     CWalletTx wtx(pwalletMain, tx);
-                    if (pindex && ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
+                    {
                         LOCK(cs_main);
                         wtx.SetMerkleBranch(block);
                     }
@@ -330,17 +401,18 @@ void CHDMintWallet::SyncWithChain(bool fGenerateMintPool, boost::optional<std::l
                     wtx.nTimeReceived = pindex->GetBlockTime();
                     pwalletMain->AddToWallet(wtx, false, &walletdb);
                     setAddedTx.insert(txHash);
+                    break;
                 }
+            }
 
-                if(!SetMintSeedSeen(pMint, pindex->nHeight, txHash, denomination.get()))
-                    continue;
+            if(!SetMintSeedSeen(pMint, pindex->nHeight, txHash, mintInfo.denomination))
+                continue;
 
-                // Only update if the current hashSeedMaster matches the mints'
-                if(hashSeedMaster == mintHashSeedMaster && mintCount >= GetCount()){
-                    SetCount(++mintCount);
-                    UpdateCountDB();
-                    LogPrint("zero", "%s: updated count to %d\n", __func__, nCountNextUse);
-                }
+            // Only update if the current hashSeedMaster matches the mints'
+            if(hashSeedMaster == mintHashSeedMaster && mintCount >= GetCount()){
+                SetCount(++mintCount);
+                UpdateCountDB();
+                LogPrint("zero", "%s: updated count to %d\n", __func__, nCountNextUse);
             }
         }
         // Clear listMints to allow it to be repopulated by the mintPool on the next iteration
@@ -470,8 +542,9 @@ bool CHDMintWallet::SeedToMint(const uint512& mintSeed, GroupElement& commit, si
     coin.setRandomness(randomness);
 
     // Generate a Pedersen commitment to the serial number
+    const sigma::GeneratorTables& tables = coin.getParams()->get_tables();
     commit = sigma::SigmaPrimitives<Scalar, GroupElement>::commit(
-             coin.getParams()->get_g(), coin.getSerialNumber(), coin.getParams()->get_h0(), coin.getRandomness());
+             tables.g, coin.getSerialNumber(), tables.h[0], coin.getRandomness());
 
     return true;
 }
@@ -94,6 +94,7 @@ static CZMQReplierInterface* pzmqReplierInterface = NULL;
 #include "netfulfilledman.h"
 #include "flat-database.h"
 #include "instantx.h"
+#include "messageprecheck.h"
 #include "spork.h"
 
 
@@ -486,6 +487,9 @@ std::string HelpMessage(HelpMessageMode mode) {
     strUsage += HelpMessageOpt("-maxtimeadjustment", strprintf(
             _("Maximum allowed median peer time offset adjustment. Local perspective of time may be influenced by peers forward or backward by this amount. (default: %u seconds)"),
             DEFAULT_MAX_TIME_ADJUSTMENT));
+    strUsage += HelpMessageOpt("-msgcheckthreads=<n>", strprintf(
+            _("Set the number of threads checking shroudnode and spork message signatures ahead of processing (0 = auto, up to %d, default: %d)"),
+            MAX_MESSAGE_PRECHECK_THREADS, DEFAULT_MESSAGE_PRECHECK_THREADS));
     strUsage += HelpMessageOpt("-onion=<ip:port>", strprintf(
             _("Use separate SOCKS5 proxy to reach peers via Tor hidden services (default: %s)"), "-proxy"));
     strUsage += HelpMessageOpt("-onlynet=<net>", _("Only connect to nodes in network <net> (ipv4, ipv6 or onion)"));
@@ -511,6 +515,11 @@ std::string HelpMessage(HelpMessageMode mode) {
             _("Sets the serialization of raw transaction or block hex returned in non-verbose mode, non-segwit(0) or segwit(1) (default: %d)"),
             DEFAULT_RPC_SERIALIZE_VERSION));
     strUsage += HelpMessageOpt("-seednode=<ip>", _("Connect to a node to retrieve peer addresses, and disconnect"));
+#ifdef HAVE_SYS_EPOLL_H
+    strUsage += HelpMessageOpt("-socketevents=<mode>",
+                               strprintf(_("Socket events mode, which must be one of: select, epoll (default: %s)"),
+                                         DEFAULT_SOCKET_EVENTS));
+#endif
     strUsage += HelpMessageOpt("-timeout=<n>",
                                strprintf(_("Specify connection timeout in milliseconds (minimum: 1, default: %d)"),
                                          DEFAULT_CONNECT_TIMEOUT));
@@ -709,8 +718,9 @@ std::string HelpMessage(HelpMessageMode mode) {
     strUsage += HelpMessageGroup("Elysium options:");
     strUsage += HelpMessageOpt("-elysium", "Enable Elysium");
     strUsage += HelpMessageOpt("-startclean", "Clear all persistence files on startup; triggers reparsing of Elysium transactions");
-    strUsage += HelpMessageOpt("-elysiumtxcache=<num>", "The maximum number of transactions in the input transaction cache (default: 500000)");
+    strUsage += HelpMessageOpt("-elysiumtxcache=<num>", "The maximum number of transaction outputs in the input cache (default: 500000)");
     strUsage += HelpMessageOpt("-elysiumprogressfrequency=<seconds>", "Time in seconds after which the initial scanning progress is reported (default: 30)");
+    strUsage += HelpMessageOpt("-elysiumscanthreads=<n>", "Number of threads reading blocks ahead of the initial scan (default: number of cores, up to 8)");
     strUsage += HelpMessageOpt("-elysiumdebug=<category>", "Enable or disable log categories, can be \"all\" or \"none\"");
     strUsage += HelpMessageOpt("-autocommit=<flag>", "Enable or disable broadcasting of transactions, when creating transactions (default: 1)");
     strUsage += HelpMessageOpt("-overrideforcedshutdown=<flag>", "Disable force shutdown when error (default: 0)");
@@ -1232,8 +1242,18 @@ bool AppInit2(boost::thread_group &threadGroup, CScheduler &scheduler) {
     int nUserMaxConnections = GetArg("-maxconnections", DEFAULT_MAX_PEER_CONNECTIONS);
     nMaxConnections = std::max(nUserMaxConnections, 0);
 
+    std::string strSocketEvents = GetArg("-socketevents", DEFAULT_SOCKET_EVENTS);
+    if (strSocketEvents != "select"
+#ifdef HAVE_SYS_EPOLL_H
+        && strSocketEvents != "epoll"
+#endif
+        )
+        return InitError(strprintf(_("Invalid -socketevents ('%s') specified."), strSocketEvents));
+
     // Trim requested connection counts, to fit into system limitations
-    nMaxConnections = std::max(std::min(nMaxConnections, (int) (FD_SETSIZE - nBind - MIN_CORE_FILEDESCRIPTORS)), 0);
+    // (only select() is limited to sockets below FD_SETSIZE)
+    if (strSocketEvents == "select")
+        nMaxConnections = std::max(std::min(nMaxConnections, (int) (FD_SETSIZE - nBind - MIN_CORE_FILEDESCRIPTORS)), 0);
     int nFD = RaiseFileDescriptorLimit(nMaxConnections + MIN_CORE_FILEDESCRIPTORS);
     if (nFD < MIN_CORE_FILEDESCRIPTORS)
         return InitError(_("Not enough file descriptors available."));
@@ -1462,8 +1482,10 @@ bool AppInit2(boost::thread_group &threadGroup, CScheduler &scheduler) {
 
     LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
     if (nScriptCheckThreads) {
-        for (int i = 0; i < nScriptCheckThreads - 1; i++)
+        for (int i = 0; i < nScriptCheckThreads - 1; i++) {
             threadGroup.create_thread(&ThreadScriptCheck);
+            threadGroup.create_thread(&ThreadSigmaSpendCheck);
+        }
     }
 	    if (mapArgs.count("-sporkkey")) // spork priv key
     {
@@ -2223,6 +2245,9 @@ bool AppInit2(boost::thread_group &threadGroup, CScheduler &scheduler) {
 
     threadGroup.create_thread(boost::bind(&ThreadCheckDarkSendPool));
 
+    if (!fLiteMode)
+        messagePrecheckPool.Start(threadGroup);
+
 
 
     // ********************************************************* Step 12: finished
@@ -57,6 +57,7 @@
 #include "shroudnode-payments.h"
 #include "shroudnode-sync.h"
 #include "shroudnodeman.h"
+#include "messageprecheck.h"
 #include "coins.h"
 
 #include "sigma/coinspend.h"
@@ -417,6 +418,7 @@ namespace {
             mapBlocksInFlight.erase(entry.hash);
         }
         EraseOrphansFor(nodeid);
+        messagePrecheckPool.RemovePeer(nodeid);
         nPreferredDownload -= state->fPreferredDownload;
         nPeersWithValidatedDownloads -= (state->nBlocksInFlightValidHeaders != 0);
         assert(nPeersWithValidatedDownloads >= 0);
@@ -2580,32 +2582,36 @@ namespace {
         return true;
     }
 
-    bool UndoReadFromDisk(CBlockUndo &blockundo, const CDiskBlockPos &pos, const uint256 &hashBlock) {
-        // Open history file to read
-        CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
-        if (filein.IsNull())
-            return error("%s: OpenUndoFile failed", __func__);
-
-        // Read block
-        uint256 hashChecksum;
-        try {
-            filein >> blockundo;
-            filein >> hashChecksum;
-        }
-        catch (const std::exception &e) {
-            return error("%s: Deserialize or I/O error - %s", __func__, e.what());
-        }
+} // anon namespace
 
-        // Verify checksum
-        CHashWriter hasher(SER_GETHASH, PROTOCOL_VERSION);
-        hasher << hashBlock;
-        hasher << blockundo;
-        if (hashChecksum != hasher.GetHash())
-            return error("%s: Checksum mismatch", __func__);
+bool UndoReadFromDisk(CBlockUndo &blockundo, const CDiskBlockPos &pos, const uint256 &hashBlock) {
+    // Open history file to read
+    CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull())
+        return error("%s: OpenUndoFile failed", __func__);
 
-        return true;
+    // Read block
+    uint256 hashChecksum;
+    try {
+        filein >> blockundo;
+        filein >> hashChecksum;
+    }
+    catch (const std::exception &e) {
+        return error("%s: Deserialize or I/O error - %s", __func__, e.what());
     }
 
+    // Verify checksum
+    CHashWriter hasher(SER_GETHASH, PROTOCOL_VERSION);
+    hasher << hashBlock;
+    hasher << blockundo;
+    if (hashChecksum != hasher.GetHash())
+        return error("%s: Checksum mismatch", __func__);
+
+    return true;
+}
+
+namespace {
+
 /** Abort with a message */
     /*bool AbortNode(const std::string &strMessage, const std::string &userMessage = "") {
         strMiscWarning = strMessage;
@@ -2789,6 +2795,13 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+static CCheckQueue<sigma::CSigmaSpendCheck> sigmaspendcheckqueue(1);
+
+void ThreadSigmaSpendCheck() {
+    RenameThread("bitcoin-sigmach");
+    sigmaspendcheckqueue.Thread();
+}
+
 // Protected by cs_main
 VersionBitsCache versionbitscache;
 
@@ -3004,6 +3017,8 @@ bool ConnectBlock(const CBlock &block, CValidationState &state, CBlockIndex *pin
 
     block.zerocoinTxInfo = std::make_shared<CZerocoinTxInfo>();
     block.sigmaTxInfo = std::make_shared<sigma::CSigmaTxInfo>();
+    // sigma proofs are verified in one go by ConnectBlockSigma
+    block.sigmaTxInfo->spendBatch.reset(new sigma::CSigmaSpendBatch());
 
     for (unsigned int i = 0; i < block.vtx.size(); i++) {
         const CTransaction &tx = block.vtx[i];
@@ -3098,6 +3113,14 @@ bool ConnectBlock(const CBlock &block, CValidationState &state, CBlockIndex *pin
     block.zerocoinTxInfo->Complete();
     block.sigmaTxInfo->Complete();
 
+    // verify sigma proofs on the script check threads while the rest of the block is being checked
+    CCheckQueueControl<sigma::CSigmaSpendCheck> sigmaControl(nScriptCheckThreads ? &sigmaspendcheckqueue : NULL);
+    bool fSigmaChecks = nScriptCheckThreads && block.sigmaTxInfo->spendBatch && !block.sigmaTxInfo->spendBatch->IsEmpty();
+    if (fSigmaChecks) {
+        std::vector<sigma::CSigmaSpendCheck> vSigmaChecks = block.sigmaTxInfo->spendBatch->GetChecks();
+        sigmaControl.Add(vSigmaChecks);
+    }
+
     int64_t nTime3 = GetTimeMicros();
     nTimeConnect += nTime3 - nTime2;
     LogPrint("bench", "      - Connect %u transactions: %.2fms (%.3fms/tx, %.3fms/txin) [%.2fs]\n",
@@ -3141,6 +3164,13 @@ bool ConnectBlock(const CBlock &block, CValidationState &state, CBlockIndex *pin
 
     if (!control.Wait())
         return state.DoS(100, false);
+    if (!sigmaControl.Wait())
+        return state.DoS(100, error("ConnectBlock(): sigma spend verification failed"),
+                         REJECT_INVALID, "bad-txns-zerocoin");
+    if (fSigmaChecks) {
+        // proofs are verified, don't do it again in ConnectBlockSigma
+        block.sigmaTxInfo->spendBatch.reset();
+    }
     int64_t nTime4 = GetTimeMicros();
     nTimeVerify += nTime4 - nTime2;
     LogPrint("bench", "    - Verify %u txins: %.2fms (%.3fms/txin) [%.2fs]\n", nInputs - 1, 0.001 * (nTime4 - nTime2),
@@ -8169,6 +8199,24 @@ bool ProcessMessages(CNode *pfrom) {
     // this maintains the order of responses
     if (!pfrom->vRecvGetData.empty()) return fOk;
 
+    // Offer the newly completed messages to the precheck pool, so their signatures are
+    // checked in parallel while the messages before them are processed here one by one.
+    // Messages complete in order, so the scan stops at the first one offered before.
+    if (messagePrecheckPool.IsRunning()) {
+        std::deque<CNetMessage>::reverse_iterator rit = pfrom->vRecvMsg.rbegin();
+        if (rit != pfrom->vRecvMsg.rend() && !rit->complete())
+            rit++;
+        std::deque<CNetMessage>::reverse_iterator ritEnd = rit;
+        while (ritEnd != pfrom->vRecvMsg.rend() && !ritEnd->fPrecheckSeen)
+            ritEnd++;
+        for (std::deque<CNetMessage>::iterator itNew = ritEnd.base(); itNew != rit.base(); itNew++) {
+            itNew->fPrecheckSeen = true;
+            std::string strCommand = itNew->hdr.GetCommand();
+            if (CMessagePrecheckPool::IsPrecheckedCommand(strCommand))
+                messagePrecheckPool.Enqueue(pfrom->GetId(), strCommand, itNew->vRecv);
+        }
+    }
+
     std::deque<CNetMessage>::iterator it = pfrom->vRecvMsg.begin();
     while (!pfrom->fDisconnect && it != pfrom->vRecvMsg.end()) {
         // Don't bother if send buffer is too full to respond anyway
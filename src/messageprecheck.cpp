@@ -0,0 +1,170 @@
+// Copyright (c) 2020 The ShroudX Project developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "messageprecheck.h"
+
+#include "darksend.h"
+#include "shroudnode.h"
+#include "shroudnode-payments.h"
+#include "spork.h"
+#include "util.h"
+
+#include <algorithm>
+
+CMessagePrecheckPool messagePrecheckPool;
+
+bool CMessagePrecheckPool::IsPrecheckedCommand(const std::string& strCommand)
+{
+    return strCommand == NetMsgType::MNANNOUNCE ||
+           strCommand == NetMsgType::MNPING ||
+           strCommand == NetMsgType::SHROUDNODEPAYMENTVOTE ||
+           strCommand == NetMsgType::SPORK;
+}
+
+void CMessagePrecheckPool::Start(boost::thread_group& threadGroup)
+{
+    int nThreads = GetArg("-msgcheckthreads", DEFAULT_MESSAGE_PRECHECK_THREADS);
+    if (nThreads <= 0) {
+        nThreads = GetNumCores() - 1;
+    }
+    nThreads = std::min(nThreads, MAX_MESSAGE_PRECHECK_THREADS);
+    if (nThreads <= 0) {
+        LogPrintf("CMessagePrecheckPool::Start -- no spare cores, messages are checked by the message handler\n");
+        return;
+    }
+
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        if (fRunning) return;
+        fRunning = true;
+    }
+
+    LogPrintf("CMessagePrecheckPool::Start -- using %d threads\n", nThreads);
+    for (int i = 0; i < nThreads; i++) {
+        threadGroup.create_thread(boost::bind(&TraceThread<boost::function<void()> >, "msgcheck",
+                                              boost::function<void()>(boost::bind(&CMessagePrecheckPool::ThreadPrecheck, this))));
+    }
+}
+
+bool CMessagePrecheckPool::IsRunning()
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    return fRunning;
+}
+
+void CMessagePrecheckPool::Enqueue(NodeId nodeid, const std::string& strCommand, const CDataStream& vRecv)
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    if (!fRunning) return;
+
+    CPeerPrechecks& peer = mapPeers[nodeid];
+    // skipping the check is harmless, ProcessMessage verifies the signature anyway
+    if (peer.queue.size() >= MAX_PEER_PRECHECKS ||
+        peer.nBytes + vRecv.size() > ReceiveFloodSize() ||
+        nTotalBytes + vRecv.size() > MAX_PRECHECK_QUEUE_BYTES) {
+        if (!peer.fBusy && peer.queue.empty()) mapPeers.erase(nodeid);
+        return;
+    }
+
+    if (!peer.fBusy && peer.queue.empty()) {
+        queueReady.push_back(nodeid);
+        condition.notify_one();
+    }
+    peer.queue.push_back(std::make_pair(strCommand, vRecv));
+    peer.nBytes += vRecv.size();
+    nTotalBytes += vRecv.size();
+}
+
+void CMessagePrecheckPool::RemovePeer(NodeId nodeid)
+{
+    boost::unique_lock<boost::mutex> lock(mutex);
+    std::map<NodeId, CPeerPrechecks>::iterator it = mapPeers.find(nodeid);
+    if (it == mapPeers.end()) return;
+
+    nTotalBytes -= it->second.nBytes;
+    if (it->second.fBusy) {
+        // the worker drops the entry once it is done
+        it->second.queue.clear();
+        it->second.nBytes = 0;
+        return;
+    }
+    queueReady.erase(std::remove(queueReady.begin(), queueReady.end(), nodeid), queueReady.end());
+    mapPeers.erase(it);
+}
+
+void CMessagePrecheckPool::ThreadPrecheck()
+{
+    while (true) {
+        NodeId nodeid;
+        std::string strCommand;
+        CDataStream vRecv(SER_NETWORK, PROTOCOL_VERSION);
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            while (queueReady.empty()) {
+                condition.wait(lock);
+            }
+            nodeid = queueReady.front();
+            queueReady.pop_front();
+
+            CPeerPrechecks& peer = mapPeers[nodeid];
+            strCommand.swap(peer.queue.front().first);
+            vRecv = peer.queue.front().second;
+            peer.queue.pop_front();
+            peer.nBytes -= vRecv.size();
+            nTotalBytes -= vRecv.size();
+            peer.fBusy = true;
+        }
+
+        try {
+            Precheck(strCommand, vRecv);
+        } catch (const std::exception& e) {
+            // malformed messages are reported by ProcessMessage
+            LogPrint("net", "CMessagePrecheckPool::ThreadPrecheck -- %s: %s, peer=%d\n", strCommand, e.what(), nodeid);
+        }
+
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            std::map<NodeId, CPeerPrechecks>::iterator it = mapPeers.find(nodeid);
+            if (it != mapPeers.end()) {
+                it->second.fBusy = false;
+                if (it->second.queue.empty()) {
+                    mapPeers.erase(it);
+                } else {
+                    // back of the line, so one busy peer does not hold up the others
+                    queueReady.push_back(nodeid);
+                    condition.notify_one();
+                }
+            }
+        }
+        boost::this_thread::interruption_point();
+    }
+}
+
+void CMessagePrecheckPool::Precheck(const std::string& strCommand, CDataStream& vRecv)
+{
+    // the pubkey a signature must match can depend on shroudnode state, so only the
+    // recovery is done here and ProcessMessage compares the keys
+    CKeyID keyID;
+
+    if (strCommand == NetMsgType::MNANNOUNCE) {
+        CShroudnodeBroadcast mnb;
+        vRecv >> mnb;
+        darkSendSigner.RecoverMessageKey(mnb.vchSig, mnb.GetSignatureMessage(), keyID);
+        if (!mnb.lastPing.vchSig.empty()) {
+            darkSendSigner.RecoverMessageKey(mnb.lastPing.vchSig, mnb.lastPing.GetSignatureMessage(), keyID);
+        }
+    } else if (strCommand == NetMsgType::MNPING) {
+        CShroudnodePing mnp;
+        vRecv >> mnp;
+        darkSendSigner.RecoverMessageKey(mnp.vchSig, mnp.GetSignatureMessage(), keyID);
+    } else if (strCommand == NetMsgType::SHROUDNODEPAYMENTVOTE) {
+        CShroudnodePaymentVote vote;
+        vRecv >> vote;
+        darkSendSigner.RecoverMessageKey(vote.vchSig, vote.GetSignatureMessage(), keyID);
+    } else if (strCommand == NetMsgType::SPORK) {
+        CSporkMessage spork;
+        vRecv >> spork;
+        darkSendSigner.RecoverMessageKey(spork.GetSignature(), spork.GetSignatureMessage(), keyID);
+    }
+}
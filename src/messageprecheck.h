@@ -0,0 +1,76 @@
+// Copyright (c) 2020 The ShroudX Project developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef MESSAGEPRECHECK_H
+#define MESSAGEPRECHECK_H
+
+#include "net.h"
+#include "streams.h"
+
+#include <boost/thread.hpp>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <utility>
+
+//! -msgcheckthreads default, 0 = one thread per core besides the message handler
+static const int DEFAULT_MESSAGE_PRECHECK_THREADS = 0;
+static const int MAX_MESSAGE_PRECHECK_THREADS = 16;
+//! messages of a peer waiting to be checked, more are left to the message handler
+static const size_t MAX_PEER_PRECHECKS = 5000;
+//! payload bytes waiting to be checked over all peers, a single peer is held to ReceiveFloodSize()
+static const size_t MAX_PRECHECK_QUEUE_BYTES = 64 * 1000 * 1000;
+
+class CMessagePrecheckPool;
+extern CMessagePrecheckPool messagePrecheckPool;
+
+/**
+ * Checks the signatures of shroudnode and spork messages on a pool of worker threads
+ * before the message handler gets to them. The workers neither need cs_main nor touch
+ * any shroudnode state, they only warm the recovered key cache of darkSendSigner.
+ * Everything that changes state is still done in order by ProcessMessage.
+ */
+class CMessagePrecheckPool
+{
+private:
+    struct CPeerPrechecks
+    {
+        // command - payload, checked in the order they were received
+        std::deque<std::pair<std::string, CDataStream> > queue;
+        // payload bytes in queue
+        size_t nBytes;
+        // a worker is checking a message of the peer
+        bool fBusy;
+
+        CPeerPrechecks() : nBytes(0), fBusy(false) {}
+    };
+
+    boost::mutex mutex;
+    boost::condition_variable condition;
+    std::map<NodeId, CPeerPrechecks> mapPeers;
+    // peers with queued messages and no worker, served round robin
+    std::deque<NodeId> queueReady;
+    // payload bytes queued over all peers
+    size_t nTotalBytes;
+    bool fRunning;
+
+    void ThreadPrecheck();
+    static void Precheck(const std::string& strCommand, CDataStream& vRecv);
+
+public:
+    CMessagePrecheckPool() : nTotalBytes(0), fRunning(false) {}
+
+    static bool IsPrecheckedCommand(const std::string& strCommand);
+
+    void Start(boost::thread_group& threadGroup);
+    bool IsRunning();
+
+    /// Queue a complete message of the peer, a peer is only served by one worker at a time
+    void Enqueue(NodeId nodeid, const std::string& strCommand, const CDataStream& vRecv);
+    /// Drop the messages still queued for a disconnected peer
+    void RemovePeer(NodeId nodeid);
+};
+
+#endif
@@ -58,6 +58,10 @@ uint64_t nLastBlockSize = 0;
 uint64_t nLastBlockWeight = 0;
 int64_t nLastCoinStakeSearchInterval = 0;
 unsigned int nMinerSleep = 4000;
+
+/** Nonces hashed together by the PoW miner */
+static const unsigned int MINER_NONCE_BATCH = 8;
+
 class ScoreCompare
 {
 public:
@@ -1115,11 +1119,28 @@ void static ZcoinMiner(const CChainParams &chainparams) {
                 uint256 thash;
                    ///change to x116rv3
                 while (true) {
-                    thash = pblock->GetPoWHash();
+                    // Nonces share hashPrevBlock, so they are hashed side by side, see HashX16RV2Batch
+                    CBlockHeader candidates[MINER_NONCE_BATCH];
+                    const CBlockHeader* pcandidates[MINER_NONCE_BATCH];
+                    uint256 hashes[MINER_NONCE_BATCH];
+                    for (unsigned int i = 0; i < MINER_NONCE_BATCH; i++) {
+                        candidates[i] = pblock->GetBlockHeader();
+                        candidates[i].nNonce = pblock->nNonce + i;
+                        pcandidates[i] = &candidates[i];
+                    }
+                    GetPoWHashes(pcandidates, MINER_NONCE_BATCH, hashes);
+
+                    unsigned int nFound = MINER_NONCE_BATCH;
+                    for (unsigned int i = 0; i < MINER_NONCE_BATCH && nFound == MINER_NONCE_BATCH; i++) {
+                        if (UintToArith256(hashes[i]) <= hashTarget)
+                            nFound = i;
+                    }
 
                     //LogPrintf("*****\nhash   : %s  \ntarget : %s\n", UintToArith256(thash).ToString(), hashTarget.ToString());
 
-                    if (UintToArith256(thash) <= hashTarget) {
+                    if (nFound < MINER_NONCE_BATCH) {
+                        pblock->nNonce += nFound;
+                        thash = hashes[nFound];
                         // Found a solution
                         LogPrintf("Found a solution. Hash: %s", UintToArith256(thash).ToString());
                         SetThreadPriority(THREAD_PRIORITY_NORMAL);
@@ -1138,8 +1159,8 @@ void static ZcoinMiner(const CChainParams &chainparams) {
                             throw boost::thread_interrupted();
                         break;
                     }
-                    pblock->nNonce += 1;
-                    if ((pblock->nNonce & 0xFF) == 0)
+                    pblock->nNonce += MINER_NONCE_BATCH;
+                    if ((pblock->nNonce & 0xFF) < MINER_NONCE_BATCH)
                         break;
                 }
                 // Check for stop or if block needs to be rebuilt
@@ -35,6 +35,10 @@
 
 #endif
 
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+
 #ifdef USE_UPNP
 #include <miniupnpc/miniupnpc.h>
 #include <miniupnpc/miniwget.h>
@@ -45,6 +49,7 @@
 #include <boost/thread.hpp>
 
 #include <math.h>
+#include <set>
 
 // Dump addresses to peers.dat and banlist.dat every 15 minutes (900s)
 #define DUMP_ADDRESSES_INTERVAL 900
@@ -157,6 +162,39 @@ CCriticalSection cs_nLastNodeId;
 static CSemaphore *semOutbound = NULL;
 boost::condition_variable messageHandlerCondition;
 
+// How ThreadSocketHandler waits for socket readiness, see InitSocketEvents
+static bool fSocketEventsEpoll = false;
+#ifdef HAVE_SYS_EPOLL_H
+static int epollFd = -1;
+#endif
+#ifndef WIN32
+// Lets other threads interrupt the wait for socket events, see WakeSocketHandler
+static int wakeupPipe[2] = {-1, -1};
+static std::atomic<bool> fWakeupPending(false);
+#endif
+
+/**
+ * Takes a socket out of the epoll set before it is closed. A registration lives as long as
+ * the open file, which a forked -blocknotify or -walletnotify child may keep alive.
+ */
+static void UnregisterSocketEvents(SOCKET hSocket)
+{
+#ifdef HAVE_SYS_EPOLL_H
+    if (fSocketEventsEpoll && hSocket != INVALID_SOCKET) {
+        struct epoll_event event;
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, hSocket, &event);
+    }
+#endif
+}
+
+/** Keeps peer sockets out of the processes started by runCommand */
+static void SetSocketCloseOnExec(SOCKET hSocket)
+{
+#ifndef WIN32
+    fcntl(hSocket, F_SETFD, fcntl(hSocket, F_GETFD, 0) | FD_CLOEXEC);
+#endif
+}
+
 // Signals for message handling
 static CNodeSignals g_signals;
 
@@ -428,11 +466,12 @@ CNode *ConnectNode(CAddress addrConnect, const char *pszDest, bool fCountFailure
     if (pszDest ? ConnectSocketByName(addrConnect, hSocket, pszDest, Params().GetDefaultPort(), nConnectTimeout,
                                       &proxyConnectionFailed) :
         ConnectSocket(addrConnect, hSocket, nConnectTimeout, &proxyConnectionFailed)) {
-        if (!IsSelectableSocket(hSocket)) {
+        if (!IsUsableSocket(hSocket)) {
             LogPrintf("Cannot create connection: non-selectable socket created (fd >= FD_SETSIZE ?)\n");
             CloseSocket(hSocket);
             return NULL;
         }
+        SetSocketCloseOnExec(hSocket);
 
         if (pszDest && addrConnect.IsValid()) {
             // It is possible that we already have a connection to the IP/port pszDest resolved to.
@@ -507,6 +546,7 @@ void CNode::CloseSocketDisconnect() {
     fDisconnect = true;
     if (hSocket != INVALID_SOCKET) {
         LogPrint("net", "disconnecting peer=%d\n", id);
+        UnregisterSocketEvents(hSocket);
         CloseSocket(hSocket);
     }
 
@@ -1109,11 +1149,12 @@ static void AcceptConnection(const ListenSocket &hListenSocket) {
         return;
     }
 
-    if (!IsSelectableSocket(hSocket)) {
+    if (!IsUsableSocket(hSocket)) {
         LogPrintf("connection from %s dropped: non-selectable socket\n", addr.ToString());
         CloseSocket(hSocket);
         return;
     }
+    SetSocketCloseOnExec(hSocket);
 
     // According to the internet TCP_NODELAY is not carried into accepted sockets
     // on all platforms.  Set it again here just to be sure.
@@ -1243,6 +1284,285 @@ void CNode::CloseDandelionConnections(const CNode* const pnode)
               CNode::GetDandelionRoutingDataDebugString());
 }
 
+// frequency to poll pnode->vSend when nothing wakes the socket handler earlier
+static const int SOCKET_EVENTS_TIMEOUT_MSEC = 50;
+#ifdef HAVE_SYS_EPOLL_H
+// maximum number of ready sockets reported by one epoll_wait()
+static const int MAX_SOCKET_EVENTS = 1024;
+#endif
+
+bool IsUsableSocket(const SOCKET& hSocket)
+{
+    return fSocketEventsEpoll || IsSelectableSocket(hSocket);
+}
+
+void WakeSocketHandler()
+{
+#ifndef WIN32
+    // one pending byte is enough, the handler re-examines every node after waking up
+    if (wakeupPipe[1] == -1 || fWakeupPending.exchange(true))
+        return;
+    char buf = 0;
+    if (write(wakeupPipe[1], &buf, 1) != 1)
+        fWakeupPending = false;
+#endif
+}
+
+#ifndef WIN32
+static void DrainWakeupPipe()
+{
+    char buf[128];
+    while (read(wakeupPipe[0], buf, sizeof(buf)) > 0) {}
+    // cleared after draining, so a wakeup requested meanwhile is covered by the next loop
+    fWakeupPending = false;
+}
+#endif
+
+/**
+ * Decides whether the socket handler waits for sending or receiving on the socket of a node.
+ * fRecv and fSend are left unchanged where the buffer they depend on is locked by another thread.
+ */
+static void GetSocketInterest(CNode* pnode, bool& fRecv, bool& fSend)
+{
+    // Implement the following logic:
+    // * If there is data to send, wait for sending data. As this only
+    //   happens when optimistic write failed, we choose to first drain the
+    //   write buffer in this case before receiving more. This avoids
+    //   needlessly queueing received data, if the remote peer is not themselves
+    //   receiving data. This means properly utilizing TCP flow control signalling.
+    // * Otherwise, if there is no (complete) message in the receive buffer,
+    //   or there is space left in the buffer, wait for receiving data.
+    // * (if neither of the above applies, there is certainly one message
+    //   in the receiver buffer ready to be processed).
+    // Together, that means that at least one of the following is always possible,
+    // so we don't deadlock:
+    // * We send some data.
+    // * We wait for data to be received (and disconnect after timeout).
+    // * We process a message in the buffer (message handler thread).
+    {
+        TRY_LOCK(pnode->cs_vSend, lockSend);
+        if (lockSend)
+            fSend = !pnode->vSendMsg.empty();
+    }
+    if (fSend) {
+        fRecv = false;
+        return;
+    }
+    {
+        TRY_LOCK(pnode->cs_vRecvMsg, lockRecv);
+        if (lockRecv)
+            fRecv = pnode->vRecvMsg.empty() || !pnode->vRecvMsg.front().complete() ||
+                    pnode->GetTotalRecvSize() <= ReceiveFloodSize();
+    }
+}
+
+static void SocketEventsSelect(std::set<SOCKET>& recv_set, std::set<SOCKET>& send_set, std::set<SOCKET>& error_set)
+{
+    struct timeval timeout;
+    timeout.tv_sec = 0;
+    timeout.tv_usec = SOCKET_EVENTS_TIMEOUT_MSEC * 1000;
+
+    fd_set fdsetRecv;
+    fd_set fdsetSend;
+    fd_set fdsetError;
+    FD_ZERO(&fdsetRecv);
+    FD_ZERO(&fdsetSend);
+    FD_ZERO(&fdsetError);
+    SOCKET hSocketMax = 0;
+    bool have_fds = false;
+    std::vector<SOCKET> vSockets;
+
+    BOOST_FOREACH(const ListenSocket &hListenSocket, vhListenSocket) {
+        FD_SET(hListenSocket.socket, &fdsetRecv);
+        hSocketMax = std::max(hSocketMax, hListenSocket.socket);
+        vSockets.push_back(hListenSocket.socket);
+        have_fds = true;
+    }
+
+#ifndef WIN32
+    if (wakeupPipe[0] != -1) {
+        FD_SET(wakeupPipe[0], &fdsetRecv);
+        hSocketMax = std::max(hSocketMax, (SOCKET)wakeupPipe[0]);
+        have_fds = true;
+    }
+#endif
+
+    {
+        LOCK(cs_vNodes);
+        BOOST_FOREACH(CNode * pnode, vNodes)
+        {
+            if (pnode->hSocket == INVALID_SOCKET)
+                continue;
+            FD_SET(pnode->hSocket, &fdsetError);
+            hSocketMax = std::max(hSocketMax, pnode->hSocket);
+            vSockets.push_back(pnode->hSocket);
+            have_fds = true;
+
+            bool fRecv = false, fSend = false;
+            GetSocketInterest(pnode, fRecv, fSend);
+            if (fSend)
+                FD_SET(pnode->hSocket, &fdsetSend);
+            if (fRecv)
+                FD_SET(pnode->hSocket, &fdsetRecv);
+        }
+    }
+
+    int nSelect = select(have_fds ? hSocketMax + 1 : 0,
+                         &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
+    boost::this_thread::interruption_point();
+
+    if (nSelect == SOCKET_ERROR) {
+        if (have_fds) {
+            int nErr = WSAGetLastError();
+            LogPrintf("socket select error %s\n", NetworkErrorString(nErr));
+            recv_set.insert(vSockets.begin(), vSockets.end());
+        }
+        MilliSleep(SOCKET_EVENTS_TIMEOUT_MSEC);
+        return;
+    }
+
+#ifndef WIN32
+    if (wakeupPipe[0] != -1 && FD_ISSET(wakeupPipe[0], &fdsetRecv))
+        DrainWakeupPipe();
+#endif
+
+    BOOST_FOREACH(SOCKET hSocket, vSockets) {
+        if (FD_ISSET(hSocket, &fdsetRecv))
+            recv_set.insert(hSocket);
+        if (FD_ISSET(hSocket, &fdsetSend))
+            send_set.insert(hSocket);
+        if (FD_ISSET(hSocket, &fdsetError))
+            error_set.insert(hSocket);
+    }
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+static void SocketEventsEpoll(std::set<SOCKET>& recv_set, std::set<SOCKET>& send_set, std::set<SOCKET>& error_set)
+{
+    {
+        LOCK(cs_vNodes);
+        BOOST_FOREACH(CNode * pnode, vNodes)
+        {
+            if (pnode->hSocket == INVALID_SOCKET)
+                continue;
+
+            // the epoll set keeps the interest of every socket, so it is only updated on change
+            bool fRegistered = pnode->hSocketEvents == pnode->hSocket;
+            bool fRecv = fRegistered && (pnode->nSocketEvents & EPOLLIN);
+            bool fSend = fRegistered && (pnode->nSocketEvents & EPOLLOUT);
+            GetSocketInterest(pnode, fRecv, fSend);
+
+            uint32_t nEvents = (fRecv ? (uint32_t)EPOLLIN : 0) | (fSend ? (uint32_t)EPOLLOUT : 0);
+            if (fRegistered && pnode->nSocketEvents == nEvents)
+                continue;
+
+            struct epoll_event event;
+            event.events = nEvents;
+            event.data.fd = pnode->hSocket;
+            if (epoll_ctl(epollFd, fRegistered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, pnode->hSocket, &event) != 0) {
+                LogPrintf("socket epoll_ctl error %s\n", NetworkErrorString(errno));
+                pnode->fDisconnect = true;
+                continue;
+            }
+            pnode->hSocketEvents = pnode->hSocket;
+            pnode->nSocketEvents = nEvents;
+        }
+    }
+
+    struct epoll_event events[MAX_SOCKET_EVENTS];
+    int nEvents = epoll_wait(epollFd, events, MAX_SOCKET_EVENTS, SOCKET_EVENTS_TIMEOUT_MSEC);
+    boost::this_thread::interruption_point();
+
+    if (nEvents < 0) {
+        if (errno != EINTR) {
+            LogPrintf("socket epoll_wait error %s\n", NetworkErrorString(errno));
+            MilliSleep(SOCKET_EVENTS_TIMEOUT_MSEC);
+        }
+        return;
+    }
+
+    for (int i = 0; i < nEvents; i++) {
+        SOCKET hSocket = events[i].data.fd;
+        if ((int)hSocket == wakeupPipe[0]) {
+            DrainWakeupPipe();
+            continue;
+        }
+        if (events[i].events & EPOLLIN)
+            recv_set.insert(hSocket);
+        if (events[i].events & EPOLLOUT)
+            send_set.insert(hSocket);
+        if (events[i].events & (EPOLLERR | EPOLLHUP))
+            error_set.insert(hSocket);
+    }
+}
+#endif
+
+static void InitSocketEvents()
+{
+#ifndef WIN32
+    if (pipe(wakeupPipe) != 0) {
+        LogPrintf("Failed to create the socket handler wakeup pipe: %s\n", NetworkErrorString(errno));
+        wakeupPipe[0] = wakeupPipe[1] = -1;
+    } else {
+        for (int i = 0; i < 2; i++) {
+            fcntl(wakeupPipe[i], F_SETFL, fcntl(wakeupPipe[i], F_GETFL, 0) | O_NONBLOCK);
+        }
+    }
+#endif
+
+    std::string strMode = GetArg("-socketevents", DEFAULT_SOCKET_EVENTS);
+    if (strMode == "select")
+        return;
+#ifdef HAVE_SYS_EPOLL_H
+    if (strMode == "epoll") {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd == -1) {
+            LogPrintf("epoll_create1 failed, falling back to select: %s\n", NetworkErrorString(errno));
+            return;
+        }
+
+        // listening sockets and the wakeup pipe never change their interest
+        std::vector<SOCKET> vSockets;
+        BOOST_FOREACH(const ListenSocket &hListenSocket, vhListenSocket)
+            vSockets.push_back(hListenSocket.socket);
+        if (wakeupPipe[0] != -1)
+            vSockets.push_back(wakeupPipe[0]);
+        BOOST_FOREACH(SOCKET hSocket, vSockets) {
+            struct epoll_event event;
+            event.events = EPOLLIN;
+            event.data.fd = hSocket;
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, hSocket, &event) != 0) {
+                LogPrintf("epoll_ctl failed, falling back to select: %s\n", NetworkErrorString(errno));
+                close(epollFd);
+                epollFd = -1;
+                return;
+            }
+        }
+
+        fSocketEventsEpoll = true;
+    }
+#endif
+}
+
+static void ShutdownSocketEvents()
+{
+    fSocketEventsEpoll = false;
+#ifdef HAVE_SYS_EPOLL_H
+    if (epollFd != -1) {
+        close(epollFd);
+        epollFd = -1;
+    }
+#endif
+#ifndef WIN32
+    for (int i = 0; i < 2; i++) {
+        if (wakeupPipe[i] != -1) {
+            close(wakeupPipe[i]);
+            wakeupPipe[i] = -1;
+        }
+    }
+#endif
+}
+
 void ThreadSocketHandler() {
     unsigned int nPrevNodeCount = 0;
     while (true) {
@@ -1314,83 +1634,13 @@ void ThreadSocketHandler() {
         //
         // Find which sockets have data to receive
         //
-        struct timeval timeout;
-        timeout.tv_sec = 0;
-        timeout.tv_usec = 50000; // frequency to poll pnode->vSend
-
-        fd_set fdsetRecv;
-        fd_set fdsetSend;
-        fd_set fdsetError;
-        FD_ZERO(&fdsetRecv);
-        FD_ZERO(&fdsetSend);
-        FD_ZERO(&fdsetError);
-        SOCKET hSocketMax = 0;
-        bool have_fds = false;
-
-        BOOST_FOREACH(
-        const ListenSocket &hListenSocket, vhListenSocket) {
-            FD_SET(hListenSocket.socket, &fdsetRecv);
-            hSocketMax = std::max(hSocketMax, hListenSocket.socket);
-            have_fds = true;
-        }
-
-        {
-            LOCK(cs_vNodes);
-            BOOST_FOREACH(CNode * pnode, vNodes)
-            {
-                if (pnode->hSocket == INVALID_SOCKET)
-                    continue;
-                FD_SET(pnode->hSocket, &fdsetError);
-                hSocketMax = std::max(hSocketMax, pnode->hSocket);
-                have_fds = true;
-
-                // Implement the following logic:
-                // * If there is data to send, select() for sending data. As this only
-                //   happens when optimistic write failed, we choose to first drain the
-                //   write buffer in this case before receiving more. This avoids
-                //   needlessly queueing received data, if the remote peer is not themselves
-                //   receiving data. This means properly utilizing TCP flow control signalling.
-                // * Otherwise, if there is no (complete) message in the receive buffer,
-                //   or there is space left in the buffer, select() for receiving data.
-                // * (if neither of the above applies, there is certainly one message
-                //   in the receiver buffer ready to be processed).
-                // Together, that means that at least one of the following is always possible,
-                // so we don't deadlock:
-                // * We send some data.
-                // * We wait for data to be received (and disconnect after timeout).
-                // * We process a message in the buffer (message handler thread).
-                {
-                    TRY_LOCK(pnode->cs_vSend, lockSend);
-                    if (lockSend && !pnode->vSendMsg.empty()) {
-                        FD_SET(pnode->hSocket, &fdsetSend);
-                        continue;
-                    }
-                }
-                {
-                    TRY_LOCK(pnode->cs_vRecvMsg, lockRecv);
-                    if (lockRecv && (
-                            pnode->vRecvMsg.empty() || !pnode->vRecvMsg.front().complete() ||
-                            pnode->GetTotalRecvSize() <= ReceiveFloodSize()))
-                        FD_SET(pnode->hSocket, &fdsetRecv);
-                }
-            }
-        }
-
-        int nSelect = select(have_fds ? hSocketMax + 1 : 0,
-                             &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
-        boost::this_thread::interruption_point();
-
-        if (nSelect == SOCKET_ERROR) {
-            if (have_fds) {
-                int nErr = WSAGetLastError();
-                LogPrintf("socket select error %s\n", NetworkErrorString(nErr));
-                for (unsigned int i = 0; i <= hSocketMax; i++)
-                    FD_SET(i, &fdsetRecv);
-            }
-            FD_ZERO(&fdsetSend);
-            FD_ZERO(&fdsetError);
-            MilliSleep(timeout.tv_usec / 1000);
-        }
+        std::set<SOCKET> recv_set, send_set, error_set;
+#ifdef HAVE_SYS_EPOLL_H
+        if (fSocketEventsEpoll)
+            SocketEventsEpoll(recv_set, send_set, error_set);
+        else
+#endif
+            SocketEventsSelect(recv_set, send_set, error_set);
 
         //
         // Accept new connections
@@ -1398,7 +1648,7 @@ void ThreadSocketHandler() {
         BOOST_FOREACH(
         const ListenSocket &hListenSocket, vhListenSocket)
         {
-            if (hListenSocket.socket != INVALID_SOCKET && FD_ISSET(hListenSocket.socket, &fdsetRecv)) {
+            if (hListenSocket.socket != INVALID_SOCKET && recv_set.count(hListenSocket.socket)) {
                 AcceptConnection(hListenSocket);
             }
         }
@@ -1422,7 +1672,7 @@ void ThreadSocketHandler() {
             //
             if (pnode->hSocket == INVALID_SOCKET)
                 continue;
-            if (FD_ISSET(pnode->hSocket, &fdsetRecv) || FD_ISSET(pnode->hSocket, &fdsetError)) {
+            if (recv_set.count(pnode->hSocket) || error_set.count(pnode->hSocket)) {
                 TRY_LOCK(pnode->cs_vRecvMsg, lockRecv);
                 if (lockRecv) {
                     {
@@ -1459,7 +1709,7 @@ void ThreadSocketHandler() {
             //
             if (pnode->hSocket == INVALID_SOCKET)
                 continue;
-            if (FD_ISSET(pnode->hSocket, &fdsetSend)) {
+            if (send_set.count(pnode->hSocket)) {
                 TRY_LOCK(pnode->cs_vSend, lockSend);
                 if (lockSend)
                     SocketSendData(pnode);
@@ -2330,6 +2580,9 @@ void StartNode(boost::thread_group &threadGroup, CScheduler &scheduler) {
 
     Discover(threadGroup);
 
+    InitSocketEvents();
+    LogPrintf("Using %s to wait for socket events\n", fSocketEventsEpoll ? "epoll" : "select");
+
     //
     // Start threads
     //
@@ -2407,6 +2660,7 @@ public:
         semOutbound = NULL;
         delete pnodeLocalHost;
         pnodeLocalHost = NULL;
+        ShutdownSocketEvents();
 
 #ifdef WIN32
         // Shutdown Windows Sockets
@@ -2818,6 +3072,8 @@ CNode::CNode(SOCKET hSocketIn, const CAddress &addrIn, const std::string &addrNa
     nRefCount = 0;
     nSendSize = 0;
     nSendOffset = 0;
+    hSocketEvents = INVALID_SOCKET;
+    nSocketEvents = 0;
     hashContinue = uint256();
     nStartingHeight = -1;
     filterInventoryKnown.reset();
@@ -2866,6 +3122,7 @@ CNode::CNode(SOCKET hSocketIn, const CAddress &addrIn, const std::string &addrNa
 }
 
 CNode::~CNode() {
+    UnregisterSocketEvents(hSocket);
     CloseSocket(hSocket);
 
     if (pfilter)
@@ -2960,10 +3217,18 @@ void CNode::EndMessage(const char *pszCommand) UNLOCK_FUNCTION(cs_vSend) {
     nSendSize += (*it).size();
 
     // If write queue empty, attempt "optimistic write"
-    if (it == vSendMsg.begin())
+    bool fWake = false;
+    if (it == vSendMsg.begin()) {
         SocketSendData(this);
+        // whatever the socket did not take is left to the socket handler, which
+        // would otherwise not notice the queued data before its wait times out
+        fWake = !vSendMsg.empty();
+    }
 
     LEAVE_CRITICAL_SECTION(cs_vSend);
+
+    if (fWake)
+        WakeSocketHandler();
 }
 
 //
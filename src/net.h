@@ -76,6 +76,12 @@ static const bool DEFAULT_BLOCKSONLY = false;
 static const bool DEFAULT_FORCEDNSSEED = false;
 static const size_t DEFAULT_MAXRECEIVEBUFFER = 5 * 1000;
 static const size_t DEFAULT_MAXSENDBUFFER    = 1 * 1000;
+/** -socketevents default, epoll is not limited to sockets below FD_SETSIZE */
+#ifdef HAVE_SYS_EPOLL_H
+static const char * const DEFAULT_SOCKET_EVENTS = "epoll";
+#else
+static const char * const DEFAULT_SOCKET_EVENTS = "select";
+#endif
 
 static const ServiceFlags REQUIRED_SERVICES = NODE_NETWORK;
 
@@ -103,6 +109,10 @@ bool BindListenPort(const CService &bindAddr, std::string& strError, bool fWhite
 void StartNode(boost::thread_group& threadGroup, CScheduler& scheduler);
 bool StopNode();
 void SocketSendData(CNode *pnode);
+/** Interrupts the socket handler's wait for socket events, e.g. when data got queued for sending */
+void WakeSocketHandler();
+/** Whether the socket handler can wait for events on the socket */
+bool IsUsableSocket(const SOCKET& hSocket);
 
 struct CombinerAll
 {
@@ -236,12 +246,15 @@ public:
 
     int64_t nTime;                  // time (in microseconds) of message receipt.
 
+    bool fPrecheckSeen;             // already offered to the message precheck pool
+
     CNetMessage(const CMessageHeader::MessageStartChars& pchMessageStartIn, int nTypeIn, int nVersionIn) : hdrbuf(nTypeIn, nVersionIn), hdr(pchMessageStartIn), vRecv(nTypeIn, nVersionIn) {
         hdrbuf.resize(24);
         in_data = false;
         nHdrPos = 0;
         nDataPos = 0;
         nTime = 0;
+        fPrecheckSeen = false;
     }
 
     bool complete() const
@@ -334,6 +347,8 @@ public:
     CDataStream ssSend;
     size_t nSendSize; // total size of all vSendMsg entries
     size_t nSendOffset; // offset inside the first vSendMsg already sent
+    SOCKET hSocketEvents; // socket registered for epoll events, only used by the socket handler
+    uint32_t nSocketEvents; // epoll events registered for hSocketEvents
     uint64_t nSendBytes;
     std::deque<CSerializeData> vSendMsg;
     CCriticalSection cs_vSend;
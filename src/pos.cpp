@@ -14,6 +14,7 @@
 #include "clientversion.h"
 #include "coins.h"
 #include "consensus/consensus.h"
+#include "crypto/sha256.h"
 #include "hash.h"
 #include "main.h"
 #include "uint256.h"
@@ -21,6 +22,10 @@
 #include <stdio.h>
 #include "util.h"
 #include "shroudnode-sync.h"
+#include "streams.h"
+
+/** Timestamps hashed together by SearchStakeKernelHash */
+static const unsigned int STAKE_KERNEL_BATCH = 64;
 
 // Stake Modifier (hash modifier of proof-of-stake):
 // The purpose of stake modifier is to prevent a txout (coin) owner from
@@ -67,10 +72,14 @@ bool CheckStakeBlockTimestamp(int64_t nTimeBlock)
 //   block/tx hash should not be used here as they can be generated in vast
 //   quantities so as to generate blocks faster, degrading the system back into
 //   a proof-of-work situation.
+//   nValueIn: value of txPrev.vout[n], the weight of the kernel
+//
+// The nFirstPOSBlock exemption below has always been evaluated at the height
+// of pindexPrev, not at the height of txPrev.
 //
-bool CheckStakeKernelHash(const CBlockIndex* pindexPrev, unsigned int nBits, unsigned int nBlockTime, const CCoins* txPrev, const COutPoint& prevout, unsigned int nTimeTx, bool fPrintProofOfStake)
+bool CheckStakeKernelHash(const CBlockIndex* pindexPrev, unsigned int nBits, unsigned int nBlockTime, CAmount nValueIn, const COutPoint& prevout, unsigned int nTimeTx, bool fPrintProofOfStake)
 {
-      if ((nTimeTx < nBlockTime) && !(txPrev->nHeight <= Params().GetConsensus().nFirstPOSBlock))  // Transaction timestamp violation
+      if ((nTimeTx < nBlockTime) && !(pindexPrev->nHeight <= Params().GetConsensus().nFirstPOSBlock))  // Transaction timestamp violation
         return false;
         // return error("CheckStakeKernelHash() : nTime violation");
 
@@ -79,7 +88,6 @@ bool CheckStakeKernelHash(const CBlockIndex* pindexPrev, unsigned int nBits, uns
     bnTarget.SetCompact(nBits);
 
     // Weighted target
-    int64_t nValueIn = txPrev->vout[prevout.n].nValue;
     if (nValueIn == 0)
         return error("CheckStakeKernelHash() : nValueIn = 0");
     arith_uint256 bnWeight = arith_uint256(nValueIn);
@@ -117,6 +125,59 @@ bool CheckStakeKernelHash(const CBlockIndex* pindexPrev, unsigned int nBits, uns
     return true;
 }
 
+// Kernel search over the timestamps nTimeTx, nTimeTx - 1, ... nTimeTx - nCount + 1,
+// with the same result as CheckStakeKernelHash for each of them in turn. Everything
+// in the kernel but the timestamp is hashed once, the timestamps are then hashed in
+// batches, see CSHA256DSweep. On success nTimeTx is the first timestamp that meets
+// the target.
+bool SearchStakeKernelHash(const CBlockIndex* pindexPrev, unsigned int nBits, unsigned int nBlockTime, CAmount nValueIn, const COutPoint& prevout, uint32_t& nTimeTx, unsigned int nCount)
+{
+    if (nValueIn == 0)
+        return error("SearchStakeKernelHash() : nValueIn = 0");
+
+    arith_uint256 bnTarget;
+    bnTarget.SetCompact(nBits);
+    bnTarget *= arith_uint256(nValueIn);
+
+    // timestamps go down, once one is before nBlockTime all the rest are
+    const bool fCheckTime = !(pindexPrev->nHeight <= Params().GetConsensus().nFirstPOSBlock);
+
+    CDataStream ss(SER_GETHASH, 0);
+    ss << pindexPrev->nStakeModifier;
+    ss << nBlockTime << prevout.hash << prevout.n;
+    const CSHA256DSweep sweep((const unsigned char*)&ss[0], ss.size());
+
+    uint32_t vTime[STAKE_KERNEL_BATCH];
+    unsigned char vHash[STAKE_KERNEL_BATCH * CSHA256DSweep::OUTPUT_SIZE];
+    unsigned int n = 0;
+    while (n < nCount) {
+        size_t nBatch = 0;
+        for (; n < nCount && nBatch < STAKE_KERNEL_BATCH; n++) {
+            if (fCheckTime && nTimeTx - n < nBlockTime) {
+                n = nCount;
+                break;
+            }
+            vTime[nBatch++] = nTimeTx - n;
+        }
+        sweep.Finalize(vTime, nBatch, vHash);
+
+        for (size_t i = 0; i < nBatch; i++) {
+            uint256 hashProofOfStake;
+            memcpy(hashProofOfStake.begin(), vHash + i * CSHA256DSweep::OUTPUT_SIZE, CSHA256DSweep::OUTPUT_SIZE);
+            if (UintToArith256(hashProofOfStake) <= bnTarget) {
+                nTimeTx = vTime[i];
+                if (fDebug)
+                    LogPrintf("SearchStakeKernelHash() : nStakeModifier=%s, txPrev.nTime=%u, txPrev.vout.hash=%s, txPrev.vout.n=%u, nTime=%u, hashProof=%s\n",
+                        pindexPrev->nStakeModifier.GetHex().c_str(),
+                        nBlockTime, prevout.hash.ToString(), prevout.n, nTimeTx,
+                        hashProofOfStake.ToString());
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
 // Check kernel hash target and coinstake signature
 bool CheckProofOfStake(CBlockIndex* pindexPrev, const CTransaction& tx, unsigned int nBlockTime, unsigned int nBits, CValidationState &state,CBlockIndex* mapBlockIndexFallback)
 {
@@ -150,7 +211,7 @@ bool CheckProofOfStake(CBlockIndex* pindexPrev, const CTransaction& tx, unsigned
 
     unsigned int nTime = pindexPrev->GetBlockTime();
 
-    if (!CheckStakeKernelHash(pindexPrev, nBits, nTime, new CCoins(txPrev, pindexPrev->nHeight), txin.prevout, nBlockTime, fDebug))
+    if (!CheckStakeKernelHash(pindexPrev, nBits, nTime, txPrev.vout[txin.prevout.n].nValue, txin.prevout, nBlockTime, fDebug))
        return state.Invalid(false, REJECT_INVALID,"CheckProofOfStake() : INFO: check kernel failed on coinstake %s", tx.GetHash().ToString()); // may occur during initial download or if behind on block chain sync
     return true;
 }
@@ -177,43 +238,73 @@ bool CheckKernel(CBlockIndex* pindexPrev, unsigned int nBits, uint32_t nTimeBloc
     return CheckKernel(pindexPrev, nBits, nTimeBlock, prevout, tmp,&pBlockTime);
 }
 
-bool CheckKernel(CBlockIndex* pindexPrev, unsigned int nBits, uint32_t nTime, const COutPoint& prevout, const std::map<COutPoint, CStakeCache>& cache, int64_t *pBlockTime)
+// Value of the staked output, if it is mature at the height after pindexPrev
+static bool GetKernelValue(CBlockIndex* pindexPrev, const COutPoint& prevout, const std::map<COutPoint, CStakeCache>& cache, CAmount& nValueIn)
 {
-    uint256 hashProofOfStake, targetProofOfStake;
     auto it=cache.find(prevout);
+    if(it != cache.end()) {
+        //found in cache, usable as long as its block was not reorganized away
+        const CStakeCache& stake = it->second;
+        if (stake.nHeight <= pindexPrev->nHeight && pindexPrev->GetAncestor(stake.nHeight)->GetBlockHash() == stake.hashBlock) {
+            if (pindexPrev->nHeight + 1 - stake.nHeight < COINBASE_MATURITY)
+                return false;
+            nValueIn = stake.nValue;
+            return true;
+        }
+    }
+
+    CTransaction txPrev;
+    uint256 hashBlock = uint256();
+    if (!GetTransaction(prevout.hash, txPrev, Params().GetConsensus(), hashBlock, true)){
+        LogPrintf("CheckKernel() : could not find previous transaction %s\n", prevout.hash.ToString());
+        return false;
+    }
 
+    if (mapBlockIndex.count(hashBlock) == 0) {
+        LogPrintf("CheckKernel() : could not find block of previous transaction %s\n", hashBlock.ToString());
+        return false;
+    }
+
+    if (pindexPrev->nHeight + 1 - mapBlockIndex[hashBlock]->nHeight < COINBASE_MATURITY){
+        LogPrintf("CheckKernel() : stake prevout is not mature in block %s\n", hashBlock.ToString());
+        return false;
+    }
+
+    if (prevout.n >= txPrev.vout.size())
+        return false;
+
+    nValueIn = txPrev.vout[prevout.n].nValue;
+    return true;
+}
+
+bool CheckKernel(CBlockIndex* pindexPrev, unsigned int nBits, uint32_t nTime, const COutPoint& prevout, const std::map<COutPoint, CStakeCache>& cache, int64_t *pBlockTime)
+{
     *pBlockTime = pindexPrev->GetBlockTime();
     if(nTime < *pBlockTime) return false;
 
-    if(it == cache.end()) {
-        CTransaction txPrev;
-        uint256 hashBlock = uint256();
-        if (!GetTransaction(prevout.hash, txPrev, Params().GetConsensus(), hashBlock, true)){
-            LogPrintf("CheckKernel() : could not find previous transaction %s\n", prevout.hash.ToString());
-            return false;
-        }
-
-        if (mapBlockIndex.count(hashBlock) == 0) {
-            LogPrintf("CheckKernel() : could not find block of previous transaction %s\n", hashBlock.ToString());
-            return false;
-        }
+    CAmount nValueIn;
+    if (!GetKernelValue(pindexPrev, prevout, cache, nValueIn))
+        return false;
+    return CheckStakeKernelHash(pindexPrev, nBits, *pBlockTime, nValueIn, prevout, nTime);
+}
 
-        if (pindexPrev->nHeight + 1 - mapBlockIndex[hashBlock]->nHeight < COINBASE_MATURITY){
-            LogPrintf("CheckKernel() : stake prevout is not mature in block %s\n", hashBlock.ToString());
-            return false;
-        }
+// CheckKernel for the timestamps nTime, nTime - 1, ... nTime - nCount + 1, the first
+// one that has a kernel goes to pTimeKernel
+bool FindKernel(CBlockIndex* pindexPrev, unsigned int nBits, uint32_t nTime, unsigned int nCount, const COutPoint& prevout, const std::map<COutPoint, CStakeCache>& cache, int64_t *pBlockTime, uint32_t *pTimeKernel)
+{
+    *pBlockTime = pindexPrev->GetBlockTime();
+    if(nTime < *pBlockTime) return false;
+    nCount = std::min<int64_t>(nCount, nTime - *pBlockTime + 1);
 
-        return CheckStakeKernelHash(pindexPrev, nBits, *pBlockTime, new CCoins(txPrev, pindexPrev->nHeight), prevout, nTime);
-    } else {
-        //found in cache
-        const CStakeCache& stake = it->second;
-        if (CheckStakeKernelHash(pindexPrev, nBits,nTime, new CCoins(stake.txPrev, pindexPrev->nHeight), prevout, *pBlockTime)) {
-            // Cache could potentially cause false positive stakes in the event of deep reorgs, so check without cache also
-            return CheckKernel(pindexPrev, nBits, nTime, prevout);
-        }
-        // LogPrintf("CheckKernel()::CheckStakeKernelHash(): pBlockTime=%u, nTime=%u\n", *pBlockTime, nTime);
-        return CheckStakeKernelHash(pindexPrev, nBits, *pBlockTime, new CCoins(stake.txPrev, pindexPrev->nHeight), prevout, nTime);
-    }
+    CAmount nValueIn;
+    if (!GetKernelValue(pindexPrev, prevout, cache, nValueIn))
+        return false;
+    uint32_t nTimeKernel = nTime;
+    if (!SearchStakeKernelHash(pindexPrev, nBits, *pBlockTime, nValueIn, prevout, nTimeKernel, nCount))
+        return false;
+    if (pTimeKernel)
+        *pTimeKernel = nTimeKernel;
+    return true;
 }
 
 void CacheKernel(std::map<COutPoint, CStakeCache>& cache, const COutPoint& prevout, CBlockIndex* pindexPrev){
@@ -238,6 +329,9 @@ void CacheKernel(std::map<COutPoint, CStakeCache>& cache, const COutPoint& prevo
         return;
     }
 
-    CStakeCache c(hashBlock, txPrev);
+    if (prevout.n >= txPrev.vout.size())
+        return;
+
+    CStakeCache c(hashBlock, mapBlockIndex[hashBlock]->nHeight, txPrev.vout[prevout.n].nValue);
     cache.insert({prevout, c});
-}
\ No newline at end of file
+}
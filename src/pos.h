@@ -26,11 +26,17 @@ using namespace std;
 /** Compute the hash modifier for proof-of-stake */
 uint256 ComputeStakeModifier(const CBlockIndex* pindexPrev, const uint256& kernel);
 
+/**
+ * What the kernel of a staking output needs from its previous transaction, so a stake search
+ * doesn't have to read it from disk for every timestamp tried. An entry is only used while its
+ * block is an ancestor of the block being staked on.
+ */
 struct CStakeCache{
-    CStakeCache(uint256 hashBlock_, const CTransaction txPrev_) : hashBlock(hashBlock_), txPrev(txPrev_){
+    CStakeCache(uint256 hashBlock_, int nHeight_, CAmount nValue_) : hashBlock(hashBlock_), nHeight(nHeight_), nValue(nValue_){
     }
-    uint256 hashBlock;
-    const CTransaction txPrev;
+    uint256 hashBlock; // block of the previous transaction
+    int nHeight;       // height of that block, for the maturity check
+    CAmount nValue;    // value of the staked output, the kernel weight
 };
 
 // Check whether the coinstake timestamp meets protocol
@@ -38,7 +44,9 @@ bool CheckCoinStakeTimestamp(int64_t nTimeBlock, int64_t nTimeTx);
 bool CheckStakeBlockTimestamp(int64_t nTimeBlock);
 bool CheckKernel(CBlockIndex* pindexPrev, unsigned int nBits, uint32_t nTimeBlock, const COutPoint& prevout);
 bool CheckKernel(CBlockIndex* pindexPrev, unsigned int nBits, uint32_t nTime, const COutPoint& prevout, const std::map<COutPoint, CStakeCache>& cache, int64_t *pBlockTime);
-bool CheckStakeKernelHash(const CBlockIndex* pindexPrev, unsigned int nBits, unsigned int nBlockTime, const CCoins* txPrev, const COutPoint& prevout, unsigned int nTimeTx, bool fPrintProofOfStake = false);
+bool CheckStakeKernelHash(const CBlockIndex* pindexPrev, unsigned int nBits, unsigned int nBlockTime, CAmount nValueIn, const COutPoint& prevout, unsigned int nTimeTx, bool fPrintProofOfStake = false);
+bool SearchStakeKernelHash(const CBlockIndex* pindexPrev, unsigned int nBits, unsigned int nBlockTime, CAmount nValueIn, const COutPoint& prevout, uint32_t& nTimeTx, unsigned int nCount);
+bool FindKernel(CBlockIndex* pindexPrev, unsigned int nBits, uint32_t nTime, unsigned int nCount, const COutPoint& prevout, const std::map<COutPoint, CStakeCache>& cache, int64_t *pBlockTime, uint32_t *pTimeKernel = NULL);
 bool CheckProofOfStake(CBlockIndex* pindexPrev, const CTransaction& tx, unsigned int nBlockTime, unsigned int nBits, CValidationState &state,CBlockIndex* mapBlockIndexFallback);
 void CacheKernel(std::map<COutPoint, CStakeCache>& cache, const COutPoint& prevout, CBlockIndex* pindexPrev);
 bool VerifySignature(const CTransaction& txFrom, const CTransaction& txTo, unsigned int nIn, unsigned int flags, int nHashType);
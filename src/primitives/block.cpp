@@ -18,20 +18,122 @@
 #include <chrono>
 #include <fstream>
 #include <algorithm>
+#include <array>
+#include <cstddef>
+#include <limits>
 #include <string>
+#include <unordered_map>
 #include "crypto/x16Rv2/hash_algos.h"
+#include "crypto/x16Rv2/hash_batch.h"
+
+namespace {
+
+/**
+ * X16Rv2 hashes of recently seen headers. A header is hashed many times on its way through
+ * header sync, reindex and block validation, and X16Rv2 is expensive. Header fields are public
+ * and get changed in place, so entries are keyed by the hashed bytes themselves rather than
+ * remembered in the header object: a modified header can never be served a stale hash.
+ */
+class CHeaderHashCache
+{
+public:
+    static const size_t HEADER_SIZE = X16RV2_HEADER_SIZE;
+    /** Each generation holds up to half of the entries */
+    static const size_t MAX_ENTRIES = 8192;
+
+    typedef std::array<unsigned char, HEADER_SIZE> Key;
+
+    CHeaderHashCache() : hasher(GetRand(std::numeric_limits<uint64_t>::max()), GetRand(std::numeric_limits<uint64_t>::max())) {}
+
+    bool Get(const Key& key, uint256& hash)
+    {
+        LOCK(cs);
+        auto it = current.find(key);
+        if (it != current.end()) {
+            hash = it->second;
+            return true;
+        }
+        it = previous.find(key);
+        if (it == previous.end())
+            return false;
+        hash = it->second;
+        Insert(key, hash);
+        return true;
+    }
+
+    void Put(const Key& key, const uint256& hash)
+    {
+        LOCK(cs);
+        Insert(key, hash);
+    }
+
+private:
+    // Salted so that headers with colliding buckets can't be crafted without knowing the key
+    struct KeyHasher
+    {
+        CSipHasher sip;
+        KeyHasher(const CSipHasher& sip) : sip(sip) {}
+        size_t operator()(const Key& key) const
+        {
+            return CSipHasher(sip).Write(key.data(), key.size()).Finalize();
+        }
+    };
+
+    typedef std::unordered_map<Key, uint256, KeyHasher> Map;
+
+    void Insert(const Key& key, const uint256& hash)
+    {
+        if (current.size() >= MAX_ENTRIES / 2) {
+            previous.swap(current);
+            current.clear();
+        }
+        current.emplace(key, hash);
+    }
+
+    CCriticalSection cs;
+    CSipHasher hasher;
+    Map current{0, KeyHasher(hasher)};
+    Map previous{0, KeyHasher(hasher)};
+};
+
+static_assert(offsetof(CBlockHeader, nNonce) + sizeof(uint32_t) - offsetof(CBlockHeader, nVersion) == CHeaderHashCache::HEADER_SIZE,
+    "X16Rv2 input is expected to be the 80 contiguous header bytes");
+
+CHeaderHashCache& GetHeaderHashCache()
+{
+    static CHeaderHashCache cache;
+    return cache;
+}
+
+} // namespace
 
 uint256 CBlockHeader::GetHash() const {
+    CHeaderHashCache::Key key;
+    std::copy(BEGIN(nVersion), END(nNonce), key.begin());
 
-    return HashX16RV2(BEGIN(nVersion), END(nNonce), hashPrevBlock);
+    uint256 hash;
+    if (GetHeaderHashCache().Get(key, hash))
+        return hash;
 
+    hash = HashX16RV2(BEGIN(nVersion), END(nNonce), hashPrevBlock);
+    GetHeaderHashCache().Put(key, hash);
+    return hash;
 }
 
 uint256 CBlockHeader::GetPoWHash() const {
         //Changed hash algo to X16Rv2
+        //Not cached: nonce search loops hash every header exactly once
     return HashX16RV2(BEGIN(nVersion), END(nNonce), hashPrevBlock);
 }
 
+void GetPoWHashes(const CBlockHeader* const headers[], size_t count, uint256 hashes[])
+{
+    std::vector<const unsigned char*> inputs(count);
+    for (size_t i = 0; i < count; i++)
+        inputs[i] = reinterpret_cast<const unsigned char*>(&headers[i]->nVersion);
+    HashX16RV2Batch(inputs.data(), count, hashes);
+}
+
 std::string CBlock::ToString() const {
     std::stringstream s;
     s << strprintf(
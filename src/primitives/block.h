@@ -254,4 +254,7 @@ struct CBlockLocator
 /** Compute the consensus-critical block weight (see BIP 141). */
 int64_t GetBlockWeight(const CBlock& tx);
 
+/** Proof of work hashes of many headers at once, hashes[i] is headers[i]->GetPoWHash() (see HashX16RV2Batch). */
+void GetPoWHashes(const CBlockHeader* const headers[], size_t count, uint256 hashes[]);
+
 #endif // BITCOIN_PRIMITIVES_BLOCK_H
@@ -275,10 +275,10 @@ void ShroudnodeList::updateNodeList()
     ui->tableWidgetShroudnodes->clearContents();
     ui->tableWidgetShroudnodes->setRowCount(0);
 //    std::map<COutPoint, CShroudnode> mapShroudnodes = mnodeman.GetFullShroudnodeMap();
-    std::vector<CShroudnode> vShroudnodes = mnodeman.GetFullShroudnodeVector();
+    CShroudnodeMan::shroudnode_snapshot_t vShroudnodes = mnodeman.GetShroudnodeSnapshot();
     int offsetFromUtc = GetOffsetFromUtc();
 
-    BOOST_FOREACH(CShroudnode & mn, vShroudnodes)
+    BOOST_FOREACH(const CShroudnode & mn, *vShroudnodes)
     {
 //        CShroudnode mn = mnpair.second;
         // populate list
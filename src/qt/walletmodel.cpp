@@ -1034,8 +1034,8 @@ void WalletModel::sigmaMint(const CAmount& n, const CCoinControl *coinControl)
 
 std::vector<CSigmaEntry> WalletModel::GetUnsafeCoins(const CCoinControl* coinControl)
 {
-    auto allCoins = wallet->GetAvailableCoins(coinControl, true);
-    auto spendableCoins = wallet->GetAvailableCoins(coinControl);
+    auto allCoins = wallet->ListAvailableCoins(coinControl, true);
+    auto spendableCoins = wallet->ListAvailableCoins(coinControl);
     std::vector<CSigmaEntry> unsafeCoins;
     for (auto& coin : allCoins) {
         if (spendableCoins.end() == std::find_if(spendableCoins.begin(), spendableCoins.end(),
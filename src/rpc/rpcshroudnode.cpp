@@ -488,8 +488,8 @@ UniValue shroudnodelist(const UniValue &params, bool fHelp) {
             obj.push_back(Pair(strOutpoint, s.first));
         }
     } else {
-        std::vector <CShroudnode> vShroudnodes = mnodeman.GetFullShroudnodeVector();
-        BOOST_FOREACH(CShroudnode & mn, vShroudnodes)
+        CShroudnodeMan::shroudnode_snapshot_t vShroudnodes = mnodeman.GetShroudnodeSnapshot();
+        BOOST_FOREACH(const CShroudnode & mn, *vShroudnodes)
         {
             std::string strOutpoint = mn.vin.prevout.ToStringShort();
             if (strMode == "activeseconds") {
@@ -554,7 +554,8 @@ UniValue shroudnodelist(const UniValue &params, bool fHelp) {
                     nBlockHeight = pindex->nHeight;
                 }
                 int nMnCount = mnodeman.CountEnabled();
-                char* reasonStr = mnodeman.GetNotQualifyReason(mn, nBlockHeight, true, nMnCount);
+                CShroudnode mnQualify(mn);
+                char* reasonStr = mnodeman.GetNotQualifyReason(mnQualify, nBlockHeight, true, nMnCount);
                 std::string strOutpoint = mn.vin.prevout.ToStringShort();
                 if (strFilter != "" && strOutpoint.find(strFilter) == std::string::npos) continue;
                 obj.push_back(Pair(strOutpoint, (reasonStr != NULL) ? reasonStr : "true"));
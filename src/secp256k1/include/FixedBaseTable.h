@@ -0,0 +1,52 @@
+#ifndef SECP_FIXED_BASE_TABLE_H
+#define SECP_FIXED_BASE_TABLE_H
+
+#include <cstddef>
+#include <vector>
+#include "../include/GroupElement.h"
+#include "../include/Scalar.h"
+
+namespace secp_primitives {
+
+// Precomputed multiples d * 2^(window * i) * base for every window i of a scalar and every digit d,
+// so multiplication of a fixed base by a scalar takes at most one point addition per window and no
+// doublings. Meant for long lived generators: a table takes 60KB with 4 bit windows (64 additions
+// per multiplication) and 510KB with 8 bit windows (32 additions).
+class FixedBaseTable {
+public:
+    static constexpr unsigned int default_window = 4;
+    static constexpr unsigned int max_window = 8;
+
+public:
+    explicit FixedBaseTable(const GroupElement& base, unsigned int window = default_window);
+    FixedBaseTable(const FixedBaseTable& other);
+    ~FixedBaseTable();
+
+    FixedBaseTable& operator=(const FixedBaseTable& other);
+
+    const GroupElement& get_base() const;
+
+    // base * multiplier
+    GroupElement multiply(const Scalar& multiplier) const;
+
+    // Sum of tables[i].get_base() * powers[i]
+    static GroupElement multi_multiply(
+            const std::vector<FixedBaseTable>& tables,
+            const std::vector<Scalar>& powers);
+
+private:
+    // Adds base * multiplier to the accumulator
+    void add_multiple(void *acc, const Scalar& multiplier) const;
+
+    std::size_t digits() const;
+    std::size_t rows() const;
+
+private:
+    GroupElement base_;
+    unsigned int window_;
+    void *table_; // secp256k1_ge_storage[]
+};
+
+}// namespace secp_primitives
+
+#endif //SECP_FIXED_BASE_TABLE_H
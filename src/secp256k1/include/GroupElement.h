@@ -106,6 +106,7 @@ public:
   GroupElement& set_base_g();
 
   friend class MultiExponent;
+  friend class FixedBaseTable;
 private:
     // Returns the secp object inside it.
     const void * get_value() const;
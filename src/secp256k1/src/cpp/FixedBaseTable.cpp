@@ -0,0 +1,137 @@
+#include "../include/FixedBaseTable.h"
+
+#include "../include/secp256k1.h"
+#include "../field.h"
+#include "../field_impl.h"
+#include "../group.h"
+#include "../group_impl.h"
+#include "../scalar.h"
+#include "../scalar_impl.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace secp_primitives {
+
+FixedBaseTable::FixedBaseTable(const GroupElement& base, unsigned int window)
+        : base_(base)
+        , window_(window)
+        , table_(nullptr)
+{
+    // windows must not cross the 64 bit limbs of the scalar
+    if (window_ == 0 || window_ > max_window || 64 % window_ != 0)
+        throw std::invalid_argument("Unsupported window size.");
+
+    if (base_.isInfinity())
+        return;
+
+    const std::size_t digits = this->digits();
+    const std::size_t rows = this->rows();
+    const std::size_t table_size = rows * digits;
+
+    // entries of the row i are base_i, 2 * base_i, ..., digits * base_i and base_{i+1} = base_i * 2^window,
+    // so the whole table is built with additions only
+    std::vector<secp256k1_gej> points(table_size);
+    secp256k1_gej row_base = *reinterpret_cast<const secp256k1_gej *>(base_.get_value());
+    for (std::size_t i = 0; i < rows; ++i) {
+        secp256k1_gej *row = &points[i * digits];
+        row[0] = row_base;
+        for (std::size_t d = 1; d < digits; ++d)
+            secp256k1_gej_add_var(&row[d], &row[d - 1], &row_base, NULL);
+        secp256k1_gej_add_var(&row_base, &row[digits - 1], &row_base, NULL);
+    }
+
+    std::vector<secp256k1_ge> affine(table_size);
+    secp256k1_ge_set_all_gej_var(affine.data(), points.data(), table_size, NULL);
+
+    secp256k1_ge_storage *table = new secp256k1_ge_storage[table_size];
+    for (std::size_t i = 0; i < table_size; ++i)
+        secp256k1_ge_to_storage(&table[i], &affine[i]);
+    table_ = table;
+}
+
+FixedBaseTable::FixedBaseTable(const FixedBaseTable& other)
+        : base_(other.base_)
+        , window_(other.window_)
+        , table_(nullptr)
+{
+    *this = other;
+}
+
+FixedBaseTable::~FixedBaseTable() {
+    delete []reinterpret_cast<secp256k1_ge_storage *>(table_);
+}
+
+FixedBaseTable& FixedBaseTable::operator=(const FixedBaseTable& other) {
+    if (this == &other)
+        return *this;
+
+    delete []reinterpret_cast<secp256k1_ge_storage *>(table_);
+    table_ = nullptr;
+    base_ = other.base_;
+    window_ = other.window_;
+
+    if (other.table_ != nullptr) {
+        const std::size_t table_size = rows() * digits();
+        secp256k1_ge_storage *table = new secp256k1_ge_storage[table_size];
+        const secp256k1_ge_storage *other_table = reinterpret_cast<const secp256k1_ge_storage *>(other.table_);
+        std::copy(other_table, other_table + table_size, table);
+        table_ = table;
+    }
+    return *this;
+}
+
+const GroupElement& FixedBaseTable::get_base() const {
+    return base_;
+}
+
+std::size_t FixedBaseTable::digits() const {
+    return (std::size_t(1) << window_) - 1;
+}
+
+std::size_t FixedBaseTable::rows() const {
+    return 256 / window_;
+}
+
+void FixedBaseTable::add_multiple(void *acc, const Scalar& multiplier) const {
+    if (table_ == nullptr)
+        return;
+
+    secp256k1_gej *r = reinterpret_cast<secp256k1_gej *>(acc);
+    const secp256k1_scalar *s = reinterpret_cast<const secp256k1_scalar *>(multiplier.get_value());
+    const secp256k1_ge_storage *table = reinterpret_cast<const secp256k1_ge_storage *>(table_);
+
+    const std::size_t digits = this->digits();
+    const std::size_t rows = this->rows();
+
+    secp256k1_ge p;
+    for (std::size_t i = 0; i < rows; ++i) {
+        unsigned int d = secp256k1_scalar_get_bits(s, i * window_, window_);
+        if (d == 0)
+            continue;
+        secp256k1_ge_from_storage(&p, &table[i * digits + d - 1]);
+        secp256k1_gej_add_ge_var(r, r, &p, NULL);
+    }
+}
+
+GroupElement FixedBaseTable::multiply(const Scalar& multiplier) const {
+    secp256k1_gej r;
+    secp256k1_gej_set_infinity(&r);
+    add_multiple(&r, multiplier);
+    return &r;
+}
+
+GroupElement FixedBaseTable::multi_multiply(
+        const std::vector<FixedBaseTable>& tables,
+        const std::vector<Scalar>& powers) {
+    if (tables.size() < powers.size())
+        throw std::invalid_argument("Not enough tables for the powers given.");
+
+    secp256k1_gej r;
+    secp256k1_gej_set_infinity(&r);
+    for (std::size_t i = 0; i < powers.size(); ++i)
+        tables[i].add_multiple(&r, powers[i]);
+    return &r;
+}
+
+}// namespace secp_primitives
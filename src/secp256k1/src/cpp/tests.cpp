@@ -12,6 +12,7 @@
 #ifdef ENABLE_OPENSSL_TESTS
 #include "include/GroupElement.h"
 #include "include/Scalar.h"
+#include "include/FixedBaseTable.h"
 #endif
 
 int main(int argc, char* argv[])
@@ -99,6 +100,32 @@ int main(int argc, char* argv[])
     // test scalar infinite loop bugs on GCC 8
     secp_primitives::Scalar scalar;
     scalar.randomize();
+
+    // fixed-base multiplication must match the generic one
+    secp_primitives::GroupElement base;
+    base.randomize();
+    std::vector<secp_primitives::FixedBaseTable> tables;
+    tables.push_back(secp_primitives::FixedBaseTable(base));
+    tables.push_back(secp_primitives::FixedBaseTable(base, secp_primitives::FixedBaseTable::max_window));
+    std::vector<secp_primitives::Scalar> multipliers;
+    multipliers.push_back(secp_primitives::Scalar(uint64_t(0)));
+    multipliers.push_back(secp_primitives::Scalar(uint64_t(1)));
+    multipliers.push_back(secp_primitives::Scalar(uint64_t(1)).negate());
+    multipliers.push_back(scalar);
+
+    for (auto& table : tables) {
+        for (auto& multiplier : multipliers) {
+            if (table.multiply(multiplier) != base * multiplier) {
+                std::cout<< "fixed-base multiplication failed for " << multiplier.tostring() << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    if (secp_primitives::FixedBaseTable::multi_multiply(tables, {scalar, scalar}) != base * scalar + base * scalar) {
+        std::cout<< "fixed-base multi multiplication failed" << std::endl;
+        return EXIT_FAILURE;
+    }
 #endif
 
     return EXIT_SUCCESS;
@@ -381,11 +381,15 @@ void CShroudnodePayments::ProcessMessage(CNode *pfrom, std::string &strCommand,
     }
 }
 
+std::string CShroudnodePaymentVote::GetSignatureMessage() const {
+    return vinShroudnode.prevout.ToStringShort() +
+           boost::lexical_cast<std::string>(nBlockHeight) +
+           ScriptToAsmStr(payee);
+}
+
 bool CShroudnodePaymentVote::Sign() {
     std::string strError;
-    std::string strMessage = vinShroudnode.prevout.ToStringShort() +
-                             boost::lexical_cast<std::string>(nBlockHeight) +
-                             ScriptToAsmStr(payee);
+    std::string strMessage = GetSignatureMessage();
 
     if (!darkSendSigner.SignMessage(strMessage, vchSig, activeShroudnode.keyShroudnode)) {
         LogPrintf("CShroudnodePaymentVote::Sign -- SignMessage() failed\n");
@@ -751,9 +755,7 @@ bool CShroudnodePaymentVote::CheckSignature(const CPubKey &pubKeyShroudnode, int
     // do not ban by default
     nDos = 0;
 
-    std::string strMessage = vinShroudnode.prevout.ToStringShort() +
-                             boost::lexical_cast<std::string>(nBlockHeight) +
-                             ScriptToAsmStr(payee);
+    std::string strMessage = GetSignatureMessage();
 
     std::string strError = "";
     if (!darkSendSigner.VerifyMessage(pubKeyShroudnode, vchSig, strMessage, strError)) {
@@ -149,6 +149,7 @@ public:
         return ss.GetHash();
     }
 
+    std::string GetSignatureMessage() const;
     bool Sign();
     bool CheckSignature(const CPubKey& pubKeyShroudnode, int nValidationHeight, int &nDos);
 
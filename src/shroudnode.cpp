@@ -826,15 +826,19 @@ bool CShroudnodeBroadcast::CheckOutpoint(int &nDos) {
     return true;
 }
 
+std::string CShroudnodeBroadcast::GetSignatureMessage() const {
+    return addr.ToString() + boost::lexical_cast<std::string>(sigTime) +
+           pubKeyCollateralAddress.GetID().ToString() + pubKeyShroudnode.GetID().ToString() +
+           boost::lexical_cast<std::string>(nProtocolVersion);
+}
+
 bool CShroudnodeBroadcast::Sign(CKey &keyCollateralAddress) {
     std::string strError;
     std::string strMessage;
 
     sigTime = GetAdjustedTime();
 
-    strMessage = addr.ToString() + boost::lexical_cast<std::string>(sigTime) +
-                 pubKeyCollateralAddress.GetID().ToString() + pubKeyShroudnode.GetID().ToString() +
-                 boost::lexical_cast<std::string>(nProtocolVersion);
+    strMessage = GetSignatureMessage();
 
     if (!darkSendSigner.SignMessage(strMessage, vchSig, keyCollateralAddress)) {
         LogPrintf("CShroudnodeBroadcast::Sign -- SignMessage() failed\n");
@@ -854,9 +858,7 @@ bool CShroudnodeBroadcast::CheckSignature(int &nDos) {
     std::string strError = "";
     nDos = 0;
 
-    strMessage = addr.ToString() + boost::lexical_cast<std::string>(sigTime) +
-                 pubKeyCollateralAddress.GetID().ToString() + pubKeyShroudnode.GetID().ToString() +
-                 boost::lexical_cast<std::string>(nProtocolVersion);
+    strMessage = GetSignatureMessage();
 
     LogPrint("shroudnode", "CShroudnodeBroadcast::CheckSignature -- strMessage: %s  pubKeyCollateralAddress address: %s  sig: %s\n", strMessage, CBitcoinAddress(pubKeyCollateralAddress.GetID()).ToString(), EncodeBase64(&vchSig[0], vchSig.size()));
 
@@ -885,12 +887,16 @@ CShroudnodePing::CShroudnodePing(CTxIn &vinNew) {
     vchSig = std::vector < unsigned char > ();
 }
 
+std::string CShroudnodePing::GetSignatureMessage() const {
+    return vin.ToString() + blockHash.ToString() + boost::lexical_cast<std::string>(sigTime);
+}
+
 bool CShroudnodePing::Sign(CKey &keyShroudnode, CPubKey &pubKeyShroudnode) {
     std::string strError;
     std::string strShroudNodeSignMessage;
 
     sigTime = GetAdjustedTime();
-    std::string strMessage = vin.ToString() + blockHash.ToString() + boost::lexical_cast<std::string>(sigTime);
+    std::string strMessage = GetSignatureMessage();
 
     if (!darkSendSigner.SignMessage(strMessage, vchSig, keyShroudnode)) {
         LogPrintf("CShroudnodePing::Sign -- SignMessage() failed\n");
@@ -906,7 +912,7 @@ bool CShroudnodePing::Sign(CKey &keyShroudnode, CPubKey &pubKeyShroudnode) {
 }
 
 bool CShroudnodePing::CheckSignature(CPubKey &pubKeyShroudnode, int &nDos) {
-    std::string strMessage = vin.ToString() + blockHash.ToString() + boost::lexical_cast<std::string>(sigTime);
+    std::string strMessage = GetSignatureMessage();
     std::string strError = "";
     nDos = 0;
 
@@ -82,6 +82,7 @@ public:
 
     bool IsExpired() { return GetTime() - sigTime > SHROUDNODE_NEW_START_REQUIRED_SECONDS; }
 
+    std::string GetSignatureMessage() const;
     bool Sign(CKey& keyShroudnode, CPubKey& pubKeyShroudnode);
     bool CheckSignature(CPubKey& pubKeyShroudnode, int &nDos);
     bool SimpleCheck(int& nDos);
@@ -387,6 +388,7 @@ public:
     bool Update(CShroudnode* pmn, int& nDos);
     bool CheckOutpoint(int& nDos);
 
+    std::string GetSignatureMessage() const;
     bool Sign(CKey& keyCollateralAddress);
     bool CheckSignature(int& nDos);
     void RelayShroudNode();
@@ -19,7 +19,7 @@
 /** Shroudnode manager */
 CShroudnodeMan mnodeman;
 
-const std::string CShroudnodeMan::SERIALIZATION_VERSION_STRING = "CShroudnodeMan-Version-4";
+const std::string CShroudnodeMan::SERIALIZATION_VERSION_STRING = "CShroudnodeMan-Version-5";
 
 struct CompareLastPaidBlock
 {
@@ -30,12 +30,24 @@ struct CompareLastPaidBlock
     }
 };
 
-struct CompareScoreMN
+SaltedPubKeyHasher::SaltedPubKeyHasher() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
+
+SaltedServiceHasher::SaltedServiceHasher() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
+
+size_t SaltedServiceHasher::operator()(const CService& addr) const
 {
-    bool operator()(const std::pair<int64_t, CShroudnode*>& t1,
-                    const std::pair<int64_t, CShroudnode*>& t2) const
+    struct in6_addr ip;
+    addr.GetIn6Addr(&ip);
+    return CSipHasher(k0, k1).Write((const unsigned char*)&ip, sizeof(ip)).Write(addr.GetPort()).Finalize();
+}
+
+// Best score first, ties broken by vin, also descending
+struct CompareScoreDescending
+{
+    template<typename T>
+    bool operator()(const T& t1, const T& t2) const
     {
-        return (t1.first != t2.first) ? (t1.first < t2.first) : (t1.second->vin < t2.second->vin);
+        return (t1.nCompactScore != t2.nCompactScore) ? (t1.nCompactScore > t2.nCompactScore) : (t2.pmn->vin < t1.pmn->vin);
     }
 };
 
@@ -101,7 +113,9 @@ void CShroudnodeIndex::RebuildIndex()
 }
 
 CShroudnodeMan::CShroudnodeMan() : cs(),
-  vShroudnodes(),
+  mapShroudnodes(),
+  mapShroudnodesByPubKey(),
+  mapShroudnodesByAddr(),
   mAskedUsForShroudnodeList(),
   mWeAskedForShroudnodeList(),
   mWeAskedForShroudnodeListEntry(),
@@ -117,6 +131,7 @@ CShroudnodeMan::CShroudnodeMan() : cs(),
   fShroudnodesRemoved(false),
 //  vecDirtyGovernanceObjectHashes(),
   nLastWatchdogVoteTime(0),
+  nSnapshotTime(0),
   mapSeenShroudnodeBroadcast(),
   mapSeenShroudnodePing(),
   nDsqCount(0)
@@ -129,7 +144,7 @@ bool CShroudnodeMan::Add(CShroudnode &mn)
     CShroudnode *pmn = Find(mn.vin);
     if (pmn == NULL) {
         LogPrint("shroudnode", "CShroudnodeMan::Add -- Adding new Shroudnode: addr=%s, %i now\n", mn.addr.ToString(), size() + 1);
-        vShroudnodes.push_back(mn);
+        Insert(mn);
         indexShroudnodes.AddShroudnodeVIN(mn.vin);
         fShroudnodesAdded = true;
         return true;
@@ -173,8 +188,8 @@ void CShroudnodeMan::Check()
 
 //    LogPrint("shroudnode", "CShroudnodeMan::Check -- nLastWatchdogVoteTime=%d, IsWatchdogActive()=%d\n", nLastWatchdogVoteTime, IsWatchdogActive());
 
-    BOOST_FOREACH(CShroudnode& mn, vShroudnodes) {
-        mn.Check();
+    for (auto& mnpair : mapShroudnodes) {
+        mnpair.second.Check();
     }
 }
 
@@ -192,30 +207,30 @@ void CShroudnodeMan::CheckAndRemove()
         Check();
 
         // Remove spent shroudnodes, prepare structures and make requests to reasure the state of inactive ones
-        std::vector<CShroudnode>::iterator it = vShroudnodes.begin();
+        shroudnode_map_t::iterator it = mapShroudnodes.begin();
         std::vector<std::pair<int, CShroudnode> > vecShroudnodeRanks;
         // ask for up to MNB_RECOVERY_MAX_ASK_ENTRIES shroudnode entries at a time
         int nAskForMnbRecovery = MNB_RECOVERY_MAX_ASK_ENTRIES;
-        while(it != vShroudnodes.end()) {
-            CShroudnodeBroadcast mnb = CShroudnodeBroadcast(*it);
+        while(it != mapShroudnodes.end()) {
+            CShroudnodeBroadcast mnb = CShroudnodeBroadcast(it->second);
             uint256 hash = mnb.GetHash();
             // If collateral was spent ...
-            if ((*it).IsOutpointSpent()) {
-                LogPrint("shroudnode", "CShroudnodeMan::CheckAndRemove -- Removing Shroudnode: %s  addr=%s  %i now\n", (*it).GetStateString(), (*it).addr.ToString(), size() - 1);
+            if (it->second.IsOutpointSpent()) {
+                LogPrint("shroudnode", "CShroudnodeMan::CheckAndRemove -- Removing Shroudnode: %s  addr=%s  %i now\n", it->second.GetStateString(), it->second.addr.ToString(), size() - 1);
 
                 // erase all of the broadcasts we've seen from this txin, ...
                 mapSeenShroudnodeBroadcast.erase(hash);
-                mWeAskedForShroudnodeListEntry.erase((*it).vin.prevout);
+                mWeAskedForShroudnodeListEntry.erase(it->first);
 
                 // and finally remove it from the list
 //                it->FlagGovernanceItemsAsDirty();
-                it = vShroudnodes.erase(it);
+                it = Erase(it);
                 fShroudnodesRemoved = true;
             } else {
                 bool fAsk = pCurrentBlockIndex &&
                             (nAskForMnbRecovery > 0) &&
                             shroudnodeSync.IsSynced() &&
-                            it->IsNewStartRequired() &&
+                            it->second.IsNewStartRequired() &&
                             !IsMnbRecoveryRequested(hash);
                 if(fAsk) {
                     // this mn is in a non-recoverable state and we haven't asked other nodes yet
@@ -229,7 +244,7 @@ void CShroudnodeMan::CheckAndRemove()
                     // ask first MNB_RECOVERY_QUORUM_TOTAL shroudnodes we can connect to and we haven't asked recently
                     for(int i = 0; setRequested.size() < MNB_RECOVERY_QUORUM_TOTAL && i < (int)vecShroudnodeRanks.size(); i++) {
                         // avoid banning
-                        if(mWeAskedForShroudnodeListEntry.count(it->vin.prevout) && mWeAskedForShroudnodeListEntry[it->vin.prevout].count(vecShroudnodeRanks[i].second.addr)) continue;
+                        if(mWeAskedForShroudnodeListEntry.count(it->first) && mWeAskedForShroudnodeListEntry[it->first].count(vecShroudnodeRanks[i].second.addr)) continue;
                         // didn't ask recently, ok to ask now
                         CService addr = vecShroudnodeRanks[i].second.addr;
                         setRequested.insert(addr);
@@ -237,7 +252,7 @@ void CShroudnodeMan::CheckAndRemove()
                         fAskedForMnbRecovery = true;
                     }
                     if(fAskedForMnbRecovery) {
-                        LogPrint("shroudnode", "CShroudnodeMan::CheckAndRemove -- Recovery initiated, shroudnode=%s\n", it->vin.prevout.ToStringShort());
+                        LogPrint("shroudnode", "CShroudnodeMan::CheckAndRemove -- Recovery initiated, shroudnode=%s\n", it->first.ToStringShort());
                         nAskForMnbRecovery--;
                     }
                     // wait for mnb recovery replies for MNB_RECOVERY_WAIT_SECONDS seconds
@@ -333,7 +348,7 @@ void CShroudnodeMan::CheckAndRemove()
         // NOTE: do not expire mapSeenShroudnodeBroadcast entries here, clean them on mnb updates!
 
         // remove expired mapSeenShroudnodePing
-        std::map<uint256, CShroudnodePing>::iterator it4 = mapSeenShroudnodePing.begin();
+        std::unordered_map<uint256, CShroudnodePing, SaltedTxidHasher>::iterator it4 = mapSeenShroudnodePing.begin();
         while(it4 != mapSeenShroudnodePing.end()){
             if((*it4).second.IsExpired()) {
                 LogPrint("shroudnode", "CShroudnodeMan::CheckAndRemove -- Removing expired Shroudnode ping: hash=%s\n", (*it4).second.GetHash().ToString());
@@ -344,7 +359,7 @@ void CShroudnodeMan::CheckAndRemove()
         }
 
         // remove expired mapSeenShroudnodeVerification
-        std::map<uint256, CShroudnodeVerification>::iterator itv2 = mapSeenShroudnodeVerification.begin();
+        std::unordered_map<uint256, CShroudnodeVerification, SaltedTxidHasher>::iterator itv2 = mapSeenShroudnodeVerification.begin();
         while(itv2 != mapSeenShroudnodeVerification.end()){
             if((*itv2).second.nBlockHeight < pCurrentBlockIndex->nHeight - MAX_POSE_BLOCKS){
                 LogPrint("shroudnode", "CShroudnodeMan::CheckAndRemove -- Removing expired Shroudnode verification: hash=%s\n", (*itv2).first.ToString());
@@ -369,7 +384,8 @@ void CShroudnodeMan::CheckAndRemove()
 void CShroudnodeMan::Clear()
 {
     LOCK(cs);
-    vShroudnodes.clear();
+    mapShroudnodes.clear();
+    RebuildIndexes();
     mAskedUsForShroudnodeList.clear();
     mWeAskedForShroudnodeList.clear();
     mWeAskedForShroudnodeListEntry.clear();
@@ -387,8 +403,8 @@ int CShroudnodeMan::CountShroudnodes(int nProtocolVersion)
     int nCount = 0;
     nProtocolVersion = nProtocolVersion == -1 ? mnpayments.GetMinShroudnodePaymentsProto() : nProtocolVersion;
 
-    BOOST_FOREACH(CShroudnode& mn, vShroudnodes) {
-        if(mn.nProtocolVersion < nProtocolVersion) continue;
+    for (auto& mnpair : mapShroudnodes) {
+        if(mnpair.second.nProtocolVersion < nProtocolVersion) continue;
         nCount++;
     }
 
@@ -401,8 +417,8 @@ int CShroudnodeMan::CountEnabled(int nProtocolVersion)
     int nCount = 0;
     nProtocolVersion = nProtocolVersion == -1 ? mnpayments.GetMinShroudnodePaymentsProto() : nProtocolVersion;
 
-    BOOST_FOREACH(CShroudnode& mn, vShroudnodes) {
-        if(mn.nProtocolVersion < nProtocolVersion || !mn.IsEnabled()) continue;
+    for (auto& mnpair : mapShroudnodes) {
+        if(mnpair.second.nProtocolVersion < nProtocolVersion || !mnpair.second.IsEnabled()) continue;
         nCount++;
     }
 
@@ -415,10 +431,10 @@ int CShroudnodeMan::CountByIP(int nNetworkType)
     LOCK(cs);
     int nNodeCount = 0;
 
-    BOOST_FOREACH(CShroudnode& mn, vShroudnodes)
-        if ((nNetworkType == NET_IPV4 && mn.addr.IsIPv4()) ||
-            (nNetworkType == NET_TOR  && mn.addr.IsTor())  ||
-            (nNetworkType == NET_IPV6 && mn.addr.IsIPv6())) {
+    for (auto& mnpair : mapShroudnodes)
+        if ((nNetworkType == NET_IPV4 && mnpair.second.addr.IsIPv4()) ||
+            (nNetworkType == NET_TOR  && mnpair.second.addr.IsTor())  ||
+            (nNetworkType == NET_IPV6 && mnpair.second.addr.IsIPv6())) {
                 nNodeCount++;
         }
 
@@ -451,25 +467,25 @@ CShroudnode* CShroudnodeMan::Find(const std::string &txHash, const std::string o
 {
     LOCK(cs);
 
-    BOOST_FOREACH(CShroudnode& mn, vShroudnodes)
-    {
-        COutPoint outpoint = mn.vin.prevout;
+    uint32_t n;
+    if(!ParseUInt32(outputIndex, &n))
+        return NULL;
 
-        if(txHash==outpoint.hash.ToString().substr(0,64) &&
-           outputIndex==to_string(outpoint.n))
-            return &mn;
-    }
-    return NULL;
+    CShroudnode* pmn = Find(CTxIn(COutPoint(uint256S(txHash), n)));
+    // only the exact strings the outpoint prints as, like the old scan
+    if(pmn == NULL || txHash != pmn->vin.prevout.hash.ToString() || outputIndex != to_string(n))
+        return NULL;
+    return pmn;
 }
 
 CShroudnode* CShroudnodeMan::Find(const CScript &payee)
 {
     LOCK(cs);
 
-    BOOST_FOREACH(CShroudnode& mn, vShroudnodes)
+    for (auto& mnpair : mapShroudnodes)
     {
-        if(GetScriptForDestination(mn.pubKeyCollateralAddress.GetID()) == payee)
-            return &mn;
+        if(GetScriptForDestination(mnpair.second.pubKeyCollateralAddress.GetID()) == payee)
+            return &mnpair.second;
     }
     return NULL;
 }
@@ -478,24 +494,16 @@ CShroudnode* CShroudnodeMan::Find(const CTxIn &vin)
 {
     LOCK(cs);
 
-    BOOST_FOREACH(CShroudnode& mn, vShroudnodes)
-    {
-        if(mn.vin.prevout == vin.prevout)
-            return &mn;
-    }
-    return NULL;
+    shroudnode_map_t::iterator it = mapShroudnodes.find(vin.prevout);
+    return it == mapShroudnodes.end() ? NULL : &it->second;
 }
 
 CShroudnode* CShroudnodeMan::Find(const CPubKey &pubKeyShroudnode)
 {
     LOCK(cs);
 
-    BOOST_FOREACH(CShroudnode& mn, vShroudnodes)
-    {
-        if(mn.pubKeyShroudnode == pubKeyShroudnode)
-            return &mn;
-    }
-    return NULL;
+    auto it = mapShroudnodesByPubKey.find(pubKeyShroudnode);
+    return it == mapShroudnodesByPubKey.end() ? NULL : it->second;
 }
 
 bool CShroudnodeMan::Get(const CPubKey& pubKeyShroudnode, CShroudnode& shroudnode)
@@ -672,8 +680,9 @@ CShroudnode* CShroudnodeMan::GetNextShroudnodeInQueueForPayment(int nBlockHeight
     */
     int nMnCount = CountEnabled();
     int index = 0;
-    BOOST_FOREACH(CShroudnode &mn, vShroudnodes)
+    for (auto& mnpair : mapShroudnodes)
     {
+        CShroudnode &mn = mnpair.second;
         index += 1;
         // LogPrintf("shroud=%s, mn=%s\n", index, mn.ToString());
         /*if (!mn.IsValidForPayment()) {
@@ -744,8 +753,9 @@ CShroudnode* CShroudnodeMan::GetNextShroudnodeInQueueForPayment(int nBlockHeight
     int nTenthNetwork = nMnCount/10;
     int nCountTenth = 0;
     arith_uint256 nHighest = 0;
+    const CShroudnodeScores& scores = GetScores(blockHash);
     BOOST_FOREACH (PAIRTYPE(int, CShroudnode*)& s, vecShroudnodeLastPaid){
-        arith_uint256 nScore = s.second->CalculateScore(blockHash);
+        arith_uint256 nScore = scores.vecScores[scores.mapPosition.find(s.second->vin.prevout)->second].nScore;
         if(nScore > nHighest){
             nHighest = nScore;
             pBestShroudnode = s.second;
@@ -770,8 +780,8 @@ CShroudnode* CShroudnodeMan::FindRandomNotInVec(const std::vector<CTxIn> &vecToE
 
     // fill a vector of pointers
     std::vector<CShroudnode*> vpShroudnodesShuffled;
-    BOOST_FOREACH(CShroudnode &mn, vShroudnodes) {
-        vpShroudnodesShuffled.push_back(&mn);
+    for (auto& mnpair : mapShroudnodes) {
+        vpShroudnodesShuffled.push_back(&mnpair.second);
     }
 
     InsecureRand insecureRand;
@@ -799,18 +809,140 @@ CShroudnode* CShroudnodeMan::FindRandomNotInVec(const std::vector<CTxIn> &vecToE
     return NULL;
 }
 
-int CShroudnodeMan::GetShroudnodeRank(const CTxIn& vin, int nBlockHeight, int nMinProtocol, bool fOnlyActive)
+const CShroudnodeMan::CShroudnodeScores& CShroudnodeMan::GetScores(const uint256& blockHash)
+{
+    AssertLockHeld(cs);
+
+    std::map<uint256, CShroudnodeScores>::iterator it = mapScoreCache.find(blockHash);
+    if (it != mapScoreCache.end())
+        return it->second;
+
+    if (listScoreCacheBlocks.size() >= MAX_SCORE_CACHE_BLOCKS) {
+        mapScoreCache.erase(listScoreCacheBlocks.front());
+        listScoreCacheBlocks.pop_front();
+    }
+    CShroudnodeScores& scores = mapScoreCache[blockHash];
+    listScoreCacheBlocks.push_back(blockHash);
+
+    scores.vecScores.reserve(mapShroudnodes.size());
+    for (auto& mnpair : mapShroudnodes) {
+        CShroudnode& mn = mnpair.second;
+        CShroudnodeScore score;
+        score.nScore = mn.CalculateScore(blockHash);
+        score.nCompactScore = score.nScore.GetCompact(false);
+        score.pmn = &mn;
+        scores.vecScores.push_back(score);
+    }
+
+    // a total order, so the ranks among any subset of shroudnodes are their order in here
+    sort(scores.vecScores.begin(), scores.vecScores.end(), CompareScoreDescending());
+
+    for (size_t i = 0; i < scores.vecScores.size(); i++)
+        scores.mapPosition[scores.vecScores[i].pmn->vin.prevout] = i;
+    return scores;
+}
+
+void CShroudnodeMan::ClearScoreCache()
+{
+    mapScoreCache.clear();
+    listScoreCacheBlocks.clear();
+}
+
+void CShroudnodeMan::RebuildIndexes()
+{
+    AssertLockHeld(cs);
+
+    mapShroudnodesByPubKey.clear();
+    mapShroudnodesByAddr.clear();
+    for (auto& mnpair : mapShroudnodes) {
+        AddToIndexes(&mnpair.second);
+    }
+    ClearScoreCache();
+    snapshotShroudnodes.reset();
+}
+
+void CShroudnodeMan::AddToIndexes(CShroudnode* pmn)
+{
+    AssertLockHeld(cs);
+
+    mapShroudnodesByPubKey.insert(std::make_pair(pmn->pubKeyShroudnode, pmn));
+    mapShroudnodesByAddr.insert(std::make_pair(pmn->addr, pmn));
+    snapshotShroudnodes.reset();
+}
+
+void CShroudnodeMan::RemoveFromIndexes(CShroudnode* pmn)
+{
+    AssertLockHeld(cs);
+
+    auto rangePubKey = mapShroudnodesByPubKey.equal_range(pmn->pubKeyShroudnode);
+    for (auto it = rangePubKey.first; it != rangePubKey.second; ++it) {
+        if (it->second == pmn) {
+            mapShroudnodesByPubKey.erase(it);
+            break;
+        }
+    }
+    auto rangeAddr = mapShroudnodesByAddr.equal_range(pmn->addr);
+    for (auto it = rangeAddr.first; it != rangeAddr.second; ++it) {
+        if (it->second == pmn) {
+            mapShroudnodesByAddr.erase(it);
+            break;
+        }
+    }
+}
+
+CShroudnode* CShroudnodeMan::Insert(const CShroudnode& mn)
 {
-    std::vector<std::pair<int64_t, CShroudnode*> > vecShroudnodeScores;
+    AssertLockHeld(cs);
+
+    CShroudnode* pmn = &mapShroudnodes.insert(std::make_pair(mn.vin.prevout, mn)).first->second;
+    AddToIndexes(pmn);
+    ClearScoreCache();
+    return pmn;
+}
+
+CShroudnodeMan::shroudnode_map_t::iterator CShroudnodeMan::Erase(shroudnode_map_t::iterator it)
+{
+    AssertLockHeld(cs);
+
+    RemoveFromIndexes(&it->second);
+    ClearScoreCache();
+    snapshotShroudnodes.reset();
+    return mapShroudnodes.erase(it);
+}
+
+CShroudnodeMan::shroudnode_snapshot_t CShroudnodeMan::GetShroudnodeSnapshot()
+{
+    LOCK(cs);
+
+    int64_t nNow = GetTime();
+    if (!snapshotShroudnodes || nNow - nSnapshotTime >= SNAPSHOT_MAX_AGE_SECONDS || nNow < nSnapshotTime) {
+        std::shared_ptr<std::vector<CShroudnode> > pvShroudnodes = std::make_shared<std::vector<CShroudnode> >();
+        pvShroudnodes->reserve(mapShroudnodes.size());
+        for (auto& mnpair : mapShroudnodes) {
+            pvShroudnodes->push_back(mnpair.second);
+        }
+        snapshotShroudnodes = pvShroudnodes;
+        nSnapshotTime = nNow;
+    }
+    return snapshotShroudnodes;
+}
 
+int CShroudnodeMan::GetShroudnodeRank(const CTxIn& vin, int nBlockHeight, int nMinProtocol, bool fOnlyActive)
+{
     //make sure we know about this block
     uint256 blockHash = uint256();
     if(!GetBlockHash(blockHash, nBlockHeight)) return -1;
 
     LOCK(cs);
 
-    // scan for winner
-    BOOST_FOREACH(CShroudnode& mn, vShroudnodes) {
+    const CShroudnodeScores& scores = GetScores(blockHash);
+    std::unordered_map<COutPoint, size_t, SaltedOutpointHasher>::const_iterator it = scores.mapPosition.find(vin.prevout);
+    if (it == scores.mapPosition.end()) return -1;
+
+    // count the ones ranked up to it
+    int nRank = 0;
+    for (size_t i = 0; i <= it->second; i++) {
+        CShroudnode& mn = *scores.vecScores[i].pmn;
         if(mn.nProtocolVersion < nMinProtocol) continue;
         if(fOnlyActive) {
             if(!mn.IsEnabled()) continue;
@@ -818,17 +950,8 @@ int CShroudnodeMan::GetShroudnodeRank(const CTxIn& vin, int nBlockHeight, int nM
         else {
             if(!mn.IsValidForPayment()) continue;
         }
-        int64_t nScore = mn.CalculateScore(blockHash).GetCompact(false);
-
-        vecShroudnodeScores.push_back(std::make_pair(nScore, &mn));
-    }
-
-    sort(vecShroudnodeScores.rbegin(), vecShroudnodeScores.rend(), CompareScoreMN());
-
-    int nRank = 0;
-    BOOST_FOREACH (PAIRTYPE(int64_t, CShroudnode*)& scorePair, vecShroudnodeScores) {
         nRank++;
-        if(scorePair.second->vin.prevout == vin.prevout) return nRank;
+        if(i == it->second) return nRank;
     }
 
     return -1;
@@ -836,7 +959,6 @@ int CShroudnodeMan::GetShroudnodeRank(const CTxIn& vin, int nBlockHeight, int nM
 
 std::vector<std::pair<int, CShroudnode> > CShroudnodeMan::GetShroudnodeRanks(int nBlockHeight, int nMinProtocol)
 {
-    std::vector<std::pair<int64_t, CShroudnode*> > vecShroudnodeScores;
     std::vector<std::pair<int, CShroudnode> > vecShroudnodeRanks;
 
     //make sure we know about this block
@@ -845,23 +967,14 @@ std::vector<std::pair<int, CShroudnode> > CShroudnodeMan::GetShroudnodeRanks(int
 
     LOCK(cs);
 
-    // scan for winner
-    BOOST_FOREACH(CShroudnode& mn, vShroudnodes) {
-
+    int nRank = 0;
+    BOOST_FOREACH(const CShroudnodeScore& score, GetScores(blockHash).vecScores) {
+        CShroudnode& mn = *score.pmn;
         if(mn.nProtocolVersion < nMinProtocol || !mn.IsEnabled()) continue;
 
-        int64_t nScore = mn.CalculateScore(blockHash).GetCompact(false);
-
-        vecShroudnodeScores.push_back(std::make_pair(nScore, &mn));
-    }
-
-    sort(vecShroudnodeScores.rbegin(), vecShroudnodeScores.rend(), CompareScoreMN());
-
-    int nRank = 0;
-    BOOST_FOREACH (PAIRTYPE(int64_t, CShroudnode*)& s, vecShroudnodeScores) {
         nRank++;
-        s.second->SetRank(nRank);
-        vecShroudnodeRanks.push_back(std::make_pair(nRank, *s.second));
+        mn.SetRank(nRank);
+        vecShroudnodeRanks.push_back(std::make_pair(nRank, mn));
     }
 
     return vecShroudnodeRanks;
@@ -869,8 +982,6 @@ std::vector<std::pair<int, CShroudnode> > CShroudnodeMan::GetShroudnodeRanks(int
 
 CShroudnode* CShroudnodeMan::GetShroudnodeByRank(int nRank, int nBlockHeight, int nMinProtocol, bool fOnlyActive)
 {
-    std::vector<std::pair<int64_t, CShroudnode*> > vecShroudnodeScores;
-
     LOCK(cs);
 
     uint256 blockHash;
@@ -879,24 +990,15 @@ CShroudnode* CShroudnodeMan::GetShroudnodeByRank(int nRank, int nBlockHeight, in
         return NULL;
     }
 
-    // Fill scores
-    BOOST_FOREACH(CShroudnode& mn, vShroudnodes) {
-
+    int rank = 0;
+    BOOST_FOREACH(const CShroudnodeScore& score, GetScores(blockHash).vecScores) {
+        CShroudnode& mn = *score.pmn;
         if(mn.nProtocolVersion < nMinProtocol) continue;
         if(fOnlyActive && !mn.IsEnabled()) continue;
 
-        int64_t nScore = mn.CalculateScore(blockHash).GetCompact(false);
-
-        vecShroudnodeScores.push_back(std::make_pair(nScore, &mn));
-    }
-
-    sort(vecShroudnodeScores.rbegin(), vecShroudnodeScores.rend(), CompareScoreMN());
-
-    int rank = 0;
-    BOOST_FOREACH (PAIRTYPE(int64_t, CShroudnode*)& s, vecShroudnodeScores){
         rank++;
         if(rank == nRank) {
-            return s.second;
+            return &mn;
         }
     }
 
@@ -1047,7 +1149,11 @@ void CShroudnodeMan::ProcessMessage(CNode* pfrom, std::string& strCommand, CData
 
         int nInvCount = 0;
 
-        BOOST_FOREACH(CShroudnode& mn, vShroudnodes) {
+        // a specific entry is looked up, only a request for the whole list walks it
+        shroudnode_map_t::iterator it = vin == CTxIn() ? mapShroudnodes.begin() : mapShroudnodes.find(vin.prevout);
+        shroudnode_map_t::iterator itEnd = (vin == CTxIn() || it == mapShroudnodes.end()) ? mapShroudnodes.end() : std::next(it);
+        for (; it != itEnd; ++it) {
+            CShroudnode& mn = it->second;
             if (vin != CTxIn() && vin != mn.vin) continue; // asked for specific vin but we are not there yet
             if (mn.addr.IsRFC1918() || mn.addr.IsLocal()) continue; // do not send local network shroudnode
             if (mn.IsUpdateRequired()) continue; // do not send outdated shroudnodes
@@ -1142,8 +1248,8 @@ void CShroudnodeMan::DoFullVerificationStep()
     if(nOffset >= (int)vecShroudnodeRanks.size()) return;
 
     std::vector<CShroudnode*> vSortedByAddr;
-    BOOST_FOREACH(CShroudnode& mn, vShroudnodes) {
-        vSortedByAddr.push_back(&mn);
+    for (auto& mnpair : mapShroudnodes) {
+        vSortedByAddr.push_back(&mnpair.second);
     }
 
     sort(vSortedByAddr.begin(), vSortedByAddr.end(), CompareByAddr());
@@ -1182,7 +1288,7 @@ void CShroudnodeMan::DoFullVerificationStep()
 
 void CShroudnodeMan::CheckSameAddr()
 {
-    if(!shroudnodeSync.IsSynced() || vShroudnodes.empty()) return;
+    if(!shroudnodeSync.IsSynced() || mapShroudnodes.empty()) return;
 
     std::vector<CShroudnode*> vBan;
     std::vector<CShroudnode*> vSortedByAddr;
@@ -1193,8 +1299,8 @@ void CShroudnodeMan::CheckSameAddr()
         CShroudnode* pprevShroudnode = NULL;
         CShroudnode* pverifiedShroudnode = NULL;
 
-        BOOST_FOREACH(CShroudnode& mn, vShroudnodes) {
-            vSortedByAddr.push_back(&mn);
+        for (auto& mnpair : mapShroudnodes) {
+            vSortedByAddr.push_back(&mnpair.second);
         }
 
         sort(vSortedByAddr.begin(), vSortedByAddr.end(), CompareByAddr());
@@ -1343,47 +1449,45 @@ void CShroudnodeMan::ProcessVerifyReply(CNode* pnode, CShroudnodeVerification& m
 
         CShroudnode* prealShroudnode = NULL;
         std::vector<CShroudnode*> vpShroudnodesToBan;
-        std::vector<CShroudnode>::iterator it = vShroudnodes.begin();
         std::string strMessage1 = strprintf("%s%d%s", pnode->addr.ToString(), mnv.nonce, blockHash.ToString());
-        while(it != vShroudnodes.end()) {
-            if(CAddress(it->addr, NODE_NETWORK) == pnode->addr) {
-                if(darkSendSigner.VerifyMessage(it->pubKeyShroudnode, mnv.vchSig1, strMessage1, strError)) {
-                    // found it!
-                    prealShroudnode = &(*it);
-                    if(!it->IsPoSeVerified()) {
-                        it->DecreasePoSeBanScore();
-                    }
-                    netfulfilledman.AddFulfilledRequest(pnode->addr, strprintf("%s", NetMsgType::MNVERIFY)+"-done");
-
-                    // we can only broadcast it if we are an activated shroudnode
-                    if(activeShroudnode.vin == CTxIn()) continue;
-                    // update ...
-                    mnv.addr = it->addr;
-                    mnv.vin1 = it->vin;
-                    mnv.vin2 = activeShroudnode.vin;
-                    std::string strMessage2 = strprintf("%s%d%s%s%s", mnv.addr.ToString(), mnv.nonce, blockHash.ToString(),
-                                            mnv.vin1.prevout.ToStringShort(), mnv.vin2.prevout.ToStringShort());
-                    // ... and sign it
-                    if(!darkSendSigner.SignMessage(strMessage2, mnv.vchSig2, activeShroudnode.keyShroudnode)) {
-                        LogPrintf("ShroudnodeMan::ProcessVerifyReply -- SignMessage() failed\n");
-                        return;
-                    }
+        auto range = mapShroudnodesByAddr.equal_range(pnode->addr);
+        for (auto it = range.first; it != range.second; ++it) {
+            CShroudnode* pmn = it->second;
+            if(darkSendSigner.VerifyMessage(pmn->pubKeyShroudnode, mnv.vchSig1, strMessage1, strError)) {
+                // found it!
+                prealShroudnode = pmn;
+                if(!pmn->IsPoSeVerified()) {
+                    pmn->DecreasePoSeBanScore();
+                }
+                netfulfilledman.AddFulfilledRequest(pnode->addr, strprintf("%s", NetMsgType::MNVERIFY)+"-done");
+
+                // we can only broadcast it if we are an activated shroudnode
+                if(activeShroudnode.vin == CTxIn()) continue;
+                // update ...
+                mnv.addr = pmn->addr;
+                mnv.vin1 = pmn->vin;
+                mnv.vin2 = activeShroudnode.vin;
+                std::string strMessage2 = strprintf("%s%d%s%s%s", mnv.addr.ToString(), mnv.nonce, blockHash.ToString(),
+                                        mnv.vin1.prevout.ToStringShort(), mnv.vin2.prevout.ToStringShort());
+                // ... and sign it
+                if(!darkSendSigner.SignMessage(strMessage2, mnv.vchSig2, activeShroudnode.keyShroudnode)) {
+                    LogPrintf("ShroudnodeMan::ProcessVerifyReply -- SignMessage() failed\n");
+                    return;
+                }
 
-                    std::string strError;
+                std::string strError;
 
-                    if(!darkSendSigner.VerifyMessage(activeShroudnode.pubKeyShroudnode, mnv.vchSig2, strMessage2, strError)) {
-                        LogPrintf("ShroudnodeMan::ProcessVerifyReply -- VerifyMessage() failed, error: %s\n", strError);
-                        return;
-                    }
+                if(!darkSendSigner.VerifyMessage(activeShroudnode.pubKeyShroudnode, mnv.vchSig2, strMessage2, strError)) {
+                    LogPrintf("ShroudnodeMan::ProcessVerifyReply -- VerifyMessage() failed, error: %s\n", strError);
+                    return;
+                }
 
-                    mWeAskedForVerification[pnode->addr] = mnv;
-                    mnv.Relay();
+                mWeAskedForVerification[pnode->addr] = mnv;
+                mnv.Relay();
 
-                } else {
-                    vpShroudnodesToBan.push_back(&(*it));
-                }
+            } else {
+                vpShroudnodesToBan.push_back(pmn);
             }
-            ++it;
         }
         // no real shroudnode found?...
         if(!prealShroudnode) {
@@ -1497,12 +1601,14 @@ void CShroudnodeMan::ProcessVerifyBroadcast(CNode* pnode, const CShroudnodeVerif
 
         // increase ban score for everyone else with the same addr
         int nCount = 0;
-        BOOST_FOREACH(CShroudnode& mn, vShroudnodes) {
-            if(mn.addr != mnv.addr || mn.vin.prevout == mnv.vin1.prevout) continue;
-            mn.IncreasePoSeBanScore();
+        auto range = mapShroudnodesByAddr.equal_range(mnv.addr);
+        for (auto it = range.first; it != range.second; ++it) {
+            CShroudnode* pmn = it->second;
+            if(pmn->vin.prevout == mnv.vin1.prevout) continue;
+            pmn->IncreasePoSeBanScore();
             nCount++;
             LogPrint("shroudnode", "CShroudnodeMan::ProcessVerifyBroadcast -- increased PoSe ban score for %s addr %s, new score %d\n",
-                        mn.vin.prevout.ToStringShort(), mn.addr.ToString(), mn.nPoSeBanScore);
+                        pmn->vin.prevout.ToStringShort(), pmn->addr.ToString(), pmn->nPoSeBanScore);
         }
         LogPrintf("CShroudnodeMan::ProcessVerifyBroadcast -- PoSe score incresed for %d fake shroudnodes, addr %s\n",
                     nCount, pnode->addr.ToString());
@@ -1513,7 +1619,7 @@ std::string CShroudnodeMan::ToString() const
 {
     std::ostringstream info;
 
-    info << "Shroudnodes: " << (int)vShroudnodes.size() <<
+    info << "Shroudnodes: " << (int)mapShroudnodes.size() <<
             ", peers who asked us for Shroudnode list: " << (int)mAskedUsForShroudnodeList.size() <<
             ", peers we asked for Shroudnode list: " << (int)mWeAskedForShroudnodeList.size() <<
             ", entries in Shroudnode list we asked for: " << (int)mWeAskedForShroudnodeListEntry.size() <<
@@ -1542,7 +1648,11 @@ void CShroudnodeMan::UpdateShroudnodeList(CShroudnodeBroadcast mnb)
             }
         } else {
             CShroudnodeBroadcast mnbOld = mapSeenShroudnodeBroadcast[CShroudnodeBroadcast(*pmn).GetHash()].second;
-            if (pmn->UpdateFromNewBroadcast(mnb)) {
+            // the broadcast can move the shroudnode to another key or address
+            RemoveFromIndexes(pmn);
+            bool fUpdated = pmn->UpdateFromNewBroadcast(mnb);
+            AddToIndexes(pmn);
+            if (fUpdated) {
                 shroudnodeSync.AddedShroudnodeList();
                 GetMainSignals().UpdatedShroudnode(*pmn);
                 mapSeenShroudnodeBroadcast.erase(mnbOld.GetHash());
@@ -1609,7 +1719,10 @@ bool CShroudnodeMan::CheckMnbAndUpdateShroudnodeList(CNode* pfrom, CShroudnodeBr
         CShroudnode *pmn = Find(mnb.vin);
         if (pmn) {
             CShroudnodeBroadcast mnbOld = mapSeenShroudnodeBroadcast[CShroudnodeBroadcast(*pmn).GetHash()].second;
-            if (!mnb.Update(pmn, nDos)) {
+            RemoveFromIndexes(pmn);
+            bool fUpdated = mnb.Update(pmn, nDos);
+            AddToIndexes(pmn);
+            if (!fUpdated) {
                 LogPrint("shroudnode", "CShroudnodeMan::CheckMnbAndUpdateShroudnodeList -- Update() failed, shroudnode=%s\n", mnb.vin.prevout.ToStringShort());
                 return false;
             }
@@ -1665,8 +1778,8 @@ void CShroudnodeMan::UpdateLastPaid()
     LogPrint("mnpayments", "CShroudnodeMan::UpdateLastPaid -- nHeight=%d, nMaxBlocksToScanBack=%d, IsFirstRun=%s\n",
                              pCurrentBlockIndex->nHeight, nMaxBlocksToScanBack, IsFirstRun ? "true" : "false");
 
-    BOOST_FOREACH(CShroudnode& mn, vShroudnodes) {
-        mn.UpdateLastPaid(pCurrentBlockIndex, nMaxBlocksToScanBack);
+    for (auto& mnpair : mapShroudnodes) {
+        mnpair.second.UpdateLastPaid(pCurrentBlockIndex, nMaxBlocksToScanBack);
     }
 
     // every time is like the first time if winners list is not synced
@@ -1685,14 +1798,14 @@ void CShroudnodeMan::CheckAndRebuildShroudnodeIndex()
         return;
     }
 
-    if(indexShroudnodes.GetSize() <= int(vShroudnodes.size())) {
+    if(indexShroudnodes.GetSize() <= int(mapShroudnodes.size())) {
         return;
     }
 
     indexShroudnodesOld = indexShroudnodes;
     indexShroudnodes.Clear();
-    for(size_t i = 0; i < vShroudnodes.size(); ++i) {
-        indexShroudnodes.AddShroudnodeVIN(vShroudnodes[i].vin);
+    for (auto& mnpair : mapShroudnodes) {
+        indexShroudnodes.AddShroudnodeVIN(mnpair.second.vin);
     }
 
     fIndexRebuilt = true;
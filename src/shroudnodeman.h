@@ -6,15 +6,45 @@
 #ifndef SHROUDNODEMAN_H
 #define SHROUDNODEMAN_H
 
+#include "coins.h"
 #include "shroudnode.h"
 #include "sync.h"
 
+#include <memory>
+#include <unordered_map>
+
 using namespace std;
 
 class CShroudnodeMan;
 
 extern CShroudnodeMan mnodeman;
 
+class SaltedPubKeyHasher
+{
+private:
+    /** Salt */
+    const uint64_t k0, k1;
+
+public:
+    SaltedPubKeyHasher();
+
+    size_t operator()(const CPubKey& pubKey) const {
+        return CSipHasher(k0, k1).Write(pubKey.begin(), pubKey.size()).Finalize();
+    }
+};
+
+class SaltedServiceHasher
+{
+private:
+    /** Salt */
+    const uint64_t k0, k1;
+
+public:
+    SaltedServiceHasher();
+
+    size_t operator()(const CService& addr) const;
+};
+
 /**
  * Provides a forward and reverse index between MN vin's and integers.
  *
@@ -88,6 +118,10 @@ public:
 
     typedef index_m_t::const_iterator index_m_cit;
 
+    typedef std::unordered_map<COutPoint, CShroudnode, SaltedOutpointHasher> shroudnode_map_t;
+
+    typedef std::shared_ptr<const std::vector<CShroudnode> > shroudnode_snapshot_t;
+
 private:
     static const int MAX_EXPECTED_INDEX_SIZE = 30000;
 
@@ -111,6 +145,27 @@ private:
     static const int MNB_RECOVERY_WAIT_SECONDS      = 60;
     static const int MNB_RECOVERY_RETRY_SECONDS     = 3 * 60 * 60;
 
+    /// Blocks whose shroudnode scores are kept, see GetScores
+    static const size_t MAX_SCORE_CACHE_BLOCKS  = 32;
+
+    /// How long GetShroudnodeSnapshot hands out the same copy while the list doesn't change
+    static const int SNAPSHOT_MAX_AGE_SECONDS   = 5;
+
+    struct CShroudnodeScore
+    {
+        arith_uint256 nScore;
+        /// what ranks are sorted by
+        int64_t nCompactScore;
+        CShroudnode* pmn;
+    };
+
+    /// All shroudnodes with their scores for one block, best first, and where each of them is
+    struct CShroudnodeScores
+    {
+        std::vector<CShroudnodeScore> vecScores;
+        std::unordered_map<COutPoint, size_t, SaltedOutpointHasher> mapPosition;
+    };
+
 
     // critical section to protect the inner data structures
     mutable CCriticalSection cs;
@@ -118,8 +173,11 @@ private:
     // Keep track of current block index
     const CBlockIndex *pCurrentBlockIndex;
 
-    // map to hold all MNs
-    std::vector<CShroudnode> vShroudnodes;
+    // map to hold all MNs, entries don't move while they are in the map
+    shroudnode_map_t mapShroudnodes;
+    // the same MNs by their key and by their address, kept up to date by AddToIndexes/RemoveFromIndexes
+    std::unordered_multimap<CPubKey, CShroudnode*, SaltedPubKeyHasher> mapShroudnodesByPubKey;
+    std::unordered_multimap<CService, CShroudnode*, SaltedServiceHasher> mapShroudnodesByAddr;
     // who's asked for the Shroudnode list and the last time
     std::map<CNetAddr, int64_t> mAskedUsForShroudnodeList;
     // who we asked for the Shroudnode list and the last time
@@ -153,15 +211,40 @@ private:
 
     int64_t nLastWatchdogVoteTime;
 
+    /// A score only depends on the block and the collateral of a shroudnode, so the scores for a
+    /// block are computed once and kept until a shroudnode is added or removed. Entries point into
+    /// mapShroudnodes, so every change to the map must clear them.
+    std::map<uint256, CShroudnodeScores> mapScoreCache;
+    /// Blocks in mapScoreCache, oldest first
+    std::list<uint256> listScoreCacheBlocks;
+
+    /// Last copy made by GetShroudnodeSnapshot, reset when a shroudnode is added, removed or updated
+    shroudnode_snapshot_t snapshotShroudnodes;
+    int64_t nSnapshotTime;
+
     friend class CShroudnodeSync;
 
+    /// Scores of all shroudnodes for blockHash, requires cs
+    const CShroudnodeScores& GetScores(const uint256& blockHash);
+    void ClearScoreCache();
+    /// Reindex all shroudnodes and drop everything derived from the list, requires cs
+    void RebuildIndexes();
+
+    /// Index pmn by key and address, requires cs
+    void AddToIndexes(CShroudnode* pmn);
+    /// Undo AddToIndexes, must be called before the key or the address of pmn change, requires cs
+    void RemoveFromIndexes(CShroudnode* pmn);
+    /// Add or remove an entry of mapShroudnodes, requires cs
+    CShroudnode* Insert(const CShroudnode& mn);
+    shroudnode_map_t::iterator Erase(shroudnode_map_t::iterator it);
+
 public:
     // Keep track of all broadcasts I've seen
-    std::map<uint256, std::pair<int64_t, CShroudnodeBroadcast> > mapSeenShroudnodeBroadcast;
+    std::unordered_map<uint256, std::pair<int64_t, CShroudnodeBroadcast>, SaltedTxidHasher> mapSeenShroudnodeBroadcast;
     // Keep track of all pings I've seen
-    std::map<uint256, CShroudnodePing> mapSeenShroudnodePing;
+    std::unordered_map<uint256, CShroudnodePing, SaltedTxidHasher> mapSeenShroudnodePing;
     // Keep track of all verifications I've seen
-    std::map<uint256, CShroudnodeVerification> mapSeenShroudnodeVerification;
+    std::unordered_map<uint256, CShroudnodeVerification, SaltedTxidHasher> mapSeenShroudnodeVerification;
     // keep track of dsq count to prevent shroudnodes from gaming darksend queue
     int64_t nDsqCount;
 
@@ -180,7 +263,7 @@ public:
             READWRITE(strVersion);
         }
 
-        READWRITE(vShroudnodes);
+        READWRITE(mapShroudnodes);
         READWRITE(mAskedUsForShroudnodeList);
         READWRITE(mWeAskedForShroudnodeList);
         READWRITE(mWeAskedForShroudnodeListEntry);
@@ -192,6 +275,9 @@ public:
         READWRITE(mapSeenShroudnodeBroadcast);
         READWRITE(mapSeenShroudnodePing);
         READWRITE(indexShroudnodes);
+        if(ser_action.ForRead()) {
+            RebuildIndexes();
+        }
         if(ser_action.ForRead() && (strVersion != SERIALIZATION_VERSION_STRING)) {
             Clear();
         }
@@ -298,7 +384,9 @@ public:
     /// Find a random entry
     CShroudnode* FindRandomNotInVec(const std::vector<CTxIn> &vecToExclude, int nProtocolVersion = -1);
 
-    std::vector<CShroudnode> GetFullShroudnodeVector() { LOCK(cs); return vShroudnodes; }
+    /// Copy of all shroudnodes that can be used without holding cs. Callers share the same copy until
+    /// the list changes or the copy is SNAPSHOT_MAX_AGE_SECONDS old, so it can lag behind pings.
+    shroudnode_snapshot_t GetShroudnodeSnapshot();
 
     std::vector<std::pair<int, CShroudnode> > GetShroudnodeRanks(int nBlockHeight = -1, int nMinProtocol=0);
     int GetShroudnodeRank(const CTxIn &vin, int nBlockHeight, int nMinProtocol=0, bool fOnlyActive=true);
@@ -317,7 +405,7 @@ public:
     void ProcessVerifyBroadcast(CNode* pnode, const CShroudnodeVerification& mnv);
 
     /// Return the number of (unique) Shroudnodes
-    int size() { return vShroudnodes.size(); }
+    int size() { return mapShroudnodes.size(); }
 
     std::string ToString() const;
 
@@ -30,6 +30,9 @@ namespace sigma {
 
 static CSigmaState sigmaState;
 
+// Maximum number of anonymity sets kept in CSigmaState cache
+static const std::size_t ANONYMITY_SET_CACHE_SIZE = 16;
+
 static bool CheckSigmaSpendSerial(
         CValidationState &state,
         CSigmaTxInfo *sigmaTxInfo,
@@ -254,8 +257,6 @@ bool CheckSigmaSpendTransaction(
 
         bool passVerify = false;
         CBlockIndex *index = coinGroup.lastBlock;
-        pair<sigma::CoinDenomination, int> denominationAndId = std::make_pair(
-            targetDenominations[vinIndex], coinGroupId);
 
         uint256 accumulatorBlockHash = spend->getAccumulatorBlockHash();
 
@@ -269,19 +270,10 @@ bool CheckSigmaSpendTransaction(
         while (index != coinGroup.firstBlock && index->GetBlockHash() != accumulatorBlockHash)
             index = index->pprev;
 
-        // Build a vector with all the public coins with given denomination and accumulator id before
-        // the block on which the spend occured.
-        // This list of public coins is required by function "Verify" of CoinSpend.
-        std::vector<sigma::PublicCoin> anonymity_set;
-        while(true) {
-            BOOST_FOREACH(const sigma::PublicCoin& pubCoinValue,
-                    index->sigmaMintedPubCoins[denominationAndId]) {
-                anonymity_set.push_back(pubCoinValue);
-            }
-            if (index == coinGroup.firstBlock)
-                break;
-            index = index->pprev;
-        }
+        // All the public coins with given denomination and accumulator id before the block on which
+        // the spend occured. This list of public coins is required by function "Verify" of CoinSpend.
+        std::shared_ptr<const std::vector<sigma::PublicCoin>> anonymity_set =
+            sigmaState.GetAnonymitySet(targetDenominations[vinIndex], coinGroupId, index);
 
         bool fPadding = spend->getVersion() >= ZEROCOIN_TX_VERSION_3_1;
         if (!isVerifyDB) {
@@ -291,7 +283,13 @@ bool CheckSigmaSpendTransaction(
                 return state.DoS(1, error("Incorrect sigma spend transaction version"));
         }
 
-        passVerify = spend->Verify(anonymity_set, newMetaData, fPadding);
+        // when connecting a block the proof itself is verified later together with other spends of the block
+        bool fBatchProof = sigmaTxInfo && !sigmaTxInfo->fInfoIsComplete && sigmaTxInfo->spendBatch;
+        if (fBatchProof)
+            passVerify = spend->VerifySignature(newMetaData);
+        else
+            passVerify = spend->Verify(*anonymity_set, newMetaData, fPadding);
+
         if (passVerify) {
             Scalar serial = spend->getCoinSerialNumber();
             // do not check for duplicates in case we've seen exact copy of this tx in this block before
@@ -316,6 +314,11 @@ bool CheckSigmaSpendTransaction(
                                 serial, CSpendCoinInfo::make(spend->getDenomination(), coinGroupId)));
                 }
             }
+
+            if (fBatchProof) {
+                sigmaTxInfo->spendBatch->Add(
+                    std::move(spend), newMetaData, coinGroupId, fPadding, anonymity_set);
+            }
         }
         else {
             LogPrintf("CheckSigmaSpendTransaction: verification failed at block %d\n", nHeight);
@@ -606,6 +609,16 @@ bool ConnectBlockSigma(
             return false;
         }
 
+        if (pblock->sigmaTxInfo->spendBatch) {
+            bool fValid = pblock->sigmaTxInfo->spendBatch->Verify();
+            // proofs are not needed anymore, free the anonymity sets
+            pblock->sigmaTxInfo->spendBatch.reset();
+            if (!fValid) {
+                return state.DoS(100, error("ConnectBlockSigma: sigma spend verification failed"),
+                                 REJECT_INVALID, "bad-txns-zerocoin");
+            }
+        }
+
         BOOST_FOREACH(auto& serial, pblock->sigmaTxInfo->spentSerials) {
             if (!CheckSigmaSpendSerial(
                     state,
@@ -749,6 +762,99 @@ void CSigmaTxInfo::Complete() {
     fInfoIsComplete = true;
 }
 
+/******************************************************************************/
+// CSigmaSpendBatch
+/******************************************************************************/
+
+bool CSigmaSpendCheck::operator()() {
+    return batch->VerifyGroup(std::make_pair(denomination, coinGroupId));
+}
+
+void CSigmaSpendBatch::Add(
+        std::unique_ptr<sigma::CoinSpend> spend,
+        const sigma::SpendMetaData& metaData,
+        int coinGroupId,
+        bool fPadding,
+        std::shared_ptr<const std::vector<sigma::PublicCoin>> anonymitySet) {
+    SpendGroup &group = groups[std::make_pair(spend->getDenomination(), coinGroupId)];
+
+    std::size_t setSize = anonymitySet->size();
+    // keep only the largest set of the group, sets of other spends are its tails
+    if (!group.anonymitySet || setSize > group.anonymitySet->size())
+        group.anonymitySet = std::move(anonymitySet);
+
+    group.spends.push_back(SpendInfo{std::move(spend), metaData, fPadding, setSize});
+}
+
+bool CSigmaSpendBatch::Verify() const {
+    for (const auto &group : groups) {
+        if (!VerifyGroup(group.first))
+            return false;
+    }
+    return true;
+}
+
+std::vector<CSigmaSpendCheck> CSigmaSpendBatch::GetChecks() const {
+    std::vector<CSigmaSpendCheck> checks;
+    checks.reserve(groups.size());
+    for (const auto &group : groups)
+        checks.emplace_back(this, group.first.first, group.first.second);
+    return checks;
+}
+
+bool CSigmaSpendBatch::VerifyGroup(const std::pair<sigma::CoinDenomination, int>& groupId) const {
+    auto groupIt = groups.find(groupId);
+    if (groupIt == groups.end())
+        return true;
+
+    const SpendGroup &group = groupIt->second;
+    if (VerifyProofs(group))
+        return true;
+
+    LogPrintf("CSigmaSpendBatch: batch verification failed for denomination=%d, group=%d\n",
+        (int)groupId.first, groupId.second);
+
+    // find the offending spend
+    for (const SpendInfo &info : group.spends) {
+        std::vector<sigma::PublicCoin> anonymitySet(
+            group.anonymitySet->end() - info.setSize, group.anonymitySet->end());
+        if (!info.spend->Verify(anonymitySet, info.metaData, info.fPadding)) {
+            LogPrintf("CSigmaSpendBatch: verification failed for serial=%s\n",
+                info.spend->getCoinSerialNumber().tostring());
+            break;
+        }
+    }
+    return false;
+}
+
+bool CSigmaSpendBatch::VerifyProofs(const SpendGroup& group) const {
+    sigma::Params* params = sigma::Params::get_default();
+    sigma::SigmaPlusVerifier<Scalar, GroupElement> verifier(
+        params->get_g(), params->get_h(), params->get_n(), params->get_m(), &params->get_tables());
+
+    std::vector<GroupElement> commits;
+    commits.reserve(group.anonymitySet->size());
+    for (const sigma::PublicCoin &coin : *group.anonymitySet)
+        commits.emplace_back(coin.getValue());
+
+    std::vector<Scalar> serials;
+    std::vector<bool> fPadding;
+    std::vector<std::size_t> setSizes;
+    std::vector<sigma::SigmaPlusProof<Scalar, GroupElement>> proofs;
+    serials.reserve(group.spends.size());
+    setSizes.reserve(group.spends.size());
+    proofs.reserve(group.spends.size());
+
+    for (const SpendInfo &info : group.spends) {
+        serials.push_back(info.spend->getCoinSerialNumber());
+        fPadding.push_back(info.fPadding);
+        setSizes.push_back(info.setSize);
+        proofs.push_back(info.spend->getProof());
+    }
+
+    return verifier.batch_verify(commits, serials, fPadding, setSizes, proofs);
+}
+
 /******************************************************************************/
 // CSigmaState::Containers
 /******************************************************************************/
@@ -832,13 +938,16 @@ void CSigmaState::Containers::CheckSurgeCondition(int groupId, CoinDenomination
 /******************************************************************************/
 
 CSigmaState::CSigmaState()
-:containers(surgeCondition)
+:nAnonymitySetUses(0),
+containers(surgeCondition)
 {}
 
 void CSigmaState::AddMintsToStateAndBlockIndex(
         CBlockIndex *index,
         const CBlock* pblock) {
 
+    EraseAnonymitySets(index->GetBlockHash());
+
     std::unordered_map<sigma::CoinDenomination, std::vector<sigma::PublicCoin>> blockDenomMints;
     for (const auto& mint : pblock->sigmaTxInfo->mints) {
         blockDenomMints[mint.getDenomination()].push_back(mint);
@@ -892,6 +1001,8 @@ void CSigmaState::AddSpend(const Scalar &serial, CoinDenomination denom, int coi
 }
 
 void CSigmaState::AddBlock(CBlockIndex *index) {
+    EraseAnonymitySets(index->GetBlockHash());
+
     BOOST_FOREACH(
         const PAIRTYPE(PAIRTYPE(sigma::CoinDenomination, int), vector<sigma::PublicCoin>) &pubCoins,
             index->sigmaMintedPubCoins) {
@@ -916,6 +1027,9 @@ void CSigmaState::AddBlock(CBlockIndex *index) {
 }
 
 void CSigmaState::RemoveBlock(CBlockIndex *index) {
+    // sets ending at this block are not valid anymore
+    EraseAnonymitySets(index->GetBlockHash());
+
     // roll back accumulator updates
     BOOST_FOREACH(
         const PAIRTYPE(PAIRTYPE(sigma::CoinDenomination, int),vector<sigma::PublicCoin>) &coin,
@@ -1018,37 +1132,108 @@ int CSigmaState::GetCoinSetForSpend(
         uint256& blockHash_out,
         std::vector<sigma::PublicCoin>& coins_out) {
 
-    coins_out.clear();
+    std::shared_ptr<const std::vector<sigma::PublicCoin>> coins;
+    int numberOfCoins = GetCoinSetForSpend(chain, maxHeight, denomination, coinGroupID, blockHash_out, coins);
+
+    if (coins)
+        coins_out = *coins;
+    else
+        coins_out.clear();
+
+    return numberOfCoins;
+}
+
+int CSigmaState::GetCoinSetForSpend(
+        CChain *chain,
+        int maxHeight,
+        sigma::CoinDenomination denomination,
+        int coinGroupID,
+        uint256& blockHash_out,
+        std::shared_ptr<const std::vector<sigma::PublicCoin>>& coins_out) {
+
+    coins_out.reset();
 
     pair<sigma::CoinDenomination, int> denomAndId = std::make_pair(denomination, coinGroupID);
 
-    if (coinGroups.count(denomAndId) == 0)
+    auto coinGroupIt = coinGroups.find(denomAndId);
+    if (coinGroupIt == coinGroups.end())
         return 0;
 
-    SigmaCoinGroupInfo coinGroup = coinGroups[denomAndId];
+    const SigmaCoinGroupInfo &coinGroup = coinGroupIt->second;
 
-    int numberOfCoins = 0;
+    // latest block satisfying given conditions
     for (CBlockIndex *block = coinGroup.lastBlock;
             ;
             block = block->pprev) {
-        if (block->sigmaMintedPubCoins[denomAndId].size() > 0) {
-            if (block->nHeight <= maxHeight) {
-                if (numberOfCoins == 0) {
-                    // latest block satisfying given conditions
-                    // remember block hash
-                    blockHash_out = block->GetBlockHash();
-                }
-                numberOfCoins += block->sigmaMintedPubCoins[denomAndId].size();
-                coins_out.insert(coins_out.end(),
-                        block->sigmaMintedPubCoins[denomAndId].begin(),
-                        block->sigmaMintedPubCoins[denomAndId].end());
+        if (block->nHeight <= maxHeight) {
+            auto mintsIt = block->sigmaMintedPubCoins.find(denomAndId);
+            if (mintsIt != block->sigmaMintedPubCoins.end() && mintsIt->second.size() > 0) {
+                blockHash_out = block->GetBlockHash();
+                coins_out = GetAnonymitySet(denomination, coinGroupID, block);
+                return coins_out->size();
             }
         }
         if (block == coinGroup.firstBlock) {
             break ;
         }
     }
-    return numberOfCoins;
+    return 0;
+}
+
+std::shared_ptr<const std::vector<sigma::PublicCoin>> CSigmaState::GetAnonymitySet(
+        sigma::CoinDenomination denomination,
+        int coinGroupID,
+        CBlockIndex *lastBlock) {
+
+    AnonymitySetKey key(denomination, coinGroupID, lastBlock->GetBlockHash());
+
+    auto cached = anonymitySets.find(key);
+    if (cached != anonymitySets.end()) {
+        cached->second.nLastUsed = ++nAnonymitySetUses;
+        return cached->second.coins;
+    }
+
+    std::shared_ptr<std::vector<sigma::PublicCoin>> coins = std::make_shared<std::vector<sigma::PublicCoin>>();
+
+    pair<sigma::CoinDenomination, int> denomAndId = std::make_pair(denomination, coinGroupID);
+    auto coinGroupIt = coinGroups.find(denomAndId);
+    if (coinGroupIt != coinGroups.end()) {
+        const SigmaCoinGroupInfo &coinGroup = coinGroupIt->second;
+
+        for (CBlockIndex *block = lastBlock; block != nullptr; block = block->pprev) {
+            auto mintsIt = block->sigmaMintedPubCoins.find(denomAndId);
+            if (mintsIt != block->sigmaMintedPubCoins.end())
+                coins->insert(coins->end(), mintsIt->second.begin(), mintsIt->second.end());
+
+            if (block == coinGroup.firstBlock)
+                break;
+        }
+    }
+
+    // evict least recently used set
+    if (anonymitySets.size() >= ANONYMITY_SET_CACHE_SIZE) {
+        auto oldest = anonymitySets.begin();
+        for (auto it = anonymitySets.begin(); it != anonymitySets.end(); ++it) {
+            if (it->second.nLastUsed < oldest->second.nLastUsed)
+                oldest = it;
+        }
+        anonymitySets.erase(oldest);
+    }
+
+    AnonymitySetEntry &entry = anonymitySets[key];
+    entry.coins = coins;
+    entry.nLastUsed = ++nAnonymitySetUses;
+
+    return entry.coins;
+}
+
+void CSigmaState::EraseAnonymitySets(const uint256 &blockHash) {
+    for (auto it = anonymitySets.begin(); it != anonymitySets.end(); ) {
+        if (std::get<2>(it->first) == blockHash)
+            it = anonymitySets.erase(it);
+        else
+            ++it;
+    }
 }
 
 std::pair<int, int> CSigmaState::GetMintedCoinHeightAndId(
@@ -1110,6 +1295,7 @@ bool CSigmaState::CanAddMintToMempool(const GroupElement& pubCoin){
 }
 
 void CSigmaState::Reset() {
+    anonymitySets.clear();
     coinGroups.clear();
     latestCoinIds.clear();
     mempoolCoinSerials.clear();
@@ -12,6 +12,9 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <functional>
+#include <map>
+#include <memory>
+#include <tuple>
 #include "coin_containers.h"
 
 //tests
@@ -22,6 +25,73 @@ namespace zerocoin_tests3_v3 { class zerocoin_mintspend_v3; }
 
 namespace sigma {
 
+class CSigmaSpendBatch;
+
+// Closure verifying proofs of one [denomination, group] of the batch, to be run on the script check threads.
+// Batch must outlive the check.
+class CSigmaSpendCheck {
+public:
+    CSigmaSpendCheck() : batch(nullptr), denomination(CoinDenomination::SIGMA_DENOM_0_1), coinGroupId(0) {}
+    CSigmaSpendCheck(const CSigmaSpendBatch *batch, sigma::CoinDenomination denomination, int coinGroupId)
+        : batch(batch), denomination(denomination), coinGroupId(coinGroupId) {}
+
+    bool operator()();
+
+    void swap(CSigmaSpendCheck &check) {
+        std::swap(batch, check.batch);
+        std::swap(denomination, check.denomination);
+        std::swap(coinGroupId, check.coinGroupId);
+    }
+
+private:
+    const CSigmaSpendBatch *batch;
+    sigma::CoinDenomination denomination;
+    int coinGroupId;
+};
+
+// Sigma spends of a block which passed all the checks except the sigma proof itself. Proofs are grouped by
+// anonymity set and every group is verified with a single multi-exponentiation.
+class CSigmaSpendBatch {
+public:
+    // Anonymity set of the spend must be the last anonymitySet.size() coins of the set of any later spend
+    // with the same denomination and group id, that is the way sets are built from the chain.
+    void Add(
+        std::unique_ptr<sigma::CoinSpend> spend,
+        const sigma::SpendMetaData& metaData,
+        int coinGroupId,
+        bool fPadding,
+        std::shared_ptr<const std::vector<sigma::PublicCoin>> anonymitySet);
+
+    // Verify all the proofs added so far. On failure every spend of the failed group is verified
+    // separately to report the offending one.
+    bool Verify() const;
+
+    // One check per group for parallel verification, the result is the same as of Verify()
+    std::vector<CSigmaSpendCheck> GetChecks() const;
+
+    bool IsEmpty() const { return groups.empty(); }
+
+private:
+    friend class CSigmaSpendCheck;
+
+    struct SpendInfo {
+        std::unique_ptr<sigma::CoinSpend> spend;
+        sigma::SpendMetaData metaData;
+        bool fPadding;
+        std::size_t setSize;
+    };
+
+    struct SpendGroup {
+        std::shared_ptr<const std::vector<sigma::PublicCoin>> anonymitySet;
+        std::vector<SpendInfo> spends;
+    };
+
+    bool VerifyGroup(const std::pair<sigma::CoinDenomination, int>& groupId) const;
+    bool VerifyProofs(const SpendGroup& group) const;
+
+    std::map<std::pair<sigma::CoinDenomination, int>, SpendGroup> groups;
+};
+
 // Zerocoin transaction info, added to the CBlock to ensure zerocoin mint/spend transactions got their info stored into
 // index
 class CSigmaTxInfo {
@@ -38,6 +108,9 @@ public:
     // information about transactions in the block is complete
     bool fInfoIsComplete;
 
+    // if set, sigma proofs of spends are collected here and verified by ConnectBlockSigma
+    std::unique_ptr<CSigmaSpendBatch> spendBatch;
+
     CSigmaTxInfo(): fInfoIsComplete(false) {}
 
     // finalize everything
@@ -152,6 +225,23 @@ public:
         uint256& blockHash_out,
         std::vector<sigma::PublicCoin>& coins_out);
 
+    // Same as above but returns shared snapshot of the set instead of copying it
+    int GetCoinSetForSpend(
+        CChain *chain,
+        int maxHeight,
+        sigma::CoinDenomination denomination,
+        int id,
+        uint256& blockHash_out,
+        std::shared_ptr<const std::vector<sigma::PublicCoin>>& coins_out);
+
+    // Coins with given denomination and id minted from the first block of the group up to and including
+    // lastBlock, in the order used by spend proofs. Snapshot is cached and shared between callers until
+    // lastBlock is disconnected
+    std::shared_ptr<const std::vector<sigma::PublicCoin>> GetAnonymitySet(
+        sigma::CoinDenomination denomination,
+        int id,
+        CBlockIndex *lastBlock);
+
     // Return height of mint transaction and id of minted coin
     std::pair<int, int> GetMintedCoinHeightAndId(const sigma::PublicCoin& pubCoin);
 
@@ -211,6 +301,28 @@ private:
 
     std::atomic<bool> surgeCondition;
 
+    // Cache of anonymity sets keyed by denomination, group id and hash of the last block of the set
+    typedef std::tuple<CoinDenomination, int, uint256> AnonymitySetKey;
+
+    struct anonymitysethash {
+        std::size_t operator()(const AnonymitySetKey &key) const {
+            return std::get<2>(key).GetCheapHash()
+                ^ std::hash<int>()(std::get<1>(key))
+                ^ (std::hash<int>()(static_cast<int>(std::get<0>(key))) << 16);
+        }
+    };
+
+    struct AnonymitySetEntry {
+        std::shared_ptr<const std::vector<sigma::PublicCoin>> coins;
+        uint64_t nLastUsed;
+    };
+
+    std::unordered_map<AnonymitySetKey, AnonymitySetEntry, anonymitysethash> anonymitySets;
+    uint64_t nAnonymitySetUses;
+
+    // Forget cached sets ending at given block
+    void EraseAnonymitySets(const uint256 &blockHash);
+
     struct Containers {
         Containers(std::atomic<bool> & surgeCondition);
 
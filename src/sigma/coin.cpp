@@ -279,7 +279,7 @@ void PrivateCoin::mintCoin(const CoinDenomination denomination){
 
     randomness.randomize();
     GroupElement commit = SigmaPrimitives<Scalar, GroupElement>::commit(
-            params->get_g(), serialNumber, params->get_h0(), randomness);
+            params->get_tables().g, serialNumber, params->get_tables().h[0], randomness);
     publicCoin = PublicCoin(commit, denomination);
 }
 
@@ -26,9 +26,10 @@ CoinSpend::CoinSpend(
         params->get_g(),
         params->get_h(),
         params->get_n(),
-        params->get_m());
+        params->get_m(),
+        &params->get_tables());
     //compute inverse of g^s
-    GroupElement gs = (params->get_g() * coinSerialNumber).inverse();
+    GroupElement gs = params->get_tables().g.multiply(coinSerialNumber).inverse();
     std::vector<GroupElement> C_;
     C_.reserve(anonymity_set.size());
     std::size_t coinIndex;
@@ -51,6 +52,25 @@ CoinSpend::CoinSpend(
     updateMetaData(coin, m);
 }
 
+CoinSpend::CoinSpend(const Params* p, const PrivateCoin& coin, const SpendMetaData& m)
+    :
+    params(p),
+    denomination(coin.getPublicCoin().getDenomination()),
+    accumulatorBlockHash(m.blockHash),
+    coinSerialNumber(coin.getSerialNumber()),
+    ecdsaSignature(64, 0),
+    ecdsaPubkey(33, 0),
+    sigmaProof(p->get_n(), p->get_m())
+{
+    // the proof elements have fixed sizes, only their counts have to match
+    sigmaProof.r1Proof_.f_.resize(p->get_m() * (p->get_n() - 1));
+    sigmaProof.Gk_.resize(p->get_m());
+}
+
+CoinSpend CoinSpend::CreateDummy(const Params* p, const PrivateCoin& coin, const SpendMetaData& m) {
+    return CoinSpend(p, coin, m);
+}
+
 void CoinSpend::updateMetaData(const PrivateCoin& coin, const SpendMetaData& m){
     // Proves that the coin is correct w.r.t. serial number and hidden coin secret
     // (This proof is bound to the coin 'metadata', i.e., transaction hash)
@@ -101,14 +121,23 @@ bool CoinSpend::Verify(
         const std::vector<sigma::PublicCoin>& anonymity_set,
         const SpendMetaData& m,
         bool fPadding) const {
-    SigmaPlusVerifier<Scalar, GroupElement> sigmaVerifier(params->get_g(), params->get_h(), params->get_n(), params->get_m());
+    if (!VerifySignature(m))
+        return false;
+
+    SigmaPlusVerifier<Scalar, GroupElement> sigmaVerifier(
+        params->get_g(), params->get_h(), params->get_n(), params->get_m(), &params->get_tables());
     //compute inverse of g^s
-    GroupElement gs = (params->get_g() * coinSerialNumber).inverse();
+    GroupElement gs = params->get_tables().g.multiply(coinSerialNumber).inverse();
     std::vector<GroupElement> C_;
     C_.reserve(anonymity_set.size());
     for(std::size_t j = 0; j < anonymity_set.size(); ++j)
         C_.emplace_back(anonymity_set[j].getValue() + gs);
 
+    // Now verify the sigma proof itself.
+    return sigmaVerifier.verify(C_, sigmaProof, fPadding);
+}
+
+bool CoinSpend::VerifySignature(const SpendMetaData& m) const {
     uint256 metahash = signatureHash(m);
 
     // Verify ecdsa_signature, to make sure someone did not change the output of transaction.
@@ -144,8 +173,7 @@ bool CoinSpend::Verify(
         return false;
     }
 
-    // Now verify the sigma proof itself.
-    return sigmaVerifier.verify(C_, sigmaProof, fPadding);
+    return true;
 }
 
 const Scalar& CoinSpend::getCoinSerialNumber() {
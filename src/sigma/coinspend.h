@@ -28,6 +28,9 @@ public:
               const SpendMetaData& m,
               bool fPadding);
 
+    // Creates a spend of the same serialized size as a real one but with an empty proof, for fee estimation.
+    static CoinSpend CreateDummy(const Params* p, const PrivateCoin& coin, const SpendMetaData& m);
+
     void updateMetaData(const PrivateCoin& coin, const SpendMetaData& m);
 
     const Scalar& getCoinSerialNumber();
@@ -52,6 +55,13 @@ public:
 
     bool Verify(const std::vector<sigma::PublicCoin>& anonymity_set, const SpendMetaData &m, bool fPadding) const;
 
+    // Checks the serial number and the ecdsa signature only, the sigma proof is left to the caller.
+    bool VerifySignature(const SpendMetaData &m) const;
+
+    const SigmaPlusProof<Scalar, GroupElement>& getProof() const {
+        return sigmaProof;
+    }
+
     ADD_SERIALIZE_METHODS;
     template <typename Stream, typename Operation>
     void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion) {
@@ -74,6 +84,9 @@ public:
 
     uint256 signatureHash(const SpendMetaData& m) const;
 
+private:
+    CoinSpend(const Params* p, const PrivateCoin& coin, const SpendMetaData& m);
+
 private:
     const Params* params;
     unsigned int version = 0;
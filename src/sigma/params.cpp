@@ -47,6 +47,8 @@ Params::Params(const GroupElement& g, int n, int m) :
         h_[i - 1].sha256(buff);
         h_[i].generate(buff);
     }
+
+    tables_.reset(new GeneratorTables(g_, h_));
 }
 
 Params::~Params(){
@@ -64,6 +66,10 @@ const std::vector<GroupElement>& Params::get_h() const{
     return h_;
 }
 
+const GeneratorTables& Params::get_tables() const{
+    return *tables_;
+}
+
 uint64_t Params::get_n() const{
     return n_;
 }
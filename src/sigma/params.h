@@ -3,6 +3,9 @@
 #include <secp256k1/include/Scalar.h>
 #include <secp256k1/include/GroupElement.h>
 #include <serialize.h>
+#include "sigma_primitives.h"
+
+#include <memory>
 
 using namespace secp_primitives;
 
@@ -14,6 +17,8 @@ public:
     const GroupElement& get_g() const;
     const GroupElement& get_h0() const;
     const std::vector<GroupElement>& get_h() const;
+    // Precomputed tables of g and h for commitments and proofs
+    const GeneratorTables& get_tables() const;
     uint64_t get_n() const;
     uint64_t get_m() const;
 
@@ -25,6 +30,7 @@ private:
     static Params* instance;
     GroupElement g_;
     std::vector<GroupElement> h_;
+    std::unique_ptr<GeneratorTables> tables_;
     int m_;
     int n_;
 };
@@ -15,7 +15,8 @@ public:
                      const std::vector<Exponent>& b,
                      const Exponent& r,
                      int n,
-                     int m);
+                     int m,
+                     const GeneratorTables* tables = nullptr);
 
     // Returns commitment B.
     const GroupElement& get_B() const;
@@ -53,6 +54,9 @@ private:
     const GroupElement& g_;
     const std::vector<GroupElement>& h_;
 
+    // Precomputed tables of g_ and h_, may be null.
+    const GeneratorTables* tables_;
+
     // n*m values of a matrix describing index l of the coin being spent.
     // Each value in this vector is a bit, I.E. 0 or 1.
     std::vector<Exponent> b_;
@@ -1,6 +1,9 @@
 #ifndef ZCOIN_SIGMA_R1_PROOF_VERIFIER_H
 #define ZCOIN_SIGMA_R1_PROOF_VERIFIER_H
 
+#include "r1_proof.h"
+#include "sigma_primitives.h"
+
 namespace sigma {
 
 template <class Exponent, class GroupElement>
@@ -9,7 +12,8 @@ class R1ProofVerifier {
 public:
     R1ProofVerifier(const GroupElement& g,
             const std::vector<GroupElement>& h_gens,
-            const GroupElement& B, int n , int m);
+            const GroupElement& B, int n , int m,
+            const GeneratorTables* tables = nullptr);
 
     bool verify(const R1Proof<Exponent, GroupElement>& proof,
                 bool skip_final_response_verification = false) const;
@@ -26,6 +30,8 @@ public:
 private:
     const GroupElement& g_;
     const std::vector<GroupElement>& h_;
+    // Precomputed tables of g_ and h_, may be null.
+    const GeneratorTables* tables_;
     GroupElement B_Commit;
     int n_;
     int m_;
@@ -6,9 +6,11 @@ R1ProofVerifier<Exponent,GroupElement>::R1ProofVerifier(
         const std::vector<GroupElement>& h_gens,
         const GroupElement& B,
         int n ,
-        int m)
+        int m,
+        const GeneratorTables* tables)
     : g_(g)
     , h_(h_gens)
+    , tables_(tables)
     , B_Commit(B)
     , n_(n)
     , m_(m){
@@ -84,7 +86,7 @@ bool R1ProofVerifier<Exponent,GroupElement>::verify_final_response(
     }
 
     GroupElement one;
-    SigmaPrimitives<Exponent, GroupElement>::commit(g_, h_, f_out, proof.ZA_, one);
+    SigmaPrimitives<Exponent, GroupElement>::commit(g_, h_, f_out, proof.ZA_, tables_, one);
     if((B_Commit * challenge_x + proof.A_) != one)
         return false;
 
@@ -95,7 +97,7 @@ bool R1ProofVerifier<Exponent,GroupElement>::verify_final_response(
     }
 
     GroupElement two;
-    SigmaPrimitives<Exponent, GroupElement>::commit(g_, h_, f_outprime, proof.ZC_, two);
+    SigmaPrimitives<Exponent, GroupElement>::commit(g_, h_, f_outprime, proof.ZC_, tables_, two);
     if ((proof.C_ * challenge_x + proof.D_) != two)
         return false;
 
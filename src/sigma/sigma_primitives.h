@@ -2,6 +2,7 @@
 #define ZCOIN_SIGMA_SIGMA_PRIMITIVES_H
 
 #include "../secp256k1/include/MultiExponent.h"
+#include "../secp256k1/include/FixedBaseTable.h"
 #include "../secp256k1/include/GroupElement.h"
 #include "../secp256k1/include/Scalar.h"
 
@@ -10,6 +11,25 @@
 
 namespace sigma {
 
+// Precomputed fixed-base tables of the commitment generators g and h. g and h[0] are multiplied alone
+// by every commitment and get the larger tables.
+struct GeneratorTables {
+    GeneratorTables(const secp_primitives::GroupElement& g_gen,
+                    const std::vector<secp_primitives::GroupElement>& h_gens)
+        : g(g_gen, secp_primitives::FixedBaseTable::max_window) {
+        h.reserve(h_gens.size());
+        for (std::size_t i = 0; i < h_gens.size(); ++i) {
+            unsigned int window = i == 0
+                ? secp_primitives::FixedBaseTable::max_window
+                : secp_primitives::FixedBaseTable::default_window;
+            h.emplace_back(h_gens[i], window);
+        }
+    }
+
+    secp_primitives::FixedBaseTable g;
+    std::vector<secp_primitives::FixedBaseTable> h;
+};
+
 template<class Exponent, class GroupElement>
 class SigmaPrimitives {
 
@@ -20,8 +40,22 @@ public:
             const Exponent& r,
             GroupElement& result_out);
 
+    // Same as above, but uses the precomputed tables of g and h if given.
+    static void commit(const GroupElement& g,
+            const std::vector<GroupElement>& h,
+            const std::vector<Exponent>& exp,
+            const Exponent& r,
+            const GeneratorTables* tables,
+            GroupElement& result_out);
+
     static GroupElement commit(const GroupElement& g, const Exponent m, const GroupElement h, const Exponent r);
 
+    static GroupElement commit(
+            const secp_primitives::FixedBaseTable& g,
+            const Exponent& m,
+            const secp_primitives::FixedBaseTable& h,
+            const Exponent& r);
+
     static void convert_to_sigma(uint64_t num, uint64_t n, uint64_t m, std::vector<Exponent>& out);
 
     static std::vector<uint64_t> convert_to_nal(uint64_t num, uint64_t n, uint64_t m);
@@ -12,6 +12,20 @@ void SigmaPrimitives<Exponent, GroupElement>::commit(const GroupElement& g,
     result_out += g * r + mult.get_multiple();
 }
 
+template<class Exponent, class GroupElement>
+void SigmaPrimitives<Exponent, GroupElement>::commit(const GroupElement& g,
+        const std::vector<GroupElement>& h,
+        const std::vector<Exponent>& exp,
+        const Exponent& r,
+        const GeneratorTables* tables,
+        GroupElement& result_out) {
+    if (tables == nullptr) {
+        commit(g, h, exp, r, result_out);
+        return;
+    }
+    result_out += tables->g.multiply(r) + secp_primitives::FixedBaseTable::multi_multiply(tables->h, exp);
+}
+
 template<class Exponent, class GroupElement>
 GroupElement SigmaPrimitives<Exponent, GroupElement>::commit(
         const GroupElement& g,
@@ -21,6 +35,15 @@ GroupElement SigmaPrimitives<Exponent, GroupElement>::commit(
     return g * m + h * r;
 }
 
+template<class Exponent, class GroupElement>
+GroupElement SigmaPrimitives<Exponent, GroupElement>::commit(
+        const secp_primitives::FixedBaseTable& g,
+        const Exponent& m,
+        const secp_primitives::FixedBaseTable& h,
+        const Exponent& r) {
+    return g.multiply(m) + h.multiply(r);
+}
+
 template<class Exponent, class GroupElement>
 void SigmaPrimitives<Exponent, GroupElement>::convert_to_sigma(
         uint64_t num,
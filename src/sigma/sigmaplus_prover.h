@@ -13,7 +13,8 @@ class SigmaPlusProver{
 
 public:
     SigmaPlusProver(const GroupElement& g,
-                    const std::vector<GroupElement>& h_gens, int n, int m);
+                    const std::vector<GroupElement>& h_gens, int n, int m,
+                    const GeneratorTables* tables = nullptr);
     void proof(const std::vector<GroupElement>& commits,
                std::size_t l,
                const Exponent& r,
@@ -23,6 +24,8 @@ public:
 private:
     GroupElement g_;
     std::vector<GroupElement> h_;
+    // Precomputed tables of g_ and h_, may be null.
+    const GeneratorTables* tables_;
     int n_;
     int m_;
 };
@@ -6,9 +6,11 @@ SigmaPlusProver<Exponent, GroupElement>::SigmaPlusProver(
         const GroupElement& g,
         const std::vector<GroupElement>& h_gens,
         int n,
-        int m)
+        int m,
+        const GeneratorTables* tables)
     : g_(g)
     , h_(h_gens)
+    , tables_(tables)
     , n_(n)
     , m_(m) {
 }
@@ -36,7 +38,7 @@ void SigmaPlusProver<Exponent, GroupElement>::proof(
     for (int k = 0; k < m_; ++k) {
         Pk[k].randomize();
     }
-    R1ProofGenerator<secp_primitives::Scalar, secp_primitives::GroupElement> r1prover(g_, h_, sigma, rB, n_, m_);
+    R1ProofGenerator<secp_primitives::Scalar, secp_primitives::GroupElement> r1prover(g_, h_, sigma, rB, n_, m_, tables_);
     proof_out.B_ = r1prover.get_B();
     std::vector<Exponent> a;
     r1prover.proof(a, proof_out.r1Proof_, true /*Skip generation of final response*/);
@@ -119,7 +121,7 @@ void SigmaPlusProver<Exponent, GroupElement>::proof(
         }
         secp_primitives::MultiExponent mult(commits, P_i);
         GroupElement c_k = mult.get_multiple();
-        c_k += SigmaPrimitives<Exponent, GroupElement>::commit(g_, Exponent(uint64_t(0)), h_[0], Pk[k]);
+        c_k += tables_ ? tables_->h[0].multiply(Pk[k]) : h_[0] * Pk[k];
         Gk.emplace_back(c_k);
     }
     proof_out.Gk_ = Gk;
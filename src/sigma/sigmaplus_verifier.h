@@ -11,15 +11,41 @@ class SigmaPlusVerifier{
 public:
     SigmaPlusVerifier(const GroupElement& g,
                       const std::vector<GroupElement>& h_gens,
-                      int n, int m_);
+                      int n, int m_,
+                      const GeneratorTables* tables = nullptr);
 
     bool verify(const std::vector<GroupElement>& commits,
                 const SigmaPlusProof<Exponent, GroupElement>& proof,
                 bool fPadding) const;
 
+    /** \brief Verifies a batch of proofs over the same anonymity set with a single multi-exponentiation.
+     *  \param[in] commits Anonymity set as stored in the chain, without the serial number offset applied.
+     *  \param[in] serials Serial number of every proof, commitments of proof t are commits[i] - g^serials[t].
+     *  \param[in] fPadding Padding flag of every proof.
+     *  \param[in] setSizes Proof t is over the last setSizes[t] elements of commits.
+     *  \param[in] proofs Proofs to verify.
+     *  \return false if at least one of the proofs is invalid.
+     */
+    bool batch_verify(const std::vector<GroupElement>& commits,
+                      const std::vector<Exponent>& serials,
+                      const std::vector<bool>& fPadding,
+                      const std::vector<std::size_t>& setSizes,
+                      const std::vector<SigmaPlusProof<Exponent, GroupElement>>& proofs) const;
+
 private:
+    // Runs all the checks of a single proof except the final multi-exponentiation and computes
+    // the challenge and the exponents for the N commitments used in it.
+    bool compute_fis(const SigmaPlusProof<Exponent, GroupElement>& proof,
+                     std::size_t N,
+                     bool fPadding,
+                     Exponent& challenge_x,
+                     std::vector<Exponent>& f_i_) const;
+
+
     GroupElement g_;
     std::vector<GroupElement> h_;
+    // Precomputed tables of g_ and h_, may be null.
+    const GeneratorTables* tables_;
     int n;
     int m;
 };
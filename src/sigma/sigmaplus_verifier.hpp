@@ -5,9 +5,11 @@ SigmaPlusVerifier<Exponent, GroupElement>::SigmaPlusVerifier(
         const GroupElement& g,
         const std::vector<GroupElement>& h_gens,
         int n,
-        int m)
+        int m,
+        const GeneratorTables* tables)
     : g_(g)
     , h_(h_gens)
+    , tables_(tables)
     , n(n)
     , m(m){
 }
@@ -18,7 +20,132 @@ bool SigmaPlusVerifier<Exponent, GroupElement>::verify(
         const SigmaPlusProof<Exponent, GroupElement>& proof,
         bool fPadding) const {
 
-    R1ProofVerifier<Exponent, GroupElement> r1ProofVerifier(g_, h_, proof.B_, n, m);
+    Exponent challenge_x;
+    std::vector<Exponent> f_i_;
+    if (!compute_fis(proof, commits.size(), fPadding, challenge_x, f_i_))
+        return false;
+
+    secp_primitives::MultiExponent mult(commits, f_i_);
+    GroupElement t1 = mult.get_multiple();
+
+    const std::vector <GroupElement>& Gk = proof.Gk_;
+    GroupElement t2;
+    Exponent x_k(uint64_t(1));
+    for(int k = 0; k < m; ++k){
+        t2 += (Gk[k] * (x_k.negate()));
+        x_k *= challenge_x;
+    }
+
+    GroupElement left(t1 + t2);
+    GroupElement right = tables_ ? tables_->h[0].multiply(proof.z_) : h_[0] * proof.z_;
+    if (left != right) {
+        LogPrintf("Sigma spend failed due to final proof verification failure.");
+        return false;
+    }
+
+    return true;
+}
+
+template<class Exponent, class GroupElement>
+bool SigmaPlusVerifier<Exponent, GroupElement>::batch_verify(
+        const std::vector<GroupElement>& commits,
+        const std::vector<Exponent>& serials,
+        const std::vector<bool>& fPadding,
+        const std::vector<std::size_t>& setSizes,
+        const std::vector<SigmaPlusProof<Exponent, GroupElement>>& proofs) const {
+
+    std::size_t M = proofs.size();
+    std::size_t N = commits.size();
+    if (serials.size() != M || fPadding.size() != M || setSizes.size() != M) {
+        LogPrintf("Sigma batch verification failed due to inconsistent input sizes.");
+        return false;
+    }
+
+    if (M == 0)
+        return true;
+
+    /*
+     * Every proof t is valid iff
+     *
+     *   \sum_i f_{t,i} (C_i - g^{s_t}) - \sum_k x_t^k G_{t,k} - h_0^{z_t} = 0
+     *
+     * Multiplying each of these equations by a random weight y_t and summing them up leaves a single
+     * multi-exponentiation where the anonymity set, g and h_0 are shared by all proofs. If the sum is zero
+     * all the proofs are valid, except with negligible probability.
+     */
+    std::vector<Exponent> f_i_(N, Exponent(uint64_t(0)));
+    Exponent g_exp(uint64_t(0));
+    Exponent h0_exp(uint64_t(0));
+
+    std::vector<GroupElement> Gk_points;
+    std::vector<Exponent> Gk_exps;
+    Gk_points.reserve(M * m);
+    Gk_exps.reserve(M * m);
+
+    for (std::size_t t = 0; t < M; ++t) {
+        if (setSizes[t] > N) {
+            LogPrintf("Sigma batch verification failed due to anonymity set size out of range.");
+            return false;
+        }
+
+        Exponent challenge_x;
+        std::vector<Exponent> f_t;
+        if (!compute_fis(proofs[t], setSizes[t], fPadding[t], challenge_x, f_t))
+            return false;
+
+        Exponent y;
+        y.randomize();
+
+        std::size_t start = N - setSizes[t];
+        Exponent f_sum(uint64_t(0));
+        for (std::size_t i = 0; i < setSizes[t]; ++i) {
+            f_i_[start + i] += f_t[i] * y;
+            f_sum += f_t[i];
+        }
+
+        g_exp -= f_sum * serials[t] * y;
+        h0_exp -= proofs[t].z_ * y;
+
+        Exponent x_k(uint64_t(1));
+        for (int k = 0; k < m; ++k) {
+            Gk_points.emplace_back(proofs[t].Gk_[k]);
+            Gk_exps.emplace_back(x_k.negate() * y);
+            x_k *= challenge_x;
+        }
+    }
+
+    std::vector<GroupElement> points;
+    std::vector<Exponent> exps;
+    points.reserve(N + 2 + Gk_points.size());
+    exps.reserve(N + 2 + Gk_exps.size());
+
+    points.insert(points.end(), commits.begin(), commits.end());
+    exps.insert(exps.end(), f_i_.begin(), f_i_.end());
+    points.emplace_back(g_);
+    exps.emplace_back(g_exp);
+    points.emplace_back(h_[0]);
+    exps.emplace_back(h0_exp);
+    points.insert(points.end(), Gk_points.begin(), Gk_points.end());
+    exps.insert(exps.end(), Gk_exps.begin(), Gk_exps.end());
+
+    secp_primitives::MultiExponent mult(points, exps);
+    if (!mult.get_multiple().isInfinity()) {
+        LogPrintf("Sigma batch verification failed due to final proof verification failure.");
+        return false;
+    }
+
+    return true;
+}
+
+template<class Exponent, class GroupElement>
+bool SigmaPlusVerifier<Exponent, GroupElement>::compute_fis(
+        const SigmaPlusProof<Exponent, GroupElement>& proof,
+        std::size_t N,
+        bool fPadding,
+        Exponent& challenge_x,
+        std::vector<Exponent>& f_i_) const {
+
+    R1ProofVerifier<Exponent, GroupElement> r1ProofVerifier(g_, h_, proof.B_, n, m, tables_);
     std::vector<Exponent> f;
     const R1Proof<Exponent, GroupElement>& r1Proof = proof.r1Proof_;
     if (!r1ProofVerifier.verify(r1Proof, f, true /* Skip verification of final response */)) {
@@ -44,7 +171,6 @@ bool SigmaPlusVerifier<Exponent, GroupElement>::verify(
         r1Proof.A_, proof.B_, r1Proof.C_, r1Proof.D_};
 
     group_elements.insert(group_elements.end(), Gk.begin(), Gk.end());
-    Exponent challenge_x;
     SigmaPrimitives<Exponent, GroupElement>::generate_challenge(group_elements, challenge_x);
 
     // Now verify the final response of r1 proof. Values of "f" are finalized only after this call.
@@ -58,13 +184,12 @@ bool SigmaPlusVerifier<Exponent, GroupElement>::verify(
         return false;
     }
 
-    if (commits.empty()) {
+    if (N == 0) {
         LogPrintf("No mints in the anonymity set");
         return false;
     }
 
-    std::size_t N = commits.size();
-    std::vector<Exponent> f_i_;
+    f_i_.clear();
     f_i_.reserve(N);
 
     // if fPadding is true last index is special
@@ -112,22 +237,6 @@ bool SigmaPlusVerifier<Exponent, GroupElement>::verify(
         f_i_.emplace_back(pow);
     }
 
-    secp_primitives::MultiExponent mult(commits, f_i_);
-    GroupElement t1 = mult.get_multiple();
-
-    GroupElement t2;
-    Exponent x_k(uint64_t(1));
-    for(int k = 0; k < m; ++k){
-        t2 += (Gk[k] * (x_k.negate()));
-        x_k *= challenge_x;
-    }
-
-    GroupElement left(t1 + t2);
-    if (left != SigmaPrimitives<Exponent, GroupElement>::commit(g_, Exponent(uint64_t(0)), h_[0], proof.z_)) {
-        LogPrintf("Sigma spend failed due to final proof verification failure.");
-        return false;
-    }
-
     return true;
 }
 
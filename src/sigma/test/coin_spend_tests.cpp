@@ -190,4 +190,29 @@ BOOST_AUTO_TEST_CASE(verify_test_with_accumulatorBlockHash)
     BOOST_CHECK(spend_coin.Verify(anonymity_set, metaData, true));
 }
 
+BOOST_AUTO_TEST_CASE(dummy_spend_test)
+{
+    auto params = sigma::Params::get_default();
+
+    const sigma::PrivateCoin privcoin(params, sigma::CoinDenomination::SIGMA_DENOM_1);
+    sigma::PublicCoin pubcoin;
+    pubcoin = privcoin.getPublicCoin();
+
+    std::vector<sigma::PublicCoin> anonymity_set;
+    anonymity_set.push_back(pubcoin);
+
+    sigma::SpendMetaData metaData(0, uint256S("120"), uint256S("120"));
+
+    sigma::CoinSpend spend_coin(params, privcoin, anonymity_set, metaData, true);
+    sigma::CoinSpend dummy_coin = sigma::CoinSpend::CreateDummy(params, privcoin, metaData);
+
+    // a dummy spend has the size of a real one but doesn't prove anything
+    CDataStream serialized(SER_NETWORK, PROTOCOL_VERSION), dummy_serialized(SER_NETWORK, PROTOCOL_VERSION);
+    serialized << spend_coin;
+    dummy_serialized << dummy_coin;
+
+    BOOST_CHECK_EQUAL(serialized.size(), dummy_serialized.size());
+    BOOST_CHECK(!dummy_coin.Verify(anonymity_set, metaData, true));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
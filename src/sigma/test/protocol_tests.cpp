@@ -209,4 +209,108 @@ BOOST_AUTO_TEST_CASE(prove_coin_not_in_set)
     BOOST_CHECK(!verifier.verify(commits, proof, true));
 }
 
+BOOST_AUTO_TEST_CASE(batch_verify)
+{
+    auto params = sigma::Params::get_default();
+    int N = 10000;
+    int n = params->get_n();
+    int m = params->get_m();
+
+    secp_primitives::GroupElement g;
+    g.randomize();
+    std::vector<secp_primitives::GroupElement> h_gens;
+    h_gens.resize(n * m);
+    for(int i = 0; i < n * m; ++i ){
+        h_gens[i].randomize();
+    }
+    sigma::SigmaPlusProver<secp_primitives::Scalar,secp_primitives::GroupElement> prover(g,h_gens, n, m);
+
+    std::vector<secp_primitives::GroupElement> commits;
+    for(int i = 0; i < N; ++i){
+        commits.push_back(secp_primitives::GroupElement());
+        commits[i].randomize();
+    }
+
+    // Every proof is made over the tail of the set with its own serial, as the spends of a block are
+    std::vector<std::size_t> setSizes = {10000, 5000, 100};
+    std::vector<std::size_t> indexes = {100, 2000, 99};
+    std::vector<bool> fPadding = {true, true, true};
+    std::vector<secp_primitives::Scalar> serials, randomness;
+    for (std::size_t t = 0; t < setSizes.size(); ++t) {
+        secp_primitives::Scalar s, r;
+        s.randomize();
+        r.randomize();
+        serials.push_back(s);
+        randomness.push_back(r);
+        commits[N - setSizes[t] + indexes[t]] =
+            sigma::SigmaPrimitives<secp_primitives::Scalar,secp_primitives::GroupElement>::commit(g, s, h_gens[0], r);
+    }
+
+    std::vector<sigma::SigmaPlusProof<secp_primitives::Scalar,secp_primitives::GroupElement>> proofs;
+    for (std::size_t t = 0; t < setSizes.size(); ++t) {
+        secp_primitives::GroupElement gs = (g * serials[t]).inverse();
+        std::vector<secp_primitives::GroupElement> C_;
+        for (std::size_t i = N - setSizes[t]; i < commits.size(); ++i)
+            C_.push_back(commits[i] + gs);
+
+        sigma::SigmaPlusProof<secp_primitives::Scalar,secp_primitives::GroupElement> proof(n, m);
+        prover.proof(C_, indexes[t], randomness[t], fPadding[t], proof);
+        proofs.push_back(proof);
+    }
+
+    sigma::SigmaPlusVerifier<secp_primitives::Scalar,secp_primitives::GroupElement> verifier(g, h_gens, n, m);
+    BOOST_CHECK(verifier.batch_verify(commits, serials, fPadding, setSizes, proofs));
+
+    // Wrong serial of a single proof breaks the whole batch
+    std::vector<secp_primitives::Scalar> wrongSerials(serials);
+    wrongSerials[1].randomize();
+    BOOST_CHECK(!verifier.batch_verify(commits, wrongSerials, fPadding, setSizes, proofs));
+
+    // So does the proof verified against a wrong part of the set
+    std::vector<std::size_t> wrongSetSizes(setSizes);
+    wrongSetSizes[1] = 5001;
+    BOOST_CHECK(!verifier.batch_verify(commits, serials, fPadding, wrongSetSizes, proofs));
+}
+
+BOOST_AUTO_TEST_CASE(prove_and_verify_with_tables)
+{
+    auto params = sigma::Params::get_default();
+    int N = 100;
+    int n = params->get_n();
+    int m = params->get_m();
+    int index = 42;
+
+    const secp_primitives::GroupElement& g = params->get_g();
+    const std::vector<secp_primitives::GroupElement>& h_gens = params->get_h();
+    const sigma::GeneratorTables& tables = params->get_tables();
+
+    secp_primitives::Scalar r;
+    r.randomize();
+    std::vector<secp_primitives::GroupElement> commits;
+    for(int i = 0; i < N; ++i){
+        commits.push_back(secp_primitives::GroupElement());
+        commits[i].randomize();
+    }
+    commits[index] = tables.h[0].multiply(r);
+    BOOST_CHECK(commits[index] == h_gens[0] * r);
+
+    // Proofs made with and without the tables are interchangeable
+    sigma::SigmaPlusProver<secp_primitives::Scalar,secp_primitives::GroupElement> prover(g, h_gens, n, m);
+    sigma::SigmaPlusProver<secp_primitives::Scalar,secp_primitives::GroupElement> tableProver(g, h_gens, n, m, &tables);
+    sigma::SigmaPlusVerifier<secp_primitives::Scalar,secp_primitives::GroupElement> verifier(g, h_gens, n, m);
+    sigma::SigmaPlusVerifier<secp_primitives::Scalar,secp_primitives::GroupElement> tableVerifier(g, h_gens, n, m, &tables);
+
+    sigma::SigmaPlusProof<secp_primitives::Scalar,secp_primitives::GroupElement> proof(n, m);
+    prover.proof(commits, index, r, false, proof);
+    BOOST_CHECK(tableVerifier.verify(commits, proof, false));
+
+    sigma::SigmaPlusProof<secp_primitives::Scalar,secp_primitives::GroupElement> tableProof(n, m);
+    tableProver.proof(commits, index, r, false, tableProof);
+    BOOST_CHECK(verifier.verify(commits, tableProof, false));
+    BOOST_CHECK(tableVerifier.verify(commits, tableProof, false));
+
+    commits[index].randomize();
+    BOOST_CHECK(!tableVerifier.verify(commits, tableProof, false));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
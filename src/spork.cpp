@@ -220,12 +220,17 @@ bool CSporkManager::SetPrivKey(std::string strPrivKey)
     }
 }
 
+std::string CSporkMessage::GetSignatureMessage() const
+{
+    return boost::lexical_cast<std::string>(nSporkID) + boost::lexical_cast<std::string>(nValue) + boost::lexical_cast<std::string>(nTimeSigned);
+}
+
 bool CSporkMessage::Sign(std::string strSignKey)
 {
     CKey key;
     CPubKey pubkey;
     std::string strError = "";
-    std::string strMessage = boost::lexical_cast<std::string>(nSporkID) + boost::lexical_cast<std::string>(nValue) + boost::lexical_cast<std::string>(nTimeSigned);
+    std::string strMessage = GetSignatureMessage();
 
     if(!darkSendSigner.GetKeysFromSecret(strSignKey, key, pubkey)) {
         LogPrintf("CSporkMessage::Sign -- GetKeysFromSecret() failed, invalid spork key %s\n", strSignKey);
@@ -249,7 +254,7 @@ bool CSporkMessage::CheckSignature()
 {
     //note: need to investigate why this is failing
     std::string strError = "";
-    std::string strMessage = boost::lexical_cast<std::string>(nSporkID) + boost::lexical_cast<std::string>(nValue) + boost::lexical_cast<std::string>(nTimeSigned);
+    std::string strMessage = GetSignatureMessage();
     CPubKey pubkey(ParseHex(Params().SporkPubKey()));
 
     if(!darkSendSigner.VerifyMessage(pubkey, vchSig, strMessage, strError)) {
@@ -92,6 +92,8 @@ public:
         return ss.GetHash();
     }
 
+    const std::vector<unsigned char>& GetSignature() const { return vchSig; }
+    std::string GetSignatureMessage() const;
     bool Sign(std::string strSignKey);
     bool CheckSignature();
     void Relay();
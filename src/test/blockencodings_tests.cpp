@@ -312,4 +312,30 @@ BOOST_AUTO_TEST_CASE(TransactionsRequestSerializationTest) {
     BOOST_CHECK_EQUAL(req1.indexes[3], req2.indexes[3]);
 }
 
+BOOST_AUTO_TEST_CASE(HeaderHashCacheTest)
+{
+    CBlock block(BuildBlockTestCase());
+    CBlockHeader header = block.GetBlockHeader();
+
+    uint256 hash = header.GetHash();
+    BOOST_CHECK(hash == header.GetPoWHash());
+    BOOST_CHECK(hash == block.GetHash());
+
+    // Header fields are modified in place, the cached hash must follow them
+    header.nNonce++;
+    BOOST_CHECK(header.GetHash() != hash);
+    BOOST_CHECK(header.GetHash() == header.GetPoWHash());
+
+    header.nTime++;
+    BOOST_CHECK(header.GetHash() == header.GetPoWHash());
+
+    header.nNonce--;
+    header.nTime--;
+    BOOST_CHECK(header.GetHash() == hash);
+
+    // Only the hashed bytes matter
+    header.vchBlockSig.assign(72, 0x42);
+    BOOST_CHECK(header.GetHash() == hash);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
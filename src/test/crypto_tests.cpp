@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "crypto/aes.h"
+#include "crypto/common.h"
 #include "crypto/ripemd160.h"
 #include "crypto/sha1.h"
 #include "crypto/sha256.h"
@@ -255,6 +256,29 @@ BOOST_AUTO_TEST_CASE(sha256_testvectors) {
     TestSHA256(test1, "a316d55510b49662420f49d145d42fb83f31ef8dc016aa4e32df049991a91e26");
 }
 
+BOOST_AUTO_TEST_CASE(sha256d_sweep) {
+    // prefix lengths around the block boundaries, 72 is a stake kernel
+    const size_t lengths[] = {1, 3, 51, 52, 60, 64, 72, 115, 116, 200};
+    for (size_t len : lengths) {
+        std::vector<unsigned char> prefix(len);
+        for (size_t i = 0; i < len; i++)
+            prefix[i] = insecure_rand();
+        std::vector<uint32_t> values(37);
+        for (uint32_t& value : values)
+            value = insecure_rand();
+
+        std::vector<unsigned char> out(values.size() * CSHA256DSweep::OUTPUT_SIZE);
+        CSHA256DSweep(prefix.data(), len).Finalize(values.data(), values.size(), out.data());
+        for (size_t i = 0; i < values.size(); i++) {
+            unsigned char value[4], hash[CSHA256::OUTPUT_SIZE];
+            WriteLE32(value, values[i]);
+            CSHA256().Write(prefix.data(), len).Write(value, 4).Finalize(hash);
+            CSHA256().Write(hash, sizeof(hash)).Finalize(hash);
+            BOOST_CHECK(std::equal(hash, hash + sizeof(hash), out.begin() + i * CSHA256DSweep::OUTPUT_SIZE));
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(sha512_testvectors) {
     TestSHA512("",
                "cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce"
@@ -0,0 +1,81 @@
+// Copyright (c) 2020 The ShroudX Project developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "darksend.h"
+
+#include "key.h"
+#include "pubkey.h"
+#include "tinyformat.h"
+
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+BOOST_FIXTURE_TEST_SUITE(darksend_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(recover_message_key_cache)
+{
+    CDarkSendSigner signer;
+
+    CKey key;
+    key.MakeNewKey(true);
+    CKey otherKey;
+    otherKey.MakeNewKey(true);
+
+    std::string strMessage = "shroudnode ping";
+    std::vector<unsigned char> vchSig;
+    BOOST_CHECK(signer.SignMessage(strMessage, vchSig, key));
+
+    std::string strError;
+    BOOST_CHECK(signer.VerifyMessage(key.GetPubKey(), vchSig, strMessage, strError));
+    BOOST_CHECK_EQUAL(signer.GetRecoveredKeysCount(), 1U);
+
+    // a second check of the same signature is served from the cache
+    CKeyID keyID;
+    BOOST_CHECK(signer.RecoverMessageKey(vchSig, strMessage, keyID));
+    BOOST_CHECK(keyID == key.GetPubKey().GetID());
+    BOOST_CHECK(signer.VerifyMessage(key.GetPubKey(), vchSig, strMessage, strError));
+    BOOST_CHECK_EQUAL(signer.GetRecoveredKeysCount(), 1U);
+
+    // a cached signature still fails against a different key
+    BOOST_CHECK(!signer.VerifyMessage(otherKey.GetPubKey(), vchSig, strMessage, strError));
+    BOOST_CHECK_EQUAL(signer.GetRecoveredKeysCount(), 1U);
+
+    // the same signature over another message is a different entry and recovers another key
+    BOOST_CHECK(signer.RecoverMessageKey(vchSig, strMessage + " ", keyID));
+    BOOST_CHECK(keyID != key.GetPubKey().GetID());
+    BOOST_CHECK_EQUAL(signer.GetRecoveredKeysCount(), 2U);
+}
+
+BOOST_AUTO_TEST_CASE(recover_message_key_cache_eviction)
+{
+    CDarkSendSigner signer;
+
+    CKey key;
+    key.MakeNewKey(true);
+
+    std::vector<unsigned char> vchFirstSig;
+    std::vector<unsigned char> vchSig;
+    for (size_t i = 0; i <= MAX_RECOVERED_MESSAGE_KEYS; i++) {
+        BOOST_REQUIRE(signer.SignMessage(strprintf("message %d", i), vchSig, key));
+        if (i == 0)
+            vchFirstSig = vchSig;
+
+        CKeyID keyID;
+        BOOST_REQUIRE(signer.RecoverMessageKey(vchSig, strprintf("message %d", i), keyID));
+        BOOST_REQUIRE(keyID == key.GetPubKey().GetID());
+        BOOST_REQUIRE_EQUAL(signer.GetRecoveredKeysCount(), std::min(i + 1, MAX_RECOVERED_MESSAGE_KEYS));
+    }
+
+    // the cache stays at its bound, a signature verifies whether or not it was evicted
+    std::string strError;
+    BOOST_CHECK(signer.VerifyMessage(key.GetPubKey(), vchFirstSig, "message 0", strError));
+    BOOST_CHECK(signer.VerifyMessage(key.GetPubKey(), vchSig, strprintf("message %d", MAX_RECOVERED_MESSAGE_KEYS), strError));
+    BOOST_CHECK_EQUAL(signer.GetRecoveredKeysCount(), MAX_RECOVERED_MESSAGE_KEYS);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,8 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "hash.h"
+#include "primitives/block.h"
+#include "random.h"
 #include "utilstrencodings.h"
 #include "test/test_bitcoin.h"
 
@@ -107,6 +109,13 @@ BOOST_AUTO_TEST_CASE(siphash)
 
     BOOST_CHECK_EQUAL(SipHashUint256(0x0706050403020100ULL, 0x0F0E0D0C0B0A0908ULL, uint256S("1f1e1d1c1b1a191817161514131211100f0e0d0c0b0a09080706050403020100")), 0x7127512f72f27cceull);
 
+    // the 36 bytes of an outpoint
+    static const unsigned char t5[4] = {32,33,34,35};
+    uint256 val = uint256S("1f1e1d1c1b1a191817161514131211100f0e0d0c0b0a09080706050403020100");
+    CSipHasher hasher4(0x0706050403020100ULL, 0x0F0E0D0C0B0A0908ULL);
+    hasher4.Write(val.begin(), 32).Write(t5, 4);
+    BOOST_CHECK_EQUAL(SipHashUint256Extra(0x0706050403020100ULL, 0x0F0E0D0C0B0A0908ULL, val, 0x23222120), hasher4.Finalize());
+
     // Check test vectors from spec, one byte at a time
     CSipHasher hasher2(0x0706050403020100ULL, 0x0F0E0D0C0B0A0908ULL);
     for (uint8_t x=0; x<ARRAYLEN(siphash_4_2_testvec); ++x)
@@ -128,4 +137,32 @@ BOOST_AUTO_TEST_CASE(siphash)
     BOOST_CHECK_EQUAL(SipHashUint256(1, 2, ss.GetHash()), 0x79751e980c2a0a35ULL);
 }
 
+BOOST_AUTO_TEST_CASE(x16rv2_batch)
+{
+    // 100 headers of a chain, every hashPrevBlock selects different algorithms, and 10 nonces of
+    // a header, which select the same ones
+    std::vector<CBlockHeader> headers(110);
+    for (size_t i = 0; i < headers.size(); i++) {
+        CBlockHeader& header = headers[i];
+        header.nVersion = 2;
+        header.hashPrevBlock = i < 100 ? GetRandHash() : headers[99].hashPrevBlock;
+        header.hashMerkleRoot = GetRandHash();
+        header.nTime = 1585000000 + i;
+        header.nBits = 0x1e0ffff0;
+        header.nNonce = i;
+    }
+
+    std::vector<const CBlockHeader*> pheaders;
+    for (const CBlockHeader& header : headers)
+        pheaders.push_back(&header);
+
+    // every batch size, so all of the lane counts of the vectorized functions get used
+    for (size_t count = 1; count <= pheaders.size(); count += count < 10 ? 1 : 50) {
+        std::vector<uint256> hashes(count);
+        GetPoWHashes(pheaders.data() + pheaders.size() - count, count, hashes.data());
+        for (size_t i = 0; i < count; i++)
+            BOOST_CHECK(hashes[i] == pheaders[pheaders.size() - count + i]->GetPoWHash());
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -355,4 +355,49 @@ BOOST_AUTO_TEST_CASE(blockchain_restore)
 
 }
 
+
+/*
+HDMint mint pool test
+- The mint pool is derived on several threads in chunks of 8 seeds
+- Verify each entry matches the mint derived from the same seed on its own
+*/
+BOOST_AUTO_TEST_CASE(mintpool_matches_serial_derivation)
+{
+    CWalletDB walletdb(pwalletMain->strWalletFile);
+
+    // the fixture generated the pool already
+    vector<std::pair<uint256, MintPoolEntry>> listMintPool = walletdb.ListMintPool();
+    std::vector<std::pair<uint256, GroupElement>> serialPubcoinPairs = walletdb.ListSerialPubcoinPairs();
+    int32_t nCountGenerated;
+    BOOST_REQUIRE(walletdb.ReadMintSeedCount(nCountGenerated));
+
+    // more than one chunk
+    BOOST_CHECK(listMintPool.size() > 8);
+    BOOST_CHECK_EQUAL(listMintPool.size(), serialPubcoinPairs.size());
+
+    std::set<int32_t> counts;
+    for (auto& mintPoolPair : listMintPool){
+        uint160 hashSeedMaster;
+        CKeyID seedId;
+        int32_t nCount;
+        std::tie(hashSeedMaster, seedId, nCount) = mintPoolPair.second;
+
+        CKeyID seedIdRegenerated;
+        std::pair<uint256, uint256> regenerated = zwalletMain->RegenerateMintPoolEntry(hashSeedMaster, seedIdRegenerated, nCount);
+        BOOST_CHECK(regenerated.first == mintPoolPair.first);
+        BOOST_CHECK(seedIdRegenerated == seedId);
+
+        uint256 hashSerial;
+        BOOST_CHECK(zwalletMain->GetSerialForPubcoin(serialPubcoinPairs, mintPoolPair.first, hashSerial));
+        BOOST_CHECK(hashSerial == regenerated.second);
+
+        counts.insert(nCount);
+    }
+
+    // one entry for each count up to the one generated next
+    BOOST_CHECK_EQUAL(counts.size(), listMintPool.size());
+    BOOST_CHECK_EQUAL(*counts.begin(), 0);
+    BOOST_CHECK_EQUAL(*counts.rbegin() + 1, nCountGenerated);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
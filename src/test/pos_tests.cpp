@@ -0,0 +1,93 @@
+// Copyright (c) 2020 The ShroudX Project developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "arith_uint256.h"
+#include "chain.h"
+#include "consensus/consensus.h"
+#include "pos.h"
+#include "test/test_bitcoin.h"
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(pos_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(stake_cache_kernel)
+{
+    const int nLength = COINBASE_MATURITY * 2;
+    std::vector<uint256> vHash(nLength);
+    std::vector<CBlockIndex> vIndex(nLength);
+    for (int i = 0; i < nLength; i++) {
+        vHash[i] = ArithToUint256(i + 1);
+        vIndex[i].nHeight = i;
+        vIndex[i].nTime = 1500000000 + i * 60;
+        vIndex[i].nStakeModifier = ArithToUint256(i * 7 + 3);
+        vIndex[i].pprev = i ? &vIndex[i - 1] : NULL;
+        vIndex[i].phashBlock = &vHash[i];
+        vIndex[i].BuildSkip();
+    }
+    CBlockIndex* pindexPrev = &vIndex[nLength - 1];
+    uint32_t nTime = pindexPrev->GetBlockTime() + 60;
+    int64_t nBlockTime;
+
+    COutPoint prevoutMature(ArithToUint256(1000), 1);
+    COutPoint prevoutImmature(ArithToUint256(1001), 0);
+    COutPoint prevoutStale(ArithToUint256(1002), 0);
+    std::map<COutPoint, CStakeCache> cache;
+    cache.insert(std::make_pair(prevoutMature, CStakeCache(vHash[10], 10, 1000 * COIN)));
+    cache.insert(std::make_pair(prevoutImmature, CStakeCache(vHash[nLength - 10], nLength - 10, 1000 * COIN)));
+    // block of the entry is not on the chain of pindexPrev any more
+    cache.insert(std::make_pair(prevoutStale, CStakeCache(ArithToUint256(5000), 10, 1000 * COIN)));
+
+    // cached kernels give the same answers as the kernel hash itself, about one timestamp in 20 is a hit
+    unsigned int nBits = 0x1b7fffff;
+    uint32_t nTimeHit = 0;
+    for (uint32_t n = 0; n < 1024; n++) {
+        bool fKernel = CheckStakeKernelHash(pindexPrev, nBits, pindexPrev->GetBlockTime(), 1000 * COIN, prevoutMature, nTime + n);
+        BOOST_CHECK_EQUAL(CheckKernel(pindexPrev, nBits, nTime + n, prevoutMature, cache, &nBlockTime), fKernel);
+        BOOST_CHECK_EQUAL(nBlockTime, pindexPrev->GetBlockTime());
+        if (fKernel && !nTimeHit)
+            nTimeHit = nTime + n;
+    }
+    BOOST_REQUIRE(nTimeHit != 0);
+
+    BOOST_CHECK(!CheckKernel(pindexPrev, nBits, nBlockTime - 1, prevoutMature, cache, &nBlockTime));
+    BOOST_CHECK(!CheckKernel(pindexPrev, nBits, nTimeHit, prevoutImmature, cache, &nBlockTime));
+    // stale entries fall back to the transaction index, which doesn't know this one
+    BOOST_CHECK(!CheckKernel(pindexPrev, nBits, nTimeHit, prevoutStale, cache, &nBlockTime));
+}
+
+BOOST_AUTO_TEST_CASE(stake_kernel_search)
+{
+    CBlockIndex index;
+    uint256 hash = ArithToUint256(42);
+    index.phashBlock = &hash;
+    index.nHeight = Params().GetConsensus().nFirstPOSBlock + 1;
+    index.nTime = 1500000000;
+    index.nStakeModifier = ArithToUint256(0x1234567);
+    COutPoint prevout(ArithToUint256(1000), 3);
+    unsigned int nBits = 0x1b7fffff;
+    unsigned int nBlockTime = index.GetBlockTime();
+
+    // the first hit searching down from every start time, including windows that reach below nBlockTime
+    for (uint32_t nStart = nBlockTime - 10; nStart < nBlockTime + 400; nStart += 7) {
+        for (unsigned int nCount : {1u, 8u, 60u, 130u}) {
+            bool fExpected = false;
+            uint32_t nTimeExpected = 0;
+            for (unsigned int n = 0; n < nCount && !fExpected; n++) {
+                if (CheckStakeKernelHash(&index, nBits, nBlockTime, 1000 * COIN, prevout, nStart - n)) {
+                    fExpected = true;
+                    nTimeExpected = nStart - n;
+                }
+            }
+            uint32_t nTimeTx = nStart;
+            BOOST_CHECK_EQUAL(SearchStakeKernelHash(&index, nBits, nBlockTime, 1000 * COIN, prevout, nTimeTx, nCount), fExpected);
+            if (fExpected)
+                BOOST_CHECK_EQUAL(nTimeTx, nTimeExpected);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
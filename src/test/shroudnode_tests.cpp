@@ -11,6 +11,7 @@
 #include <stdint.h>
 #include <vector>
 
+#include "arith_uint256.h"
 #include "chainparams.h"
 #include "consensus/consensus.h"
 #include "consensus/validation.h"
@@ -234,6 +235,50 @@ BOOST_AUTO_TEST_CASE(Test_EnforceShroudnodePayment)
     BOOST_CHECK(true == CheckTransaction(tx, state, tx.GetHash(), false, before_block));
 }
 
-
+BOOST_AUTO_TEST_CASE(Test_ShroudnodeIndexes)
+{
+    CShroudnodeMan man;
+    CKey keyCollateral, key1, key2, key3;
+    keyCollateral.MakeNewKey(true);
+    key1.MakeNewKey(true);
+    key2.MakeNewKey(true);
+    key3.MakeNewKey(true);
+    CTxIn vin1(COutPoint(ArithToUint256(1), 0));
+    CTxIn vin2(COutPoint(ArithToUint256(2), 1));
+    CShroudnode mn1(CService("10.0.0.1:8168"), vin1, keyCollateral.GetPubKey(), key1.GetPubKey(), PROTOCOL_VERSION);
+    CShroudnode mn2(CService("10.0.0.2:8168"), vin2, keyCollateral.GetPubKey(), key2.GetPubKey(), PROTOCOL_VERSION);
+
+    BOOST_CHECK(man.Add(mn1));
+    BOOST_CHECK(man.Add(mn2));
+    BOOST_CHECK(!man.Add(mn1));
+    BOOST_CHECK_EQUAL(man.size(), 2);
+
+    BOOST_CHECK(man.Find(vin1) && man.Find(vin1)->addr == mn1.addr);
+    BOOST_CHECK(man.Find(key2.GetPubKey()) == man.Find(vin2));
+    BOOST_CHECK(man.Find(key3.GetPubKey()) == NULL);
+    BOOST_CHECK(man.Find(CTxIn(COutPoint(ArithToUint256(2), 0))) == NULL);
+    BOOST_CHECK(man.Find(vin2.prevout.hash.ToString(), "1") == man.Find(vin2));
+    BOOST_CHECK(man.Find(vin2.prevout.hash.ToString(), "01") == NULL);
+    BOOST_CHECK(man.Find(vin2.prevout.hash.ToString(), "0") == NULL);
+
+    CShroudnodeMan::shroudnode_snapshot_t snapshot = man.GetShroudnodeSnapshot();
+    BOOST_CHECK_EQUAL(snapshot->size(), 2);
+    BOOST_CHECK(man.GetShroudnodeSnapshot() == snapshot);
+
+    // a newer broadcast moves the shroudnode to another key and address
+    CShroudnodeBroadcast mnb(CService("10.0.0.3:8168"), vin1, keyCollateral.GetPubKey(), key3.GetPubKey(), PROTOCOL_VERSION);
+    mnb.sigTime = man.Find(vin1)->sigTime + 1;
+    man.UpdateShroudnodeList(mnb);
+    BOOST_CHECK(man.Find(key1.GetPubKey()) == NULL);
+    BOOST_CHECK(man.Find(key3.GetPubKey()) == man.Find(vin1));
+    BOOST_CHECK(man.Find(vin1)->addr == CService("10.0.0.3:8168"));
+    BOOST_CHECK(man.GetShroudnodeSnapshot() != snapshot);
+    BOOST_CHECK_EQUAL(snapshot->size(), 2);
+
+    man.Clear();
+    BOOST_CHECK(man.Find(vin1) == NULL);
+    BOOST_CHECK(man.Find(key3.GetPubKey()) == NULL);
+    BOOST_CHECK(man.GetShroudnodeSnapshot()->empty());
+}
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -16,6 +16,7 @@
 
 #include "wallet/db.h"
 #include "wallet/wallet.h"
+#include "hdmint/wallet.h"
 
 #include <boost/filesystem.hpp>
 #include <boost/test/unit_test.hpp>
@@ -165,4 +166,74 @@ BOOST_AUTO_TEST_CASE(sigma_mintspend_test)
         sigmaState->Reset();
     }
 }
+
+BOOST_AUTO_TEST_CASE(sigma_cached_balances)
+{
+    string stringError;
+    pwalletMain->SetBroadcastTransactions(true);
+
+    CreateAndProcessEmptyBlocks(201, scriptPubKey);
+
+    // the cached balances follow new blocks and wallet transactions
+    CWalletBalances balances = pwalletMain->GetBalances();
+    BOOST_CHECK_EQUAL(balances.nTrusted, pwalletMain->GetBalance(true));
+    BOOST_CHECK(balances.nImmature > 0);
+    BOOST_CHECK(pwalletMain->GetSigmaBalance() == std::make_pair(CAmount(0), CAmount(0)));
+
+    vector<pair<std::string, int>> denominationPairs;
+    denominationPairs.push_back(std::make_pair("1", 2));
+    BOOST_CHECK_MESSAGE(pwalletMain->CreateZerocoinMintModel(
+        stringError, denominationPairs, SIGMA), stringError + " - Create Mint failed");
+    BOOST_CHECK_EQUAL(pwalletMain->GetBalances().nTrusted, pwalletMain->GetBalance(true));
+    BOOST_CHECK(pwalletMain->GetSigmaBalance() == std::make_pair(2 * COIN, CAmount(0)));
+
+    CreateAndProcessBlock({}, scriptPubKey);
+    balances = pwalletMain->GetBalances();
+    BOOST_CHECK_EQUAL(balances.nTrusted, pwalletMain->GetBalance(true));
+    BOOST_CHECK_EQUAL(balances.nUnconfirmed, 0);
+
+    // the mints confirm without any wallet transaction changing
+    CreateAndProcessEmptyBlocks(5, scriptPubKey);
+    BOOST_CHECK(pwalletMain->GetSigmaBalance() == std::make_pair(2 * COIN, 2 * COIN));
+    BOOST_CHECK_EQUAL(pwalletMain->GetBalances().nTrusted, pwalletMain->GetBalance(true));
+
+    mempool.clear();
+    sigma::CSigmaState::GetState()->Reset();
+}
+
+BOOST_AUTO_TEST_CASE(sigma_rescan_recovers_mints_and_spends)
+{
+    string stringError;
+    pwalletMain->SetBroadcastTransactions(true);
+
+    CreateAndProcessEmptyBlocks(201, scriptPubKey);
+
+    vector<pair<std::string, int>> denominationPairs;
+    denominationPairs.push_back(std::make_pair("1", 2));
+    BOOST_CHECK_MESSAGE(pwalletMain->CreateZerocoinMintModel(
+        stringError, denominationPairs, SIGMA), stringError + " - Create Mint failed");
+    BOOST_CHECK_EQUAL(mempool.size(), 1);
+    uint256 mintTx = mempool.mapTx.begin()->GetTx().GetHash();
+    CreateAndProcessEmptyBlocks(6, scriptPubKey);
+
+    BOOST_CHECK_MESSAGE(pwalletMain->CreateZerocoinSpendModel(
+        stringError, "", "1"), stringError + " - Spend failed");
+    BOOST_CHECK_EQUAL(mempool.size(), 1);
+    uint256 spendTx = mempool.mapTx.begin()->GetTx().GetHash();
+    CreateAndProcessBlock({}, scriptPubKey);
+
+    // drop the transactions and the in-memory mints, as on startup before the tracker is loaded
+    BOOST_CHECK(pwalletMain->EraseFromWallet(mintTx));
+    BOOST_CHECK(pwalletMain->EraseFromWallet(spendTx));
+    zwalletMain->GetTracker().Clear();
+
+    pwalletMain->ScanForWalletTransactions(chainActive.Genesis(), true);
+    BOOST_CHECK(pwalletMain->mapWallet.count(mintTx));
+    BOOST_CHECK(pwalletMain->mapWallet.count(spendTx));
+
+    zwalletMain->GetTracker().ListMints(false, false, false, true);
+    mempool.clear();
+    sigma::CSigmaState::GetState()->Reset();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
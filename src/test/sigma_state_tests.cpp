@@ -1200,4 +1200,50 @@ BOOST_AUTO_TEST_CASE(sigma_surge_detection_failure_anywhere)
 }
 
 
+// Checking GetAnonymitySet caching and invalidation
+BOOST_AUTO_TEST_CASE(sigma_getanonymityset_cache)
+{
+    sigma::CSigmaState *sigmaState = sigma::CSigmaState::GetState();
+    auto params = sigma::Params::get_default();
+    std::pair<sigma::CoinDenomination, int> denomination1Group1(sigma::CoinDenomination::SIGMA_DENOM_1, 1);
+
+    auto pubCoins = getPubcoins(generateCoins(params, 2, sigma::CoinDenomination::SIGMA_DENOM_1));
+    auto index1 = CreateBlockIndex(1);
+    index1.phashBlock = new uint256(uint256S("1"));
+    index1.sigmaMintedPubCoins[denomination1Group1] = pubCoins;
+
+    auto pubCoins2 = getPubcoins(generateCoins(params, 3, sigma::CoinDenomination::SIGMA_DENOM_1));
+    auto index2 = CreateBlockIndex(2);
+    index2.pprev = &index1;
+    index2.phashBlock = new uint256(uint256S("2"));
+    index2.sigmaMintedPubCoins[denomination1Group1] = pubCoins2;
+
+    sigmaState->AddBlock(&index1);
+    sigmaState->AddBlock(&index2);
+
+    auto set2 = sigmaState->GetAnonymitySet(sigma::CoinDenomination::SIGMA_DENOM_1, 1, &index2);
+    BOOST_CHECK_MESSAGE(set2->size() == 5, "Unexpected anonymity set size");
+    BOOST_CHECK_MESSAGE(set2 == sigmaState->GetAnonymitySet(sigma::CoinDenomination::SIGMA_DENOM_1, 1, &index2),
+      "Anonymity set is not cached");
+
+    // set ending at the previous block is the tail of the bigger one
+    auto set1 = sigmaState->GetAnonymitySet(sigma::CoinDenomination::SIGMA_DENOM_1, 1, &index1);
+    BOOST_CHECK_MESSAGE(set1->size() == 2, "Unexpected anonymity set size");
+    BOOST_CHECK(std::equal(set1->begin(), set1->end(), set2->end() - set1->size()));
+
+    // disconnecting a block drops only the sets ending at it, snapshots handed out stay intact
+    sigmaState->RemoveBlock(&index2);
+    BOOST_CHECK_MESSAGE(set2->size() == 5, "Snapshot changed after removing block");
+    BOOST_CHECK_MESSAGE(set1 == sigmaState->GetAnonymitySet(sigma::CoinDenomination::SIGMA_DENOM_1, 1, &index1),
+      "Anonymity set of connected block was dropped");
+
+    index2.sigmaMintedPubCoins[denomination1Group1] = {pubCoins2[0]};
+    sigmaState->AddBlock(&index2);
+    auto newSet2 = sigmaState->GetAnonymitySet(sigma::CoinDenomination::SIGMA_DENOM_1, 1, &index2);
+    BOOST_CHECK_MESSAGE(newSet2 != set2 && newSet2->size() == 3,
+      "Stale anonymity set returned after reconnecting block");
+
+    sigmaState->Reset();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
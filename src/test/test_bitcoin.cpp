@@ -97,8 +97,10 @@ TestingSetup::TestingSetup(const std::string& chainName, std::string suf) : Basi
             BOOST_CHECK(ok);
         }
         nScriptCheckThreads = 3;
-        for (int i=0; i < nScriptCheckThreads-1; i++)
+        for (int i=0; i < nScriptCheckThreads-1; i++) {
             threadGroup.create_thread(&ThreadScriptCheck);
+            threadGroup.create_thread(&ThreadSigmaSpendCheck);
+        }
         RegisterNodeSignals(GetNodeSignals());
 #ifdef ENABLE_CLIENTAPI
         StartAPI();
@@ -34,6 +34,9 @@ static const char DB_REINDEX_FLAG = 'R';
 static const char DB_LAST_BLOCK = 'l';
 static const char DB_TOTAL_SUPPLY = 'S';
 
+/** Block index entries whose headers are hashed together on startup */
+static const size_t BLOCK_INDEX_HASH_BATCH = 1024;
+
 
 CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, bool fMemory, bool fWipe) : db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe, true)
 {
@@ -308,6 +311,53 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
     return true;
 }
 
+/** Adds block index entries read from disk to mapBlockIndex, their headers are hashed together */
+static bool InsertDiskBlockIndexes(const std::vector<CDiskBlockIndex>& vDiskIndex,
+        boost::function<CBlockIndex*(const uint256&)> insertBlockIndex, const Consensus::Params& consensusParams)
+{
+    std::vector<CBlockHeader> vHeaders(vDiskIndex.size());
+    std::vector<const CBlockHeader*> vpHeaders(vDiskIndex.size());
+    for (size_t i = 0; i < vDiskIndex.size(); i++) {
+        vHeaders[i] = vDiskIndex[i].GetDiskBlockHeader();
+        vpHeaders[i] = &vHeaders[i];
+    }
+    std::vector<uint256> vHashes(vDiskIndex.size());
+    GetPoWHashes(vpHeaders.data(), vpHeaders.size(), vHashes.data());
+
+    for (size_t i = 0; i < vDiskIndex.size(); i++) {
+        const CDiskBlockIndex& diskindex = vDiskIndex[i];
+
+        // Construct block index object
+        CBlockIndex* pindexNew    = insertBlockIndex(vHashes[i]);
+        pindexNew->pprev          = insertBlockIndex(diskindex.hashPrev);
+
+        pindexNew->nHeight        = diskindex.nHeight;
+        pindexNew->nFile          = diskindex.nFile;
+        pindexNew->nDataPos       = diskindex.nDataPos;
+        pindexNew->nUndoPos       = diskindex.nUndoPos;
+        pindexNew->nVersion       = diskindex.nVersion;
+        pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
+        pindexNew->nTime          = diskindex.nTime;
+        pindexNew->nBits          = diskindex.nBits;
+        pindexNew->nNonce         = diskindex.nNonce;
+        pindexNew->nStatus        = diskindex.nStatus;
+        pindexNew->nTx            = diskindex.nTx;
+
+        pindexNew->accumulatorChanges = diskindex.accumulatorChanges;
+        pindexNew->mintedPubCoins     = diskindex.mintedPubCoins;
+        pindexNew->spentSerials       = diskindex.spentSerials;
+
+        pindexNew->sigmaMintedPubCoins   = diskindex.sigmaMintedPubCoins;
+        pindexNew->sigmaSpentSerials     = diskindex.sigmaSpentSerials;
+        pindexNew->nStakeModifier = diskindex.nStakeModifier;
+        pindexNew->vchBlockSig    = diskindex.vchBlockSig; // qtum
+
+        if (pindexNew->nNonce != 0 && !CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits, consensusParams))
+                return error("LoadBlockIndex(): CheckProofOfWork failed: %s", pindexNew->ToString());
+    }
+    return true;
+}
+
 bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex)
 {
     auto consensusParams = Params().GetConsensus();
@@ -317,44 +367,21 @@ bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256
 
     pcursor->Seek(make_pair(DB_BLOCK_INDEX, uint256()));
 
-    // Load mapBlockIndex
+    // Load mapBlockIndex, BLOCK_INDEX_HASH_BATCH entries at a time
+    std::vector<CDiskBlockIndex> vDiskIndex;
+    vDiskIndex.reserve(BLOCK_INDEX_HASH_BATCH);
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
         std::pair<char, uint256> key;
         if (pcursor->GetKey(key) && key.first == DB_BLOCK_INDEX) {
             CDiskBlockIndex diskindex;
             if (pcursor->GetValue(diskindex)) {
-                // Construct block index object
-            	//if(diskindex.hashBlock != uint256()
-            	//	&& diskindex.hashPrev != uint256()){
-
-                CBlockIndex* pindexNew    = insertBlockIndex(diskindex.GetBlockHash());
-                pindexNew->pprev 		  = insertBlockIndex(diskindex.hashPrev);
-
-                pindexNew->nHeight        = diskindex.nHeight;
-                pindexNew->nFile          = diskindex.nFile;
-                pindexNew->nDataPos       = diskindex.nDataPos;
-                pindexNew->nUndoPos       = diskindex.nUndoPos;
-                pindexNew->nVersion       = diskindex.nVersion;
-                pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
-                pindexNew->nTime          = diskindex.nTime;
-                pindexNew->nBits          = diskindex.nBits;
-                pindexNew->nNonce         = diskindex.nNonce;
-                pindexNew->nStatus        = diskindex.nStatus;
-                pindexNew->nTx            = diskindex.nTx;
-
-                pindexNew->accumulatorChanges = diskindex.accumulatorChanges;
-                pindexNew->mintedPubCoins     = diskindex.mintedPubCoins;
-                pindexNew->spentSerials       = diskindex.spentSerials;
-
-                pindexNew->sigmaMintedPubCoins   = diskindex.sigmaMintedPubCoins;
-                pindexNew->sigmaSpentSerials     = diskindex.sigmaSpentSerials;
-                pindexNew->nStakeModifier = diskindex.nStakeModifier;
-                pindexNew->vchBlockSig    = diskindex.vchBlockSig; // qtum
-
-                if (pindexNew->nNonce != 0 && !CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits, consensusParams))
-                        return error("LoadBlockIndex(): CheckProofOfWork failed: %s", pindexNew->ToString());
-
+                vDiskIndex.push_back(diskindex);
+                if (vDiskIndex.size() == BLOCK_INDEX_HASH_BATCH) {
+                    if (!InsertDiskBlockIndexes(vDiskIndex, insertBlockIndex, consensusParams))
+                        return false;
+                    vDiskIndex.clear();
+                }
                 pcursor->Next();
             } else {
                 return error("LoadBlockIndex() : failed to read value");
@@ -364,7 +391,7 @@ bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256
         }
     }
 
-    return true;
+    return InsertDiskBlockIndexes(vDiskIndex, insertBlockIndex, consensusParams);
 }
 
 int CBlockTreeDB::GetBlockIndexVersion()
@@ -15,14 +15,17 @@
 #include "../sigma.h"
 #include "../hdmint/wallet.h"
 
+#include <map>
+#include <memory>
 #include <stdexcept>
 #include <tuple>
+#include <utility>
 
 class SigmaSpendSigner : public InputSigner
 {
 public:
     const sigma::PrivateCoin coin;
-    std::vector<sigma::PublicCoin> group;
+    std::shared_ptr<const std::vector<sigma::PublicCoin>> group;
     uint256 lastBlockOfGroup;
     bool fPadding;
 
@@ -36,11 +39,15 @@ public:
     {
         // construct spend
         sigma::SpendMetaData meta(output.n, lastBlockOfGroup, sig);
-        sigma::CoinSpend spend(coin.getParams(), coin, group, meta, fPadding);
+
+        // a dummy spend only has to be as large as the real one, so skip the proof
+        sigma::CoinSpend spend = fDummy
+            ? sigma::CoinSpend::CreateDummy(coin.getParams(), coin, meta)
+            : sigma::CoinSpend(coin.getParams(), coin, *group, meta, fPadding);
 
         spend.setVersion(coin.getVersion());
 
-        if (!fDummy && !spend.Verify(group, meta, fPadding)) {
+        if (!fDummy && !spend.Verify(*group, meta, fPadding)) {
             throw std::runtime_error(_("The spend coin transaction failed to verify"));
         }
 
@@ -57,7 +64,17 @@ public:
     }
 };
 
-static std::unique_ptr<SigmaSpendSigner> CreateSigner(const CSigmaEntry& coin)
+// Anonymity sets resolved for a transaction, shared by all inputs spending from the same group
+struct AnonymitySet
+{
+    uint256 lastBlock;
+    std::shared_ptr<const std::vector<sigma::PublicCoin>> coins;
+    int size;
+};
+
+typedef std::map<std::pair<sigma::CoinDenomination, int>, AnonymitySet> AnonymitySets;
+
+static std::unique_ptr<SigmaSpendSigner> CreateSigner(const CSigmaEntry& coin, AnonymitySets& sets)
 {
     sigma::CSigmaState* state = sigma::CSigmaState::GetState();
     auto params = sigma::Params::get_default();
@@ -98,13 +115,26 @@ static std::unique_ptr<SigmaSpendSigner> CreateSigner(const CSigmaEntry& coin)
     signer->output.n = static_cast<uint32_t>(groupId);
     signer->sequence = CTxIn::SEQUENCE_FINAL;
 
-    if (state->GetCoinSetForSpend(
-        &chainActive,
-        chainActive.Height() - (ZC_MINT_CONFIRMATIONS - 1), // required 6 confirmation for mint to spend
-        denom,
-        groupId,
-        signer->lastBlockOfGroup,
-        signer->group) < 2) {
+    auto set = sets.find(std::make_pair(denom, groupId));
+
+    if (set == sets.end()) {
+        AnonymitySet resolved;
+
+        resolved.size = state->GetCoinSetForSpend(
+            &chainActive,
+            chainActive.Height() - (ZC_MINT_CONFIRMATIONS - 1), // required 6 confirmation for mint to spend
+            denom,
+            groupId,
+            resolved.lastBlock,
+            resolved.coins);
+
+        set = sets.emplace(std::make_pair(denom, groupId), resolved).first;
+    }
+
+    signer->lastBlockOfGroup = set->second.lastBlock;
+    signer->group = set->second.coins;
+
+    if (set->second.size < 2) {
         throw std::runtime_error(_("Has to have at least two mint coins with at least 6 confirmation in order to spend a coin"));
     }
 
@@ -151,10 +181,11 @@ CAmount SigmaSpendBuilder::GetInputs(std::vector<std::unique_ptr<InputSigner>>&
     }
 
     // construct signers
+    AnonymitySets sets;
     CAmount total = 0;
     for (auto& coin : selected) {
         total += coin.get_denomination_value();
-        signers.push_back(CreateSigner(coin));
+        signers.push_back(CreateSigner(coin, sets));
     }
 
     return total;
@@ -421,6 +421,38 @@ BOOST_AUTO_TEST_CASE(get_coin_by_limit_max_to_1)
     sigmaState->Reset();
 }
 
+BOOST_AUTO_TEST_CASE(get_coin_secrets_of_selected_only)
+{
+    AddOneCoinForEachGroup();
+    std::vector<std::pair<sigma::CoinDenomination, int>> newCoins;
+    GetCoinSetByDenominationAmount(newCoins, 0, 0, 0, 3, 0, 0, 0);
+    GenerateBlockWithCoins(newCoins);
+    GenerateEmptyBlocks(5);
+
+    // listing leaves the secrets out, the full coins carry them
+    auto listed = pwalletMain->ListAvailableCoins();
+    auto available = pwalletMain->GetAvailableCoins();
+    BOOST_CHECK_EQUAL(listed.size(), 3);
+    BOOST_CHECK_EQUAL(available.size(), 3);
+    for (auto& coin : listed) {
+        BOOST_CHECK(coin.serialNumber.isZero());
+        BOOST_CHECK(std::find_if(available.begin(), available.end(), [&coin](const CSigmaEntry& full) {
+            return full.value == coin.value && !full.serialNumber.isZero();
+        }) != available.end());
+    }
+
+    std::vector<CSigmaEntry> coins;
+    std::vector<sigma::CoinDenomination> coinsToMint;
+    BOOST_CHECK(pwalletMain->GetCoinsToSpend(2 * COIN, coins, coinsToMint));
+    BOOST_CHECK_EQUAL(coins.size(), 2);
+    for (auto& coin : coins) {
+        BOOST_CHECK(std::find_if(available.begin(), available.end(), [&coin](const CSigmaEntry& full) {
+            return full.value == coin.value && full.serialNumber == coin.serialNumber;
+        }) != available.end());
+    }
+    sigmaState->Reset();
+}
+
 BOOST_AUTO_TEST_CASE(create_spend_with_insufficient_coins)
 {
     CAmount fee;
@@ -6,6 +6,7 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <atomic>
 #include <functional>
 #include <vector>
 
@@ -228,5 +229,60 @@ BOOST_AUTO_TEST_CASE(build_with_changes)
     BOOST_CHECK(std::find_if(tx.vout.begin(), tx.vout.end(), [](const CTxOut& o) { return o.nValue == 20; }) != tx.vout.end());
 }
 
+BOOST_AUTO_TEST_CASE(build_with_real_signatures_once_fee_settled)
+{
+    class CountingInputSigner : public InputSigner
+    {
+    public:
+        std::atomic<int>& realSigns;
+
+    public:
+        CountingInputSigner(std::atomic<int>& realSigns, const COutPoint& output) :
+            InputSigner(output),
+            realSigns(realSigns)
+        {
+        }
+
+        CScript Sign(const CMutableTransaction& tx, const uint256& sig, bool fDummy = false) override
+        {
+            CScript script;
+
+            if (!fDummy) {
+                realSigns++;
+            }
+
+            script << std::vector<unsigned char>(100, fDummy ? 0x00 : 0x01);
+            return script;
+        }
+    };
+
+    TestTxBuilder builder(*pwalletMain);
+    CAmount fee;
+    std::atomic<int> realSigns(0);
+
+    builder.getInputs = [&realSigns](std::vector<std::unique_ptr<InputSigner>>& signers, CAmount required, bool fDummy) {
+        for (uint32_t i = 0; i < 4; i++) {
+            signers.push_back(std::unique_ptr<InputSigner>(new CountingInputSigner(realSigns, COutPoint(GetRandHash(), i))));
+        }
+        return required;
+    };
+
+    std::vector<CRecipient> recipients = {
+        {.scriptPubKey = GetScriptForDestination(randomAddr1.Get()), .nAmount = 10, .fSubtractFeeFromAmount = false}
+    };
+    bool fChangeAddedToFee;
+    auto tx = builder.Build(recipients, fee, fChangeAddedToFee);
+
+    // the fee converged on dummy signatures, the real ones are only made once
+    BOOST_CHECK_GT(builder.amountsRequested.size(), 1);
+    BOOST_CHECK_EQUAL(realSigns, 4);
+
+    BOOST_CHECK_EQUAL(tx.vin.size(), 4);
+
+    for (auto& in : tx.vin) {
+        BOOST_CHECK(in.scriptSig == CScript() << std::vector<unsigned char>(100, 0x01));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -10,8 +10,11 @@
 #include "../util.h"
 
 #include <boost/format.hpp>
+#include <boost/thread/thread.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <exception>
 #include <random>
 #include <stdexcept>
 #include <string>
@@ -213,26 +216,18 @@ CWalletTx TxBuilder::Build(const std::vector<CRecipient>& recipients, CAmount& f
         // now every fields is populated then we can sign transaction
         uint256 sig = tx.GetHash();
 
+        // dummy signatures have the size of real ones, so the fee can be settled without proving
         for (size_t i = 0; i < tx.vin.size(); i++) {
-            tx.vin[i].scriptSig = signers[i]->Sign(tx, sig, fDummy);
+            tx.vin[i].scriptSig = signers[i]->Sign(tx, sig, true);
         }
 
-        // check fee
-        static_cast<CTransaction&>(result) = CTransaction(tx);
+        CAmount feeNeeded = CheckFee(result, tx);
 
-        if (GetTransactionWeight(result) >= MAX_STANDARD_TX_WEIGHT) {
-            throw std::runtime_error(_("Transaction too large"));
-        }
-
-        // check fee
-        unsigned size = GetVirtualTransactionSize(result);
-        CAmount feeNeeded = CWallet::GetMinimumFee(size, nTxConfirmTarget, mempool);
-        feeNeeded = AdjustFee(feeNeeded, size);
+        if (fee >= feeNeeded && !fDummy) {
+            SignInputs(tx, sig, signers);
 
-        // If we made it here and we aren't even able to meet the relay fee on the next pass, give up
-        // because we must be at the maximum allowed fee.
-        if (feeNeeded < minRelayTxFee.GetFee(size)) {
-            throw std::runtime_error(_("Transaction too large for fee policy"));
+            // in case the real signatures turned out larger
+            feeNeeded = CheckFee(result, tx);
         }
 
         if (fee >= feeNeeded) {
@@ -261,6 +256,73 @@ CWalletTx TxBuilder::Build(const std::vector<CRecipient>& recipients, CAmount& f
     return result;
 }
 
+CAmount TxBuilder::CheckFee(CWalletTx& result, const CMutableTransaction& tx)
+{
+    static_cast<CTransaction&>(result) = CTransaction(tx);
+
+    if (GetTransactionWeight(result) >= MAX_STANDARD_TX_WEIGHT) {
+        throw std::runtime_error(_("Transaction too large"));
+    }
+
+    // check fee
+    unsigned size = GetVirtualTransactionSize(result);
+    CAmount feeNeeded = CWallet::GetMinimumFee(size, nTxConfirmTarget, mempool);
+    feeNeeded = AdjustFee(feeNeeded, size);
+
+    // If we made it here and we aren't even able to meet the relay fee on the next pass, give up
+    // because we must be at the maximum allowed fee.
+    if (feeNeeded < minRelayTxFee.GetFee(size)) {
+        throw std::runtime_error(_("Transaction too large for fee policy"));
+    }
+
+    return feeNeeded;
+}
+
+void TxBuilder::SignInputs(CMutableTransaction& tx, const uint256& sig, const std::vector<std::unique_ptr<InputSigner>>& signers)
+{
+    // the signature hash is fixed already, so the inputs are independent of each other
+    std::vector<CScript> scripts(signers.size());
+    std::vector<std::exception_ptr> errors(signers.size());
+    std::atomic<size_t> next(0);
+
+    auto sign = [&]() {
+        size_t i;
+        while ((i = next++) < signers.size()) {
+            try {
+                scripts[i] = signers[i]->Sign(tx, sig, false);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+
+    int64_t threads = GetArg("-signthreads", DEFAULT_SIGN_THREADS);
+    if (threads <= 0) {
+        threads = GetNumCores();
+    }
+    threads = std::min(threads, static_cast<int64_t>(signers.size()));
+
+    if (threads > 1) {
+        boost::thread_group workers;
+        for (int64_t i = 0; i < threads; i++) {
+            workers.create_thread(sign);
+        }
+        workers.join_all();
+    } else {
+        sign();
+    }
+
+    for (auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    for (size_t i = 0; i < tx.vin.size(); i++) {
+        tx.vin[i].scriptSig = std::move(scripts[i]);
+    }
+}
+
 CAmount TxBuilder::AdjustFee(CAmount needed, unsigned txSize)
 {
     return needed;
@@ -43,6 +43,13 @@ protected:
     virtual CAmount GetInputs(std::vector<std::unique_ptr<InputSigner>>& signers, CAmount required, bool fDummy = false) = 0;
     virtual CAmount GetChanges(std::vector<CTxOut>& outputs, CAmount amount, bool fDummy = false) = 0;
     virtual CAmount AdjustFee(CAmount needed, unsigned txSize);
+
+private:
+    //! Updates result to tx and returns the fee it needs.
+    CAmount CheckFee(CWalletTx& result, const CMutableTransaction& tx);
+
+    //! Produces the final signatures, running the signers on a bounded number of threads.
+    static void SignInputs(CMutableTransaction& tx, const uint256& sig, const std::vector<std::unique_ptr<InputSigner>>& signers);
 };
 
 #endif
@@ -50,6 +50,7 @@
 #include "hdmint/tracker.h"
 
 #include <assert.h>
+#include <atomic>
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/thread.hpp>
@@ -673,8 +674,16 @@ bool CWallet::IsSpent(const uint256 &hash, unsigned int n) const {
     return false;
 }
 
+void CWallet::MarkSpentDirty(const COutPoint &outpoint) {
+    // the available credit of the spent transaction changes
+    map<uint256, CWalletTx>::iterator it = mapWallet.find(outpoint.hash);
+    if (it != mapWallet.end())
+        it->second.MarkDirty();
+}
+
 void CWallet::AddToSpends(const COutPoint &outpoint, const uint256 &wtxid) {
     mapTxSpends.insert(make_pair(outpoint, wtxid));
+    MarkSpentDirty(outpoint);
 
     pair <TxSpends::iterator, TxSpends::iterator> range;
     range = mapTxSpends.equal_range(outpoint);
@@ -707,6 +716,7 @@ void CWallet::RemoveFromSpends(const COutPoint& outpoint, const uint256& wtxid)
             break;
         }
     }
+    MarkSpentDirty(outpoint);
     range = mapTxSpends.equal_range(outpoint);
     SyncMetaData(range);
 }
@@ -842,98 +852,97 @@ bool CWallet::CreateCoinStake(const CKeyStore& keystore, unsigned int nBits, int
     if (setCoins.empty())
         return false;
 
-    // if (stakeCache.size() > setCoins.size() + 100){
-    //     //Determining if the cache is still valid is harder than just clearing it when it gets too big, so instead just clear it
-    //     //when it has more than 100 entries more than the actual setCoins.
-    //     stakeCache.clear();
-    // }
-
-    // if (GetBoolArg("-stakecache", shroudnodeSync.IsBlockchainSynced())) {
-    //     BOOST_FOREACH(const PAIRTYPE(const CWalletTx*, unsigned int)& pcoin, setCoins)
-    //     {
-    //         boost::this_thread::interruption_point();
-    //         COutPoint prevoutStake = COutPoint(pcoin.first->GetHash(), pcoin.second);
-    //         CacheKernel(stakeCache, prevoutStake, pindexPrev); //this will do a 2 disk loads per op
-    //     }
-    // }
+    // Everything the kernel needs is in the wallet already, so the search below runs without
+    // reading a single transaction from disk. SyncTransaction drops the entries of spent and
+    // reorganized outputs, so the search works on a copy of the entries taken under cs_wallet.
+    std::map<COutPoint, CStakeCache> stakeCoins;
+    {
+        LOCK2(cs_main, cs_wallet);
+        BOOST_FOREACH(const PAIRTYPE(const CWalletTx*, unsigned int)& pcoin, setCoins)
+        {
+            COutPoint prevoutStake = COutPoint(pcoin.first->GetHash(), pcoin.second);
+            std::map<COutPoint, CStakeCache>::const_iterator it = stakeCache.find(prevoutStake);
+            if (it == stakeCache.end()) {
+                BlockMap::const_iterator mi = mapBlockIndex.find(pcoin.first->hashBlock);
+                if (mi == mapBlockIndex.end() || !chainActive.Contains(mi->second))
+                    continue;
+                it = stakeCache.insert(std::make_pair(prevoutStake, CStakeCache(mi->first, mi->second->nHeight, pcoin.first->vout[pcoin.second].nValue))).first;
+            }
+            stakeCoins.insert(*it);
+        }
+    }
 
     int64_t nCredit = 0;
     CScript scriptPubKeyKernel;
     BOOST_FOREACH(const PAIRTYPE(const CWalletTx*, unsigned int)& pcoin, setCoins)
     {
         static int nMaxStakeSearchInterval = 60;
-        bool fKernelFound = false;
-        for (unsigned int n=0; n < min(nSearchInterval,(int64_t)nMaxStakeSearchInterval) && !fKernelFound && pindexPrev == pindexBestHeader; n++)
-        {
-            boost::this_thread::interruption_point();
-            // Search backward in time from the given txNew timestamp
-            // Search nSearchInterval seconds back up to nMaxStakeSearchInterval
-            COutPoint prevoutStake = COutPoint(pcoin.first->GetHash(), pcoin.second);
+        if (pindexPrev != pindexBestHeader)
+            break;
+        boost::this_thread::interruption_point();
+        // Search backward in time from the given txNew timestamp
+        // Search nSearchInterval seconds back up to nMaxStakeSearchInterval
+        COutPoint prevoutStake = COutPoint(pcoin.first->GetHash(), pcoin.second);
 
-            int64_t nBlockTime;
+        int64_t nBlockTime;
 
-            if (CheckKernel(pindexPrev, nBits, nTime - n, prevoutStake, stakeCache, &nBlockTime))
+        if (FindKernel(pindexPrev, nBits, nTime, min(nSearchInterval,(int64_t)nMaxStakeSearchInterval), prevoutStake, stakeCoins, &nBlockTime))
+        {
+            // Found a kernel
+            LogPrintf("CWallet::CreateCoinStake(): kernel found\n");
+            vector<vector<unsigned char> > vSolutions;
+            txnouttype whichType;
+            CScript scriptPubKeyOut;
+            scriptPubKeyKernel = pcoin.first->vout[pcoin.second].scriptPubKey;
+            if (!Solver(scriptPubKeyKernel, whichType, vSolutions))
+            {
+                LogPrintf("CWallet::CreateCoinStake(): failed to parse kernel\n");
+                continue;
+            }
+            LogPrintf("CWallet::CreateCoinStake(): parsed kernel type=%d\n", whichType);
+            if (whichType != TX_PUBKEY && whichType != TX_PUBKEYHASH)
             {
-                // Found a kernel
-                LogPrintf("CWallet::CreateCoinStake(): kernel found\n");
-                vector<vector<unsigned char> > vSolutions;
-                txnouttype whichType;
-                CScript scriptPubKeyOut;
-                scriptPubKeyKernel = pcoin.first->vout[pcoin.second].scriptPubKey;
-                if (!Solver(scriptPubKeyKernel, whichType, vSolutions))
+                LogPrintf("CWallet::CreateCoinStake(): no support for kernel type=%d\n", whichType);
+                continue;  // only support pay to public key and pay to address
+            }
+            if (whichType == TX_PUBKEYHASH) // pay to address type
+            {
+                // convert to pay to public key type
+                if (!keystore.GetKey(uint160(vSolutions[0]), key))
                 {
-                    LogPrintf("CWallet::CreateCoinStake(): failed to parse kernel\n");
-                    break;
+                    LogPrintf("CWallet::CreateCoinStake(): failed to get key for kernel type=%d\n", whichType);
+                    continue;  // unable to find corresponding public key
                 }
-                LogPrintf("CWallet::CreateCoinStake(): parsed kernel type=%d\n", whichType);
-                if (whichType != TX_PUBKEY && whichType != TX_PUBKEYHASH)
+
+                scriptPubKeyOut << key.GetPubKey().getvch() << OP_CHECKSIG;
+            }
+            if (whichType == TX_PUBKEY)
+            {
+
+                if (!keystore.GetKey(Hash160(vSolutions[0]), key))
                 {
-                    LogPrintf("CWallet::CreateCoinStake(): no support for kernel type=%d\n", whichType);
-                    break;  // only support pay to public key and pay to address
+                    LogPrintf("CWallet::CreateCoinStake(): failed to get key for kernel type=%d\n", whichType);
+                    continue;  // unable to find corresponding public key
                 }
-                if (whichType == TX_PUBKEYHASH) // pay to address type
-                {
-                    // convert to pay to public key type
-                    if (!keystore.GetKey(uint160(vSolutions[0]), key))
-                    {
-                        LogPrintf("CWallet::CreateCoinStake(): failed to get key for kernel type=%d\n", whichType);
-                        break;  // unable to find corresponding public key
-                    }
 
-                    scriptPubKeyOut << key.GetPubKey().getvch() << OP_CHECKSIG;
-                }
-                if (whichType == TX_PUBKEY)
+                if (key.GetPubKey() != vSolutions[0])
                 {
-
-                    if (!keystore.GetKey(Hash160(vSolutions[0]), key))
-                    {
-                        LogPrintf("CWallet::CreateCoinStake(): failed to get key for kernel type=%d\n", whichType);
-                        break;  // unable to find corresponding public key
-                    }
-
-                    if (key.GetPubKey() != vSolutions[0])
-                    {
-                        LogPrintf("CWallet::CreateCoinStake(): invalid key for kernel type=%d\n", whichType);
-                        break; // keys mismatch
-                    }
-
-                    scriptPubKeyOut = scriptPubKeyKernel;
+                    LogPrintf("CWallet::CreateCoinStake(): invalid key for kernel type=%d\n", whichType);
+                    continue; // keys mismatch
                 }
 
-                //txNew.nTime -= n;
-                txNew.vin.push_back(CTxIn(pcoin.first->GetHash(), pcoin.second));
-                nCredit += pcoin.first->vout[pcoin.second].nValue;
-                vwtxPrev.push_back(pcoin.first);
-                txNew.vout.push_back(CTxOut(0, scriptPubKeyOut));
-
-                LogPrintf("CWallet::CreateCoinStake(): added kernel type=%d\n", whichType);
-                fKernelFound = true;
-                break;
+                scriptPubKeyOut = scriptPubKeyKernel;
             }
-        }
 
-        if (fKernelFound)
+            //txNew.nTime -= n;
+            txNew.vin.push_back(CTxIn(pcoin.first->GetHash(), pcoin.second));
+            nCredit += pcoin.first->vout[pcoin.second].nValue;
+            vwtxPrev.push_back(pcoin.first);
+            txNew.vout.push_back(CTxOut(0, scriptPubKeyOut));
+
+            LogPrintf("CWallet::CreateCoinStake(): added kernel type=%d\n", whichType);
             break; // if kernel is found stop searching
+        }
     }
 
     if (nCredit == 0 || nCredit > nBalance - nReserveBalance)
@@ -1187,11 +1196,115 @@ bool CWallet::GetAccountPubkey(CPubKey &pubKey, std::string strAccount, bool bFo
 void CWallet::MarkDirty() {
     {
         LOCK(cs_wallet);
+        fBalanceAllDirty = true;
         BOOST_FOREACH(PAIRTYPE(const uint256, CWalletTx)&item, mapWallet)
         item.second.MarkDirty();
     }
 }
 
+void CWallet::MarkBalanceDirty(const uint256 &hash) const {
+    LOCK(cs_wallet);
+    if (!fBalanceAllDirty)
+        setBalanceDirty.insert(hash);
+}
+
+void CWallet::UpdateBalances() const {
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
+
+    if (fBalanceAllDirty) {
+        balancesCached = CWalletBalances();
+        mapBalanceContributions.clear();
+        setBalanceDirty.clear();
+        setBalanceVolatile.clear();
+        fBalanceAllDirty = false;
+
+        for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
+            UpdateBalanceContribution(it->first);
+        return;
+    }
+
+    std::set<uint256> setDirty;
+    setDirty.swap(setBalanceDirty);
+    setDirty.insert(setBalanceVolatile.begin(), setBalanceVolatile.end());
+
+    BOOST_FOREACH(const uint256 &hash, setDirty)
+        UpdateBalanceContribution(hash);
+}
+
+void CWallet::UpdateBalanceContribution(const uint256 &hash) const {
+    std::map<uint256, CWalletBalances>::iterator previous = mapBalanceContributions.find(hash);
+    if (previous != mapBalanceContributions.end()) {
+        balancesCached -= previous->second;
+        mapBalanceContributions.erase(previous);
+    }
+    setBalanceVolatile.erase(hash);
+
+    map<uint256, CWalletTx>::const_iterator it = mapWallet.find(hash);
+    if (it == mapWallet.end())
+        return;
+
+    // same categories as the full scans these balances replace
+    const CWalletTx *pcoin = &it->second;
+    int nDepth = pcoin->GetDepthInMainChain();
+    CWalletBalances contribution;
+
+    if (pcoin->IsTrusted()) {
+        contribution.nTrusted = pcoin->GetAvailableCredit();
+        contribution.nWatchOnly = pcoin->GetAvailableWatchOnlyCredit();
+    } else if (nDepth == 0 && (pcoin->InMempool() || pcoin->InStempool())) {
+        contribution.nUnconfirmed = pcoin->GetAvailableCredit();
+        contribution.nUnconfirmedWatchOnly = pcoin->GetAvailableWatchOnlyCredit();
+    }
+    contribution.nImmature = pcoin->GetImmatureCredit();
+    contribution.nStake = pcoin->GetImmatureStakeCredit();
+    contribution.nImmatureWatchOnly = pcoin->GetImmatureWatchOnlyCredit();
+
+    if (!contribution.IsNull()) {
+        balancesCached += contribution;
+        mapBalanceContributions.insert(std::make_pair(hash, contribution));
+    }
+
+    // unconfirmed and immature transactions change with the tip and the mempool, the credit of
+    // mints is not cached since their spends are not tracked
+    if (nDepth < 1
+        || ((pcoin->IsCoinBase() || pcoin->IsCoinStake()) && pcoin->GetBlocksToMaturity() > 0)
+        || ((pcoin->IsZerocoinMint() || pcoin->IsSigmaMint()) && !contribution.IsNull()))
+        setBalanceVolatile.insert(hash);
+}
+
+CWalletBalances CWallet::GetBalances() const {
+    LOCK2(cs_main, cs_wallet);
+    UpdateBalances();
+    return balancesCached;
+}
+
+std::pair<CAmount, CAmount> CWallet::GetSigmaBalance() const {
+    LOCK2(cs_main, cs_wallet);
+
+    if (!zwalletMain)
+        return std::make_pair(0, 0);
+
+    CHDMintTracker &tracker = zwalletMain->GetTracker();
+    if (nSigmaBalanceHeight == chainActive.Height() && nSigmaBalanceTrackerState == tracker.GetUpdateCount())
+        return sigmaBalanceCached;
+
+    CAmount nAll = 0, nConfirmed = 0;
+    BOOST_FOREACH(const CMintMeta &coin, tracker.ListMints(true, false, false)) {
+        int64_t coinValue;
+        DenominationToInteger(coin.denom, coinValue);
+
+        nAll += coinValue;
+        if (coin.nHeight > 0 && coin.nHeight + (ZC_MINT_CONFIRMATIONS - 1) <= chainActive.Height())
+            nConfirmed += coinValue;
+    }
+
+    sigmaBalanceCached = std::make_pair(nAll, nConfirmed);
+    nSigmaBalanceHeight = chainActive.Height();
+    nSigmaBalanceTrackerState = tracker.GetUpdateCount();
+    return sigmaBalanceCached;
+}
+
 bool CWallet::AddToWallet(const CWalletTx &wtxIn, bool fFromLoadWallet, CWalletDB *pwalletdb) {
     LogPrintf("CWallet::AddToWallet\n");
     uint256 hash = wtxIn.GetHash();
@@ -1557,6 +1670,16 @@ void CWallet::MarkConflicted(const uint256 &hashBlock, const uint256 &hashTx) {
 void CWallet::SyncTransaction(const CTransaction &tx, const CBlockIndex *pindex, const CBlock *pblock) {
 //    LogPrintf("SyncTransaction()\n");
     LOCK2(cs_main, cs_wallet);
+    // Its depth changes, which moves its credit between the balance categories
+    MarkBalanceDirty(tx.GetHash());
+    // Outputs of tx moved to another block or back to the mempool, and its inputs are spent
+    // (or unspent again), either way their stake cache entries are stale
+    if (!stakeCache.empty()) {
+        for (unsigned int i = 0; i < tx.vout.size(); i++)
+            stakeCache.erase(COutPoint(tx.GetHash(), i));
+        BOOST_FOREACH(const CTxIn &txin, tx.vin)
+            stakeCache.erase(txin.prevout);
+    }
     if (!pblock) {
         // wallets need to refund inputs when disconnecting coinstake
         if (tx.IsCoinStake()) {
@@ -2067,17 +2190,129 @@ void CWalletTx::GetAccountAmounts(const string &strAccount, CAmount &nReceived,
     }
 }
 
+namespace {
+
+/**
+ * What the wallet owns, in a form blocks can be tested against without holding cs_wallet. Outputs
+ * are tested against the keystore, which has its own lock, and Sigma mints, spends and remints
+ * against the mints and spend serials in the wallet database, read before the rescan starts,
+ * as CWallet::IsMine does. Inputs spending wallet transactions are left to the caller, since
+ * these may have been found earlier in the same rescan.
+ */
+class RescanFilter
+{
+public:
+    explicit RescanFilter(const CKeyStore& keystore) : keystore(keystore)
+    {
+    }
+
+    std::set<uint256> pubcoinHashes;
+    std::set<uint256> serialHashes;
+    std::set<Bignum> remintSerials;
+
+    bool Matches(const CTransaction& tx) const
+    {
+        for (const CTxOut& txout : tx.vout) {
+            if (txout.scriptPubKey.IsSigmaMint()) {
+                try {
+                    if (pubcoinHashes.count(primitives::GetPubCoinValueHash(sigma::ParseSigmaMintScript(txout.scriptPubKey)))) {
+                        return true;
+                    }
+                } catch (std::invalid_argument&) {
+                }
+            } else if (::IsMine(keystore, txout.scriptPubKey) != ISMINE_NO) {
+                return true;
+            }
+        }
+
+        for (const CTxIn& txin : tx.vin) {
+            try {
+                if (txin.IsSigmaSpend()) {
+                    std::unique_ptr<sigma::CoinSpend> spend;
+                    std::tie(spend, std::ignore) = sigma::ParseSigmaSpend(txin);
+                    if (serialHashes.count(primitives::GetSerialHash(spend->getCoinSerialNumber()))) {
+                        return true;
+                    }
+                } else if (txin.IsZerocoinRemint()) {
+                    CDataStream serializedCoinRemint(
+                        std::vector<char>(txin.scriptSig.begin() + 1, txin.scriptSig.end()),
+                        SER_NETWORK, PROTOCOL_VERSION);
+                    sigma::CoinRemintToV3 remint(serializedCoinRemint);
+                    if (remintSerials.count(remint.getSerialNumber())) {
+                        return true;
+                    }
+                }
+            } catch (std::exception&) {
+            }
+        }
+
+        return false;
+    }
+
+private:
+    const CKeyStore& keystore;
+};
+
+struct RescanBlock
+{
+    CBlockIndex* pindex;
+    CDiskBlockPos pos;
+    uint256 hash;
+    CBlock block;
+    bool fRead;
+    std::vector<bool> matches;
+};
+
+static const size_t RESCAN_BATCH_SIZE = 128;
+
+//! Reads the blocks of a batch and tests their transactions, spread over a number of threads.
+void ReadRescanBatch(std::vector<RescanBlock>& batch, const RescanFilter& filter, int threads)
+{
+    std::atomic<size_t> next(0);
+
+    auto read = [&]() {
+        size_t i;
+        while ((i = next++) < batch.size()) {
+            RescanBlock& item = batch[i];
+            item.fRead = ReadBlockFromDisk(item.block, item.pos, item.pindex->nHeight, Params().GetConsensus())
+                && item.block.GetHash() == item.hash;
+            if (!item.fRead) {
+                item.block.SetNull();
+                continue;
+            }
+            item.matches.resize(item.block.vtx.size());
+            for (size_t j = 0; j < item.block.vtx.size(); j++) {
+                item.matches[j] = filter.Matches(item.block.vtx[j]);
+            }
+        }
+    };
+
+    boost::thread_group readers;
+    for (int i = 0; i < threads; i++) {
+        readers.create_thread(read);
+    }
+    readers.join_all();
+}
+
+} // anonymous namespace
+
 /**
  * Scan the block chain (starting in pindexStart) for transactions
  * from or to us. If fUpdate is true, found transactions that already
  * exist in the wallet will be updated.
+ *
+ * Blocks are read and filtered in batches by a number of threads while the previous batch is
+ * applied, so cs_main and cs_wallet are only held to add the transactions that may be ours.
  */
 int CWallet::ScanForWalletTransactions(CBlockIndex *pindexStart, bool fUpdate) {
     int ret = 0;
     int64_t nNow = GetTime();
     const CChainParams &chainParams = Params();
+    int threads = std::max(GetNumCores(), 1);
 
     CBlockIndex *pindex = pindexStart;
+    double dProgressStart, dProgressTip;
+    std::unique_ptr<RescanFilter> filter;
     {
         LOCK2(cs_main, cs_wallet);
 
@@ -2086,35 +2321,117 @@ int CWallet::ScanForWalletTransactions(CBlockIndex *pindexStart, bool fUpdate) {
         while (pindex && nTimeFirstKey && (pindex->GetBlockTime() < (nTimeFirstKey - 7200)))
             pindex = chainActive.Next(pindex);
 
+        // the mint tracker is not loaded yet when the wallet is rescanned on startup, so
+        // the filter is built from the database like CWallet::IsMine
+        filter.reset(new RescanFilter(*this));
+        CWalletDB walletdb(strWalletFile);
+        for (const CHDMint& mint : walletdb.ListHDMints()) {
+            filter->pubcoinHashes.insert(mint.GetPubCoinHash());
+            filter->serialHashes.insert(mint.GetSerialHash());
+        }
+
+        std::list<CSigmaEntry> pubcoins;
+        walletdb.ListSigmaPubCoin(pubcoins);
+        for (const CSigmaEntry& pubcoin : pubcoins) {
+            filter->pubcoinHashes.insert(primitives::GetPubCoinValueHash(pubcoin.value));
+            filter->serialHashes.insert(primitives::GetSerialHash(pubcoin.serialNumber));
+        }
+
+        std::list<CSigmaSpendEntry> spends;
+        walletdb.ListCoinSpendSerial(spends);
+        for (const CSigmaSpendEntry& spend : spends) {
+            filter->serialHashes.insert(primitives::GetSerialHash(spend.coinSerial));
+        }
+
+        std::list<CZerocoinSpendEntry> zerocoinSpends;
+        walletdb.ListCoinSpendSerial(zerocoinSpends);
+        for (const CZerocoinSpendEntry& spend : zerocoinSpends) {
+            filter->remintSerials.insert(spend.coinSerial);
+        }
+
         ShowProgress(_("Rescanning..."),
                      0); // show rescan progress in GUI as dialog or on splashscreen, if -rescan on startup
-        double dProgressStart = Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), pindex, false);
-        double dProgressTip = Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), chainActive.Tip(),
-                                                                     false);
-        while (pindex) {
-            if (pindex->nHeight % 100 == 0 && dProgressTip - dProgressStart > 0.0)
-                ShowProgress(_("Rescanning..."), std::max(1, std::min(99,
-                                                                      (int) ((Checkpoints::GuessVerificationProgress(
-                                                                              chainParams.Checkpoints(), pindex,
-                                                                              false) - dProgressStart) /
-                                                                             (dProgressTip - dProgressStart) * 100))));
-
-            CBlock block;
-            ReadBlockFromDisk(block, pindex, Params().GetConsensus());
-            BOOST_FOREACH(CTransaction & tx, block.vtx)
-            {
-                if (AddToWalletIfInvolvingMe(tx, &block, fUpdate))
-                    ret++;
+        dProgressStart = Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), pindex, false);
+        dProgressTip = Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), chainActive.Tip(),
+                                                              false);
+    }
+
+    // takes the next batch of blocks from the active chain
+    auto nextBatch = [&](CBlockIndex *pindexFrom) {
+        std::vector<RescanBlock> batch;
+        LOCK(cs_main);
+        for (CBlockIndex *p = pindexFrom; p && batch.size() < RESCAN_BATCH_SIZE; p = chainActive.Next(p)) {
+            RescanBlock item;
+            item.pindex = p;
+            item.pos = p->GetBlockPos();
+            item.hash = p->GetBlockHash();
+            item.fRead = false;
+            batch.push_back(std::move(item));
+        }
+        return batch;
+    };
+
+    std::vector<RescanBlock> batch = nextBatch(pindex);
+    ReadRescanBatch(batch, *filter, threads);
+
+    while (!batch.empty()) {
+        CBlockIndex *pindexNext = batch.back().pindex;
+        {
+            LOCK(cs_main);
+            // continue from the fork point, if the chain was reorganized in between
+            if (!chainActive.Contains(pindexNext)) {
+                pindexNext = const_cast<CBlockIndex*>(chainActive.FindFork(pindexNext));
             }
-            pindex = chainActive.Next(pindex);
-            if (GetTime() >= nNow + 60) {
-                nNow = GetTime();
-                LogPrintf("Still rescanning. At block %d. Progress=%f\n", pindex->nHeight,
-                          Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), pindex));
+            pindexNext = pindexNext ? chainActive.Next(pindexNext) : NULL;
+        }
+        std::vector<RescanBlock> next = nextBatch(pindexNext);
+
+        boost::thread reader([&next, &filter, threads]() {
+            ReadRescanBatch(next, *filter, std::max(threads - 1, 1));
+        });
+
+        try {
+            LOCK2(cs_main, cs_wallet);
+
+            for (RescanBlock& item : batch) {
+                pindex = item.pindex;
+
+                if (pindex->nHeight % 100 == 0 && dProgressTip - dProgressStart > 0.0)
+                    ShowProgress(_("Rescanning..."), std::max(1, std::min(99,
+                                                                          (int) ((Checkpoints::GuessVerificationProgress(
+                                                                                  chainParams.Checkpoints(), pindex,
+                                                                                  false) - dProgressStart) /
+                                                                                 (dProgressTip - dProgressStart) * 100))));
+
+                for (size_t i = 0; i < item.block.vtx.size(); i++) {
+                    const CTransaction &tx = item.block.vtx[i];
+
+                    // spends of wallet transactions, which might have been added by this rescan
+                    bool fRelevant = item.matches[i] || mapWallet.count(tx.GetHash());
+                    for (size_t j = 0; !fRelevant && j < tx.vin.size(); j++) {
+                        fRelevant = mapWallet.count(tx.vin[j].prevout.hash) != 0;
+                    }
+
+                    if (fRelevant && AddToWalletIfInvolvingMe(tx, &item.block, fUpdate))
+                        ret++;
+                }
+
+                if (GetTime() >= nNow + 60) {
+                    nNow = GetTime();
+                    LogPrintf("Still rescanning. At block %d. Progress=%f\n", pindex->nHeight,
+                              Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), pindex));
+                }
             }
+        } catch (...) {
+            reader.join();
+            throw;
         }
-        ShowProgress(_("Rescanning..."), 100); // hide progress dialog in GUI
+
+        reader.join();
+        batch = std::move(next);
     }
+
+    ShowProgress(_("Rescanning..."), 100); // hide progress dialog in GUI
     return ret;
 }
 
@@ -2256,6 +2573,20 @@ CAmount CWalletTx::GetCredit(const isminefilter &filter) const {
     return credit;
 }
 
+void CWalletTx::MarkDirty() {
+    fCreditCached = false;
+    fAvailableCreditCached = false;
+    fWatchDebitCached = false;
+    fWatchCreditCached = false;
+    fAvailableWatchCreditCached = false;
+    fImmatureWatchCreditCached = false;
+    fDebitCached = false;
+    fChangeCached = false;
+
+    if (pwallet)
+        pwallet->MarkBalanceDirty(GetHash());
+}
+
 CAmount CWalletTx::GetImmatureCredit(bool fUseCache) const {
     if ((IsCoinBase()) && GetBlocksToMaturity() > 0 && IsInMainChain()) {
         if (fUseCache && fImmatureCreditCached)
@@ -2517,6 +2848,10 @@ void CWallet::ResendWalletTransactions(int64_t nBestBlockTime) {
 
 
 CAmount CWallet::GetBalance(bool fExcludeLocked) const {
+    if (!fExcludeLocked)
+        return GetBalances().nTrusted;
+
+    // locked coins are not tracked by the cached balances
     CAmount nTotal = 0;
     {
         LOCK2(cs_main, cs_wallet);
@@ -2756,101 +3091,122 @@ CAmount CWallet::SelectSpendCoinsForAmount(
 }
 
 std::list<CSigmaEntry> CWallet::GetAvailableCoins(const CCoinControl *coinControl, bool includeUnsafe, bool fDummy) const {
+    LOCK2(cs_main, cs_wallet);
+    std::list<CSigmaEntry> coins = ListAvailableCoins(coinControl, includeUnsafe);
+    for (CSigmaEntry& coin : coins) {
+        if (!FillMintSecrets(coin, fDummy)) {
+            throw std::runtime_error(
+                _("Failed to read the secrets of an available coin."));
+        }
+    }
+
+    return coins;
+}
+
+std::list<CSigmaEntry> CWallet::ListAvailableCoins(const CCoinControl *coinControl, bool includeUnsafe) const {
     EnsureMintWalletAvailable();
 
     LOCK2(cs_main, cs_wallet);
-    CWalletDB walletdb(strWalletFile);
     std::list<CSigmaEntry> coins;
-    std::vector<CMintMeta> vecMints = zwalletMain->GetTracker().ListMints(true, true, false);
-    list<CMintMeta> listMints(vecMints.begin(), vecMints.end());
-    for (const CMintMeta& mint : listMints) {
-        CSigmaEntry entry;
-        const auto& sigmaParams = sigma::Params::get_default();
-        if(fDummy){
-            /* If we just want to create the spend tx without signing (eg. to get fee before entering password),
-             * we fill in the available unencrypted details from the metadata, and create dummy values for the
-             * encrypted ones.
-             */
-            sigma::PrivateCoin dummyCoin(sigmaParams, mint.denom);
-
-            entry.value = mint.GetPubCoinValue();
-            entry.set_denomination(mint.denom);
-            entry.randomness = dummyCoin.getRandomness();
-            entry.serialNumber = dummyCoin.getSerialNumber();
-            entry.IsUsed = mint.isUsed;
-            entry.nHeight = mint.nHeight;
-            entry.id = mint.nId;
-            entry.ecdsaSecretKey = std::vector<unsigned char>(&dummyCoin.getEcdsaSeckey()[0],&dummyCoin.getEcdsaSeckey()[32]);
-        }else{
-            GetMint(mint.hashSerial, entry);   
-        }
-        coins.push_back(entry);
-    }
+    sigma::CSigmaState* sigmaState = sigma::CSigmaState::GetState();
+
+    // Locked and selected coins are matched by outpoint, which takes reading the block of the mint
+    bool fCheckOutPoint = !setLockedCoins.empty() || (coinControl != NULL && coinControl->HasSelected());
 
-    std::set<COutPoint> lockedCoins = setLockedCoins;
+    // Coins of the same group share the anonymity set, so its size is looked up once
+    std::map<std::pair<sigma::CoinDenomination, int>, int> mapGroupSizes;
 
     // Filter out coins which are not confirmed, I.E. do not have at least 6 blocks
     // above them, after they were minted.
     // Also filter out used coins.
     // Finally filter out coins that have not been selected from CoinControl should that be used
-    coins.remove_if([lockedCoins, coinControl, includeUnsafe](const CSigmaEntry& coin) {
-        sigma::CSigmaState* sigmaState = sigma::CSigmaState::GetState();
-        if (coin.IsUsed)
-            return true;
+    for (const CMintMeta& mint : zwalletMain->GetTracker().ListMints(true, true, false)) {
+        if (mint.isUsed)
+            continue;
 
+        sigma::PublicCoin pubCoin(mint.GetPubCoinValue(), mint.denom);
         int coinHeight, coinId;
-        std::tie(coinHeight, coinId) =  sigmaState->GetMintedCoinHeightAndId(
-            sigma::PublicCoin(coin.value, coin.get_denomination()));
-
-        // Check group size
-        uint256 hashOut;
-        std::vector<sigma::PublicCoin> coinOuts;
-        sigmaState->GetCoinSetForSpend(
-            &chainActive,
-            chainActive.Height() - (ZC_MINT_CONFIRMATIONS - 1), // required 6 confirmation for mint to spend
-            coin.get_denomination(),
-            coinId,
-            hashOut,
-            coinOuts
-        );
-
-        if (!includeUnsafe && coinOuts.size() < 2) {
-            return true;
-        }
+        std::tie(coinHeight, coinId) = sigmaState->GetMintedCoinHeightAndId(pubCoin);
 
         if (coinHeight == -1) {
             // Coin still in the mempool.
-            return true;
+            continue;
         }
 
         if (coinHeight + (ZC_MINT_CONFIRMATIONS - 1) > chainActive.Height()) {
             // Remove the coin from the candidates list, since it does not have the
             // required number of confirmations.
-            return true;
+            continue;
         }
 
-        COutPoint outPoint;
-        sigma::PublicCoin pubCoin(coin.value, coin.get_denomination());
-        sigma::GetOutPoint(outPoint, pubCoin);
+        // Check group size
+        if (!includeUnsafe) {
+            auto group = mapGroupSizes.find(std::make_pair(mint.denom, coinId));
+            if (group == mapGroupSizes.end()) {
+                uint256 hashOut;
+                std::shared_ptr<const std::vector<sigma::PublicCoin>> coinOuts;
+                int coinsInGroup = sigmaState->GetCoinSetForSpend(
+                    &chainActive,
+                    chainActive.Height() - (ZC_MINT_CONFIRMATIONS - 1), // required 6 confirmation for mint to spend
+                    mint.denom,
+                    coinId,
+                    hashOut,
+                    coinOuts
+                );
+                group = mapGroupSizes.insert(std::make_pair(std::make_pair(mint.denom, coinId), coinsInGroup)).first;
+            }
 
-        if(lockedCoins.count(outPoint) > 0){
-            return true;
+            if (group->second < 2) {
+                continue;
+            }
         }
 
-        if(coinControl != NULL){
-            if(coinControl->HasSelected()){
-                if(!coinControl->IsSelected(outPoint)){
-                    return true;
-                }
+        if (fCheckOutPoint) {
+            COutPoint outPoint;
+            sigma::GetOutPoint(outPoint, pubCoin);
+
+            if (setLockedCoins.count(outPoint) > 0) {
+                continue;
+            }
+
+            if (coinControl != NULL && coinControl->HasSelected() && !coinControl->IsSelected(outPoint)) {
+                continue;
             }
         }
 
-        return false;
-    });
+        CSigmaEntry entry;
+        entry.value = mint.GetPubCoinValue();
+        entry.set_denomination(mint.denom);
+        entry.IsUsed = mint.isUsed;
+        entry.nHeight = mint.nHeight;
+        entry.id = mint.nId;
+        coins.push_back(entry);
+    }
 
     return coins;
 }
 
+bool CWallet::FillMintSecrets(CSigmaEntry& entry, bool fDummy) const {
+    if (fDummy) {
+        /* If we just want to create the spend tx without signing (eg. to get fee before entering password),
+         * we fill in the available unencrypted details from the metadata, and create dummy values for the
+         * encrypted ones.
+         */
+        sigma::PrivateCoin dummyCoin(sigma::Params::get_default(), entry.get_denomination());
+
+        entry.randomness = dummyCoin.getRandomness();
+        entry.serialNumber = dummyCoin.getSerialNumber();
+        entry.ecdsaSecretKey = std::vector<unsigned char>(&dummyCoin.getEcdsaSeckey()[0],&dummyCoin.getEcdsaSeckey()[32]);
+        return true;
+    }
+
+    CMintMeta meta;
+    if (!zwalletMain->GetTracker().GetMetaFromPubcoin(primitives::GetPubCoinValueHash(entry.value), meta))
+        return error("%s: pubcoin %s is not in tracker", __func__, entry.value.GetHex());
+
+    return GetMint(meta.hashSerial, entry);
+}
+
 template<typename Iterator>
 static CAmount CalculateCoinsBalance(Iterator begin, Iterator end) {
     CAmount balance(0);
@@ -2896,7 +3252,8 @@ bool CWallet::GetCoinsToSpend(
             _("Required amount exceed value spend limit"));
     }
 
-    std::list<CSigmaEntry> coins = GetAvailableCoins(coinControl, false, fDummy);
+    // Selection only needs the public data of the coins, their secrets are filled in once chosen
+    std::list<CSigmaEntry> coins = ListAvailableCoins(coinControl, false);
 
     CAmount availableBalance = CalculateCoinsBalance(coins.begin(), coins.end());
 
@@ -2984,82 +3341,43 @@ bool CWallet::GetCoinsToSpend(
         throw std::runtime_error(
             _("Problem with coin selection for re-mint while spending."));
     }
+    size_t nSelectedBefore = coinsToSpend_out.size();
     if (SelectSpendCoinsForAmount(best_spend_val, coins, coinsToSpend_out) != best_spend_val) {
         throw std::runtime_error(
             _("Problem with coin selection for spend."));
     }
 
+    for (size_t i = nSelectedBefore; i < coinsToSpend_out.size(); i++) {
+        if (!FillMintSecrets(coinsToSpend_out[i], fDummy)) {
+            throw std::runtime_error(
+                _("Failed to read the secrets of a selected coin."));
+        }
+    }
+
     return true;
 }
 
 CAmount CWallet::GetUnconfirmedBalance() const {
-    CAmount nTotal = 0;
-    {
-        LOCK2(cs_main, cs_wallet);
-        for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it) {
-            const CWalletTx *pcoin = &(*it).second;
-            if (!pcoin->IsTrusted() && pcoin->GetDepthInMainChain() == 0 &&
-                (pcoin->InMempool() || pcoin->InStempool()))
-                nTotal += pcoin->GetAvailableCredit();
-        }
-    }
-    return nTotal;
+    return GetBalances().nUnconfirmed;
 }
 
 CAmount CWallet::GetImmatureBalance() const {
-    CAmount nTotal = 0;
-    {
-        LOCK2(cs_main, cs_wallet);
-        for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it) {
-            const CWalletTx *pcoin = &(*it).second;
-            nTotal += pcoin->GetImmatureCredit();
-        }
-    }
-    return nTotal;
+    return GetBalances().nImmature;
 }
 
 // peercoin: total coins staked (non-spendable until maturity)
 CAmount CWallet::GetStake() const
 {
-    CAmount nTotal = 0;
-    {
-        LOCK2(cs_main, cs_wallet);
-        for (const auto& entry : mapWallet)
-        {
-            const CWalletTx* pcoin = &entry.second;
-            nTotal += pcoin->GetImmatureStakeCredit();
-        }
-    }
-    return nTotal;
+    return GetBalances().nStake;
 }
 
 
 CAmount CWallet::GetWatchOnlyBalance() const {
-    CAmount nTotal = 0;
-    {
-        LOCK2(cs_main, cs_wallet);
-        for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it) {
-            const CWalletTx *pcoin = &(*it).second;
-            if (pcoin->IsTrusted())
-                nTotal += pcoin->GetAvailableWatchOnlyCredit();
-        }
-    }
-
-    return nTotal;
+    return GetBalances().nWatchOnly;
 }
 
 CAmount CWallet::GetUnconfirmedWatchOnlyBalance() const {
-    CAmount nTotal = 0;
-    {
-        LOCK2(cs_main, cs_wallet);
-        for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it) {
-            const CWalletTx *pcoin = &(*it).second;
-            if (!pcoin->IsTrusted() && pcoin->GetDepthInMainChain() == 0 &&
-                (pcoin->InMempool() || pcoin->InStempool()))
-                nTotal += pcoin->GetAvailableWatchOnlyCredit();
-        }
-    }
-    return nTotal;
+    return GetBalances().nUnconfirmedWatchOnly;
 }
 
 // Recursively determine the rounds of a given input (How deep is the PrivateSend chain for a given input)
@@ -3215,15 +3533,7 @@ bool CWallet::IsCollateralAmount(CAmount nInputAmount) const {
 }
 
 CAmount CWallet::GetImmatureWatchOnlyBalance() const {
-    CAmount nTotal = 0;
-    {
-        LOCK2(cs_main, cs_wallet);
-        for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it) {
-            const CWalletTx *pcoin = &(*it).second;
-            nTotal += pcoin->GetImmatureWatchOnlyCredit();
-        }
-    }
-    return nTotal;
+    return GetBalances().nImmatureWatchOnly;
 }
 
 void CWallet::AvailableCoins(vector <COutput> &vCoins, bool fOnlyConfirmed, const CCoinControl *coinControl,
@@ -4529,8 +4839,10 @@ bool CWallet::EraseFromWallet(uint256 hash) {
         return false;
     {
         LOCK(cs_wallet);
-        if (mapWallet.erase(hash))
+        if (mapWallet.erase(hash)) {
+            MarkBalanceDirty(hash);
             CWalletDB(strWalletFile).EraseTx(hash);
+        }
     }
     return true;
 }
@@ -6078,7 +6390,7 @@ bool CWallet::CreateSigmaSpendTransaction(
             CSigmaEntry coinToUse;
             sigma::CSigmaState* sigmaState = sigma::CSigmaState::GetState();
 
-            std::vector<sigma::PublicCoin> anonimity_set;
+            std::shared_ptr<const std::vector<sigma::PublicCoin>> anonimity_set;
             uint256 blockHash;
 
             int coinId = INT_MAX;
@@ -6168,12 +6480,12 @@ bool CWallet::CreateSigmaSpendTransaction(
                 fPadding = true;
             }
 
-            sigma::CoinSpend spend(sigmaParams, privateCoin, anonimity_set, metaData, fPadding);
+            sigma::CoinSpend spend(sigmaParams, privateCoin, *anonimity_set, metaData, fPadding);
             spend.setVersion(txVersion);
 
             // This is a sanity check. The CoinSpend object should always verify,
             // but why not check before we put it onto the wire?
-            if (!spend.Verify(anonimity_set, metaData,fPadding)) {
+            if (!spend.Verify(*anonimity_set, metaData,fPadding)) {
                 strFailReason = _("the spend coin transaction did not verify");
                 return false;
             }
@@ -6680,7 +6992,7 @@ bool CWallet::CreateMultipleSigmaSpendTransaction(
 //             objects holding spend inputs & storage values while tx is formed
             struct TempStorage {
                 sigma::PrivateCoin privateCoin;
-                std::vector<sigma::PublicCoin> anonimity_set;
+                std::shared_ptr<const std::vector<sigma::PublicCoin>> anonimity_set;
                 sigma::CoinDenomination denomination;
                 uint256 blockHash;
                 CSigmaEntry coinToUse;
@@ -6729,7 +7041,7 @@ bool CWallet::CreateMultipleSigmaSpendTransaction(
                 CSigmaEntry coinToUse;
                 sigma::CSigmaState* sigmaState = sigma::CSigmaState::GetState();
 
-                std::vector<sigma::PublicCoin> anonimity_set;
+                std::shared_ptr<const std::vector<sigma::PublicCoin>> anonimity_set;
                 uint256 blockHash;
 
                 int coinId = INT_MAX;
@@ -6877,13 +7189,13 @@ bool CWallet::CreateMultipleSigmaSpendTransaction(
                 // Recreate CoinSpend object
                 sigma::CoinSpend spend(sigmaParams,
                                        tempStorage.privateCoin,
-                                       tempStorage.anonimity_set,
+                                       *tempStorage.anonimity_set,
                                        metaData,
                                        fPadding);
                 spend.setVersion(tempStorage.txVersion);
                 spends.push_back(spend);
                 // Verify the coinSpend
-                if (!spend.Verify(tempStorage.anonimity_set, metaData, fPadding)) {
+                if (!spend.Verify(*tempStorage.anonimity_set, metaData, fPadding)) {
                     strFailReason = _("the spend coin transaction did not verify");
                     return false;
                 }
@@ -8571,6 +8883,9 @@ std::string CWallet::GetWalletHelpString(bool showDebug) {
                                    strprintf(
                                            _("Send transactions as zero-fee transactions if possible (default: %u)"),
                                            DEFAULT_SEND_FREE_TRANSACTIONS));
+    strUsage += HelpMessageOpt("-signthreads=<n>", strprintf(
+            _("Set the number of threads generating the proofs of a spend transaction (0 = auto, default: %d)"),
+            DEFAULT_SIGN_THREADS));
     strUsage += HelpMessageOpt("-spendzeroconfchange",
                                strprintf(_("Spend unconfirmed change when sending transactions (default: %u)"),
                                          DEFAULT_SPEND_ZEROCONF_CHANGE));
@@ -69,6 +69,8 @@ static const bool DEFAULT_SPEND_ZEROCONF_CHANGE = true;
 static const bool DEFAULT_SEND_FREE_TRANSACTIONS = false;
 //! Default for -walletrejectlongchains
 static const bool DEFAULT_WALLET_REJECT_LONG_CHAINS = false;
+//! Default for -signthreads, 0 uses a thread per core
+static const int DEFAULT_SIGN_THREADS = 0;
 //! -txconfirmtarget default
 static const unsigned int DEFAULT_TX_CONFIRM_TARGET = 2;
 //! Largest (in bytes) free transaction we're willing to create
@@ -445,17 +447,7 @@ public:
     }
 
     //! make sure balances are recalculated
-    void MarkDirty()
-    {
-        fCreditCached = false;
-        fAvailableCreditCached = false;
-        fWatchDebitCached = false;
-        fWatchCreditCached = false;
-        fAvailableWatchCreditCached = false;
-        fImmatureWatchCreditCached = false;
-        fDebitCached = false;
-        fChangeCached = false;
-    }
+    void MarkDirty();
 
     void BindWallet(CWallet *pwalletIn)
     {
@@ -639,6 +631,53 @@ enum MintAlgorithm {
     SIGMA = 2
 };
 
+/** Balances of a wallet by category, summed up from the contributions of its transactions. */
+struct CWalletBalances
+{
+    CAmount nTrusted;
+    CAmount nUnconfirmed;
+    CAmount nImmature;
+    CAmount nStake;
+    CAmount nWatchOnly;
+    CAmount nUnconfirmedWatchOnly;
+    CAmount nImmatureWatchOnly;
+
+    CWalletBalances() : nTrusted(0), nUnconfirmed(0), nImmature(0), nStake(0), nWatchOnly(0),
+        nUnconfirmedWatchOnly(0), nImmatureWatchOnly(0)
+    {
+    }
+
+    bool IsNull() const
+    {
+        return !nTrusted && !nUnconfirmed && !nImmature && !nStake && !nWatchOnly &&
+            !nUnconfirmedWatchOnly && !nImmatureWatchOnly;
+    }
+
+    CWalletBalances& operator+=(const CWalletBalances& other)
+    {
+        nTrusted += other.nTrusted;
+        nUnconfirmed += other.nUnconfirmed;
+        nImmature += other.nImmature;
+        nStake += other.nStake;
+        nWatchOnly += other.nWatchOnly;
+        nUnconfirmedWatchOnly += other.nUnconfirmedWatchOnly;
+        nImmatureWatchOnly += other.nImmatureWatchOnly;
+        return *this;
+    }
+
+    CWalletBalances& operator-=(const CWalletBalances& other)
+    {
+        nTrusted -= other.nTrusted;
+        nUnconfirmed -= other.nUnconfirmed;
+        nImmature -= other.nImmature;
+        nStake -= other.nStake;
+        nWatchOnly -= other.nWatchOnly;
+        nUnconfirmedWatchOnly -= other.nUnconfirmedWatchOnly;
+        nImmatureWatchOnly -= other.nImmatureWatchOnly;
+        return *this;
+    }
+};
+
 /**
  * A CWallet is an extension of a keystore, which also maintains a set of transactions and balances,
  * and provides the ability to create new transactions.
@@ -664,6 +703,7 @@ private:
     int64_t nNextResend;
     int64_t nLastResend;
     bool fBroadcastTransactions;
+    //! kernel inputs of the staking candidates, kept across CreateCoinStake calls (guarded by cs_wallet)
     std::map<COutPoint, CStakeCache> stakeCache;
 
     mutable bool fAnonymizableTallyCached;
@@ -671,6 +711,25 @@ private:
     mutable bool fAnonymizableTallyCachedNonDenom;
     mutable std::vector<CompactTallyItem> vecAnonymizableTallyCachedNonDenom;
 
+    /**
+     * Balances kept up to date with the transactions changed since the last query (guarded by
+     * cs_wallet). Contributions that depend on the chain tip or the mempool, those of unconfirmed
+     * and immature transactions, are recomputed on every query.
+     */
+    mutable CWalletBalances balancesCached;
+    mutable std::map<uint256, CWalletBalances> mapBalanceContributions; //!< non-zero ones only
+    mutable std::set<uint256> setBalanceDirty;
+    mutable std::set<uint256> setBalanceVolatile;
+    mutable bool fBalanceAllDirty;
+
+    //! Sigma balance, valid for the chain height and the state of the mint tracker it was taken at
+    mutable std::pair<CAmount, CAmount> sigmaBalanceCached;
+    mutable int nSigmaBalanceHeight;
+    mutable uint64_t nSigmaBalanceTrackerState;
+
+    void UpdateBalances() const;
+    void UpdateBalanceContribution(const uint256& hash) const;
+
     /**
      * Used to keep track of spent outpoints, and
      * detect and report conflicts (double-spends or
@@ -678,6 +737,7 @@ private:
      */
     typedef std::multimap<COutPoint, uint256> TxSpends;
     TxSpends mapTxSpends;
+    void MarkSpentDirty(const COutPoint& outpoint);
     void AddToSpends(const COutPoint& outpoint, const uint256& wtxid);
     void AddToSpends(const uint256& wtxid);
 	void RemoveFromSpends(const COutPoint& outpoint, const uint256& wtxid);
@@ -748,6 +808,9 @@ public:
         fAnonymizableTallyCachedNonDenom = false;
         vecAnonymizableTallyCached.clear();
         vecAnonymizableTallyCachedNonDenom.clear();
+        fBalanceAllDirty = true;
+        nSigmaBalanceHeight = -1;
+        nSigmaBalanceTrackerState = 0;
     }
 
     std::map<uint256, CWalletTx> mapWallet;
@@ -876,6 +939,12 @@ public:
     CAmount GetWatchOnlyBalance() const;
     CAmount GetUnconfirmedWatchOnlyBalance() const;
     CAmount GetImmatureWatchOnlyBalance() const;
+    //! All balance categories at once, takes cs_main and cs_wallet itself
+    CWalletBalances GetBalances() const;
+    //! Sigma balance of the unspent mints, all and confirmed ones
+    std::pair<CAmount, CAmount> GetSigmaBalance() const;
+    //! The contribution of the transaction to the balances may have changed
+    void MarkBalanceDirty(const uint256& hash) const;
     // get the PrivateSend chain depth for a given input
     int GetRealInputPrivateSendRounds(CTxIn txin, int nRounds) const;
     // respect current settings
@@ -913,6 +982,12 @@ public:
     // to be spent.
     std::list<CSigmaEntry> GetAvailableCoins(const CCoinControl *coinControl = NULL, bool includeUnsafe = false, bool fDummy = false) const;
 
+    // Same as GetAvailableCoins, but with the public data of the coins only, read from the mint tracker
+    std::list<CSigmaEntry> ListAvailableCoins(const CCoinControl *coinControl = NULL, bool includeUnsafe = false) const;
+
+    // Fills in the secrets of a coin listed by ListAvailableCoins, or dummy ones if fDummy is set
+    bool FillMintSecrets(CSigmaEntry& entry, bool fDummy = false) const;
+
     /** \brief Selects coins to spend, and coins to re-mint based on the required amount to spend, provided by the user. As the lower denomination now is 0.1 index, user's request will be rounded up to the nearest 0.1. This difference between the user's requested value, and the actually spent value will be left to the miners as a fee.
      * \param[in] required Required amount to spend.
      * \param[out] coinsToSpend_out Coins which user needs to spend.